@@ -25,11 +25,16 @@
 
 #include <iostream>
 #include <string>
+#include <sstream>
 #include <thread>
 #include <future>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <algorithm>
 
 #include "CircularFifo.h"
 #include "ChronoUtils.h"
@@ -245,7 +250,7 @@ public:
 
 };
 
-typedef boost::mpl::list<fb::CircularFifo<DetectMove>,fb::WaitingCircularFifo<DetectMove, fb::WaitingPolicy::SPIN>,fb::WaitingCircularFifo<DetectMove, fb::WaitingPolicy::BLOCK>> test_types;
+typedef boost::mpl::list<fb::CircularFifo<DetectMove>,fb::WaitingCircularFifo<DetectMove, fb::WaitingPolicy::SPIN>,fb::WaitingCircularFifo<DetectMove, fb::WaitingPolicy::BLOCK>,fb::WaitingCircularFifo<DetectMove, fb::WaitingPolicy::HYBRID>> test_types;
 
 // We also test this for the WaitingFifo wrappers
 BOOST_AUTO_TEST_CASE_TEMPLATE(MoveTest, T, test_types) {
@@ -357,6 +362,11 @@ BOOST_AUTO_TEST_CASE(WaitingFifoValidation_Block) {
     BOOST_CHECK_NO_THROW(run_waiting_fifo_validation_test<fb::WaitingPolicy::BLOCK>());
 }
 
+BOOST_AUTO_TEST_CASE(WaitingFifoValidation_Hybrid) {
+    
+    BOOST_CHECK_NO_THROW(run_waiting_fifo_validation_test<fb::WaitingPolicy::HYBRID>());
+}
+
 template <fb::WaitingPolicy P>
 void run_fifo_cancelation_test()
 {
@@ -395,6 +405,11 @@ BOOST_AUTO_TEST_CASE(WaitingFifoCancelation_Block) {
     run_fifo_cancelation_test<fb::WaitingPolicy::BLOCK>();
 }
 
+BOOST_AUTO_TEST_CASE(WaitingFifoCancelation_Hybrid) {
+    
+    run_fifo_cancelation_test<fb::WaitingPolicy::HYBRID>();
+}
+
 template <fb::WaitingPolicy P>
 void run_fifo_optional_wait_test()
 {
@@ -510,4 +525,303 @@ BOOST_AUTO_TEST_CASE(WaitingFifoBlock_OptionalWait_Block) {
     run_fifo_optional_wait_test<fb::WaitingPolicy::BLOCK>();
 }
 
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+BOOST_AUTO_TEST_CASE(WaitingFifoBlock_OptionalWait_Hybrid) {
+    
+    run_fifo_optional_wait_test<fb::WaitingPolicy::HYBRID>();
+}
+
+BOOST_AUTO_TEST_CASE(BatchPushPop) {
+
+    fb::CircularFifo<int> fifo(5);
+
+    const std::vector<int> input = { 0, 1, 2, 3, 4, 5, 6 };
+
+    // Only five fit
+    BOOST_CHECK_EQUAL(fifo.push_n(input.begin(), input.size()), 5);
+    BOOST_CHECK(fifo.was_full());
+    BOOST_CHECK_EQUAL(fifo.push_n(input.begin(), 1), 0);
+
+    std::vector<int> output(input.size(), -1);
+    BOOST_CHECK_EQUAL(fifo.pop_n(output.begin(), 3), 3);
+    BOOST_CHECK_EQUAL(fifo.had_num_elements(), 2);
+
+    // Wraps around the (power-of-two) ring
+    BOOST_CHECK_EQUAL(fifo.push_n(input.begin() + 5, 2), 2);
+    BOOST_CHECK_EQUAL(fifo.pop_n(output.begin() + 3, 10), 4);
+    BOOST_CHECK(fifo.was_empty());
+    BOOST_CHECK_EQUAL(fifo.pop_n(output.begin(), 10), 0);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(output.begin(), output.end(), input.begin(), input.end());
+}
+
+namespace {
+
+    // Can only be constructed in place
+    class NotDefaultConstructible {
+    public:
+        NotDefaultConstructible(int a, std::string b) : a(a), b(std::move(b)) { ++instances; }
+        NotDefaultConstructible(NotDefaultConstructible&& other) : a(other.a), b(std::move(other.b)) { ++instances; }
+        NotDefaultConstructible& operator=(NotDefaultConstructible&& other) { a = other.a; b = std::move(other.b); return *this; }
+        ~NotDefaultConstructible() { --instances; }
+
+        int a;
+        std::string b;
+
+        static int instances;
+    };
+
+    int NotDefaultConstructible::instances = 0;
+
+}
+
+BOOST_AUTO_TEST_CASE(EmplaceTest) {
+
+    {
+        fb::WaitingCircularFifo<NotDefaultConstructible, fb::WaitingPolicy::BLOCK> fifo(2);
+
+        // Nothing is constructed upfront
+        BOOST_CHECK_EQUAL(NotDefaultConstructible::instances, 0);
+
+        BOOST_CHECK(fifo.emplace(1, "one"));
+        BOOST_CHECK(fifo.emplace(2, "two"));
+        BOOST_CHECK(!fifo.emplace(3, "three"));
+        BOOST_CHECK_EQUAL(NotDefaultConstructible::instances, 2);
+
+        NotDefaultConstructible out(0, "");
+        BOOST_CHECK(fifo.pop(out));
+        BOOST_CHECK_EQUAL(out.a, 1);
+        BOOST_CHECK_EQUAL(out.b, "one");
+        BOOST_CHECK_EQUAL(NotDefaultConstructible::instances, 2);
+    }
+
+    // Remaining element was destroyed with the fifo
+    BOOST_CHECK_EQUAL(NotDefaultConstructible::instances, 0);
+}
+
+template <fb::WaitingPolicy P>
+void run_waiting_fifo_batch_test() {
+
+    fb::WaitingCircularFifo<int, P> fifo{16};
+
+    static const int max_count = 100000;
+    static const size_t batch_size = 5;
+
+    std::thread producer_thread{[&]{
+        int batch[batch_size];
+        int next = 0;
+        while (next < max_count) {
+            const size_t num = std::min<size_t>(batch_size, max_count - next);
+            for (size_t i = 0; i < num; ++i)
+                batch[i] = next + static_cast<int>(i);
+
+            size_t pushed = 0;
+            while (pushed < num) {
+                pushed += fifo.push_n(batch + pushed, num - pushed);
+                if (pushed < num)
+                    std::this_thread::yield();
+            }
+            next += static_cast<int>(num);
+        }
+    }};
+
+    int expected = 0;
+    int batch[batch_size * 2];
+    bool in_order = true;
+    while (expected < max_count) {
+        const size_t num = fifo.pop_n(batch, batch_size * 2);
+        BOOST_REQUIRE(num > 0);
+        for (size_t i = 0; i < num; ++i)
+            in_order &= (batch[i] == expected++);
+    }
+
+    producer_thread.join();
+
+    BOOST_CHECK(in_order);
+    BOOST_CHECK(fifo.was_empty());
+}
+
+BOOST_AUTO_TEST_CASE(WaitingFifoBatch_Spin) {
+
+    run_waiting_fifo_batch_test<fb::WaitingPolicy::SPIN>();
+}
+
+BOOST_AUTO_TEST_CASE(WaitingFifoBatch_Block) {
+
+    run_waiting_fifo_batch_test<fb::WaitingPolicy::BLOCK>();
+}
+
+BOOST_AUTO_TEST_CASE(WaitingFifoBatch_Hybrid) {
+
+    run_waiting_fifo_batch_test<fb::WaitingPolicy::HYBRID>();
+}
+
+BOOST_AUTO_TEST_CASE(HybridFifoParksAndReportsWake) {
+
+    // Parks right away
+    fb::WaitingCircularFifo<int, fb::WaitingPolicy::HYBRID> fifo{4, fb::WaitSettings(fb::clock::duration::zero())};
+
+    size_t num_wakes = 0;
+    fb::clock::duration wake_latency = fb::clock::duration::zero();
+
+    fifo.set_wake_sampler([&](const fb::clock::time_point& signaled, const fb::clock::time_point& woken) {
+        ++num_wakes;
+        wake_latency = woken - signaled;
+    });
+
+    int el = 0;
+    std::thread consumer_thread{[&]{
+        fifo.pop(el);
+    }};
+
+    // Give the consumer time to park
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    fifo.push(42);
+
+    consumer_thread.join();
+
+    BOOST_CHECK_EQUAL(el, 42);
+    BOOST_CHECK_EQUAL(num_wakes, 1);
+    BOOST_CHECK(wake_latency >= fb::clock::duration::zero());
+
+    std::cout 
+        << "Hybrid fifo wake latency: " 
+        << boost::chrono::duration_cast<boost::chrono::microseconds>(wake_latency) 
+        << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(WaitingPolicyFromString) {
+
+    fb::WaitingPolicy policy = fb::WaitingPolicy::SPIN;
+    std::istringstream("Hybrid") >> policy;
+    BOOST_CHECK(policy == fb::WaitingPolicy::HYBRID);
+
+    const auto settings = fb::WaitSettings::for_policy(fb::WaitingPolicy::BLOCK, fb::microseconds(50));
+    BOOST_CHECK(settings.spin_duration == fb::clock::duration::zero());
+}
+
+namespace {
+
+    // The layout CircularFifo had before the head and tail were padded and
+    // cached, kept as a baseline for the benchmarks below.
+    template <typename Element>
+    class UnpaddedFifo {
+    public:
+
+        UnpaddedFifo(size_t size) : _capacity(size + 1), _tail(0), _array(new Element[size + 1]), _head(0) {}
+
+        bool push(const Element& item) {
+            const auto current_tail = _tail.load(std::memory_order_relaxed);
+            const auto next_tail = (current_tail + 1) % _capacity;
+            if (next_tail == _head.load(std::memory_order_acquire))
+                return false;
+            _array[current_tail] = item;
+            _tail.store(next_tail, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(Element& item) {
+            const auto current_head = _head.load(std::memory_order_relaxed);
+            if (current_head == _tail.load(std::memory_order_acquire))
+                return false;
+            item = std::move(_array[current_head]);
+            _head.store((current_head + 1) % _capacity, std::memory_order_release);
+            return true;
+        }
+
+    private:
+
+        const size_t _capacity;
+        std::atomic<size_t> _tail;
+        std::unique_ptr<Element[]> _array;
+        std::atomic<size_t> _head;
+    };
+
+    // Average round trip through two FIFOs, in nanoseconds
+    template <typename Fifo>
+    double measure_ping_pong(size_t num_round_trips) {
+
+        Fifo ping(4);
+        Fifo pong(4);
+
+        std::thread echo{[&]{
+            size_t value = 0;
+            for (size_t i = 0; i < num_round_trips; ++i) {
+                while (!ping.pop(value))
+                    std::this_thread::yield();
+                while (!pong.push(value))
+                    std::this_thread::yield();
+            }
+        }};
+
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        size_t value = 0;
+        for (size_t i = 0; i < num_round_trips; ++i) {
+            while (!ping.push(i))
+                std::this_thread::yield();
+            while (!pong.pop(value))
+                std::this_thread::yield();
+            BOOST_REQUIRE_EQUAL(value, i);
+        }
+
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        echo.join();
+
+        return std::chrono::duration<double, std::nano>(end - start).count() / num_round_trips;
+    }
+
+    // Elements per second from one producer to one consumer
+    template <typename Fifo>
+    double measure_throughput(size_t num_elements) {
+
+        Fifo fifo(1024);
+
+        std::thread producer{[&]{
+            for (size_t i = 0; i < num_elements; ++i) {
+                while (!fifo.push(i))
+                    std::this_thread::yield();
+            }
+        }};
+
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        size_t value = 0;
+        size_t expected = 0;
+        for (; expected < num_elements; ++expected) {
+            while (!fifo.pop(value))
+                std::this_thread::yield();
+            if (value != expected)
+                break;
+        }
+
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        producer.join();
+
+        BOOST_REQUIRE_EQUAL(expected, num_elements);
+
+        return num_elements / std::chrono::duration<double>(end - start).count();
+    }
+
+}
+
+// Not a pass/fail test, only reports the numbers. Note that the results only
+// mean something if producer and consumer actually run on different cores.
+BOOST_AUTO_TEST_CASE(FifoBenchmark) {
+
+    const size_t num_round_trips = 100000;
+    const size_t num_elements = 2000000;
+
+    const double ping_pong_unpadded = measure_ping_pong<UnpaddedFifo<size_t>>(num_round_trips);
+    const double ping_pong = measure_ping_pong<fb::CircularFifo<size_t>>(num_round_trips);
+
+    const double throughput_unpadded = measure_throughput<UnpaddedFifo<size_t>>(num_elements);
+    const double throughput = measure_throughput<fb::CircularFifo<size_t>>(num_elements);
+
+    std::cout << "Ping-pong round trip: " << ping_pong << " ns (unpadded: " << ping_pong_unpadded << " ns)." << std::endl;
+    std::cout << "Throughput: " << throughput / 1e6 << " M elements/s (unpadded: " << throughput_unpadded / 1e6 << " M elements/s)." << std::endl;
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,511 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <random>
+#include <cstring>
+#include <algorithm>
+
+#include "CpuFormatConverter.h"
+#include "V210Comparator.h"
+#include "FormatConverterStage.h"
+
+namespace fb = toa::frame_bender;
+
+namespace {
+
+    const uint32_t kTestWidth = 1920;
+    const uint32_t kTestHeight = 8;
+
+    fb::ImageFormat make_format(fb::ImageFormat::PixelFormat pixel_format) {
+
+        return fb::ImageFormat(
+            kTestWidth,
+            kTestHeight,
+            fb::ImageFormat::Transfer::BT_709,
+            fb::ImageFormat::Chromaticity::BT_709,
+            pixel_format,
+            fb::ImageFormat::Origin::LOWER_LEFT);
+
+    }
+
+    std::vector<uint8_t> random_v210_frame(const fb::ImageFormat& fmt) {
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<uint32_t> component(4, 1019);
+
+        std::vector<uint8_t> frame(fmt.image_byte_size());
+        for (size_t i = 0; i < frame.size(); i += 4) {
+            const uint32_t word = 
+                component(rng) | 
+                (component(rng) << 10) | 
+                (component(rng) << 20);
+            std::memcpy(&frame[i], &word, 4);
+        }
+
+        return frame;
+
+    }
+
+    // Random RGBA values, slightly out of [0, 1] for the float formats
+    std::vector<uint8_t> random_rgba_frame(const fb::ImageFormat& fmt) {
+
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> component(-0.1f, 1.1f);
+
+        const size_t num_values = 
+            static_cast<size_t>(fmt.width()) * fmt.height() * 4;
+
+        std::vector<uint8_t> frame(fmt.image_byte_size());
+
+        for (size_t i = 0; i<num_values; ++i) {
+
+            const float v = component(rng);
+
+            switch (fmt.pixel_format()) {
+            case fb::ImageFormat::PixelFormat::RGBA_FLOAT_32BIT:
+                std::memcpy(&frame[i*4], &v, 4);
+                break;
+            case fb::ImageFormat::PixelFormat::RGBA_FLOAT_16BIT: {
+                // Truncating conversion is good enough for test data
+                uint32_t bits;
+                std::memcpy(&bits, &v, 4);
+                const uint32_t exponent = (bits >> 23) & 0xff;
+                uint16_t h = 0;
+                if (exponent > 112)
+                    h = static_cast<uint16_t>(((exponent - 112) << 10) | ((bits >> 13) & 0x3ff));
+                h |= static_cast<uint16_t>((bits >> 16) & 0x8000);
+                std::memcpy(&frame[i*2], &h, 2);
+                }
+                break;
+            default: {
+                const uint16_t u = static_cast<uint16_t>(
+                    std::min(std::max(v, .0f), 1.0f) * 65535.0f);
+                std::memcpy(&frame[i*2], &u, 2);
+                }
+                break;
+            }
+
+        }
+
+        return frame;
+
+    }
+
+    const fb::ImageFormat::PixelFormat kRgbaFormats[] = {
+        fb::ImageFormat::PixelFormat::RGBA_16BIT,
+        fb::ImageFormat::PixelFormat::RGBA_FLOAT_16BIT,
+        fb::ImageFormat::PixelFormat::RGBA_FLOAT_32BIT
+    };
+
+}
+
+BOOST_AUTO_TEST_SUITE(CpuFormatConversionTests)
+
+BOOST_AUTO_TEST_CASE(BlackDecodesToZero) {
+
+    auto in_fmt = make_format(fb::ImageFormat::PixelFormat::YUV_10BIT_V210);
+    auto out_fmt = make_format(fb::ImageFormat::PixelFormat::RGBA_16BIT);
+
+    // Y = 64, Cb = Cr = 512 in every component slot
+    std::vector<uint8_t> src(in_fmt.image_byte_size());
+    for (size_t i = 0; i < src.size(); i += 16) {
+        const uint32_t words[4] = {
+            512 | (64 << 10) | (512 << 20),
+            64 | (512 << 10) | (64 << 20),
+            512 | (64 << 10) | (512 << 20),
+            64 | (512 << 10) | (64 << 20)
+        };
+        std::memcpy(&src[i], words, 16);
+    }
+
+    std::vector<uint8_t> dst(out_fmt.image_byte_size());
+
+    fb::CpuFormatConverter converter(
+        in_fmt, 
+        out_fmt, 
+        fb::ChromaFilter::high, 
+        false, 
+        fb::cpu::max_simd_level());
+
+    converter.convert(src.data(), dst.data());
+
+    const uint16_t* pixels = reinterpret_cast<const uint16_t*>(dst.data());
+    for (size_t i = 0; i < kTestWidth * kTestHeight; ++i) {
+        BOOST_REQUIRE_EQUAL(pixels[i*4 + 0], 0);
+        BOOST_REQUIRE_EQUAL(pixels[i*4 + 1], 0);
+        BOOST_REQUIRE_EQUAL(pixels[i*4 + 2], 0);
+        BOOST_REQUIRE_EQUAL(pixels[i*4 + 3], 65535);
+    }
+
+}
+
+// All SIMD kernels must produce exactly the same output as the scalar one,
+// otherwise the comparison against the GLSL converters would depend on the
+// machine the tests are running on.
+BOOST_AUTO_TEST_CASE(SimdLevelsAreBitExact) {
+
+    auto in_fmt = make_format(fb::ImageFormat::PixelFormat::YUV_10BIT_V210);
+    auto src = random_v210_frame(in_fmt);
+
+    const fb::ChromaFilter filters[] = {
+        fb::ChromaFilter::none,
+        fb::ChromaFilter::basic,
+        fb::ChromaFilter::high
+    };
+
+    for (auto pixel_format : kRgbaFormats) {
+        auto out_fmt = make_format(pixel_format);
+        for (auto filter : filters) {
+            for (bool linear : { false, true }) {
+
+                fb::CpuFormatConverter reference(
+                    in_fmt, out_fmt, filter, linear, fb::cpu::SimdLevel::scalar);
+
+                std::vector<uint8_t> expected(out_fmt.image_byte_size());
+                reference.convert(src.data(), expected.data());
+
+                for (int32_t level = 1; 
+                     level <= static_cast<int32_t>(fb::cpu::max_simd_level()); 
+                     ++level) {
+
+                    fb::CpuFormatConverter converter(
+                        in_fmt, 
+                        out_fmt, 
+                        filter, 
+                        linear, 
+                        static_cast<fb::cpu::SimdLevel>(level));
+
+                    std::vector<uint8_t> result(out_fmt.image_byte_size());
+                    converter.convert(src.data(), result.data());
+
+                    BOOST_CHECK_MESSAGE(
+                        std::memcmp(
+                            expected.data(), 
+                            result.data(), 
+                            result.size()) == 0,
+                        "SIMD level " << converter.simd_level() << 
+                        " differs from scalar for " << out_fmt.pixel_format() <<
+                        ", filter " << filter << ", linear " << linear);
+
+                }
+            }
+        }
+    }
+
+}
+
+BOOST_AUTO_TEST_CASE(BlackEncodesToBlack) {
+
+    auto in_fmt = make_format(fb::ImageFormat::PixelFormat::RGBA_FLOAT_32BIT);
+    auto out_fmt = make_format(fb::ImageFormat::PixelFormat::YUV_10BIT_V210);
+
+    std::vector<float> src(kTestWidth * kTestHeight * 4, .0f);
+    std::vector<uint8_t> dst(out_fmt.image_byte_size());
+
+    fb::CpuFormatConverter converter(
+        in_fmt, 
+        out_fmt, 
+        fb::ChromaFilter::high, 
+        true, 
+        fb::cpu::max_simd_level());
+
+    converter.convert(reinterpret_cast<const uint8_t*>(src.data()), dst.data());
+
+    const uint32_t expected[4] = {
+        512 | (64 << 10) | (512 << 20),
+        64 | (512 << 10) | (64 << 20),
+        512 | (64 << 10) | (512 << 20),
+        64 | (512 << 10) | (64 << 20)
+    };
+
+    for (size_t i = 0; i < dst.size(); i += 16) {
+        BOOST_REQUIRE(std::memcmp(&dst[i], expected, 16) == 0);
+    }
+
+}
+
+BOOST_AUTO_TEST_CASE(EncodingSimdLevelsAreBitExact) {
+
+    auto out_fmt = make_format(fb::ImageFormat::PixelFormat::YUV_10BIT_V210);
+
+    const fb::ChromaFilter filters[] = {
+        fb::ChromaFilter::none,
+        fb::ChromaFilter::basic,
+        fb::ChromaFilter::high
+    };
+
+    for (auto pixel_format : kRgbaFormats) {
+        auto in_fmt = make_format(pixel_format);
+        auto src = random_rgba_frame(in_fmt);
+        for (auto filter : filters) {
+            for (bool linear : { false, true }) {
+
+                fb::CpuFormatConverter reference(
+                    in_fmt, out_fmt, filter, linear, fb::cpu::SimdLevel::scalar);
+
+                std::vector<uint8_t> expected(out_fmt.image_byte_size());
+                reference.convert(src.data(), expected.data());
+
+                for (int32_t level = 1; 
+                     level <= static_cast<int32_t>(fb::cpu::max_simd_level()); 
+                     ++level) {
+
+                    fb::CpuFormatConverter converter(
+                        in_fmt, 
+                        out_fmt, 
+                        filter, 
+                        linear, 
+                        static_cast<fb::cpu::SimdLevel>(level));
+
+                    std::vector<uint8_t> result(out_fmt.image_byte_size());
+                    converter.convert(src.data(), result.data());
+
+                    BOOST_CHECK_MESSAGE(
+                        std::memcmp(
+                            expected.data(), 
+                            result.data(), 
+                            result.size()) == 0,
+                        "SIMD level " << converter.simd_level() << 
+                        " differs from scalar for " << in_fmt.pixel_format() <<
+                        ", filter " << filter << ", linear " << linear);
+
+                }
+            }
+        }
+    }
+
+}
+
+// Decoding the encoded frame again must give back the original Y'CbCr 
+// values, as long as the chroma is constant (i.e. the filters don't change 
+// anything). 
+BOOST_AUTO_TEST_CASE(RoundTripOfFlatChroma) {
+
+    auto v210_fmt = make_format(fb::ImageFormat::PixelFormat::YUV_10BIT_V210);
+    auto rgba_fmt = make_format(fb::ImageFormat::PixelFormat::RGBA_FLOAT_32BIT);
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint32_t> luma(64, 940);
+
+    std::vector<uint8_t> src(v210_fmt.image_byte_size());
+    for (size_t i = 0; i < src.size(); i += 16) {
+        const uint32_t cb = 400;
+        const uint32_t cr = 600;
+        const uint32_t words[4] = {
+            cb | (luma(rng) << 10) | (cr << 20),
+            luma(rng) | (cb << 10) | (luma(rng) << 20),
+            cr | (luma(rng) << 10) | (cb << 20),
+            luma(rng) | (cr << 10) | (luma(rng) << 20)
+        };
+        std::memcpy(&src[i], words, 16);
+    }
+
+    std::vector<uint8_t> rgba(rgba_fmt.image_byte_size());
+    std::vector<uint8_t> result(v210_fmt.image_byte_size());
+
+    fb::CpuFormatConverter decoder(
+        v210_fmt, rgba_fmt, fb::ChromaFilter::high, false, fb::cpu::max_simd_level());
+    fb::CpuFormatConverter encoder(
+        rgba_fmt, v210_fmt, fb::ChromaFilter::high, false, fb::cpu::max_simd_level());
+
+    decoder.convert(src.data(), rgba.data());
+    encoder.convert(rgba.data(), result.data());
+
+    BOOST_CHECK(std::memcmp(src.data(), result.data(), src.size()) == 0);
+
+}
+
+// The stripes are converted independently, splitting the image must not 
+// change the result.
+BOOST_AUTO_TEST_CASE(StripesMatchSingleThreaded) {
+
+    auto v210_fmt = make_format(fb::ImageFormat::PixelFormat::YUV_10BIT_V210);
+    auto rgba_fmt = make_format(fb::ImageFormat::PixelFormat::RGBA_16BIT);
+
+    auto v210_src = random_v210_frame(v210_fmt);
+    auto rgba_src = random_rgba_frame(rgba_fmt);
+
+    const std::pair<fb::ImageFormat, fb::ImageFormat> directions[] = {
+        std::make_pair(v210_fmt, rgba_fmt),
+        std::make_pair(rgba_fmt, v210_fmt)
+    };
+
+    for (const auto& direction : directions) {
+
+        const auto& src = direction.first == v210_fmt ? v210_src : rgba_src;
+
+        fb::CpuFormatConverter reference(
+            direction.first, 
+            direction.second, 
+            fb::ChromaFilter::high, 
+            false, 
+            fb::cpu::max_simd_level());
+
+        std::vector<uint8_t> expected(direction.second.image_byte_size());
+        reference.convert(src.data(), expected.data());
+
+        // Includes an uneven split and more threads than rows
+        for (size_t num_threads : { 2, 3, 8, 16 }) {
+
+            fb::CpuFormatConverter converter(
+                direction.first, 
+                direction.second, 
+                fb::ChromaFilter::high, 
+                false, 
+                fb::cpu::max_simd_level(),
+                num_threads);
+
+            const size_t num_stripes = converter.num_stripes();
+            BOOST_CHECK_EQUAL(num_stripes, std::min<size_t>(num_threads, kTestHeight));
+
+            std::vector<size_t> num_samples(num_stripes, 0);
+            std::vector<fb::SampleFunction> functions;
+            for (size_t i = 0; i < num_stripes; ++i) {
+                functions.push_back([&num_samples, i](fb::StageExecutionState) {
+                    ++num_samples[i];
+                });
+            }
+            converter.set_stripe_sample_functions(std::move(functions));
+
+            std::vector<uint8_t> result(direction.second.image_byte_size());
+            converter.convert(src.data(), result.data());
+
+            BOOST_CHECK_MESSAGE(
+                std::memcmp(expected.data(), result.data(), result.size()) == 0,
+                "Striped conversion to " << direction.second.pixel_format() << 
+                " with " << num_threads << " threads differs.");
+
+            // TASK_BEGIN and TASK_END for every stripe
+            for (size_t count : num_samples) {
+                BOOST_CHECK_EQUAL(count, 2);
+            }
+
+        }
+
+    }
+
+}
+
+BOOST_AUTO_TEST_CASE(ComparatorFindsKnownErrors) {
+
+    auto fmt = make_format(fb::ImageFormat::PixelFormat::YUV_10BIT_V210);
+    auto reference = random_v210_frame(fmt);
+    auto candidate = reference;
+
+    // Cr_2 of group 3 in row 5 (word 2, component 0), and Y'_5 of the very 
+    // last group
+    const size_t row_size = fmt.image_byte_size() / fmt.height();
+    uint32_t word;
+
+    const size_t first_offset = 5 * row_size + 3 * 16 + 2 * 4;
+    std::memcpy(&word, &candidate[first_offset], 4);
+    const int32_t first_value = static_cast<int32_t>(word & 0x3FF);
+    const int32_t first_changed = first_value > 500 ? first_value - 7 : first_value + 7;
+    word = (word & ~0x3FFu) | static_cast<uint32_t>(first_changed);
+    std::memcpy(&candidate[first_offset], &word, 4);
+
+    const size_t last_offset = candidate.size() - 4;
+    std::memcpy(&word, &candidate[last_offset], 4);
+    const int32_t last_value = static_cast<int32_t>((word >> 20) & 0x3FF);
+    const int32_t last_changed = last_value > 500 ? last_value - 3 : last_value + 3;
+    word = (word & ~(0x3FFu << 20)) | (static_cast<uint32_t>(last_changed) << 20);
+    std::memcpy(&candidate[last_offset], &word, 4);
+
+    fb::V210Comparator comparator(3, fb::cpu::max_simd_level());
+
+    auto result = comparator.compare(fmt, reference.data(), candidate.data(), 2);
+
+    BOOST_CHECK(result.reference_in_range);
+    BOOST_CHECK(result.candidate_in_range);
+    BOOST_CHECK(!result.is_within(2));
+    BOOST_CHECK(result.is_within(7));
+    BOOST_CHECK_EQUAL(result.max_error, 7);
+
+    BOOST_CHECK_EQUAL(result.first_mismatch.row, 5);
+    BOOST_CHECK_EQUAL(result.first_mismatch.word, 3 * 4 + 2);
+    BOOST_CHECK_EQUAL(result.first_mismatch.component, 0);
+    BOOST_CHECK_EQUAL(result.first_mismatch.reference_value, first_value);
+    BOOST_CHECK_EQUAL(result.first_mismatch.candidate_value, first_changed);
+
+    const double num_samples = static_cast<double>(kTestWidth) * kTestHeight;
+
+    BOOST_CHECK_EQUAL(result.channels[0].max_error, 3);
+    BOOST_CHECK_CLOSE(result.channels[0].mean_squared_error, 9.0 / num_samples, 1e-9);
+    BOOST_CHECK_EQUAL(result.channels[1].max_error, 0);
+    BOOST_CHECK(std::isinf(result.channels[1].psnr));
+    BOOST_CHECK_EQUAL(result.channels[2].max_error, 7);
+    BOOST_CHECK_CLOSE(result.channels[2].mean_squared_error, 49.0 / (num_samples / 2), 1e-9);
+
+    // Zero is a reserved code
+    reference[0] = 0;
+    reference[1] &= 0xFC;
+    result = comparator.compare(fmt, reference.data(), candidate.data(), 1023);
+    BOOST_CHECK(!result.reference_in_range);
+    BOOST_CHECK(result.candidate_in_range);
+
+}
+
+BOOST_AUTO_TEST_CASE(ComparatorSimdLevelsAndThreadsAgree) {
+
+    auto fmt = make_format(fb::ImageFormat::PixelFormat::YUV_10BIT_V210);
+    auto reference = random_v210_frame(fmt);
+
+    // Different seed than random_v210_frame()
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<uint32_t> component(0, 1023);
+    std::vector<uint8_t> candidate(reference.size());
+    for (size_t i = 0; i < candidate.size(); i += 4) {
+        const uint32_t word = 
+            component(rng) | (component(rng) << 10) | (component(rng) << 20);
+        std::memcpy(&candidate[i], &word, 4);
+    }
+
+    fb::V210Comparator reference_comparator(1, fb::cpu::SimdLevel::scalar);
+    auto expected = reference_comparator.compare(fmt, reference.data(), candidate.data(), 100);
+
+    for (int32_t level = 0; 
+         level <= static_cast<int32_t>(fb::cpu::max_simd_level()); 
+         ++level) {
+        for (size_t num_threads : { 1, 3 }) {
+
+            fb::V210Comparator comparator(num_threads, static_cast<fb::cpu::SimdLevel>(level));
+            auto result = comparator.compare(fmt, reference.data(), candidate.data(), 100);
+
+            BOOST_CHECK_EQUAL(result.max_error, expected.max_error);
+            BOOST_CHECK_EQUAL(result.candidate_in_range, expected.candidate_in_range);
+            BOOST_CHECK_EQUAL(result.first_mismatch.word, expected.first_mismatch.word);
+            BOOST_CHECK_EQUAL(result.first_mismatch.component, expected.first_mismatch.component);
+
+            for (size_t c = 0; c < 3; ++c) {
+                BOOST_CHECK_EQUAL(result.channels[c].min_error, expected.channels[c].min_error);
+                BOOST_CHECK_EQUAL(result.channels[c].max_error, expected.channels[c].max_error);
+                BOOST_CHECK_EQUAL(result.channels[c].mean_squared_error, expected.channels[c].mean_squared_error);
+            }
+
+        }
+    }
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,176 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "PrecompileTest.h"
+
+#include <vector>
+#include <stdexcept>
+
+#include <boost/test/unit_test.hpp>
+
+#include "FifoSampler.h"
+#include "Stage.h"
+
+namespace fb = toa::frame_bender;
+
+using namespace fb;
+
+namespace {
+
+    clock::time_point at_ns(int64_t ns) {
+        return clock::time_point(clock::duration(ns));
+    }
+
+}
+
+BOOST_AUTO_TEST_SUITE(FifoSamplerTests)
+
+BOOST_AUTO_TEST_CASE(RecordsPushesAndPops) {
+
+    FifoSampler sampler("A -> B", 4);
+
+    BOOST_CHECK_EQUAL(sampler.name(), "A -> B");
+    BOOST_CHECK_EQUAL(sampler.capacity(), 4);
+
+    sampler.enter_push(at_ns(100), 1);
+    sampler.enter_push(at_ns(120), 2);
+    sampler.enter_pop(at_ns(150), 1, at_ns(100));
+
+    // Tokens that were in the queue from the start have no enqueue time
+    sampler.enter_pop(at_ns(160), 0, clock::time_point());
+
+    BOOST_REQUIRE_EQUAL(sampler.number_of_push_events(), 2);
+    BOOST_REQUIRE_EQUAL(sampler.number_of_pop_events(), 2);
+
+    BOOST_CHECK(sampler.get_push_event(1).time == at_ns(120));
+    BOOST_CHECK_EQUAL(sampler.get_push_event(1).occupancy, 2);
+
+    BOOST_CHECK(sampler.get_pop_event(0).time == at_ns(150));
+    BOOST_CHECK_EQUAL(sampler.get_pop_event(0).occupancy, 1);
+    BOOST_CHECK(sampler.get_pop_event(0).dwell_time == clock::duration(50));
+    BOOST_CHECK(sampler.get_pop_event(1).dwell_time < clock::duration::zero());
+
+    BOOST_CHECK_THROW(sampler.get_push_event(2), std::invalid_argument);
+    BOOST_CHECK_THROW(sampler.get_pop_event(2), std::invalid_argument);
+
+}
+
+BOOST_AUTO_TEST_CASE(CountsOverflow) {
+
+    FifoSampler sampler("A -> B", 2);
+
+    const size_t num_max_events = FifoSampler::kNumMaxTraceEvents;
+    const size_t num_events = num_max_events + 5;
+
+    for (size_t i = 0; i<num_events; ++i) {
+        sampler.enter_push(at_ns(static_cast<int64_t>(i * 10)), 1);
+        sampler.enter_pop(at_ns(static_cast<int64_t>(i * 10 + 5)), 0, at_ns(static_cast<int64_t>(i * 10)));
+    }
+
+    BOOST_CHECK_EQUAL(sampler.number_of_push_events(), num_max_events);
+    BOOST_CHECK_EQUAL(sampler.number_of_pop_events(), num_max_events);
+    BOOST_CHECK_EQUAL(sampler.push_overflow(), 5);
+    BOOST_CHECK_EQUAL(sampler.pop_overflow(), 5);
+
+}
+
+BOOST_AUTO_TEST_CASE(SamplesStageQueues) {
+
+    const size_t pipeline_size = 4;
+    const size_t num_elements = 10;
+
+    size_t num_produced = 0;
+
+    auto producer = utils::create_producer_stage<size_t>(
+        "Produce",
+        [&](size_t& out_element){
+
+            if (num_produced == num_elements)
+                return StageCommand::STOP_EXECUTION;
+
+            out_element = num_produced++;
+            return StageCommand::NO_CHANGE;
+
+        },
+        std::vector<size_t>(pipeline_size)
+    );
+
+    std::vector<size_t> consumed;
+
+    auto consumer = utils::create_consumer_stage<decltype(producer)>(
+        "Consume",
+        [&](size_t& in_element){
+            consumed.push_back(in_element);
+            return StageCommand::NO_CHANGE;
+        },
+        producer
+    );
+
+    // A producer has no input queues
+    BOOST_CHECK(producer.sample_input_queues().empty());
+
+    auto samplers = consumer.sample_input_queues();
+    BOOST_REQUIRE_EQUAL(samplers.size(), 2);
+
+    const FifoSampler& data_queue = *samplers[0];
+    const FifoSampler& return_queue = *samplers[1];
+
+    BOOST_CHECK_EQUAL(data_queue.name(), "Produce -> Consume");
+    BOOST_CHECK_EQUAL(return_queue.name(), "Consume -> Produce (return)");
+    BOOST_CHECK_EQUAL(return_queue.capacity(), pipeline_size);
+
+    while (consumer.status() == PipelineStatus::READY_TO_EXECUTE) {
+        producer.execute();
+        consumer.execute();
+    }
+
+    BOOST_REQUIRE_EQUAL(consumed.size(), num_elements);
+
+    // One more token for the stop command
+    const size_t num_tokens = num_elements + 1;
+
+    BOOST_REQUIRE_EQUAL(data_queue.number_of_push_events(), num_tokens);
+    BOOST_REQUIRE_EQUAL(data_queue.number_of_pop_events(), num_tokens);
+    BOOST_REQUIRE_EQUAL(return_queue.number_of_push_events(), num_tokens);
+    BOOST_REQUIRE_EQUAL(return_queue.number_of_pop_events(), num_tokens);
+
+    // Executing the stages in turns, the data queue never holds more than 
+    // one token, and the return queue all but one.
+    for (size_t i = 0; i<num_tokens; ++i) {
+
+        BOOST_CHECK_EQUAL(data_queue.get_push_event(i).occupancy, 1);
+        BOOST_CHECK_EQUAL(data_queue.get_pop_event(i).occupancy, 0);
+        BOOST_CHECK(data_queue.get_pop_event(i).dwell_time >= clock::duration::zero());
+        BOOST_CHECK(data_queue.get_pop_event(i).time >= data_queue.get_push_event(i).time);
+
+        BOOST_CHECK_EQUAL(return_queue.get_push_event(i).occupancy, pipeline_size);
+        BOOST_CHECK_EQUAL(return_queue.get_pop_event(i).occupancy, pipeline_size - 1);
+
+        // The initial tokens were never pushed
+        if (i < pipeline_size)
+            BOOST_CHECK(return_queue.get_pop_event(i).dwell_time < clock::duration::zero());
+        else
+            BOOST_CHECK(return_queue.get_pop_event(i).dwell_time >= clock::duration::zero());
+    }
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,165 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "PrecompileTest.h"
+
+#include <vector>
+#include <stdexcept>
+
+#include <boost/test/unit_test.hpp>
+
+#include "FrameCodec.h"
+#include "TestCommon.h"
+
+namespace fb = toa::frame_bender;
+
+using namespace fb;
+
+namespace {
+
+    // Smooth gradients, roughly like graphics or clean footage, plus bits
+    // 30 and 31 set here and there, which the V210 prediction has to pass
+    // through.
+    std::vector<uint32_t> make_v210_image(const ImageFormat& format) {
+
+        std::vector<uint32_t> words(format.image_byte_size() / sizeof(uint32_t));
+
+        const size_t row_size = words.size() / format.height();
+
+        for (size_t i = 0; i<words.size(); ++i) {
+            const uint32_t x = static_cast<uint32_t>(i % row_size);
+            const uint32_t y = static_cast<uint32_t>(i / row_size);
+            const uint32_t c0 = (x + y) & 0x3FF;
+            const uint32_t c1 = (512 + (x >> 2)) & 0x3FF;
+            const uint32_t c2 = (1023 - y) & 0x3FF;
+            words[i] = c0 | (c1 << 10) | (c2 << 20) | ((i % 1001 == 0) ? 0xC0000000 : 0);
+        }
+
+        return words;
+    }
+
+    bool round_trip_is_exact(const uint8_t* data, const ImageFormat& format) {
+
+        auto compressed = frame_codec::compress(data, format);
+
+        std::vector<uint32_t> restored(format.image_byte_size() / sizeof(uint32_t) + 1, 0);
+        frame_codec::decompress(compressed, reinterpret_cast<uint8_t*>(restored.data()), format);
+
+        return std::equal(data, data + format.image_byte_size(), reinterpret_cast<const uint8_t*>(restored.data()));
+    }
+
+}
+
+BOOST_AUTO_TEST_SUITE(FrameCodecTests)
+
+BOOST_AUTO_TEST_CASE(LzRoundTrip) {
+
+    std::vector<std::vector<uint8_t>> inputs;
+
+    inputs.push_back(std::vector<uint8_t>());
+    inputs.push_back(std::vector<uint8_t>(1, 42));
+    inputs.push_back(std::vector<uint8_t>(8, 0));
+    // Long run, i.e. overlapping matches
+    inputs.push_back(std::vector<uint8_t>(100000, 7));
+
+    // Incompressible
+    std::vector<uint8_t> random(70000);
+    uint32_t r = 1;
+    for (auto& b : random) {
+        r = r * 1103515245 + 12345;
+        b = static_cast<uint8_t>(r >> 24);
+    }
+    inputs.push_back(random);
+
+    // Repeats beyond the maximum match offset
+    std::vector<uint8_t> repeated;
+    for (size_t i = 0; i<4; ++i)
+        repeated.insert(repeated.end(), random.begin(), random.end());
+    inputs.push_back(repeated);
+
+    for (const auto& input : inputs) {
+
+        std::vector<uint8_t> compressed;
+        frame_codec::lz_compress(input.data(), input.size(), compressed);
+
+        std::vector<uint8_t> output(input.size());
+        frame_codec::lz_decompress(compressed.data(), compressed.size(), output.data(), output.size());
+
+        BOOST_CHECK_MESSAGE(output == input, "Round trip of " << input.size() << " bytes");
+    }
+
+}
+
+BOOST_AUTO_TEST_CASE(V210RoundTripCompresses) {
+
+    const ImageFormat format = test::horse_seq_v210_1080p_format();
+    auto image = make_v210_image(format);
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(image.data());
+
+    BOOST_REQUIRE(round_trip_is_exact(data, format));
+
+    auto compressed = frame_codec::compress(data, format);
+    BOOST_TEST_MESSAGE("V210 compressed to " << compressed.size() << " of " << format.image_byte_size() << " bytes.");
+    BOOST_CHECK_LT(compressed.size() * 2, format.image_byte_size());
+
+}
+
+BOOST_AUTO_TEST_CASE(RGBRoundTrip) {
+
+    const ImageFormat format = test::ducks_seq_rgb24_1080p_format();
+
+    std::vector<uint8_t> image(format.image_byte_size());
+    for (size_t i = 0; i<image.size(); ++i)
+        image[i] = static_cast<uint8_t>((i / 3) % 1920 / 8 + i % 3);
+
+    BOOST_REQUIRE(round_trip_is_exact(image.data(), format));
+
+}
+
+BOOST_AUTO_TEST_CASE(CorruptInputThrows) {
+
+    const ImageFormat format = test::horse_seq_v210_1080p_format();
+    auto image = make_v210_image(format);
+
+    auto compressed = frame_codec::compress(reinterpret_cast<const uint8_t*>(image.data()), format);
+
+    std::vector<uint32_t> restored(image.size());
+    uint8_t* out = reinterpret_cast<uint8_t*>(restored.data());
+
+    auto truncated = compressed;
+    truncated.resize(truncated.size() / 2);
+    BOOST_CHECK_THROW(frame_codec::decompress(truncated, out, format), std::runtime_error);
+
+    auto unknown_predictor = compressed;
+    unknown_predictor[0] = 0xFF;
+    BOOST_CHECK_THROW(frame_codec::decompress(unknown_predictor, out, format), std::runtime_error);
+
+    BOOST_CHECK_THROW(frame_codec::decompress(std::vector<uint8_t>(), out, format), std::runtime_error);
+
+    // Frames are only restored for the format they have been compressed for
+    const ImageFormat other_format = test::ducks_seq_rgb24_1080p_format();
+    std::vector<uint8_t> other_restored(other_format.image_byte_size());
+    BOOST_CHECK_THROW(frame_codec::decompress(compressed, other_restored.data(), other_format), std::runtime_error);
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,255 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "PrecompileTest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "Frame.h"
+#include "FramePool.h"
+
+namespace fb = toa::frame_bender;
+
+using namespace fb;
+
+namespace {
+
+    ImageFormat make_format(uint32_t width, uint32_t height) {
+
+        return ImageFormat(
+            width,
+            height,
+            ImageFormat::Transfer::BT_709,
+            ImageFormat::Chromaticity::BT_709,
+            ImageFormat::PixelFormat::YUV_10BIT_V210,
+            ImageFormat::Origin::LOWER_LEFT);
+
+    }
+
+    FramePool::Statistics statistics_for(const FramePool& pool, size_t byte_size) {
+
+        for (const auto& stats : pool.statistics()) {
+            if (stats.byte_size == byte_size)
+                return stats;
+        }
+
+        BOOST_FAIL("No statistics for the requested byte size.");
+        return FramePool::Statistics();
+    }
+
+}
+
+BOOST_AUTO_TEST_SUITE(FramePoolTests)
+
+BOOST_AUTO_TEST_CASE(FreeListTest) {
+
+    detail::BufferFreeList free_list(5);
+
+    BOOST_CHECK_EQUAL(free_list.capacity(), 8);
+
+    std::vector<uint8_t> storage(free_list.capacity());
+
+    for (auto& el : storage)
+        BOOST_CHECK(free_list.push(&el));
+
+    // Full
+    BOOST_CHECK(!free_list.push(nullptr));
+
+    uint8_t* data = nullptr;
+    for (auto& el : storage) {
+        BOOST_REQUIRE(free_list.pop(data));
+        BOOST_CHECK(data == &el);
+    }
+
+    // Empty
+    BOOST_CHECK(!free_list.pop(data));
+
+}
+
+BOOST_AUTO_TEST_CASE(FreeListConcurrentTest) {
+
+    const size_t num_threads = 4;
+    const size_t num_rounds = 100000;
+
+    detail::BufferFreeList free_list(num_threads);
+    std::vector<uint8_t> storage(num_threads);
+
+    for (auto& el : storage)
+        BOOST_REQUIRE(free_list.push(&el));
+
+    // Every thread takes a buffer out and puts it back again, no buffer 
+    // may ever get lost or duplicated.
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads.push_back(std::thread([&]{
+            uint8_t* data = nullptr;
+            for (size_t j = 0; j < num_rounds; ++j) {
+                while (!free_list.pop(data))
+                    std::this_thread::yield();
+                ++(*data);
+                while (!free_list.push(data))
+                    std::this_thread::yield();
+            }
+        }));
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    std::vector<uint8_t*> popped;
+    uint8_t* data = nullptr;
+    while (free_list.pop(data))
+        popped.push_back(data);
+
+    BOOST_CHECK_EQUAL(popped.size(), num_threads);
+
+    std::sort(popped.begin(), popped.end());
+    BOOST_CHECK(std::unique(popped.begin(), popped.end()) == popped.end());
+
+}
+
+BOOST_AUTO_TEST_CASE(RecyclesFrameMemory) {
+
+    FramePool pool;
+    const ImageFormat format = make_format(1920, 8);
+
+    const uint8_t* first_data = nullptr;
+
+    {
+        Frame f(format, Time(0, 1), false, pool);
+        BOOST_REQUIRE(f.is_valid());
+        BOOST_CHECK(MEM_IS_ALIGNED(f.image_data(), FramePool::kAlignment));
+        first_data = f.image_data();
+    }
+
+    // Moving must not release the memory
+    Frame f(format, Time(0, 1), false, pool);
+    Frame moved(std::move(f));
+
+    BOOST_CHECK(moved.image_data() == first_data);
+
+    auto stats = statistics_for(pool, format.image_byte_size());
+    BOOST_CHECK_EQUAL(stats.num_allocations, 1);
+    BOOST_CHECK_EQUAL(stats.num_hits, 1);
+    BOOST_CHECK_EQUAL(stats.num_frees, 0);
+
+}
+
+BOOST_AUTO_TEST_CASE(SteadyStateDoesNotAllocate) {
+
+    FramePool pool;
+    const ImageFormat format = make_format(1920, 8);
+    const size_t num_in_flight = 4;
+
+    Frame source(format, Time(0, 1), false, pool);
+
+    // Like an output callback keeping the last few copies around
+    std::vector<Frame> in_flight(num_in_flight);
+
+    for (size_t i = 0; i < 1000; ++i) {
+        Frame copy(format, Time(static_cast<int64_t>(i), 1), false, pool);
+        memcpy(copy.image_data(), source.image_data(), source.image_data_size());
+        in_flight[i % num_in_flight] = std::move(copy);
+    }
+
+    auto stats = statistics_for(pool, format.image_byte_size());
+    // The source, all in-flight copies and the one being written
+    BOOST_CHECK_EQUAL(stats.num_allocations, num_in_flight + 2);
+    BOOST_CHECK_EQUAL(stats.num_hits + stats.num_allocations, 1001);
+
+}
+
+BOOST_AUTO_TEST_CASE(KeyedByFormatAndBounded) {
+
+    const size_t max_cached = 2;
+    FramePool pool(max_cached);
+
+    const ImageFormat small_format = make_format(1920, 8);
+    const ImageFormat large_format = make_format(1920, 16);
+
+    pool.reserve(small_format.image_byte_size(), 1);
+
+    {
+        std::vector<Frame> frames;
+        for (size_t i = 0; i < 4; ++i)
+            frames.push_back(Frame(large_format, Time(0, 1), false, pool));
+
+        frames.push_back(Frame(small_format, Time(0, 1), false, pool));
+    }
+
+    auto small_stats = statistics_for(pool, small_format.image_byte_size());
+    BOOST_CHECK_EQUAL(small_stats.num_allocations, 1);
+    BOOST_CHECK_EQUAL(small_stats.num_hits, 1);
+    BOOST_CHECK_EQUAL(small_stats.num_frees, 0);
+
+    // Only two large buffers fit into the cache
+    auto large_stats = statistics_for(pool, large_format.image_byte_size());
+    BOOST_CHECK_EQUAL(large_stats.num_allocations, 4);
+    BOOST_CHECK_EQUAL(large_stats.num_frees, 2);
+
+}
+
+BOOST_AUTO_TEST_CASE(HugePageCopyBenchmark) {
+
+    // A 2160p V210 frame is about 22 MB
+    const ImageFormat format = make_format(3840, 2160);
+    const size_t num_copies = 20;
+
+    const HugePages modes[] = { HugePages::OFF, HugePages::TRANSPARENT, HugePages::EXPLICIT };
+
+    for (HugePages mode : modes) {
+
+        FramePool pool(2, mode);
+
+        Frame source(format, Time(0, 1), false, pool);
+        Frame destination(format, Time(0, 1), false, pool);
+
+        BOOST_REQUIRE(MEM_IS_ALIGNED(source.image_data(), FramePool::kAlignment));
+        BOOST_REQUIRE(MEM_IS_ALIGNED(destination.image_data(), FramePool::kAlignment));
+
+        for (size_t i = 0; i < source.image_data_size(); ++i)
+            source.image_data()[i] = static_cast<uint8_t>(i);
+
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        for (size_t i = 0; i < num_copies; ++i)
+            memcpy(destination.image_data(), source.image_data(), source.image_data_size());
+
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        BOOST_CHECK(memcmp(destination.image_data(), source.image_data(), source.image_data_size()) == 0);
+
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        const double gb_per_second = static_cast<double>(source.image_data_size() * num_copies) / seconds / 1e9;
+
+        std::cout << "Frame copy with huge pages '" << mode << "': " << gb_per_second << " GB/s." << std::endl;
+
+    }
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,176 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "PrecompileTest.h"
+
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "FrameWriter.h"
+#include "HostCopy.h"
+
+namespace fb = toa::frame_bender;
+namespace bf = boost::filesystem;
+
+using namespace fb;
+
+namespace {
+
+    ImageFormat small_format() {
+        return ImageFormat(
+            48, 
+            4, 
+            ImageFormat::Transfer::BT_709,
+            ImageFormat::Chromaticity::BT_709,
+            ImageFormat::PixelFormat::YUV_10BIT_V210,
+            ImageFormat::Origin::UPPER_LEFT);
+    }
+
+    std::vector<Frame> make_frames(size_t count) {
+
+        std::vector<Frame> frames;
+
+        for (size_t i = 0; i<count; ++i) {
+            Frame f(small_format(), Time(static_cast<int64_t>(i), 50), i + 1 == count);
+            for (size_t j = 0; j<f.image_data_size(); ++j)
+                f.image_data()[j] = static_cast<uint8_t>(i * 31 + j);
+            frames.push_back(std::move(f));
+        }
+
+        return frames;
+    }
+
+    std::vector<uint8_t> read_file(const bf::path& path) {
+        std::vector<uint8_t> data(static_cast<size_t>(bf::file_size(path)));
+        bf::ifstream in(path, std::ios::in | std::ios::binary);
+        in.read(reinterpret_cast<char*>(data.data()), data.size());
+        return data;
+    }
+
+    std::vector<uint8_t> swapped(const Frame& f, size_t word_size) {
+        std::vector<uint8_t> data(f.image_data(), f.image_data() + f.image_data_size());
+        host_copy::swap_bytes(data.data(), data.size(), word_size);
+        return data;
+    }
+
+    class TemporaryFolder {
+    public:
+        TemporaryFolder() : path_(bf::temp_directory_path() / bf::unique_path("fb-writer-%%%%-%%%%")) {}
+        ~TemporaryFolder() { bf::remove_all(path_); }
+        const bf::path& path() const { return path_; }
+    private:
+        bf::path path_;
+    };
+
+}
+
+BOOST_AUTO_TEST_SUITE(FrameWriterTests)
+
+BOOST_AUTO_TEST_CASE(FilePerFrame) {
+
+    TemporaryFolder folder;
+    auto frames = make_frames(20);
+
+    {
+        // A queue of one and two writers, so that write() has to wait
+        FrameWriter writer(folder.path().string(), OutputLayout::FILE_PER_FRAME, true, 4, 1, 2);
+
+        for (const auto& f : frames)
+            writer.write(f);
+
+        writer.flush();
+
+        BOOST_REQUIRE_EQUAL(writer.num_frames_queued(), frames.size());
+        BOOST_REQUIRE_EQUAL(writer.num_frames_written(), frames.size());
+
+        BOOST_TEST_MESSAGE("Backpressure stalls: " << writer.num_backpressure_stalls());
+    }
+
+    for (size_t i = 0; i<frames.size(); ++i) {
+        std::ostringstream oss;
+        oss << std::setfill('0') << std::setw(8) << i << ".raw";
+        BOOST_CHECK(read_file(folder.path() / oss.str()) == swapped(frames[i], 4));
+    }
+
+}
+
+#ifndef _WIN32
+
+BOOST_AUTO_TEST_CASE(SingleFile) {
+
+    TemporaryFolder folder;
+    auto frames = make_frames(37);
+
+    {
+        // Preallocates past the last frame, which has to be cut off again
+        FrameWriter writer(folder.path().string(), OutputLayout::SINGLE_FILE, false, 2, 4, 3, 16);
+
+        for (const auto& f : frames)
+            writer.write(f);
+
+        // Frames are written from copies, so this mustn't change the output
+        for (auto& f : frames)
+            std::fill(f.image_data(), f.image_data() + f.image_data_size(), 0);
+    }
+
+    auto expected = make_frames(frames.size());
+
+    const size_t frame_size = small_format().image_byte_size();
+    auto contents = read_file(folder.path() / FrameWriter::kSingleFileName);
+
+    BOOST_REQUIRE_EQUAL(contents.size(), expected.size() * frame_size);
+
+    for (size_t i = 0; i<expected.size(); ++i) {
+        BOOST_CHECK(std::equal(
+            expected[i].image_data(), 
+            expected[i].image_data() + frame_size, 
+            contents.begin() + i * frame_size));
+    }
+
+}
+
+#endif
+
+BOOST_AUTO_TEST_CASE(WriteErrorsAreRethrown) {
+
+    TemporaryFolder folder;
+    auto frames = make_frames(1);
+
+    FrameWriter writer(folder.path().string(), OutputLayout::FILE_PER_FRAME);
+
+    // The writer can't create its files anymore
+    bf::remove_all(folder.path());
+    boost::filesystem::ofstream(folder.path()) << "not a folder";
+
+    writer.write(frames.front());
+
+    BOOST_CHECK_THROW(writer.flush(), std::runtime_error);
+    BOOST_CHECK_THROW(writer.write(frames.front()), std::runtime_error);
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
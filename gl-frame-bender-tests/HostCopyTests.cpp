@@ -0,0 +1,165 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "PrecompileTest.h"
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/test/unit_test.hpp>
+
+#include "HostCopy.h"
+
+namespace fb = toa::frame_bender;
+
+using namespace fb;
+
+namespace {
+
+    std::vector<HostCopyKernel> supported_kernels() {
+
+        std::vector<HostCopyKernel> kernels;
+        for (int32_t i = 0; i <= static_cast<int32_t>(host_copy::max_kernel()); ++i)
+            kernels.push_back(HostCopyKernel(i));
+
+        return kernels;
+    }
+
+    // Copies byte_size bytes between buffers at the given misalignments, and
+    // checks that exactly the destination range has been written.
+    bool copy_is_exact(
+        HostCopyEngine& engine, 
+        size_t byte_size, 
+        size_t src_offset, 
+        size_t dst_offset)
+    {
+        const size_t kGuard = 64;
+
+        std::vector<uint8_t> src(byte_size + src_offset);
+        std::vector<uint8_t> dst(byte_size + dst_offset + kGuard, 0xAB);
+
+        for (size_t i = 0; i<src.size(); ++i)
+            src[i] = static_cast<uint8_t>(i * 7 + i / 251);
+
+        engine.copy(dst.data() + dst_offset, src.data() + src_offset, byte_size);
+
+        for (size_t i = 0; i<dst_offset; ++i) {
+            if (dst[i] != 0xAB)
+                return false;
+        }
+
+        for (size_t i = 0; i<byte_size; ++i) {
+            if (dst[dst_offset + i] != src[src_offset + i])
+                return false;
+        }
+
+        for (size_t i = dst_offset + byte_size; i<dst.size(); ++i) {
+            if (dst[i] != 0xAB)
+                return false;
+        }
+
+        return true;
+    }
+
+}
+
+BOOST_AUTO_TEST_SUITE(HostCopyTests)
+
+BOOST_AUTO_TEST_CASE(KernelsCopyExactly) {
+
+    // Sizes around the kernels' block sizes and a frame-sized one
+    const size_t sizes[] = { 0, 1, 15, 31, 63, 64, 127, 128, 129, 4095, 65537, 1920 * 1080 * 8 / 3 };
+
+    for (auto kernel : supported_kernels()) {
+
+        HostCopyEngine engine(kernel);
+        BOOST_REQUIRE(engine.kernel() == kernel);
+
+        for (auto size : sizes) {
+            for (size_t src_offset = 0; src_offset < 3; ++src_offset) {
+                for (size_t dst_offset = 0; dst_offset < 35; dst_offset += 17) {
+                    BOOST_CHECK_MESSAGE(
+                        copy_is_exact(engine, size, src_offset, dst_offset), 
+                        "Kernel '" << kernel << "', size " << size << ", offsets " << src_offset << "/" << dst_offset);
+                }
+            }
+        }
+    }
+
+}
+
+BOOST_AUTO_TEST_CASE(SplitCopiesCopyExactly) {
+
+    for (auto kernel : supported_kernels()) {
+
+        // Small split size, so that the chunking is exercised with uneven 
+        // remainders as well
+        HostCopyEngine engine(kernel, 3, 1000);
+        BOOST_REQUIRE_EQUAL(engine.num_threads(), 3);
+
+        const size_t sizes[] = { 999, 1000, 1001, 4096 * 3 + 5, 1920 * 1080 * 8 / 3 };
+
+        for (auto size : sizes) {
+            BOOST_CHECK_MESSAGE(
+                copy_is_exact(engine, size, 1, 7), 
+                "Kernel '" << kernel << "', size " << size);
+        }
+    }
+
+}
+
+BOOST_AUTO_TEST_CASE(SwapBytesReversesWords) {
+
+    const size_t word_sizes[] = { 1, 2, 3, 4, 8 };
+    // Around the vector widths, plus a frame-sized one
+    const size_t num_words[] = { 0, 1, 7, 8, 17, 33, 1920 * 1080 };
+
+    for (auto word_size : word_sizes) {
+        for (auto count : num_words) {
+
+            std::vector<uint8_t> data(word_size * count);
+            for (size_t i = 0; i<data.size(); ++i)
+                data[i] = static_cast<uint8_t>(i * 13 + i / 7);
+
+            std::vector<uint8_t> expected(data);
+            for (size_t i = 0; i<expected.size(); i += word_size)
+                std::reverse(expected.begin() + i, expected.begin() + i + word_size);
+
+            // Unaligned on purpose
+            std::vector<uint8_t> buffer(data.size() + 1);
+            std::copy(data.begin(), data.end(), buffer.begin() + 1);
+
+            host_copy::swap_bytes(buffer.data() + 1, data.size(), word_size);
+
+            BOOST_CHECK_MESSAGE(
+                std::equal(expected.begin(), expected.end(), buffer.begin() + 1),
+                "Word size " << word_size << ", " << count << " words");
+        }
+    }
+
+    std::vector<uint8_t> odd(5);
+    BOOST_CHECK_THROW(host_copy::swap_bytes(odd.data(), odd.size(), 2), std::invalid_argument);
+    BOOST_CHECK_THROW(host_copy::swap_bytes(odd.data(), odd.size(), 0), std::invalid_argument);
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,248 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "PrecompileTest.h"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <boost/test/unit_test.hpp>
+
+#include "LatencyHistogram.h"
+#include "StageSampler.h"
+#include "TestCommon.h"
+
+namespace fb = toa::frame_bender;
+
+using namespace fb;
+
+namespace {
+
+    // The exact value at the percentile, the way LatencyHistogram counts it
+    int64_t exact_value_at_percentile(const std::vector<int64_t>& sorted, double percentile) {
+        size_t count = static_cast<size_t>(percentile / 100.0 * static_cast<double>(sorted.size()) + 0.5);
+        count = std::max(count, size_t(1));
+        return sorted[count - 1];
+    }
+
+    // Within the precision of a histogram with the given significant digits
+    bool is_within_precision(int64_t value, int64_t expected, int32_t significant_digits) {
+        double tolerance = std::max(1.0, static_cast<double>(expected) * std::pow(10.0, -significant_digits));
+        return std::abs(static_cast<double>(value - expected)) <= tolerance;
+    }
+
+    std::vector<int64_t> log_normal_values(size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::lognormal_distribution<double> distribution(11.0, 1.5);
+        std::vector<int64_t> values;
+        for (size_t i = 0; i<count; ++i)
+            values.push_back(static_cast<int64_t>(distribution(rng)));
+        return values;
+    }
+
+    // Restores the global options for other tests
+    struct GlobalOptionsAfterwards {
+        GlobalOptionsAfterwards() : options(ProgramOptions::global()) {}
+        ~GlobalOptionsAfterwards() { ProgramOptions::set_global(options); }
+        ProgramOptions options;
+    };
+
+    ProgramOptions options_with_percentiles(const std::vector<std::string>& percentiles) {
+        std::multimap<std::string, std::string> overrides;
+        for (const auto& p : percentiles)
+            overrides.insert(std::make_pair("profiling.statistics.percentiles", p));
+        return test::get_global_options_with_overrides(overrides);
+    }
+
+}
+
+BOOST_AUTO_TEST_SUITE(LatencyHistogramTests)
+
+BOOST_AUTO_TEST_CASE(PercentilesMatchSortedValues) {
+
+    for (int32_t digits = 1; digits <= 4; ++digits) {
+
+        LatencyHistogram histogram(LatencyHistogram::kDefaultHighestTrackableNs, digits);
+
+        auto values = log_normal_values(100000, 42 + digits);
+        for (int64_t v : values)
+            histogram.record(v);
+
+        std::sort(std::begin(values), std::end(values));
+
+        BOOST_CHECK_EQUAL(histogram.total_count(), values.size());
+        BOOST_CHECK_EQUAL(histogram.minimum(), values.front());
+        BOOST_CHECK_EQUAL(histogram.maximum(), values.back());
+
+        const double percentiles[] = { 0.0, 1.0, 25.0, 50.0, 90.0, 99.0, 99.9, 99.99, 100.0 };
+
+        for (double p : percentiles) {
+            int64_t expected = exact_value_at_percentile(values, p);
+            int64_t value = histogram.value_at_percentile(p);
+            BOOST_CHECK_MESSAGE(
+                is_within_precision(value, expected, digits),
+                "p" << p << " with " << digits << " digits is " << value << ", expected " << expected);
+        }
+    }
+
+}
+
+BOOST_AUTO_TEST_CASE(SmallValuesAreExact) {
+
+    LatencyHistogram histogram;
+
+    for (int64_t v = 0; v<2000; ++v)
+        histogram.record(v);
+
+    BOOST_CHECK_EQUAL(histogram.value_at_percentile(50.0), 999);
+    BOOST_CHECK_EQUAL(histogram.value_at_percentile(100.0), 1999);
+    BOOST_CHECK_EQUAL(histogram.value_at_percentile(0.0), 0);
+
+}
+
+BOOST_AUTO_TEST_CASE(EmptyIsZero) {
+
+    LatencyHistogram histogram;
+
+    BOOST_CHECK_EQUAL(histogram.total_count(), 0);
+    BOOST_CHECK_EQUAL(histogram.minimum(), 0);
+    BOOST_CHECK_EQUAL(histogram.maximum(), 0);
+    BOOST_CHECK_EQUAL(histogram.value_at_percentile(99.0), 0);
+
+}
+
+BOOST_AUTO_TEST_CASE(ClampsOutOfRangeValues) {
+
+    const int64_t highest = 1000000;
+    LatencyHistogram histogram(highest, 3);
+
+    histogram.record(-5);
+    histogram.record(highest * 10);
+
+    BOOST_CHECK_EQUAL(histogram.total_count(), 2);
+    BOOST_CHECK_EQUAL(histogram.minimum(), -5);
+    BOOST_CHECK_EQUAL(histogram.maximum(), highest * 10);
+    BOOST_CHECK(is_within_precision(histogram.value_at_percentile(100.0), highest, 3));
+
+}
+
+BOOST_AUTO_TEST_CASE(MergeEqualsCombinedRecording) {
+
+    auto a_values = log_normal_values(20000, 1);
+    auto b_values = log_normal_values(30000, 2);
+
+    LatencyHistogram a;
+    LatencyHistogram b;
+    LatencyHistogram combined;
+
+    for (int64_t v : a_values) { a.record(v); combined.record(v); }
+    for (int64_t v : b_values) { b.record(v); combined.record(v); }
+
+    a.merge(b);
+
+    BOOST_CHECK_EQUAL(a.total_count(), combined.total_count());
+    BOOST_CHECK_EQUAL(a.minimum(), combined.minimum());
+    BOOST_CHECK_EQUAL(a.maximum(), combined.maximum());
+
+    BOOST_REQUIRE_EQUAL(a.num_counts(), combined.num_counts());
+    for (size_t i = 0; i<a.num_counts(); ++i)
+        BOOST_REQUIRE_EQUAL(a.count_at_index(i), combined.count_at_index(i));
+
+    BOOST_CHECK_EQUAL(a.value_at_percentile(99.9), combined.value_at_percentile(99.9));
+
+}
+
+BOOST_AUTO_TEST_CASE(RestoresFromCounts) {
+
+    LatencyHistogram original;
+
+    for (int64_t v : log_normal_values(10000, 3))
+        original.record(v);
+
+    LatencyHistogram restored(original.highest_trackable_ns(), original.significant_digits());
+
+    for (size_t i = 0; i<original.num_counts(); ++i)
+        restored.add_count_at_index(i, original.count_at_index(i));
+
+    BOOST_CHECK_EQUAL(restored.total_count(), original.total_count());
+
+    const double percentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+
+    for (double p : percentiles)
+        BOOST_CHECK_EQUAL(restored.value_at_percentile(p), original.value_at_percentile(p));
+
+    BOOST_CHECK_THROW(restored.add_count_at_index(restored.num_counts(), 1), std::out_of_range);
+
+}
+
+BOOST_AUTO_TEST_CASE(RejectsInvalidLayouts) {
+
+    BOOST_CHECK_THROW(LatencyHistogram(1000, 0), std::invalid_argument);
+    BOOST_CHECK_THROW(LatencyHistogram(1000, 6), std::invalid_argument);
+    BOOST_CHECK_THROW(LatencyHistogram(1, 3), std::invalid_argument);
+
+    LatencyHistogram a(1000000, 3);
+    LatencyHistogram b(1000000, 2);
+    LatencyHistogram c(2000000, 3);
+
+    BOOST_CHECK(!a.has_same_layout(b));
+    BOOST_CHECK(!a.has_same_layout(c));
+    BOOST_CHECK_THROW(a.merge(b), std::invalid_argument);
+    BOOST_CHECK_THROW(a.merge(c), std::invalid_argument);
+
+}
+
+BOOST_AUTO_TEST_CASE(StatisticsCarryPercentiles) {
+
+    GlobalOptionsAfterwards guard;
+
+    ProgramOptions::set_global(options_with_percentiles({ "50", "99" }));
+
+    StageSampler sampler;
+
+    // Deltas of 1 to 1000 us
+    for (int64_t i = 0; i<1000; ++i) {
+        sampler.enter_sample(StageExecutionState::TASK_BEGIN, clock::time_point(clock::duration(i * 10000000)));
+        sampler.enter_sample(StageExecutionState::TASK_END, clock::time_point(clock::duration(i * 10000000 + (i + 1) * 1000)));
+    }
+
+    auto statistic = StageSampler::build_delta_statistic(
+        sampler, StageExecutionState::TASK_BEGIN, 
+        sampler, StageExecutionState::TASK_END);
+
+    BOOST_CHECK_EQUAL(statistic.histogram.total_count(), 1000);
+
+    BOOST_REQUIRE_EQUAL(statistic.percentiles.size(), 2);
+    BOOST_CHECK_EQUAL(statistic.percentiles[0].percentile, 50.0);
+    BOOST_CHECK_EQUAL(statistic.percentiles[1].percentile, 99.0);
+    BOOST_CHECK(is_within_precision(statistic.percentiles[0].value.count(), 500000, 3));
+    BOOST_CHECK(is_within_precision(statistic.percentiles[1].value.count(), 990000, 3));
+    BOOST_CHECK(is_within_precision(statistic.median.count(), 500000, 3));
+
+    BOOST_CHECK_THROW(options_with_percentiles({ "101" }), InvalidInput);
+    BOOST_CHECK_THROW(options_with_percentiles({ "-1" }), InvalidInput);
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
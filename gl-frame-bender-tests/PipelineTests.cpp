@@ -24,9 +24,13 @@
 #include <string>
 #include <numeric>
 #include <future>
+#include <chrono>
+#include <iostream>
 
 #include "Stage.h"
 #include "StageSampler.h"
+#include "StageScheduler.h"
+#include "PipelineStage.h"
 
 #include <boost/test/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
@@ -817,6 +821,187 @@ BOOST_AUTO_TEST_CASE(PassingDataOverOne) {
 
 }
 
+namespace {
+
+    // Runs the producer/consumer pair on the calling thread until the
+    // producer stops, returns the average per-token cost in nanoseconds.
+    template <typename Producer, typename Consumer>
+    double measure_dispatch_overhead(Producer& producer, Consumer& consumer, size_t num_tokens) {
+
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        while (consumer.status() == PipelineStatus::READY_TO_EXECUTE) {
+            producer.execute();
+            consumer.execute();
+        }
+
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        return std::chrono::duration<double, std::nano>(end - start).count() / num_tokens;
+    }
+
+}
+
+BOOST_AUTO_TEST_CASE(StageDispatchOverhead) {
+
+    const size_t num_tokens = 2000000;
+    const size_t pipeline_size = 4;
+
+    // Current core: std::function tasks with an active sampler
+    size_t produced_function = 0;
+    long long sum_function = 0;
+    size_t num_samples = 0;
+
+    auto function_producer = utils::create_producer_stage<int>(
+        "produce_function",
+        [&](int& out){
+            if (produced_function == num_tokens)
+                return StageCommand::STOP_EXECUTION;
+            out = static_cast<int>(produced_function++);
+            return StageCommand::NO_CHANGE;
+        },
+        std::vector<int>(pipeline_size),
+        [&](StageExecutionState){ ++num_samples; });
+
+    auto function_consumer = utils::create_consumer_stage<decltype(function_producer)>(
+        "consume_function",
+        [&](int& in){
+            sum_function += in;
+            return StageCommand::NO_CHANGE;
+        },
+        function_producer,
+        [&](StageExecutionState){ ++num_samples; });
+
+    // New core: concrete callables, sampling compiled away
+    size_t produced_inline = 0;
+    long long sum_inline = 0;
+
+    auto inline_producer = utils::make_producer_stage<int>(
+        "produce_inline",
+        [&](int& out){
+            if (produced_inline == num_tokens)
+                return StageCommand::STOP_EXECUTION;
+            out = static_cast<int>(produced_inline++);
+            return StageCommand::NO_CHANGE;
+        },
+        std::vector<int>(pipeline_size),
+        NoSampling());
+
+    auto inline_consumer = utils::make_consumer_stage(
+        "consume_inline",
+        [&](int& in){
+            sum_inline += in;
+            return StageCommand::NO_CHANGE;
+        },
+        inline_producer,
+        NoSampling());
+
+    const double function_ns = measure_dispatch_overhead(function_producer, function_consumer, num_tokens);
+    const double inline_ns = measure_dispatch_overhead(inline_producer, inline_consumer, num_tokens);
+
+    BOOST_CHECK(function_consumer.status() == PipelineStatus::HAS_BEEN_STOPPED);
+    BOOST_CHECK(inline_consumer.status() == PipelineStatus::HAS_BEEN_STOPPED);
+    BOOST_CHECK_EQUAL(sum_function, sum_inline);
+    BOOST_CHECK(num_samples > 0);
+
+    std::cout << "Stage dispatch overhead: " << inline_ns << " ns/token (std::function + sampling: " << function_ns << " ns/token)." << std::endl;
+
+}
+
+namespace {
+
+    // Exposes a plain Stage to the scheduler, like the *Stage classes do
+    template <typename StageType>
+    class ScheduledStage : public PipelineStage {
+
+    public:
+
+        explicit ScheduledStage(StageType& stage) : stage_(stage) {}
+
+        void execute() override { stage_.execute(); }
+        PipelineStatus status() const override { return stage_.status(); }
+        size_t input_queue_num_elements() const override { return stage_.input_queue_num_elements(); }
+        bool has_tokens_available() const override { return stage_.has_tokens_available(); }
+        const std::string& name() const override { return stage_.name(); }
+        size_t output_queue_size() const override { return stage_.output_queue_size(); }
+        void set_wake_sampler(WakeSampleFunction sampler) override { stage_.set_wake_sampler(std::move(sampler)); }
+        std::vector<std::unique_ptr<FifoSampler>> sample_input_queues() override { return stage_.sample_input_queues(); }
+
+    private:
+
+        StageType& stage_;
+
+    };
+
+}
+
+BOOST_AUTO_TEST_CASE(StageSchedulerTest) {
+
+    const int num_elements = 100000;
+    const size_t pipeline_size = 4;
+
+    const size_t worker_counts[] = { 1, 2, 4 };
+
+    for (size_t num_workers : worker_counts) {
+
+        int produced = 0;
+        int expected_next = 0;
+        bool is_in_order = true;
+
+        auto producer = utils::create_producer_stage<int>(
+            "produce",
+            [&](int& out){
+                if (produced == num_elements)
+                    return StageCommand::STOP_EXECUTION;
+                out = produced++;
+                return StageCommand::NO_CHANGE;
+            },
+            std::vector<int>(pipeline_size));
+
+        auto doubler = utils::create_stage<decltype(producer), int>(
+            "double",
+            [](int& in, int& out){
+                out = in * 2;
+                return StageCommand::NO_CHANGE;
+            },
+            std::vector<int>(pipeline_size),
+            producer);
+
+        auto consumer = utils::create_consumer_stage<decltype(doubler)>(
+            "consume",
+            [&](int& in){
+                is_in_order = is_in_order && (in == expected_next * 2);
+                ++expected_next;
+                return StageCommand::NO_CHANGE;
+            },
+            doubler);
+
+        ScheduledStage<decltype(producer)> scheduled_producer(producer);
+        ScheduledStage<decltype(doubler)> scheduled_doubler(doubler);
+        ScheduledStage<decltype(consumer)> scheduled_consumer(consumer);
+
+        StageScheduler scheduler("test", num_workers);
+        scheduler.add_job(StageScheduler::Job(&scheduled_producer));
+        scheduler.add_job(StageScheduler::Job(&scheduled_doubler, &scheduled_producer, 2));
+        scheduler.add_job(StageScheduler::Job(&scheduled_consumer, &scheduled_doubler));
+
+        scheduler.run();
+
+        BOOST_CHECK(producer.status() == PipelineStatus::HAS_BEEN_STOPPED);
+        BOOST_CHECK(doubler.status() == PipelineStatus::HAS_BEEN_STOPPED);
+        BOOST_CHECK(consumer.status() == PipelineStatus::HAS_BEEN_STOPPED);
+
+        BOOST_CHECK_EQUAL(expected_next, num_elements);
+        BOOST_CHECK(is_in_order);
+
+        // Each stage also executes once more for the stop token
+        BOOST_CHECK_EQUAL(scheduler.statistics().num_executions, 3 * static_cast<size_t>(num_elements) + 3);
+        BOOST_CHECK(scheduler.empty());
+
+    }
+
+}
+
 // TODO: test failure for zero-sized pipe
 // TODO: test varying pipeline sizes... 
 // TODO: test full-duplex side-effects (feed-back loop algorithms)
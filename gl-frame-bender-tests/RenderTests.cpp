@@ -679,8 +679,23 @@ boost::unit_test::test_suite* init_unit_test_suite(int argc, char* argv[]) {
     optimization_flags_combinations.push_back(flags);
     flags.reset();
 
+    flags.set(static_cast<size_t>(StreamDispatch::Flags::ZERO_COPY_OUTPUT));
+    optimization_flags_combinations.push_back(flags);
+    flags.reset();
+
+    flags.set(static_cast<size_t>(StreamDispatch::Flags::ZERO_COPY_INPUT));
+    flags.set(static_cast<size_t>(StreamDispatch::Flags::ZERO_COPY_OUTPUT));
+    optimization_flags_combinations.push_back(flags);
+    flags.reset();
+
     if (GLAD_GL_ARB_buffer_storage != 0) {
 
+        flags.set(static_cast<size_t>(StreamDispatch::Flags::ARB_PERSISTENT_MAPPING));
+        flags.set(static_cast<size_t>(StreamDispatch::Flags::ZERO_COPY_OUTPUT));
+        flags.set(static_cast<size_t>(StreamDispatch::Flags::ASYNC_OUTPUT));
+        optimization_flags_combinations.push_back(flags);
+        flags.reset();
+
         flags.set(static_cast<size_t>(StreamDispatch::Flags::ARB_PERSISTENT_MAPPING));
         optimization_flags_combinations.push_back(flags);
         flags.reset();
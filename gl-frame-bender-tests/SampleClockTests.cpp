@@ -0,0 +1,162 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "PrecompileTest.h"
+
+#include <vector>
+#include <thread>
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "SampleClock.h"
+
+namespace fb = toa::frame_bender;
+
+using namespace fb;
+
+namespace {
+
+    // Leaves the sample clock on steady for other tests
+    struct SteadyAfterwards {
+        ~SteadyAfterwards() { sample_clock::select(SampleClockSource::steady); }
+    };
+
+}
+
+BOOST_AUTO_TEST_SUITE(SampleClockTests)
+
+BOOST_AUTO_TEST_CASE(SourceReadsAndWrites) {
+
+    for (int32_t i = 0; i<static_cast<int32_t>(SampleClockSource::count); ++i) {
+
+        std::ostringstream out;
+        out << SampleClockSource(i);
+
+        std::istringstream in(out.str());
+        SampleClockSource parsed = SampleClockSource::count;
+        in >> parsed;
+
+        BOOST_CHECK(!in.fail());
+        BOOST_CHECK(parsed == SampleClockSource(i));
+    }
+
+    std::istringstream in("rdtsc");
+    SampleClockSource parsed = SampleClockSource::steady;
+    in >> parsed;
+
+    BOOST_CHECK(in.fail());
+
+}
+
+BOOST_AUTO_TEST_CASE(SteadyIsClock) {
+
+    SteadyAfterwards guard;
+
+    BOOST_REQUIRE(sample_clock::select(SampleClockSource::steady) == SampleClockSource::steady);
+    BOOST_CHECK(sample_clock::selected() == SampleClockSource::steady);
+
+    auto before = clock::now();
+    auto time = sample_clock::now();
+    auto after = clock::now();
+
+    BOOST_CHECK(before <= time && time <= after);
+
+}
+
+BOOST_AUTO_TEST_CASE(TscTracksClock) {
+
+    SteadyAfterwards guard;
+
+    if (sample_clock::select(SampleClockSource::tsc) != SampleClockSource::tsc) {
+        BOOST_TEST_MESSAGE("CPU has no invariant TSC, skipping.");
+        return;
+    }
+
+    BOOST_CHECK(sample_clock::selected() == SampleClockSource::tsc);
+    BOOST_CHECK(sample_clock::tsc_ticks_per_second() > 0.0);
+
+    // Generous, a loaded test machine might preempt us anywhere
+    const clock::duration tolerance = boost::chrono::milliseconds(1);
+
+    for (int i = 0; i<10; ++i) {
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        auto before = clock::now();
+        auto time = sample_clock::now();
+        auto after = clock::now();
+
+        BOOST_CHECK(time >= before - tolerance);
+        BOOST_CHECK(time <= after + tolerance);
+
+        sample_clock::calibrate();
+    }
+
+}
+
+BOOST_AUTO_TEST_CASE(TscIsMonotonicAcrossCalibrations) {
+
+    SteadyAfterwards guard;
+
+    if (sample_clock::select(SampleClockSource::tsc) != SampleClockSource::tsc) {
+        BOOST_TEST_MESSAGE("CPU has no invariant TSC, skipping.");
+        return;
+    }
+
+    const size_t num_threads = 4;
+    const size_t num_samples = 200000;
+
+    std::vector<size_t> num_backwards(num_threads, 0);
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t<num_threads; ++t) {
+
+        threads.push_back(std::thread([&, t]{
+
+            clock::time_point last = sample_clock::now();
+
+            for (size_t i = 0; i<num_samples; ++i) {
+
+                // Some threads refit while others sample
+                if (t % 2 == 0 && i % 1000 == 0)
+                    sample_clock::calibrate();
+
+                clock::time_point time = sample_clock::now();
+
+                if (time < last)
+                    num_backwards[t]++;
+
+                last = time;
+            }
+
+        }));
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    for (size_t t = 0; t<num_threads; ++t)
+        BOOST_CHECK_EQUAL(num_backwards[t], 0);
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
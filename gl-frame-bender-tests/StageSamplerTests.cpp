@@ -0,0 +1,189 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "PrecompileTest.h"
+
+#include <vector>
+#include <stdexcept>
+
+#include <boost/test/unit_test.hpp>
+
+#include "StageSampler.h"
+#include "TraceId.h"
+
+namespace fb = toa::frame_bender;
+
+using namespace fb;
+
+namespace {
+
+    clock::time_point at_ns(int64_t ns) {
+        return clock::time_point(clock::duration(ns));
+    }
+
+    // One task of a stage, working on the frame trace_id
+    void enter_task(StageSampler& sampler, int64_t begin_ns, int64_t end_ns, TraceId trace_id) {
+        sampler.enter_sample(StageExecutionState::TASK_BEGIN, at_ns(begin_ns));
+        sampler.enter_trace_id(trace_id);
+        sampler.enter_sample(StageExecutionState::TASK_END, at_ns(end_ns));
+    }
+
+}
+
+BOOST_AUTO_TEST_SUITE(StageSamplerTests)
+
+BOOST_AUTO_TEST_CASE(GeneratesTraceIds) {
+
+    TraceIdGenerator generator;
+
+    TraceId first = generator.next();
+    TraceId second = generator.next();
+
+    BOOST_CHECK(first != kNoTraceId);
+    BOOST_CHECK(second != kNoTraceId);
+    BOOST_CHECK(first != second);
+
+}
+
+BOOST_AUTO_TEST_CASE(RecordsTraceIdsPerTask) {
+
+    StageSampler sampler;
+
+    BOOST_CHECK(!sampler.has_trace_ids());
+
+    // Without a task, there is nothing to relate the frame to
+    sampler.enter_trace_id(7);
+    BOOST_CHECK(!sampler.has_trace_ids());
+
+    enter_task(sampler, 0, 10, 1);
+    enter_task(sampler, 20, 30, kNoTraceId);
+    enter_task(sampler, 40, 50, 3);
+
+    BOOST_CHECK(sampler.has_trace_ids());
+    BOOST_CHECK_EQUAL(sampler.get_trace_id(0), 1);
+    BOOST_CHECK_EQUAL(sampler.get_trace_id(1), kNoTraceId);
+    BOOST_CHECK_EQUAL(sampler.get_trace_id(2), 3);
+    BOOST_CHECK_THROW(sampler.get_trace_id(3), std::invalid_argument);
+
+}
+
+BOOST_AUTO_TEST_CASE(PairsStagesByFrame) {
+
+    StageSampler head;
+    StageSampler output;
+
+    // Frames 1 to 100 enter, 2 us apart. Every tenth frame is dropped 
+    // before reaching the output, where each one arrives 500 ns after it
+    // entered. Pairing by index would drift further with every drop.
+    for (TraceId id = 1; id <= 100; ++id) {
+
+        int64_t begin = static_cast<int64_t>(id) * 2000;
+
+        enter_task(head, begin, begin + 100, id);
+
+        if (id % 10 != 0)
+            enter_task(output, begin + 400, begin + 500, id);
+
+    }
+
+    auto statistic = StageSampler::build_delta_statistic(
+        head, StageExecutionState::TASK_BEGIN,
+        output, StageExecutionState::TASK_END);
+
+    BOOST_CHECK_EQUAL(statistic.num_samples, 90);
+    BOOST_CHECK_EQUAL(statistic.minimum.count(), 500);
+    BOOST_CHECK_EQUAL(statistic.maximum.count(), 500);
+    BOOST_CHECK_EQUAL(statistic.average.count(), 500);
+    BOOST_CHECK_EQUAL(statistic.median.count(), 500);
+
+}
+
+BOOST_AUTO_TEST_CASE(PairsByIndexWithoutTraceIds) {
+
+    StageSampler head;
+    StageSampler output;
+
+    for (int64_t i = 0; i<50; ++i) {
+        head.enter_sample(StageExecutionState::TASK_BEGIN, at_ns(i * 1000));
+        output.enter_sample(StageExecutionState::TASK_END, at_ns(i * 1000 + 300));
+    }
+
+    auto statistic = StageSampler::build_delta_statistic(
+        head, StageExecutionState::TASK_BEGIN,
+        output, StageExecutionState::TASK_END);
+
+    BOOST_CHECK_EQUAL(statistic.num_samples, 50);
+    BOOST_CHECK_EQUAL(statistic.minimum.count(), 300);
+    BOOST_CHECK_EQUAL(statistic.maximum.count(), 300);
+
+}
+
+BOOST_AUTO_TEST_CASE(CollectsStatisticsOfAllEvents) {
+
+    StageSampler sampler;
+
+    // Ends without a begin are not paired with anything
+    sampler.enter_sample(StageExecutionState::EXECUTE_END, at_ns(0));
+
+    // More than the sampler holds, with deltas of 100 to 109 ns
+    const size_t num_tasks = 2 * StageSampler::kNumMaxTraceEvents + 1;
+
+    for (size_t i = 0; i<num_tasks; ++i) {
+        int64_t begin = static_cast<int64_t>(i) * 1000;
+        enter_task(sampler, begin, begin + 100 + static_cast<int64_t>(i % 10), kNoTraceId);
+    }
+
+    BOOST_CHECK_NE(sampler.sample_overflow(StageExecutionState::TASK_END), 0);
+
+    auto statistics = sampler.collect_statistics();
+
+    BOOST_REQUIRE_EQUAL(statistics.size(), 1);
+
+    const auto& statistic = statistics[0];
+
+    BOOST_CHECK(statistic.begin_state == StageExecutionState::TASK_BEGIN);
+    BOOST_CHECK(statistic.end_state == StageExecutionState::TASK_END);
+    BOOST_CHECK_EQUAL(statistic.name.find("biased"), std::string::npos);
+    BOOST_CHECK_EQUAL(statistic.num_samples, num_tasks);
+    BOOST_CHECK_EQUAL(statistic.minimum.count(), 100);
+    BOOST_CHECK_EQUAL(statistic.maximum.count(), 109);
+    BOOST_CHECK_EQUAL(statistic.average.count(), 104);
+    BOOST_CHECK_EQUAL(statistic.std_deviation.count(), 2);
+
+}
+
+BOOST_AUTO_TEST_CASE(ThrowsWithoutCommonFrames) {
+
+    StageSampler head;
+    StageSampler output;
+
+    enter_task(head, 0, 10, 1);
+    enter_task(output, 20, 30, 2);
+
+    BOOST_CHECK_THROW(
+        StageSampler::build_delta_statistic(
+            head, StageExecutionState::TASK_BEGIN,
+            output, StageExecutionState::TASK_END), 
+        std::runtime_error);
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
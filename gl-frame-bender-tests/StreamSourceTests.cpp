@@ -26,6 +26,8 @@
 #include <boost/test/unit_test.hpp>
 
 #include "StreamSource.h"
+#include "SequenceContainer.h"
+#include "ProgramOptions.h"
 #include "TestUtils.h"
 #include "TestCommon.h"
 
@@ -184,4 +186,225 @@ BOOST_AUTO_TEST_CASE(V210PrefetchedImageTestSequenceTest) {
 }
 
 
+BOOST_AUTO_TEST_CASE(V210MmapImageTestSequenceTest) {
+
+    const size_t loop_count = 2;
+    const size_t prefetch_count = 4;
+
+    PrefetchedImageSequence reference(
+        "horse_v210_1920_1080p_short",
+        "horse_\\d+\\.v210",
+        test::horse_seq_v210_1080p_format(),
+        Time(1, 50),
+        loop_count
+        );
+
+    MmapImageSequence mapped(
+        "horse_v210_1920_1080p_short",
+        "horse_\\d+\\.v210",
+        test::horse_seq_v210_1080p_format(),
+        Time(1, 50),
+        loop_count,
+        prefetch_count
+        );
+
+    BOOST_REQUIRE_EQUAL(mapped.num_frames(), reference.num_frames());
+    BOOST_REQUIRE_EQUAL(mapped.total_data_size(), reference.total_data_size());
+
+    test::check_matches_reference(mapped, reference);
+
+}
+
+BOOST_AUTO_TEST_CASE(V210StreamingImageTestSequenceTest) {
+
+    const size_t loop_count = 2;
+    const size_t read_ahead_count = 2;
+
+    PrefetchedImageSequence reference(
+        "horse_v210_1920_1080p_short",
+        "horse_\\d+\\.v210",
+        test::horse_seq_v210_1080p_format(),
+        Time(1, 50),
+        loop_count
+        );
+
+    StreamingImageSequence streamed(
+        "horse_v210_1920_1080p_short",
+        "horse_\\d+\\.v210",
+        test::horse_seq_v210_1080p_format(),
+        Time(1, 50),
+        loop_count,
+        read_ahead_count,
+        true
+        );
+
+    BOOST_REQUIRE_EQUAL(streamed.num_frames(), reference.num_frames());
+
+    // Consumes faster than the disk, so this will underrun.
+    test::check_matches_reference(streamed, reference);
+
+    BOOST_TEST_MESSAGE("Streaming underruns: " << streamed.num_underruns());
+
+}
+
+BOOST_AUTO_TEST_CASE(V210CompressedImageTestSequenceTest) {
+
+    const size_t loop_count = 2;
+    const size_t read_ahead_count = 2;
+    const size_t decode_thread_count = 2;
+
+    PrefetchedImageSequence reference(
+        "horse_v210_1920_1080p_short",
+        "horse_\\d+\\.v210",
+        test::horse_seq_v210_1080p_format(),
+        Time(1, 50),
+        loop_count
+        );
+
+    CompressedImageSequence compressed(
+        "horse_v210_1920_1080p_short",
+        "horse_\\d+\\.v210",
+        test::horse_seq_v210_1080p_format(),
+        Time(1, 50),
+        loop_count,
+        read_ahead_count,
+        decode_thread_count
+        );
+
+    BOOST_REQUIRE_EQUAL(compressed.num_frames(), reference.num_frames());
+    BOOST_REQUIRE_EQUAL(compressed.decode_thread_count(), decode_thread_count);
+
+    BOOST_TEST_MESSAGE(
+        "Compressed " << compressed.total_data_size() / loop_count 
+        << " bytes into " << compressed.compressed_data_size() << " bytes.");
+
+    BOOST_REQUIRE_LT(compressed.compressed_data_size(), compressed.total_data_size() / loop_count);
+
+    test::check_matches_reference(compressed, reference);
+
+    BOOST_TEST_MESSAGE("Decompression underruns: " << compressed.num_underruns());
+
+}
+
+BOOST_AUTO_TEST_CASE(V210ContainerImageTestSequenceTest) {
+
+    const std::string container_file = "horse_v210_1920_1080p_short_test.fbseq";
+
+    boost::filesystem::path container_path(ProgramOptions::global().input_sequences_folder());
+    container_path /= container_file;
+
+    // Pack the folder sequence into a container
+    std::vector<Frame> frames;
+
+    {
+        PrefetchedImageSequence folder(
+            "horse_v210_1920_1080p_short",
+            "horse_\\d+\\.v210",
+            test::horse_seq_v210_1080p_format(),
+            Time(1, 50)
+            );
+
+        SequenceContainerWriter writer(
+            container_path.string(), 
+            test::horse_seq_v210_1080p_format(), 
+            Time(1, 50));
+
+        while (folder.state() == StreamSource::State::READY_TO_READ) {
+            Frame f;
+            BOOST_REQUIRE(folder.pop_frame(f));
+            writer.add_frame(f.image_data());
+            frames.push_back(std::move(f));
+        }
+
+        writer.finish();
+    }
+
+    // Random access
+    {
+        SequenceContainerReader reader(container_path.string());
+
+        BOOST_REQUIRE_EQUAL(reader.num_frames(), frames.size());
+        BOOST_REQUIRE(reader.image_format() == test::horse_seq_v210_1080p_format());
+        BOOST_REQUIRE_EQUAL(reader.frame_duration(), Time(1, 50));
+
+        Frame f(test::horse_seq_v210_1080p_format(), Time(0, 1), false);
+
+        for (size_t i = frames.size(); i-- > 0;) {
+            BOOST_REQUIRE_EQUAL(reader.frame_offset(i) % sequence_container::kPayloadAlignment, 0);
+            reader.read_frame(i, f.image_data());
+            BOOST_REQUIRE(test::compare_v210_frames(frames[i], f, 0));
+        }
+
+        BOOST_REQUIRE_THROW(reader.frame_offset(frames.size()), std::out_of_range);
+    }
+
+    // Streaming, twice through, starting at the second frame
+    {
+        const size_t loop_count = 2;
+        const size_t first_frame = 1;
+
+        ContainerImageSequence container(
+            container_file,
+            test::horse_seq_v210_1080p_format(),
+            loop_count,
+            4,
+            first_frame
+            );
+
+        BOOST_REQUIRE_EQUAL(container.state(), StreamSource::State::READY_TO_READ);
+        BOOST_REQUIRE_EQUAL(container.num_frames(), frames.size() * loop_count);
+
+        bool are_equal = true;
+
+        for (size_t i = 0; i<container.num_frames() && are_equal; ++i) {
+
+            Frame f;
+            BOOST_REQUIRE(container.pop_frame(f) && f.is_valid());
+
+            BOOST_REQUIRE_EQUAL(f.time(), Time(i, 50));
+            BOOST_REQUIRE_EQUAL(f.marks_end_of_sequence(), i + 1 == container.num_frames());
+
+            are_equal = are_equal && test::compare_v210_frames(frames[(first_frame + i) % frames.size()], f, 0);
+
+            container.invalidate_frame(std::move(f));
+        }
+
+        BOOST_REQUIRE(are_equal);
+        BOOST_REQUIRE_EQUAL(container.state(), StreamSource::State::END_OF_STREAM);
+    }
+
+    // Filling in place, like for zero-copy input
+    {
+        ContainerImageSequence container(
+            container_file,
+            test::horse_seq_v210_1080p_format(),
+            1,
+            2
+            );
+
+        BOOST_REQUIRE(container.can_fill_in_place());
+
+        Frame f(test::horse_seq_v210_1080p_format(), Time(0, 1), false);
+
+        bool are_equal = true;
+        size_t i = 0;
+
+        for (; container.state() == StreamSource::State::READY_TO_READ && are_equal; ++i) {
+
+            Time t;
+            BOOST_REQUIRE(container.fill_frame(f.image_data(), f.image_format(), t));
+            BOOST_REQUIRE_EQUAL(t, Time(i, 50));
+
+            are_equal = are_equal && test::compare_v210_frames(frames[i], f, 0);
+        }
+
+        BOOST_REQUIRE(are_equal);
+        BOOST_REQUIRE_EQUAL(i, frames.size());
+        BOOST_REQUIRE_EQUAL(container.state(), StreamSource::State::END_OF_STREAM);
+    }
+
+    boost::filesystem::remove(container_path);
+
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,412 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "PrecompileTest.h"
+
+#include <vector>
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "TraceFormat.h"
+#include "StageSampler.h"
+#include "FifoSampler.h"
+
+#include "fbt_format.pb.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/io/gzip_stream.h"
+
+namespace fb = toa::frame_bender;
+namespace bf = boost::filesystem;
+namespace fbf = fbt_format;
+
+using namespace fb;
+
+namespace {
+
+    class TemporaryFile {
+    public:
+        TemporaryFile() : path_(bf::temp_directory_path() / bf::unique_path("fb-trace-%%%%-%%%%.fbt")) {}
+        ~TemporaryFile() { bf::remove(path_); }
+        const bf::path& path() const { return path_; }
+    private:
+        bf::path path_;
+    };
+
+    fbf::TraceSession read_session(const bf::path& path) {
+
+        bf::ifstream in(path, std::ios::in | std::ios::binary);
+
+        google::protobuf::io::IstreamInputStream in_stream(&in);
+        google::protobuf::io::GzipInputStream gzip_in_stream(&in_stream);
+
+        fbf::TraceSession session;
+        BOOST_REQUIRE(session.ParseFromZeroCopyStream(&gzip_in_stream));
+
+        return session;
+    }
+
+    // All times of the given event type of a stage, spread over the chunks
+    std::vector<int64_t> merged_times(
+        const fbf::TraceSession& session, 
+        const std::string& name, 
+        fbf::StageTrace::EventType type) 
+    {
+        std::vector<int64_t> times;
+
+        for (const auto& stage_trace : session.stage_traces()) {
+            if (stage_trace.name() != name)
+                continue;
+            for (const auto& event_trace : stage_trace.event_traces()) {
+                if (event_trace.type() == type)
+                    times.insert(std::end(times), event_trace.trace_times_ns().begin(), event_trace.trace_times_ns().end());
+            }
+        }
+
+        return times;
+    }
+
+    // All trace IDs of the task begin events of a stage, spread over the chunks
+    std::vector<uint32_t> merged_trace_ids(
+        const fbf::TraceSession& session, 
+        const std::string& name) 
+    {
+        std::vector<uint32_t> ids;
+
+        for (const auto& stage_trace : session.stage_traces()) {
+            if (stage_trace.name() != name)
+                continue;
+            for (const auto& event_trace : stage_trace.event_traces()) {
+                if (event_trace.type() == fbf::StageTrace::TASK_BEGIN)
+                    ids.insert(std::end(ids), event_trace.trace_ids().begin(), event_trace.trace_ids().end());
+            }
+        }
+
+        return ids;
+    }
+
+    void enter_samples(StageSampler& sampler, size_t begin, size_t end) {
+        for (size_t i = begin; i<end; ++i) {
+            sampler.enter_sample(StageExecutionState::TASK_BEGIN, clock::time_point(clock::duration(static_cast<int64_t>(i * 10))));
+            sampler.enter_sample(StageExecutionState::TASK_END, clock::time_point(clock::duration(static_cast<int64_t>(i * 10 + 5))));
+        }
+    }
+
+    gl::utils::GLInfo test_gl_info() {
+        gl::utils::GLInfo info;
+        info.major = 4;
+        info.minor = 3;
+        info.version_string = "4.3";
+        info.vendor = "TestVendor";
+        info.renderer = "TestRenderer";
+        return info;
+    }
+
+}
+
+BOOST_AUTO_TEST_SUITE(TraceStreamTests)
+
+BOOST_AUTO_TEST_CASE(KeepsEventsBeyondSamplerCapacity) {
+
+    TemporaryFile file;
+
+    const size_t capacity = StageSampler::kNumMaxTraceEvents;
+    const size_t num_events = 3 * capacity + 17;
+
+    StageSampler sampler;
+
+    {
+        TraceStream stream(file.path().string());
+        stream.attach("Stage", sampler);
+
+        enter_samples(sampler, 0, num_events);
+
+        // Streamed events aren't held by the sampler
+        BOOST_CHECK_EQUAL(sampler.number_of_sampled_trace_events(StageExecutionState::TASK_BEGIN), 0);
+        BOOST_CHECK_EQUAL(sampler.sample_overflow(StageExecutionState::TASK_BEGIN), 0);
+
+        TraceFormatWriter writer(stream, "TraceStreamTest", test_gl_info());
+        writer.add_stage_sampler("Stage", sampler);
+        writer.flush();
+
+        BOOST_CHECK(stream.is_finished());
+        BOOST_CHECK(!sampler.is_streamed());
+        BOOST_CHECK_EQUAL(stream.num_events_written(), 2 * num_events);
+        BOOST_CHECK_EQUAL(stream.num_events_dropped(), 0);
+    }
+
+    fbf::TraceSession session = read_session(file.path());
+
+    // Provisional attributes are overridden when finishing
+    BOOST_CHECK_EQUAL(session.name(), "TraceStreamTest");
+    BOOST_CHECK_EQUAL(session.opengl_info().vendor(), "TestVendor");
+
+    auto begin_times = merged_times(session, "Stage", fbf::StageTrace::TASK_BEGIN);
+    auto end_times = merged_times(session, "Stage", fbf::StageTrace::TASK_END);
+
+    BOOST_REQUIRE_EQUAL(begin_times.size(), num_events);
+    BOOST_REQUIRE_EQUAL(end_times.size(), num_events);
+
+    for (size_t i = 0; i<num_events; ++i) {
+        BOOST_REQUIRE_EQUAL(begin_times[i], static_cast<int64_t>(i * 10));
+        BOOST_REQUIRE_EQUAL(end_times[i], static_cast<int64_t>(i * 10 + 5));
+    }
+
+    // Statistics cover all events, not only the ones the sampler holds
+    bool has_statistic = false;
+    for (const auto& stage_trace : session.stage_traces()) {
+        if (stage_trace.name() == "Stage" && stage_trace.delta_statistics_size() != 0) {
+            BOOST_CHECK_EQUAL(stage_trace.delta_statistics(0).num_samples(), num_events);
+            has_statistic = true;
+        }
+    }
+
+    BOOST_CHECK(has_statistic);
+
+}
+
+BOOST_AUTO_TEST_CASE(KeepsEventsOfAttachAndDetach) {
+
+    TemporaryFile file;
+
+    StageSampler kept_sampler;
+
+    {
+        TraceStream stream(file.path().string(), 16);
+
+        // Sampled before attaching
+        enter_samples(kept_sampler, 0, 100);
+        stream.attach("Kept", kept_sampler);
+        enter_samples(kept_sampler, 100, 2000);
+
+        {
+            // Gone before the stream is finished
+            StageSampler gone_sampler;
+            stream.attach("Gone", gone_sampler);
+            enter_samples(gone_sampler, 0, 10);
+        }
+
+        BOOST_CHECK_THROW(stream.attach("Kept", kept_sampler), std::invalid_argument);
+
+        BOOST_CHECK_EQUAL(stream.num_events_dropped(), 0);
+
+        // Finishes with an empty session
+    }
+
+    fbf::TraceSession session = read_session(file.path());
+
+    auto kept_times = merged_times(session, "Kept", fbf::StageTrace::TASK_BEGIN);
+    BOOST_REQUIRE_EQUAL(kept_times.size(), 2000);
+
+    for (size_t i = 0; i<kept_times.size(); ++i)
+        BOOST_REQUIRE_EQUAL(kept_times[i], static_cast<int64_t>(i * 10));
+
+    BOOST_CHECK_EQUAL(merged_times(session, "Gone", fbf::StageTrace::TASK_END).size(), 10);
+
+    // The provisional session attributes remain
+    BOOST_CHECK_EQUAL(session.name(), file.path().stem().string());
+
+}
+
+BOOST_AUTO_TEST_CASE(WaitsForSegmentsInsteadOfDropping) {
+
+    TemporaryFile file;
+
+    const size_t num_events = 20 * TraceSegment::kNumMaxEvents + 5;
+
+    StageSampler sampler;
+
+    {
+        // Less than the sampler holds on to
+        TraceStream stream(file.path().string(), 1);
+        stream.attach("Stage", sampler);
+
+        enter_samples(sampler, 0, num_events);
+
+        stream.finish(fbf::TraceSession());
+
+        BOOST_CHECK_NE(stream.num_segment_waits(), 0);
+        BOOST_CHECK_EQUAL(stream.num_events_written(), 2 * num_events);
+        BOOST_CHECK_EQUAL(stream.num_events_dropped(), 0);
+    }
+
+    fbf::TraceSession session = read_session(file.path());
+
+    auto begin_times = merged_times(session, "Stage", fbf::StageTrace::TASK_BEGIN);
+    auto end_times = merged_times(session, "Stage", fbf::StageTrace::TASK_END);
+
+    BOOST_REQUIRE_EQUAL(begin_times.size(), num_events);
+    BOOST_REQUIRE_EQUAL(end_times.size(), num_events);
+
+    for (size_t i = 0; i<num_events; ++i) {
+        BOOST_REQUIRE_EQUAL(begin_times[i], static_cast<int64_t>(i * 10));
+        BOOST_REQUIRE_EQUAL(end_times[i], static_cast<int64_t>(i * 10 + 5));
+    }
+
+}
+
+BOOST_AUTO_TEST_CASE(WritesStatisticHistograms) {
+
+    TemporaryFile file;
+
+    StageSampler sampler;
+    enter_samples(sampler, 0, 1000);
+
+    auto statistics = sampler.collect_statistics();
+    BOOST_REQUIRE_EQUAL(statistics.size(), 1);
+
+    const auto& statistic = statistics[0];
+
+    {
+        TraceFormatWriter writer(file.path().string(), "TraceStreamTest", test_gl_info());
+        writer.add_stage_sampler("Stage", sampler);
+        writer.flush();
+    }
+
+    fbf::TraceSession session = read_session(file.path());
+
+    BOOST_REQUIRE_EQUAL(session.stage_traces_size(), 1);
+    BOOST_REQUIRE_NE(session.stage_traces(0).delta_statistics_size(), 0);
+
+    const auto& delta_statistic = session.stage_traces(0).delta_statistics(0);
+
+    BOOST_REQUIRE_EQUAL(delta_statistic.percentiles_size(), static_cast<int>(statistic.percentiles.size()));
+    BOOST_REQUIRE_EQUAL(delta_statistic.percentile_values_ns_size(), delta_statistic.percentiles_size());
+
+    for (int i = 0; i<delta_statistic.percentiles_size(); ++i) {
+        BOOST_CHECK_EQUAL(delta_statistic.percentiles(i), statistic.percentiles[i].percentile);
+        BOOST_CHECK_EQUAL(delta_statistic.percentile_values_ns(i), statistic.percentiles[i].value.count());
+    }
+
+    // The histogram can be restored from its sparse counts
+    LatencyHistogram histogram(
+        delta_statistic.histogram_highest_trackable_ns(), 
+        static_cast<int32_t>(delta_statistic.histogram_significant_digits()));
+
+    BOOST_REQUIRE(histogram.has_same_layout(statistic.histogram));
+    BOOST_REQUIRE_EQUAL(delta_statistic.histogram_indices_size(), delta_statistic.histogram_counts_size());
+
+    for (int i = 0; i<delta_statistic.histogram_indices_size(); ++i)
+        histogram.add_count_at_index(delta_statistic.histogram_indices(i), delta_statistic.histogram_counts(i));
+
+    BOOST_CHECK_EQUAL(histogram.total_count(), 1000);
+    BOOST_CHECK_EQUAL(histogram.value_at_percentile(99.0), statistic.histogram.value_at_percentile(99.0));
+
+}
+
+BOOST_AUTO_TEST_CASE(WritesTraceIds) {
+
+    TemporaryFile streamed_file;
+    TemporaryFile file;
+
+    StageSampler streamed_sampler;
+    StageSampler sampler;
+
+    auto enter_frames = [](StageSampler& s, size_t num_frames) {
+        for (size_t i = 0; i<num_frames; ++i) {
+            s.enter_sample(StageExecutionState::TASK_BEGIN, clock::time_point(clock::duration(static_cast<int64_t>(i * 10))));
+            s.enter_trace_id(static_cast<TraceId>(i + 1));
+            s.enter_sample(StageExecutionState::TASK_END, clock::time_point(clock::duration(static_cast<int64_t>(i * 10 + 5))));
+        }
+    };
+
+    const size_t num_streamed_frames = 2 * StageSampler::kNumMaxTraceEvents + 3;
+
+    {
+        TraceStream stream(streamed_file.path().string());
+        stream.attach("Stage", streamed_sampler);
+        enter_frames(streamed_sampler, num_streamed_frames);
+
+        TraceFormatWriter writer(stream, "TraceStreamTest", test_gl_info());
+        writer.add_stage_sampler("Stage", streamed_sampler);
+        writer.flush();
+
+        BOOST_CHECK_EQUAL(stream.num_events_dropped(), 0);
+    }
+
+    enter_frames(sampler, 100);
+
+    {
+        TraceFormatWriter writer(file.path().string(), "TraceStreamTest", test_gl_info());
+        writer.add_stage_sampler("Stage", sampler);
+        writer.flush();
+    }
+
+    auto streamed_ids = merged_trace_ids(read_session(streamed_file.path()), "Stage");
+    auto ids = merged_trace_ids(read_session(file.path()), "Stage");
+
+    BOOST_REQUIRE_EQUAL(streamed_ids.size(), num_streamed_frames);
+    BOOST_REQUIRE_EQUAL(ids.size(), 100);
+
+    for (size_t i = 0; i<streamed_ids.size(); ++i)
+        BOOST_REQUIRE_EQUAL(streamed_ids[i], i + 1);
+
+    for (size_t i = 0; i<ids.size(); ++i)
+        BOOST_REQUIRE_EQUAL(ids[i], i + 1);
+
+}
+
+BOOST_AUTO_TEST_CASE(WritesQueueTraces) {
+
+    TemporaryFile file;
+
+    FifoSampler sampler("Produce -> Consume", 4);
+
+    sampler.enter_pop(clock::time_point(clock::duration(5)), 3, clock::time_point());
+
+    for (int64_t i = 1; i<=3; ++i) {
+        sampler.enter_push(clock::time_point(clock::duration(i * 10)), 1);
+        sampler.enter_pop(clock::time_point(clock::duration(i * 10 + 4)), 0, clock::time_point(clock::duration(i * 10)));
+    }
+
+    {
+        TraceFormatWriter writer(file.path().string(), "TraceStreamTest", test_gl_info());
+        writer.add_fifo_sampler(sampler);
+        writer.flush();
+    }
+
+    auto session = read_session(file.path());
+
+    BOOST_REQUIRE_EQUAL(session.queue_traces_size(), 1);
+
+    const auto& queue_trace = session.queue_traces(0);
+
+    BOOST_CHECK_EQUAL(queue_trace.name(), "Produce -> Consume");
+    BOOST_CHECK_EQUAL(queue_trace.capacity(), 4);
+
+    BOOST_REQUIRE_EQUAL(queue_trace.push_times_ns_size(), 3);
+    BOOST_REQUIRE_EQUAL(queue_trace.push_occupancy_size(), 3);
+    BOOST_REQUIRE_EQUAL(queue_trace.pop_times_ns_size(), 4);
+    BOOST_REQUIRE_EQUAL(queue_trace.pop_occupancy_size(), 4);
+    BOOST_REQUIRE_EQUAL(queue_trace.dwell_times_ns_size(), 4);
+
+    BOOST_CHECK_EQUAL(queue_trace.push_times_ns(2), 30);
+    BOOST_CHECK_EQUAL(queue_trace.push_occupancy(2), 1);
+    BOOST_CHECK_EQUAL(queue_trace.pop_times_ns(0), 5);
+    BOOST_CHECK_EQUAL(queue_trace.pop_occupancy(0), 3);
+    BOOST_CHECK_EQUAL(queue_trace.dwell_times_ns(0), -1);
+    BOOST_CHECK_EQUAL(queue_trace.dwell_times_ns(3), 4);
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
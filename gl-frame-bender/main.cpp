@@ -57,6 +57,12 @@ int main(int argc, const char* argv[]) {
             opts.write_config_to_file(opts.config_output_file());
         }
 
+        // Before anything is sampled
+        sample_clock::select(opts.profiling_sample_clock());
+
+        // Before any frame is allocated
+        FramePool::global().set_huge_pages(opts.pipeline_frame_huge_pages());
+
         gl::Init::require();
 
         // BEGIN RENDER SCENARIO WITH PERFORMANCE METRICS
@@ -93,13 +99,64 @@ int main(int argc, const char* argv[]) {
         FB_LOG_INFO << "Input sequence format is set to [" << input_sequence_format << "].";
         FB_LOG_INFO << "Assuming BT_709 for chromaticity by default.";
 
-        auto input_sequence = std::make_shared<PrefetchedImageSequence>(
-            ProgramOptions::global().input_sequence_name(),
-            ProgramOptions::global().input_sequence_pattern(),
-            input_sequence_format,
-            ProgramOptions::global().input_sequence_frame_duration(),
-            ProgramOptions::global().input_sequence_loop_count()
-            );
+        std::shared_ptr<StreamSource> input_sequence;
+
+        switch (ProgramOptions::global().input_sequence_reader()) {
+
+        case SequenceReader::MMAP:
+            input_sequence = std::make_shared<MmapImageSequence>(
+                ProgramOptions::global().input_sequence_name(),
+                ProgramOptions::global().input_sequence_pattern(),
+                input_sequence_format,
+                ProgramOptions::global().input_sequence_frame_duration(),
+                ProgramOptions::global().input_sequence_loop_count(),
+                ProgramOptions::global().input_sequence_read_ahead_count()
+                );
+            break;
+
+        case SequenceReader::STREAM:
+            input_sequence = std::make_shared<StreamingImageSequence>(
+                ProgramOptions::global().input_sequence_name(),
+                ProgramOptions::global().input_sequence_pattern(),
+                input_sequence_format,
+                ProgramOptions::global().input_sequence_frame_duration(),
+                ProgramOptions::global().input_sequence_loop_count(),
+                ProgramOptions::global().input_sequence_read_ahead_count(),
+                ProgramOptions::global().input_sequence_direct_io_is_enabled()
+                );
+            break;
+
+        case SequenceReader::CONTAINER:
+            input_sequence = std::make_shared<ContainerImageSequence>(
+                ProgramOptions::global().input_sequence_name(),
+                input_sequence_format,
+                ProgramOptions::global().input_sequence_loop_count(),
+                ProgramOptions::global().input_sequence_read_ahead_count()
+                );
+            break;
+
+        case SequenceReader::COMPRESSED:
+            input_sequence = std::make_shared<CompressedImageSequence>(
+                ProgramOptions::global().input_sequence_name(),
+                ProgramOptions::global().input_sequence_pattern(),
+                input_sequence_format,
+                ProgramOptions::global().input_sequence_frame_duration(),
+                ProgramOptions::global().input_sequence_loop_count(),
+                ProgramOptions::global().input_sequence_read_ahead_count(),
+                ProgramOptions::global().input_sequence_decode_thread_count()
+                );
+            break;
+
+        default:
+            input_sequence = std::make_shared<PrefetchedImageSequence>(
+                ProgramOptions::global().input_sequence_name(),
+                ProgramOptions::global().input_sequence_pattern(),
+                input_sequence_format,
+                ProgramOptions::global().input_sequence_frame_duration(),
+                ProgramOptions::global().input_sequence_loop_count()
+                );
+            break;
+        }
 
         {
 
@@ -145,38 +202,27 @@ int main(int argc, const char* argv[]) {
 
 				StreamComposition::OutputCallback output_callback;
 
-				size_t frame_output_counter = 0;
-				bf::path output_path(ProgramOptions::global().write_output_folder());
+				// Writes on its own threads, so that recording doesn't stall
+				// the output stages
+				std::unique_ptr<FrameWriter> frame_writer;
 
 				if (ProgramOptions::global().enable_write_output()) {
 
-					// Make sure output folder exists
-
-					if (bf::exists(output_path) && !bf::is_directory(output_path)) {
-						FB_LOG_ERROR << "Directory '" << output_path.string() << "' already exists, but is not a directory.";
-						throw std::invalid_argument("Invalid output directory.");
-					}
-
-					if (!bf::exists(output_path)) {
-						FB_LOG_INFO << "Directory '" << output_path.string() << "' did not exist, creating directory.";
-						bf::create_directories(output_path);
-					}
+					frame_writer = utils::make_unique<FrameWriter>(
+						ProgramOptions::global().write_output_folder(),
+						ProgramOptions::global().write_output_layout(),
+						ProgramOptions::global().write_output_swap_endianness(),
+						ProgramOptions::global().write_output_swap_endianness_word_size(),
+						ProgramOptions::global().write_output_queue_size(),
+						ProgramOptions::global().write_output_writer_thread_count(),
+						ProgramOptions::global().write_output_preallocate_frame_count());
 
 					output_callback = [&](const Frame& f){
-
-						std::ostringstream oss;
-						oss << std::setfill('0') << std::setw(8) << frame_output_counter << ".raw";
-						bf::path file_path(oss.str());
-
-						bf::path write_path = output_path / file_path;
-
-						f.dump_to_file(
-							write_path.string(),
-							ProgramOptions::global().write_output_swap_endianness(),
-							ProgramOptions::global().write_output_swap_endianness_word_size());
-
-						frame_output_counter++;
+						frame_writer->write(f);
 					};
+
+					if (frame_writer->sampler() != nullptr)
+						dispatch.add_trace_sampler("FrameWriter", *frame_writer->sampler());
 				}
 
 				auto composition_id = dispatch.create_composition(
@@ -186,6 +232,21 @@ int main(int argc, const char* argv[]) {
 					std::move(output_callback)
 					);
 
+				// Writes all events while running, instead of keeping only 
+				// the first few thousand per stage until the end
+				std::unique_ptr<TraceStream> trace_stream;
+
+				if (ProgramOptions::global().sample_stages() && 
+					!ProgramOptions::global().trace_output_file().empty() &&
+					ProgramOptions::global().trace_streaming_is_enabled())
+				{
+					trace_stream = utils::make_unique<TraceStream>(
+						ProgramOptions::global().trace_output_file(),
+						ProgramOptions::global().trace_streaming_segment_count());
+
+					dispatch.stream_trace_file(*trace_stream);
+				}
+
 				// Let's wait a little so all threads are really up for running
 				std::this_thread::sleep_for(std::chrono::seconds(1));
 
@@ -225,11 +286,13 @@ int main(int argc, const char* argv[]) {
 
 				}
 
-				if (ProgramOptions::global().enable_write_output()) {
+				if (frame_writer) {
+
+					frame_writer->flush();
 
 					FB_LOG_INFO 
-						<< "Wrote " << frame_output_counter 
-						<< " frames into '" << output_path.string() << "'.";
+						<< "Wrote " << frame_writer->num_frames_written() 
+						<< " frames into '" << ProgramOptions::global().write_output_folder() << "'.";
 
 				}
 
@@ -60,10 +60,13 @@ namespace toa {
             PipelineStatus status() const override { return stage_.status(); }
 
             size_t input_queue_num_elements() const override { return stage_.input_queue_num_elements(); }
+            bool has_tokens_available() const override { return stage_.has_tokens_available(); }
 
             const std::string& name() const override { return stage_.name(); }
 
             size_t output_queue_size() const override { return stage_.output_queue_size(); } 
+            void set_wake_sampler(WakeSampleFunction sampler) override { stage_.set_wake_sampler(std::move(sampler)); }
+            std::vector<std::unique_ptr<FifoSampler>> sample_input_queues() override { return stage_.sample_input_queues(); }
 
             const StageType& stage() const { return stage_; }
 
@@ -90,7 +93,10 @@ namespace toa {
 
             stage_ = utils::create_consumer_stage<typename InputStage::StageType>(
                 "ByPassDownloadStage",
-                [](typename InputStage::StageType::OutputType&){return StageCommand::NO_CHANGE;},
+                [this](typename InputStage::StageType::OutputType& token) -> StageCommand {
+                    sampler_.enter_trace_id(token.trace_id);
+                    return StageCommand::NO_CHANGE;
+                },
                 input_stage.stage(),
                 std::move(fnc));
 
@@ -166,6 +166,9 @@ fb::StageCommand fb::ByPassUploadStage::perform(TokenGL& token_out) {
             token_out.time_stamp = frame.time();
 
             token_out.composition = composition;
+            token_out.trace_id = trace_ids_.next();
+
+            sampler_.enter_trace_id(token_out.trace_id);
 
             // done with this frame
             source.invalidate_frame(std::move(frame));
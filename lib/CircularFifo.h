@@ -23,12 +23,28 @@
 // thread-safe bounded queue. Its implementation is based on 
 // Kjell Hedstrm's implementation as given on 
 // http://www.codeproject.com/Articles/43510/Lock-Free-Single-Producer-Single-Consumer-Circular
+//
+// Differences to the original: head and tail live on separate cache lines, 
+// and each side keeps a private copy of the other side's index, which is 
+// only refreshed when the copy says the queue is full (producer) or empty 
+// (consumer). The indices count up monotonically and are mapped to the 
+// ring with a mask, the ring size is therefore rounded up to a power of two.
+//
+// Slots are raw storage, elements are constructed when pushed (or emplaced)
+// and destroyed when popped. push_n/pop_n move a whole batch of elements
+// and publish it with a single index store.
 
 #ifndef TOA_FRAME_BENDER_CIRCULARFIFO_H
 #define TOA_FRAME_BENDER_CIRCULARFIFO_H
 
 #include <atomic>
 #include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Utils.h"
 
 namespace toa {
 
@@ -44,11 +60,26 @@ namespace toa {
             bool push(Element&& item);
             bool push(const Element& item);
 
+            // Constructs the element directly in the ring.
+            template <typename... Args>
+            bool emplace(Args&&... args);
+
+            // Pushes up to count elements read from first, returns the number
+            // of elements that were actually pushed (which is less than count
+            // if the queue runs full). Pass a std::move_iterator to move.
+            template <typename InputIterator>
+            size_t push_n(InputIterator first, size_t count);
+
             // TODO: add a unique_ptr or shared_ptr return?
             // Although, this would have the same implications mentioned
             // in C++ concurrency: allocation COULD fail in pop and throw.
             bool pop(Element& item);
 
+            // Moves up to max_count elements to out, returns the number of
+            // elements that were popped.
+            template <typename OutputIterator>
+            size_t pop_n(OutputIterator out, size_t max_count);
+
             bool was_empty() const;
             bool was_full() const;
             size_t had_num_elements() const;
@@ -58,66 +89,166 @@ namespace toa {
 
         private:
 
-            template <typename InsertElement> 
-            bool push_element(InsertElement&& item);
+            typedef typename std::aligned_storage<
+                sizeof(Element), 
+                std::alignment_of<Element>::value>::type Slot;
+
+            Element* slot(size_t index) { return reinterpret_cast<Element*>(&_array[index & _mask]); }
+
+            // Returns the number of free slots, as seen by the producer
+            size_t free_slots(size_t current_tail);
+
+            // Returns the number of filled slots, as seen by the consumer
+            size_t filled_slots(size_t current_head);
 
-            size_t increment(size_t idx) const; 
+            static size_t ring_size(size_t size);
 
+            // Read-only after construction, shared by both sides
             const size_t _size;
-            const size_t _capacity;
+            const size_t _mask;
+            std::unique_ptr<Slot[]> _array;
 
+            char _padding_0[kCacheLineSize];
+
+            // Written by the producer only
             std::atomic<size_t> _tail;
-            std::unique_ptr<Element[]> _array;
+            size_t _head_cache;
+
+            char _padding_1[kCacheLineSize];
+
+            // Written by the consumer only
             std::atomic<size_t> _head;
+            size_t _tail_cache;
+
+            char _padding_2[kCacheLineSize];
         };
 
         template<typename Element>
-        CircularFifo<Element>::CircularFifo(size_t size) : _size(size), _capacity(size+1), _tail(0), _head(0) {
-            _array = std::unique_ptr<Element[]>(new Element[_capacity]);
+        CircularFifo<Element>::CircularFifo(size_t size) : 
+            _size(size), 
+            _mask(ring_size(size) - 1), 
+            _tail(0), 
+            _head_cache(0),
+            _head(0),
+            _tail_cache(0)
+        {
+            _array = std::unique_ptr<Slot[]>(new Slot[_mask + 1]);
         }
 
         template<typename Element>
-        CircularFifo<Element>::~CircularFifo(){}
+        CircularFifo<Element>::~CircularFifo()
+        {
+            const auto tail = _tail.load();
+            for (auto idx = _head.load(); idx != tail; ++idx)
+                slot(idx)->~Element();
+        }
 
         template<typename Element>
         bool CircularFifo<Element>::push(Element&& item) {
-            return push_element(std::forward<Element>(item));
+            return emplace(std::move(item));
         }
 
         template<typename Element>
         bool CircularFifo<Element>::push(const Element& item) {
-            return push_element(item);
+            return emplace(item);
+        }
+
+        template<typename Element>
+        size_t CircularFifo<Element>::free_slots(size_t current_tail)
+        {
+            if (current_tail - _head_cache == _size)
+                _head_cache = _head.load(std::memory_order_acquire);
+
+            return _size - (current_tail - _head_cache);
         }
 
         template<typename Element>
-        template <typename InsertElement>
-        bool CircularFifo<Element>::push_element(InsertElement&& item)
+        size_t CircularFifo<Element>::filled_slots(size_t current_head)
+        {
+            if (current_head == _tail_cache)
+                _tail_cache = _tail.load(std::memory_order_acquire);
+
+            return _tail_cache - current_head;
+        }
+
+        template<typename Element>
+        template <typename... Args>
+        bool CircularFifo<Element>::emplace(Args&&... args)
         {	
             const auto current_tail = _tail.load(std::memory_order_relaxed); 
-            const auto next_tail = increment(current_tail); 
-            if(next_tail != _head.load(std::memory_order_acquire))                           
-            {	
-                _array[current_tail] = std::forward<InsertElement>(item);
-                _tail.store(next_tail, std::memory_order_release); 
-                return true;
+
+            if (free_slots(current_tail) == 0)
+                return false; // full queue
+
+            ::new (static_cast<void*>(slot(current_tail))) Element(std::forward<Args>(args)...);
+            _tail.store(current_tail + 1, std::memory_order_release); 
+            return true;
+        }
+
+        template<typename Element>
+        template <typename InputIterator>
+        size_t CircularFifo<Element>::push_n(InputIterator first, size_t count)
+        {
+            const auto current_tail = _tail.load(std::memory_order_relaxed); 
+
+            // A partial batch only refreshes the head once it looks full, 
+            // refresh it upfront if the cached view has too little room.
+            auto available = free_slots(current_tail);
+            if (available < count) {
+                _head_cache = _head.load(std::memory_order_acquire);
+                available = _size - (current_tail - _head_cache);
             }
 
-            return false; // full queue
+            const size_t num = available < count ? available : count;
+
+            for (size_t i = 0; i < num; ++i, ++first)
+                ::new (static_cast<void*>(slot(current_tail + i))) Element(*first);
 
+            if (num != 0)
+                _tail.store(current_tail + num, std::memory_order_release);
+            return num;
         }
 
         template<typename Element>
         bool CircularFifo<Element>::pop(Element& item)
         {
             const auto current_head = _head.load(std::memory_order_relaxed);  
-            if(current_head == _tail.load(std::memory_order_acquire)) 
+
+            if (filled_slots(current_head) == 0)
                 return false; // empty queue
 
-            item = std::move(_array[current_head]); 
-            _head.store(increment(current_head), std::memory_order_release); 
+            Element* element = slot(current_head);
+            item = std::move(*element); 
+            element->~Element();
+            _head.store(current_head + 1, std::memory_order_release); 
             return true;
         }
 
+        template<typename Element>
+        template <typename OutputIterator>
+        size_t CircularFifo<Element>::pop_n(OutputIterator out, size_t max_count)
+        {
+            const auto current_head = _head.load(std::memory_order_relaxed);  
+
+            auto available = filled_slots(current_head);
+            if (available < max_count) {
+                _tail_cache = _tail.load(std::memory_order_acquire);
+                available = _tail_cache - current_head;
+            }
+
+            const size_t num = available < max_count ? available : max_count;
+
+            for (size_t i = 0; i < num; ++i, ++out) {
+                Element* element = slot(current_head + i);
+                *out = std::move(*element);
+                element->~Element();
+            }
+
+            if (num != 0)
+                _head.store(current_head + num, std::memory_order_release);
+            return num;
+        }
+
         template<typename Element>
         bool CircularFifo<Element>::was_empty() const
         {
@@ -130,25 +261,18 @@ namespace toa {
         template<typename Element>
         bool CircularFifo<Element>::was_full() const
         {
-            const auto next_tail = increment(_tail.load()); // aquire, we dont know who call
-            return (next_tail == _head.load());
+            return had_num_elements() >= _size;
         }
 
         // snapshot with acceptance that this comparison is not atomic
         template<typename Element>
         size_t CircularFifo<Element>::had_num_elements() const
         {
-            const auto tail = _tail.load();
+            // Head first, the tail can only be ahead of it
             const auto head = _head.load();
+            const auto tail = _tail.load();
             
-            size_t num_elements = 0;
-
-            if (tail < head)
-                num_elements = (tail + _capacity) - head;
-            else
-                num_elements = tail - head;
-
-            return num_elements;
+            return tail - head;
         }
 
         template<typename Element>
@@ -158,9 +282,12 @@ namespace toa {
         }
 
         template<typename Element>
-        size_t CircularFifo<Element>::increment(size_t idx) const
+        size_t CircularFifo<Element>::ring_size(size_t size)
         {
-            return (idx + 1) % _capacity;
+            size_t result = 1;
+            while (result < size)
+                result <<= 1;
+            return result;
         }
 
         template<typename Element>
@@ -26,9 +26,20 @@
 #include <condition_variable>
 #include <stdexcept>
 #include <thread>
+#include <functional>
+#include <algorithm>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <cctype>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <emmintrin.h>
+#endif
 
 #include "CircularFifo.h"
 #include "ChronoUtils.h"
+#include "Futex.h"
 
 #ifndef _MSC_VER
 #pragma clang diagnostic push
@@ -46,9 +57,94 @@ namespace toa {
 
         enum class WaitingPolicy {
             SPIN,
-            BLOCK
+            BLOCK,
+            // Spins with exponential backoff for a while, then parks the 
+            // consumer on a futex. Producers only signal if the consumer is
+            // actually parked. How long to spin is set via WaitSettings, 
+            // which allows this to act like SPIN or BLOCK at runtime as well.
+            HYBRID
         };
 
+        static std::ostream& operator<< (std::ostream& out, const WaitingPolicy& v) {
+
+            switch (v) {
+            case WaitingPolicy::SPIN:
+                out << "spin";
+                break;
+            case WaitingPolicy::BLOCK:
+                out << "block";
+                break;
+            case WaitingPolicy::HYBRID:
+                out << "hybrid";
+                break;
+            default:
+                out << "<unknown>";
+                break;
+            }
+
+            return out;
+        }
+
+        static std::istream& operator>> (std::istream& in, WaitingPolicy& v) {
+
+            std::string token;
+            in >> token;
+
+            std::transform(token.begin(), token.end(), token.begin(), ::tolower);
+
+            if (token == "spin")
+                v = WaitingPolicy::SPIN;
+            else if (token == "block")
+                v = WaitingPolicy::BLOCK;
+            else if (token == "hybrid")
+                v = WaitingPolicy::HYBRID;
+            else
+                in.setstate(std::ios::failbit);
+
+            return in;
+        }
+
+        // Runtime settings of HYBRID fifos
+        struct WaitSettings {
+
+            // How long a waiting consumer spins before it parks. 
+            // clock::duration::max() never parks, zero parks right away.
+            clock::duration spin_duration;
+
+            WaitSettings() : spin_duration(microseconds(50)) {}
+            explicit WaitSettings(clock::duration spin_duration) : spin_duration(spin_duration) {}
+
+            // SPIN never parks, BLOCK parks right away
+            static WaitSettings for_policy(
+                WaitingPolicy policy, 
+                clock::duration hybrid_spin_duration) 
+            {
+                switch (policy) {
+                case WaitingPolicy::SPIN:
+                    return WaitSettings(clock::duration::max());
+                case WaitingPolicy::BLOCK:
+                    return WaitSettings(clock::duration::zero());
+                default:
+                    return WaitSettings(hybrid_spin_duration);
+                }
+            }
+        };
+
+        // The settings newly created fifos start with. Not synchronized, is
+        // meant to be set before a pipeline is created.
+        inline WaitSettings& default_wait_settings() {
+            static WaitSettings settings;
+            return settings;
+        }
+
+        // Called on the consumer's thread after it was woken up from being 
+        // parked, with the time the producer signaled, and the time the 
+        // consumer resumed. Only HYBRID fifos report this.
+        typedef std::function<void(const clock::time_point&, const clock::time_point&)> WakeSampleFunction;
+
+        // See FifoSampler.h, sampled by the stages pushing and popping
+        class FifoSampler;
+
         class CanceledFifoError : public std::runtime_error {
             
         public:
@@ -56,6 +152,28 @@ namespace toa {
             
         };
 
+        namespace detail {
+
+            // State shared between a waiting consumer and the producer
+            struct WaitState {
+
+                std::mutex mutex;
+                std::condition_variable condition;
+
+                Futex futex;
+                std::atomic<bool> consumer_is_parked;
+                std::atomic<clock::rep> signal_time;
+
+                WaitSettings settings;
+                WakeSampleFunction wake_sampler;
+
+                explicit WaitState(const WaitSettings& settings) : 
+                    consumer_is_parked(false),
+                    signal_time(0),
+                    settings(settings) {}
+            };
+
+        }
         
         template <typename Element, WaitingPolicy policy>
         class WaitingCircularFifo {
@@ -67,13 +185,30 @@ namespace toa {
             typedef Element ElementType;
 
             WaitingCircularFifo(
-                size_t size) : 
+                size_t size,
+                const WaitSettings& settings = default_wait_settings()) : 
                     fifo_(size),
-                    was_canceled_(false) {}
+                    wait_state_(settings),
+                    was_canceled_(false),
+                    sampler_(nullptr) {}
 
             bool pop(Element& item, bool wait_for_element = true);
             bool push(Element&& item);
             bool push(const Element& item);
+
+            // Constructs the element directly in the queue.
+            template <typename... Args>
+            bool emplace(Args&&... args);
+
+            // Batched versions, see CircularFifo. pop_n waits (if requested)
+            // until at least one element is available and then takes as many
+            // as there are, up to max_count. Any waiting consumer is notified 
+            // once per batch.
+            template <typename InputIterator>
+            size_t push_n(InputIterator first, size_t count);
+            template <typename OutputIterator>
+            size_t pop_n(OutputIterator out, size_t max_count, bool wait_for_element = true);
+
             bool was_full() const;
             bool was_empty() const;
             size_t size() const;
@@ -85,39 +220,63 @@ namespace toa {
             void cancel();
             bool has_been_canceled() const;
 
+            const WaitSettings& wait_settings() const { return wait_state_.settings; }
+
+            // Must be set before the consumer starts popping.
+            void set_wake_sampler(WakeSampleFunction sampler) { wait_state_.wake_sampler = std::move(sampler); }
+
+            // Not sampled by the queue itself, but by whoever pushes and 
+            // pops, which is why this is only a place to find it. Must be 
+            // set before the queue is used.
+            void set_sampler(FifoSampler* sampler) { sampler_ = sampler; }
+            FifoSampler* sampler() const { return sampler_; }
+
         private:
 
-            template <typename InsertElement>
-            bool push_element(InsertElement&& item);
+            template <typename PopFunction>
+            bool pop_or_wait(PopFunction pop_elements, bool wait_for_element);
+
+            void signal_parked_consumer();
 
             CircularFifo<Element> fifo_;
-            std::mutex mutex_;
-            std::condition_variable condition_;
+            detail::WaitState wait_state_;
             
             std::atomic<bool> was_canceled_;
+
+            FifoSampler* sampler_;
         };
 
         namespace detail {
 
             template <WaitingPolicy policy>
-            static bool wait_pop(
-                const std::function<bool()>& pop_function,
-                std::mutex& cv_mutex,
-                std::condition_variable& cv) 
-            {
+            struct WaitingPolicyTag {};
 
-                // Making sure that we only hit the specializations
-                static_assert(policy == WaitingPolicy::SPIN || policy == WaitingPolicy::BLOCK,
-                              "Invalid wait policy during compilation.");
-                
-                return false;
+            static const uint32_t kMaxSpinPauses = 64;
+
+            static inline void spin_pause() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+                _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#else
+                std::this_thread::yield();
+#endif
             }
 
-            template <>
-			STATIC_TSPL bool wait_pop<WaitingPolicy::SPIN>(
-                const std::function<bool()>& pop_function,
-                std::mutex&,
-                std::condition_variable&) 
+            // Clears the parked flag again, also if pop throws on cancel
+            struct ParkedFlagGuard {
+                std::atomic<bool>& flag;
+                explicit ParkedFlagGuard(std::atomic<bool>& flag) : flag(flag) { flag.store(true); }
+                ~ParkedFlagGuard() { flag.store(false); }
+            };
+
+            // The pop function is passed as a template argument rather than a
+            // std::function, this is called for every single token.
+            template <typename PopFunction>
+            static bool wait_pop(
+                PopFunction& pop_function,
+                WaitState&,
+                WaitingPolicyTag<WaitingPolicy::SPIN>) 
             {
                 
                 while (!pop_function()) {
@@ -126,99 +285,218 @@ namespace toa {
                 return true;
             }
 
-            template <>
-			STATIC_TSPL bool wait_pop<WaitingPolicy::BLOCK>(
-                const std::function<bool()>& pop_function,
-                std::mutex& cv_mutex,
-                std::condition_variable& cv) 
+            template <typename PopFunction>
+            static bool wait_pop(
+                PopFunction& pop_function,
+                WaitState& state,
+                WaitingPolicyTag<WaitingPolicy::BLOCK>) 
             {
                 
-                std::unique_lock<std::mutex> lk(cv_mutex);
-                cv.wait(lk,
+                std::unique_lock<std::mutex> lk(state.mutex);
+                state.condition.wait(lk,
                         [&]() {
                             return pop_function();
                         });
 
                 return true;
             }
-            
-            template <WaitingPolicy policy>
-            static void cancel(std::atomic<bool>& was_canceled_atomic,
-                        std::condition_variable& cv)
+
+            template <typename PopFunction>
+            static bool park(PopFunction& pop_function, WaitState& state) 
             {
-                
-                // Making sure that we only hit the specializations
-                static_assert(policy == WaitingPolicy::SPIN || policy == WaitingPolicy::BLOCK,
-                              "Invalid wait policy during compilation.");
+                ParkedFlagGuard parked(state.consumer_is_parked);
+
+                // Pairs with the fence in signal_parked_consumer(): either
+                // the producer sees the flag, or we see its element.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                for (;;) {
+
+                    const uint32_t futex_value = state.futex.value();
+
+                    if (pop_function())
+                        return true;
+
+                    state.futex.wait(futex_value);
+
+                    if (state.futex.value() != futex_value && pop_function()) {
 
+                        if (state.wake_sampler) {
+                            const clock::time_point woken = clock::now();
+                            const clock::time_point signaled(clock::duration(state.signal_time.load(std::memory_order_relaxed)));
+                            state.wake_sampler(signaled, woken);
+                        }
+
+                        return true;
+                    }
+                }
+            }
+
+            template <typename PopFunction>
+            static bool wait_pop(
+                PopFunction& pop_function,
+                WaitState& state,
+                WaitingPolicyTag<WaitingPolicy::HYBRID>) 
+            {
+                const bool may_park = state.settings.spin_duration != clock::duration::max();
+                const clock::time_point spin_start = clock::now();
+
+                uint32_t num_pauses = 1;
+
+                while (!pop_function()) {
+
+                    if (num_pauses <= kMaxSpinPauses) {
+                        for (uint32_t i = 0; i < num_pauses; ++i)
+                            spin_pause();
+                        num_pauses <<= 1;
+                    } else {
+                        std::this_thread::yield();
+                    }
+
+                    if (may_park && clock::now() - spin_start >= state.settings.spin_duration)
+                        return park(pop_function, state);
+                }
+
+                return true;
             }
             
-            template <>
-			STATIC_TSPL void cancel<WaitingPolicy::SPIN>(std::atomic<bool>& was_canceled,
-                                             std::condition_variable& cv)
+            static void cancel(std::atomic<bool>& was_canceled,
+                               WaitState&,
+                               WaitingPolicyTag<WaitingPolicy::SPIN>)
             {
                 
                 was_canceled = true;
             }
             
-            template <>
-			STATIC_TSPL void cancel<WaitingPolicy::BLOCK>(std::atomic<bool>& was_canceled,
-                                              std::condition_variable& cv)
+            static void cancel(std::atomic<bool>& was_canceled,
+                               WaitState& state,
+                               WaitingPolicyTag<WaitingPolicy::BLOCK>)
+            {
+                
+                was_canceled = true;
+                
+                state.condition.notify_one();
+            }
+
+            static void cancel(std::atomic<bool>& was_canceled,
+                               WaitState& state,
+                               WaitingPolicyTag<WaitingPolicy::HYBRID>)
             {
                 
                 was_canceled = true;
                 
-                cv.notify_one();
+                state.futex.increment_and_wake_all();
             }
 
         } 
 
         template <typename Element, WaitingPolicy policy>
-        bool WaitingCircularFifo<Element, policy>::pop(Element& item, bool wait_for_element) {
-
+        template <typename PopFunction>
+        bool WaitingCircularFifo<Element, policy>::pop_or_wait(
+            PopFunction pop_elements, 
+            bool wait_for_element) 
+        {
             auto pop_function = [&]{
                 
                 if (was_canceled_.load())
                     throw CanceledFifoError{};
                 
-                return fifo_.pop(item);
+                return pop_elements();
             };
             
             bool item_available = pop_function();
 
             if(!item_available && wait_for_element) {
-                item_available = detail::wait_pop<policy>(pop_function,
-                                                          mutex_,
-                                                          condition_);
+                item_available = detail::wait_pop(pop_function,
+                                                  wait_state_,
+                                                  detail::WaitingPolicyTag<policy>());
             }
 
             return item_available;
         }
+
+        template <typename Element, WaitingPolicy policy>
+        bool WaitingCircularFifo<Element, policy>::pop(Element& item, bool wait_for_element) {
+
+            return pop_or_wait(
+                [&]{ return fifo_.pop(item); }, 
+                wait_for_element);
+        }
+
+        template <typename Element, WaitingPolicy policy>
+        template <typename OutputIterator>
+        size_t WaitingCircularFifo<Element, policy>::pop_n(
+            OutputIterator out, 
+            size_t max_count, 
+            bool wait_for_element) 
+        {
+            if (max_count == 0)
+                return 0;
+
+            size_t num_popped = 0;
+            pop_or_wait(
+                [&]{ num_popped = fifo_.pop_n(out, max_count); return num_popped != 0; }, 
+                wait_for_element);
+
+            return num_popped;
+        }
         
         template <typename Element, WaitingPolicy policy>
         bool WaitingCircularFifo<Element, policy>::push(Element&& item) {
-            return push_element(std::forward<Element>(item));
+            return emplace(std::move(item));
         }
 
         template <typename Element, WaitingPolicy policy>
         bool WaitingCircularFifo<Element, policy>::push(const Element& item) {
-            return push_element(item);
+            return emplace(item);
+        }
+
+        template <typename Element, WaitingPolicy policy>
+        void WaitingCircularFifo<Element, policy>::signal_parked_consumer() {
+
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (wait_state_.consumer_is_parked.load(std::memory_order_relaxed)) {
+                wait_state_.signal_time.store(clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+                wait_state_.futex.increment_and_wake_one();
+            }
         }
 
         template <typename Element, WaitingPolicy policy>
-        template <typename InsertElement>
-        bool WaitingCircularFifo<Element, policy>::push_element(InsertElement&& item) {
-            // Because we can't bind r-value refs in lambdas, we'll have to use
-            // an if here... should be cheap, though.
+        template <typename... Args>
+        bool WaitingCircularFifo<Element, policy>::emplace(Args&&... args) {
             static const bool do_notify = (policy == WaitingPolicy::BLOCK);
+            static const bool do_signal = (policy == WaitingPolicy::HYBRID);
             if (do_notify) {
-                std::lock_guard<std::mutex> lk(mutex_);
-                bool result = fifo_.push(std::forward<InsertElement>(item));
+                std::lock_guard<std::mutex> lk(wait_state_.mutex);
+                bool result = fifo_.emplace(std::forward<Args>(args)...);
                 if (result)
-                    condition_.notify_one();
+                    wait_state_.condition.notify_one();
                 return result;
             } else {
-                return fifo_.push(std::forward<InsertElement>(item));
+                bool result = fifo_.emplace(std::forward<Args>(args)...);
+                if (do_signal && result)
+                    signal_parked_consumer();
+                return result;
+            }
+        }
+
+        template <typename Element, WaitingPolicy policy>
+        template <typename InputIterator>
+        size_t WaitingCircularFifo<Element, policy>::push_n(InputIterator first, size_t count) {
+            static const bool do_notify = (policy == WaitingPolicy::BLOCK);
+            static const bool do_signal = (policy == WaitingPolicy::HYBRID);
+            if (do_notify) {
+                std::lock_guard<std::mutex> lk(wait_state_.mutex);
+                size_t result = fifo_.push_n(first, count);
+                if (result != 0)
+                    wait_state_.condition.notify_one();
+                return result;
+            } else {
+                size_t result = fifo_.push_n(first, count);
+                if (do_signal && result != 0)
+                    signal_parked_consumer();
+                return result;
             }
         }
 
@@ -244,7 +522,7 @@ namespace toa {
         
         template <typename Element, WaitingPolicy policy>
         void WaitingCircularFifo<Element, policy>::cancel() {
-            detail::cancel<policy>(was_canceled_, condition_);
+            detail::cancel(was_canceled_, wait_state_, detail::WaitingPolicyTag<policy>());
         }
         
         template <typename Element, WaitingPolicy policy>
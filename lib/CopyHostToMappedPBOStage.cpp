@@ -68,7 +68,7 @@ fb::StageCommand fb::CopyHostToMappedPBOStage::perform(
 
     if (!dbg_bypass_copy_) {
 #ifndef FB_USE_INTEL_IPP_FOR_HOST_COPY
-        memcpy(
+        copy_engine_.copy(
             token_out.buffer, 
             token_in.frame.image_data(), 
             token_out.format.image_byte_size());
@@ -99,6 +99,9 @@ fb::StageCommand fb::CopyHostToMappedPBOStage::perform(
 
     token_out.composition = token_in.composition;
     token_out.time_stamp = token_in.frame.time();
+    token_out.trace_id = token_in.trace_id;
+
+    sampler_.enter_trace_id(token_in.trace_id);
     // Note that image format has to already be ok (checked above)
 
     // TODO: how to set end-of-stream in here?
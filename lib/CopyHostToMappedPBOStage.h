@@ -28,6 +28,7 @@
 #include "StageSampler.h"
 #include "UnmapPBOStage.h"
 #include "PipelineStage.h"
+#include "HostCopy.h"
 
 #include "Utils.h"
 
@@ -59,8 +60,11 @@ namespace toa {
             void execute() override { stage_.execute(); }
             PipelineStatus status() const override { return stage_.status(); }
             size_t input_queue_num_elements() const override { return stage_.input_queue_num_elements(); }
+            bool has_tokens_available() const override { return stage_.has_tokens_available(); }
             const std::string& name() const override { return stage_.name(); }
             size_t output_queue_size() const override { return stage_.output_queue_size(); } 
+            void set_wake_sampler(WakeSampleFunction sampler) override { stage_.set_wake_sampler(std::move(sampler)); }
+            std::vector<std::unique_ptr<FifoSampler>> sample_input_queues() override { return stage_.sample_input_queues(); }
 
             const StageType& stage() const { return stage_; }
 
@@ -77,6 +81,8 @@ namespace toa {
             const bool dbg_bypass_copy_;
 
             bool pbo_memory_is_persistently_mapped_;
+
+            HostCopyEngine copy_engine_;
         };        
 
         template <typename InputStage>
@@ -86,7 +92,10 @@ namespace toa {
             const InputStage& input_stage,
             bool dbg_bypass_copy,
             bool pbo_memory_is_persistently_mapped) : dbg_bypass_copy_(dbg_bypass_copy),
-              pbo_memory_is_persistently_mapped_(pbo_memory_is_persistently_mapped)
+              pbo_memory_is_persistently_mapped_(pbo_memory_is_persistently_mapped),
+              copy_engine_(
+                ProgramOptions::global().pipeline_host_copy_kernel(),
+                ProgramOptions::global().pipeline_host_copy_num_threads())
         {
             std::vector<TokenGL> init;
 
@@ -148,6 +157,8 @@ namespace toa {
 
 #ifdef FB_USE_INTEL_IPP_FOR_HOST_COPY
             FB_LOG_INFO << "Using Intel IPP for host-buffer copying.";
+#else
+            FB_LOG_INFO << "Using '" << copy_engine_.kernel() << "' for host-buffer copying on " << copy_engine_.num_threads() << " thread(s).";
 #endif
 
             if (dbg_bypass_copy_) {
@@ -52,7 +52,7 @@ fb::StageCommand fb::CopyMappedPBOToHostStage::perform(
 
     if (!dbg_bypass_copy_) {
 #ifndef FB_USE_INTEL_IPP_FOR_HOST_COPY
-        memcpy(
+        copy_engine_.copy(
             out_token.frame.image_data(), 
             in_token.buffer, 
             out_token.frame.image_format().image_byte_size());
@@ -82,7 +82,10 @@ fb::StageCommand fb::CopyMappedPBOToHostStage::perform(
     }
 
     out_token.composition = in_token.composition;
+    out_token.trace_id = in_token.trace_id;
     out_token.frame.set_time(in_token.time_stamp);
+
+    sampler_.enter_trace_id(in_token.trace_id);
     out_token.frame.set_marks_end_of_sequence(false);
     // TODO: how to set end-of-stream in here?
 
@@ -28,6 +28,7 @@
 #include "StageSampler.h"
 #include "PipelineStage.h"
 #include "ProgramOptions.h"
+#include "HostCopy.h"
 
 #include "Utils.h"
 
@@ -53,8 +54,11 @@ namespace toa {
             void execute() override { stage_.execute(); }
             PipelineStatus status() const override { return stage_.status(); }
             size_t input_queue_num_elements() const override { return stage_.input_queue_num_elements(); }
+            bool has_tokens_available() const override { return stage_.has_tokens_available(); }
             const std::string& name() const override { return stage_.name(); }
             size_t output_queue_size() const override { return stage_.output_queue_size(); } 
+            void set_wake_sampler(WakeSampleFunction sampler) override { stage_.set_wake_sampler(std::move(sampler)); }
+            std::vector<std::unique_ptr<FifoSampler>> sample_input_queues() override { return stage_.sample_input_queues(); }
 
             const StageType& stage() const { return stage_; }
 
@@ -71,6 +75,8 @@ namespace toa {
             ImageFormat format_;
 
             bool dbg_bypass_copy_;
+
+            HostCopyEngine copy_engine_;
         };        
 
         template <typename InputStage>
@@ -80,7 +86,10 @@ namespace toa {
             const InputStage& input_stage,
             bool dbg_bypass_copy) :
                 format_(frame_format),
-                dbg_bypass_copy_(dbg_bypass_copy)
+                dbg_bypass_copy_(dbg_bypass_copy),
+                copy_engine_(
+                    ProgramOptions::global().pipeline_host_copy_kernel(),
+                    ProgramOptions::global().pipeline_host_copy_num_threads())
         {
 
             std::vector<TokenFrame> init;
@@ -110,6 +119,8 @@ namespace toa {
 
 #ifdef FB_USE_INTEL_IPP_FOR_HOST_COPY
             FB_LOG_INFO << "Using Intel IPP for host-buffer copying.";
+#else
+            FB_LOG_INFO << "Using '" << copy_engine_.kernel() << "' for host-buffer copying on " << copy_engine_.num_threads() << " thread(s).";
 #endif
 
             if (dbg_bypass_copy_) {
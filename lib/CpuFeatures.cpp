@@ -0,0 +1,208 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "CpuFeatures.h"
+#include "Logging.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace fb = toa::frame_bender;
+
+namespace {
+
+    void query_cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i<4; ++i)
+            regs[i] = static_cast<unsigned int>(info[i]);
+#elif defined(__x86_64__) || defined(__i386__)
+        if (__get_cpuid_max(leaf & 0x80000000u, nullptr) >= leaf)
+            __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#else
+        (void)leaf;
+        (void)subleaf;
+#endif
+
+    }
+
+    unsigned long long read_xcr0() {
+
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#elif defined(__x86_64__) || defined(__i386__)
+        unsigned int eax = 0;
+        unsigned int edx = 0;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<unsigned long long>(edx) << 32) | eax;
+#else
+        return 0;
+#endif
+
+    }
+
+    fb::cpu::Features detect_features() {
+
+        fb::cpu::Features f;
+
+        unsigned int regs[4];
+        query_cpuid(0, 0, regs);
+        const unsigned int max_leaf = regs[0];
+
+        if (max_leaf >= 1) {
+
+            query_cpuid(1, 0, regs);
+
+            const unsigned int ecx = regs[2];
+            const unsigned int edx = regs[3];
+
+            f.sse2 = (edx & (1u << 26)) != 0;
+            f.sse41 = (ecx & (1u << 19)) != 0;
+            f.f16c = (ecx & (1u << 29)) != 0;
+
+            const bool has_osxsave = (ecx & (1u << 27)) != 0;
+            const bool has_avx = (ecx & (1u << 28)) != 0;
+
+            if (has_osxsave) {
+                // XMM (bit 1) and YMM (bit 2) state enabled by the OS
+                f.os_saves_ymm = (read_xcr0() & 0x6) == 0x6;
+            }
+
+            f.avx = has_avx && f.os_saves_ymm;
+
+        }
+
+        if (max_leaf >= 7) {
+
+            query_cpuid(7, 0, regs);
+            f.avx2 = f.avx && (regs[1] & (1u << 5)) != 0;
+
+        }
+
+        query_cpuid(0x80000000u, 0, regs);
+        const unsigned int max_extended_leaf = regs[0];
+
+        if (max_extended_leaf >= 0x80000001u) {
+
+            query_cpuid(0x80000001u, 0, regs);
+            f.rdtscp = (regs[3] & (1u << 27)) != 0;
+
+        }
+
+        if (max_extended_leaf >= 0x80000007u) {
+
+            query_cpuid(0x80000007u, 0, regs);
+            f.invariant_tsc = (regs[3] & (1u << 8)) != 0;
+
+        }
+
+        return f;
+    }
+
+}
+
+const fb::cpu::Features& fb::cpu::features() {
+
+    static const Features f = detect_features();
+    return f;
+
+}
+
+fb::cpu::SimdLevel fb::cpu::max_simd_level() {
+
+    const Features& f = features();
+
+    // Our AVX2 kernels also use F16C for the half-float conversions
+    if (f.avx2 && f.f16c)
+        return SimdLevel::avx2;
+
+    if (f.sse41)
+        return SimdLevel::sse41;
+
+    return SimdLevel::scalar;
+
+}
+
+fb::cpu::SimdLevel fb::cpu::clamp_simd_level(SimdLevel requested) {
+
+    SimdLevel max_level = max_simd_level();
+
+    if (static_cast<int32_t>(requested) > static_cast<int32_t>(max_level)) {
+        FB_LOG_WARNING 
+            << "Requested SIMD level '" << requested 
+            << "' is not supported by this CPU, falling back to '" 
+            << max_level << "'.";
+        return max_level;
+    }
+
+    return requested;
+
+}
+
+std::ostream& fb::cpu::operator<< (std::ostream& out, const cpu::SimdLevel& v) {
+
+    switch (v) {
+    case cpu::SimdLevel::scalar:
+        out << "scalar";
+        break;
+    case cpu::SimdLevel::sse41:
+        out << "sse41";
+        break;
+    case cpu::SimdLevel::avx2:
+        out << "avx2";
+        break;
+    default:
+        out << "<unknown>";
+        break;
+    }
+
+    return out;
+
+}
+
+std::istream& fb::cpu::operator>>(std::istream& in, cpu::SimdLevel& v) {
+
+    std::string token;
+    in >> token;
+
+    std::transform(token.begin(), token.end(),token.begin(), ::tolower);
+
+    if (token == "scalar")
+        v = cpu::SimdLevel::scalar;
+    else if (token == "sse41")
+        v = cpu::SimdLevel::sse41;
+    else if (token == "avx2")
+        v = cpu::SimdLevel::avx2;
+    else {
+        in.setstate(std::ios::failbit);
+    }
+
+    return in;
+
+}
@@ -0,0 +1,82 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_CPU_FEATURES_H
+#define TOA_FRAME_BENDER_CPU_FEATURES_H
+
+#include <iosfwd>
+#include <cstdint>
+
+namespace toa {
+    namespace frame_bender {
+        namespace cpu {
+
+            // Instruction set extensions we have hand-written kernels for.
+            // Note that the levels are ordered, i.e. a CPU supporting AVX2
+            // also supports all the levels before.
+            enum class SimdLevel : int32_t {
+                scalar,
+                sse41,
+                avx2,
+                count
+            };
+
+            struct Features {
+                bool sse2;
+                bool sse41;
+                bool avx;
+                bool avx2;
+                bool f16c;
+                // The OS saves the YMM state on context switches (XGETBV)
+                bool os_saves_ymm;
+                bool rdtscp;
+                // The TSC ticks at a constant rate regardless of P-/C-states,
+                // and is synchronized across cores
+                bool invariant_tsc;
+
+                Features() :
+                    sse2(false),
+                    sse41(false),
+                    avx(false),
+                    avx2(false),
+                    f16c(false),
+                    os_saves_ymm(false),
+                    rdtscp(false),
+                    invariant_tsc(false) {}
+            };
+
+            // Queried once via CPUID, thread-safe after first call.
+            const Features& features();
+
+            // Best level the current CPU is able to execute.
+            SimdLevel max_simd_level();
+
+            // Returns the requested level, clamped to what the CPU supports.
+            SimdLevel clamp_simd_level(SimdLevel requested);
+
+            std::ostream& operator<< (std::ostream& out, const SimdLevel& v);
+            std::istream& operator>>(std::istream& in, SimdLevel& v);
+
+        }
+    }
+}
+
+#endif // TOA_FRAME_BENDER_CPU_FEATURES_H
@@ -0,0 +1,367 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "CpuFormatConverter.h"
+#include "FormatConverterStage.h"
+#include "Logging.h"
+
+#include <cstring>
+
+namespace fb = toa::frame_bender;
+
+namespace {
+
+    // Same as bt709_rgb_to_ycbcr_inv in common.glsl (column-major)
+    const float kBt709YCbCrToRgb[9] = {
+        0.0011415525114155253f,0.0011415525114155251f,0.0011415525114155255f,
+        -2.8740650732344318e-20f,-0.00020906726889581339f,0.0020709821428571431f,
+        0.0017575892857142855f,-0.00052246012603867058f,-1.6263032587282567e-19f };
+
+    // Derived the same way as the BT.709 matrix, with Kr = 0.299 and 
+    // Kb = 0.114 (Poynton, Eq. 29.4 ff.)
+    const float kBt601YCbCrToRgb[9] = {
+        0.001141552511415525f,0.001141552511415525f,0.001141552511415525f,
+        0.0f,-0.0003840806765636408f,0.0019776785714285716f,
+        0.0015647321428571429f,-0.0007970271051350693f,0.0f };
+
+    // Same as bt709_rgb_to_ycbcr in common.glsl (column-major)
+    const float kBt709RgbToYCbCr[9] = {
+        186.23760000000001f,-102.65660702737659f,448.0f,
+        626.51519999999994f,-345.34339297262341f,-406.92100584201171f,
+        63.247199999999999f,447.99999999999994f,-41.078994157988319f };
+
+    const float kBt601RgbToYCbCr[9] = {
+        261.924f,-151.18735891647856f,448.0f,
+        514.212f,-296.81264108352144f,-375.1440798858773f,
+        99.864f,448.0f,-72.85592011412268f };
+
+    void set_taps(
+        fb::v210::ChromaTaps& taps, 
+        std::initializer_list<int32_t> weights, 
+        int32_t first, 
+        int32_t shift) 
+    {
+        FB_ASSERT(weights.size() <= static_cast<size_t>(fb::v210::ChromaTaps::kMaxCount));
+
+        taps.count = static_cast<int32_t>(weights.size());
+        std::copy(weights.begin(), weights.end(), taps.weights);
+        taps.first = first;
+        taps.shift = shift;
+    }
+
+    // See v210_decode_constants.glsl, the first tap is relative to the 
+    // chroma sample left of the interpolated position.
+    void set_decode_taps(fb::v210::ChromaTaps& taps, fb::ChromaFilter filter) {
+
+        switch (filter) {
+        case fb::ChromaFilter::none:
+            // {1.0, 0.0}, dropping the zero tap
+            set_taps(taps, {1}, 0, 0);
+            break;
+        case fb::ChromaFilter::basic:
+            set_taps(taps, {1, 1}, 0, 1);
+            break;
+        case fb::ChromaFilter::high:
+            set_taps(taps, {-2, 6, -12, 24, -48, 160, 160, -48, 24, -12, 6, -2}, -5, 8);
+            break;
+        case fb::ChromaFilter::count:
+        default:
+            throw std::invalid_argument("Invalid chroma filter value.");
+        }
+
+    }
+
+    // See v210_encode_constants.glsl, taps are centered around the 4:4:4
+    // sample which is kept by the subsampling.
+    void set_encode_taps(fb::v210::ChromaTaps& taps, fb::ChromaFilter filter) {
+
+        switch (filter) {
+        case fb::ChromaFilter::none:
+            set_taps(taps, {1}, 0, 0);
+            break;
+        case fb::ChromaFilter::basic:
+            set_taps(taps, {1, 2, 1}, -1, 2);
+            break;
+        case fb::ChromaFilter::high:
+            set_taps(taps, {-1, 3, -6, 12, -24, 80, 128, 80, -24, 12, -6, 3, -1}, -6, 8);
+            break;
+        case fb::ChromaFilter::count:
+        default:
+            throw std::invalid_argument("Invalid chroma filter value.");
+        }
+
+    }
+
+    fb::v210::RgbaLayout rgba_layout(fb::ImageFormat::PixelFormat pixel_format) {
+
+        switch (pixel_format) {
+        case fb::ImageFormat::PixelFormat::RGBA_16BIT:
+            return fb::v210::RgbaLayout::unorm16;
+        case fb::ImageFormat::PixelFormat::RGBA_FLOAT_16BIT:
+            return fb::v210::RgbaLayout::half_float;
+        case fb::ImageFormat::PixelFormat::RGBA_FLOAT_32BIT:
+            return fb::v210::RgbaLayout::float32;
+        default:
+            throw std::invalid_argument("Unsupported RGBA pixel format for CPU conversion.");
+        }
+
+    }
+
+    bool is_supported_rgba_format(fb::ImageFormat::PixelFormat pixel_format) {
+        return pixel_format == fb::ImageFormat::PixelFormat::RGBA_16BIT ||
+            pixel_format == fb::ImageFormat::PixelFormat::RGBA_FLOAT_16BIT ||
+            pixel_format == fb::ImageFormat::PixelFormat::RGBA_FLOAT_32BIT;
+    }
+
+}
+
+fb::CpuFormatConverter::RowScratch::RowScratch(size_t width) :
+    memory_(5 * (width + 2 * v210::kChromaPadding), 0)
+{
+
+    const size_t row_size = width + 2 * v210::kChromaPadding;
+
+    buffers_.luma = memory_.data();
+    buffers_.cb = memory_.data() + row_size;
+    buffers_.cr = memory_.data() + 2 * row_size;
+    buffers_.cb_full = memory_.data() + 3 * row_size;
+    buffers_.cr_full = memory_.data() + 4 * row_size;
+
+}
+
+fb::CpuFormatConverter::CpuFormatConverter(
+    ImageFormat input_format,
+    ImageFormat output_format,
+    ChromaFilter chroma_filter,
+    bool linear_rgb,
+    cpu::SimdLevel max_simd_level,
+    size_t num_threads) :
+        input_format_(std::move(input_format)),
+        output_format_(std::move(output_format)),
+        flip_image_(false),
+        input_row_size_(0),
+        output_row_size_(0),
+        simd_level_(cpu::clamp_simd_level(max_simd_level)),
+        row_function_(nullptr),
+        num_stripes_(1)
+{
+
+    if (!is_supported(input_format_, output_format_)) {
+        FB_LOG_ERROR 
+            << "CPU format conversion from '" << input_format_.pixel_format() 
+            << "' to '" << output_format_.pixel_format() << "' is not supported.";
+        throw std::invalid_argument("Unsupported formats for CPU format conversion.");
+    }
+
+    // Same as in the GLSL implementation, see FB_GLSL_FLIP_ORIGIN
+    flip_image_ = input_format_.origin() != output_format_.origin();
+
+    input_row_size_ = input_format_.image_byte_size() / input_format_.height();
+    output_row_size_ = output_format_.image_byte_size() / output_format_.height();
+
+    std::memset(&setup_, 0, sizeof(setup_));
+
+    const bool decode = input_format_.pixel_format() == ImageFormat::PixelFormat::YUV_10BIT_V210;
+
+    const ImageFormat& rgba_format = decode ? output_format_ : input_format_;
+    const ImageFormat& v210_format = decode ? input_format_ : output_format_;
+
+    setup_.width = rgba_format.width();
+    setup_.linear_rgb = linear_rgb;
+    setup_.rgba_layout = rgba_layout(rgba_format.pixel_format());
+
+    const bool is_bt601 = v210_format.chromaticity() == ImageFormat::Chromaticity::BT_601;
+
+    const float* matrix = nullptr;
+
+    if (decode) {
+        set_decode_taps(setup_.taps, chroma_filter);
+        matrix = is_bt601 ? kBt601YCbCrToRgb : kBt709YCbCrToRgb;
+    } else {
+        set_encode_taps(setup_.taps, chroma_filter);
+        matrix = is_bt601 ? kBt601RgbToYCbCr : kBt709RgbToYCbCr;
+    }
+
+    std::copy(matrix, matrix + 9, setup_.matrix);
+
+    setup_.transfer_table = nullptr;
+
+    if (!decode && linear_rgb && setup_.rgba_layout != v210::RgbaLayout::float32) {
+        transfer_table_.resize(v210::kTransferTableSize);
+        v210::build_encode_transfer_table(setup_.rgba_layout, transfer_table_.data());
+        setup_.transfer_table = transfer_table_.data();
+    }
+
+    switch (simd_level_) {
+    case cpu::SimdLevel::avx2:
+        row_function_ = decode ? &v210::decode_row_avx2 : &v210::encode_row_avx2;
+        break;
+    case cpu::SimdLevel::sse41:
+        row_function_ = decode ? &v210::decode_row_sse41 : &v210::encode_row_sse41;
+        break;
+    case cpu::SimdLevel::scalar:
+    default:
+        row_function_ = decode ? &v210::decode_row_scalar : &v210::encode_row_scalar;
+        break;
+    }
+
+    if (num_threads == 0) {
+        num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    // At least one row per stripe
+    num_stripes_ = std::min<size_t>(num_threads, output_format_.height());
+
+    if (num_stripes_ > 1) {
+        worker_pool_ = utils::make_unique<WorkerPool>(num_stripes_);
+    }
+
+    for (size_t i = 0; i < num_stripes_; ++i) {
+        scratch_.push_back(create_row_scratch());
+    }
+
+    FB_LOG_INFO 
+        << "CPU format converter from '" << input_format_.pixel_format() 
+        << "' to '" << output_format_.pixel_format() << "' is using '" 
+        << simd_level_ << "' kernels and chroma filter '" 
+        << chroma_filter << "' on " << num_stripes_ << " stripe(s).";
+
+}
+
+bool fb::CpuFormatConverter::is_supported(
+    const ImageFormat& input_format, 
+    const ImageFormat& output_format)
+{
+
+    if (input_format.width() != output_format.width() || 
+        input_format.height() != output_format.height()) 
+    {
+        return false;
+    }
+
+    const bool is_decoding = 
+        input_format.pixel_format() == ImageFormat::PixelFormat::YUV_10BIT_V210 &&
+        is_supported_rgba_format(output_format.pixel_format());
+
+    const bool is_encoding = 
+        is_supported_rgba_format(input_format.pixel_format()) &&
+        output_format.pixel_format() == ImageFormat::PixelFormat::YUV_10BIT_V210;
+
+    return is_decoding || is_encoding;
+
+}
+
+std::unique_ptr<fb::CpuFormatConverter::RowScratch> fb::CpuFormatConverter::create_row_scratch() const {
+    return utils::make_unique<RowScratch>(output_format_.width());
+}
+
+std::pair<size_t, size_t> fb::CpuFormatConverter::stripe_rows(size_t stripe) const {
+
+    FB_ASSERT(stripe < num_stripes_);
+
+    const size_t height = output_format_.height();
+
+    return std::make_pair(
+        stripe * height / num_stripes_, 
+        (stripe + 1) * height / num_stripes_);
+
+}
+
+void fb::CpuFormatConverter::set_stripe_sample_functions(std::vector<SampleFunction> functions) {
+
+    if (!functions.empty() && functions.size() != num_stripes_) {
+        FB_LOG_ERROR 
+            << "Expected " << num_stripes_ << " stripe sample functions, got " 
+            << functions.size() << ".";
+        throw std::invalid_argument("Invalid number of stripe sample functions.");
+    }
+
+    stripe_sample_functions_ = std::move(functions);
+
+}
+
+void fb::CpuFormatConverter::convert(const uint8_t* src, uint8_t* dst) {
+
+    // V210 only subsamples horizontally, so the chroma filters never reach
+    // into neighbouring rows and the stripes don't need to overlap: each row
+    // reads exactly one source row and writes one destination row. The 
+    // result is therefore identical to a single-threaded conversion.
+
+    if (num_stripes_ == 1) {
+        convert_stripe(src, dst, 0, *scratch_.front());
+        return;
+    }
+
+    worker_pool_->run(
+        num_stripes_, 
+        [&](size_t stripe, size_t worker) {
+            convert_stripe(src, dst, stripe, *scratch_[worker]);
+        });
+
+}
+
+void fb::CpuFormatConverter::convert_stripe(
+    const uint8_t* src, 
+    uint8_t* dst, 
+    size_t stripe, 
+    RowScratch& scratch) const
+{
+
+    const SampleFunction* sample = stripe_sample_functions_.empty() ? 
+        nullptr : &stripe_sample_functions_[stripe];
+
+    if (sample && *sample)
+        (*sample)(StageExecutionState::TASK_BEGIN);
+
+    const auto rows = stripe_rows(stripe);
+    convert_rows(src, dst, rows.first, rows.second, scratch);
+
+    if (sample && *sample)
+        (*sample)(StageExecutionState::TASK_END);
+
+}
+
+void fb::CpuFormatConverter::convert_rows(
+    const uint8_t* src, 
+    uint8_t* dst, 
+    size_t first_row, 
+    size_t end_row,
+    RowScratch& scratch) const
+{
+
+    FB_ASSERT(end_row <= output_format_.height());
+
+    const size_t height = output_format_.height();
+
+    for (size_t row = first_row; row < end_row; ++row) {
+
+        const size_t src_row = flip_image_ ? height - 1 - row : row;
+
+        row_function_(
+            setup_, 
+            src + src_row * input_row_size_, 
+            dst + row * output_row_size_, 
+            scratch.buffers());
+
+    }
+
+}
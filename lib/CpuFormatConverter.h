@@ -0,0 +1,134 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_CPU_FORMAT_CONVERTER_H
+#define TOA_FRAME_BENDER_CPU_FORMAT_CONVERTER_H
+
+#include <memory>
+#include <vector>
+
+#include "ImageFormat.h"
+#include "FormatOptions.h"
+#include "CpuFeatures.h"
+#include "V210CpuKernels.h"
+#include "WorkerPool.h"
+#include "Stage.h"
+#include "Utils.h"
+
+namespace toa {
+    namespace frame_bender {
+
+        // Host-side implementation of the V210 format conversions (V210 to
+        // RGBA and back), used by FormatConverterStage in Mode::cpu_simd. 
+        // The results follow the GLSL converters (same matrices, chroma 
+        // filters, edge handling and transfer functions), so both paths can 
+        // be compared against each other.
+        class CpuFormatConverter : public utils::NoCopyingOrMoving {
+
+        public:
+
+            // Scratch memory for converting a single row. Each thread calling
+            // convert_rows() concurrently needs its own instance.
+            class RowScratch : public utils::NoCopyingOrMoving {
+            public:
+                explicit RowScratch(size_t width);
+                const v210::RowBuffers& buffers() const { return buffers_; }
+            private:
+                std::vector<int32_t> memory_;
+                v210::RowBuffers buffers_;
+            };
+
+            CpuFormatConverter(
+                ImageFormat input_format,
+                ImageFormat output_format,
+                ChromaFilter chroma_filter,
+                bool linear_rgb,
+                cpu::SimdLevel max_simd_level,
+                // Number of horizontal stripes converted in parallel, 0 uses
+                // one per hardware thread.
+                size_t num_threads = 1);
+
+            static bool is_supported(
+                const ImageFormat& input_format, 
+                const ImageFormat& output_format);
+
+            // Converts a complete image, split into num_stripes() stripes 
+            // that are converted on the worker pool. Not thread-safe.
+            void convert(const uint8_t* src, uint8_t* dst);
+
+            // Converts the rows [first_row, end_row) of the output image. 
+            // Can be called concurrently for disjoint row ranges.
+            void convert_rows(
+                const uint8_t* src, 
+                uint8_t* dst, 
+                size_t first_row, 
+                size_t end_row,
+                RowScratch& scratch) const;
+
+            std::unique_ptr<RowScratch> create_row_scratch() const;
+
+            const ImageFormat& input_format() const { return input_format_; }
+            const ImageFormat& output_format() const { return output_format_; }
+
+            cpu::SimdLevel simd_level() const { return simd_level_; }
+
+            size_t num_stripes() const { return num_stripes_; }
+
+            // Rows [first, end) of the output image covered by a stripe
+            std::pair<size_t, size_t> stripe_rows(size_t stripe) const;
+
+            // Called with TASK_BEGIN / TASK_END around the conversion of each
+            // stripe, on the thread converting it. Either empty or one 
+            // function per stripe.
+            void set_stripe_sample_functions(std::vector<SampleFunction> functions);
+
+        private:
+
+            ImageFormat input_format_;
+            ImageFormat output_format_;
+
+            bool flip_image_;
+            size_t input_row_size_;
+            size_t output_row_size_;
+
+            cpu::SimdLevel simd_level_;
+            v210::ConversionSetup setup_;
+            v210::RowFunction row_function_;
+            std::vector<float> transfer_table_;
+
+            void convert_stripe(
+                const uint8_t* src, 
+                uint8_t* dst, 
+                size_t stripe, 
+                RowScratch& scratch) const;
+
+            size_t num_stripes_;
+            std::unique_ptr<WorkerPool> worker_pool_;
+            // One per worker
+            std::vector<std::unique_ptr<RowScratch>> scratch_;
+            std::vector<SampleFunction> stripe_sample_functions_;
+
+        };
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_CPU_FORMAT_CONVERTER_H
@@ -0,0 +1,145 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "FifoSampler.h"
+#include "SampleClock.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+
+namespace fb = toa::frame_bender;
+namespace bc = boost::chrono;
+
+fb::FifoSampler::FifoSampler(std::string name, size_t capacity) :
+    name_(std::move(name)),
+    capacity_(capacity),
+    push_events_(kNumMaxTraceEvents),
+    num_push_events_(0),
+    push_overflow_(0),
+    pop_events_(kNumMaxTraceEvents),
+    num_pop_events_(0),
+    pop_overflow_(0)
+{
+}
+
+fb::clock::time_point fb::FifoSampler::now() {
+    return sample_clock::now();
+}
+
+void fb::FifoSampler::enter_push(const clock::time_point& time, size_t occupancy) {
+
+    if (num_push_events_ == push_events_.size()) {
+        push_overflow_++;
+        return;
+    }
+
+    PushEvent& event = push_events_[num_push_events_++];
+    event.time = time;
+    event.occupancy = static_cast<uint32_t>(occupancy);
+
+}
+
+void fb::FifoSampler::enter_pop(
+    const clock::time_point& time, 
+    size_t occupancy, 
+    const clock::time_point& enqueue_time) 
+{
+
+    if (num_pop_events_ == pop_events_.size()) {
+        pop_overflow_++;
+        return;
+    }
+
+    PopEvent& event = pop_events_[num_pop_events_++];
+    event.time = time;
+    event.occupancy = static_cast<uint32_t>(occupancy);
+    event.dwell_time = enqueue_time == clock::time_point() ? 
+        clock::duration(-1) : 
+        time - enqueue_time;
+
+}
+
+const fb::FifoSampler::PushEvent& fb::FifoSampler::get_push_event(size_t idx) const {
+
+    if (idx >= num_push_events_) {
+        FB_LOG_ERROR << "Push event " << idx << " of queue '" << name_ << "' is out of bounds.";
+        throw std::invalid_argument("Push event index is out of bounds.");
+    }
+
+    return push_events_[idx];
+
+}
+
+const fb::FifoSampler::PopEvent& fb::FifoSampler::get_pop_event(size_t idx) const {
+
+    if (idx >= num_pop_events_) {
+        FB_LOG_ERROR << "Pop event " << idx << " of queue '" << name_ << "' is out of bounds.";
+        throw std::invalid_argument("Pop event index is out of bounds.");
+    }
+
+    return pop_events_[idx];
+
+}
+
+std::ostream& fb::operator<< (std::ostream& out, const FifoSampler& v) {
+
+    size_t num_full = 0;
+    uint64_t occupancy_sum = 0;
+
+    for (size_t i = 0; i<v.number_of_push_events(); ++i) {
+        const auto& event = v.get_push_event(i);
+        occupancy_sum += event.occupancy;
+        if (event.occupancy >= v.capacity())
+            num_full++;
+    }
+
+    size_t num_empty = 0;
+    size_t num_dwell_times = 0;
+    clock::duration dwell_sum = clock::duration::zero();
+    clock::duration dwell_max = clock::duration::zero();
+
+    for (size_t i = 0; i<v.number_of_pop_events(); ++i) {
+        const auto& event = v.get_pop_event(i);
+        occupancy_sum += event.occupancy;
+        if (event.occupancy == 0)
+            num_empty++;
+        if (event.dwell_time >= clock::duration::zero()) {
+            dwell_sum += event.dwell_time;
+            dwell_max = std::max(dwell_max, event.dwell_time);
+            num_dwell_times++;
+        }
+    }
+
+    const size_t num_events = v.number_of_push_events() + v.number_of_pop_events();
+
+    out << "Queue '" << v.name() << "': [";
+    out << "capacity: " << v.capacity() << ", ";
+    out << "average occupancy: " << (num_events != 0 ? static_cast<double>(occupancy_sum) / num_events : 0.0) << ", ";
+    out << "full after push: " << num_full << " of " << v.number_of_push_events() << ", ";
+    out << "empty after pop: " << num_empty << " of " << v.number_of_pop_events() << ", ";
+    out << "average dwell time: " << bc::duration_cast<bc::microseconds>(num_dwell_times != 0 ? dwell_sum / static_cast<int64_t>(num_dwell_times) : clock::duration::zero()) << ", ";
+    out << "maximum dwell time: " << bc::duration_cast<bc::microseconds>(dwell_max) << "].";
+
+    return out;
+}
@@ -0,0 +1,118 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_FIFO_SAMPLER_H
+#define TOA_FRAME_BENDER_FIFO_SAMPLER_H
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+
+#include "Utils.h"
+#include "ChronoUtils.h"
+
+namespace toa {
+    namespace frame_bender {
+
+        // Samples a queue between two pipeline stages: how many tokens it 
+        // holds right after every push and every pop, and how long each 
+        // token waited in it. This tells a starving queue (always empty 
+        // after a pop) from a full one (always full after a push), i.e. 
+        // which stage is the bottleneck, and which queues hold more tokens
+        // than they ever need.
+        //
+        // Pushes are entered by the producing stage and pops by the 
+        // consuming one, each side from one thread at a time, so no locking
+        // is required. Only the first kNumMaxTraceEvents of each side are 
+        // kept. See Stage::sample_input_queues().
+        class FifoSampler : public utils::NoCopyingOrMoving {
+
+        public:
+
+            struct PushEvent {
+                clock::time_point time;
+                uint32_t occupancy;
+            };
+
+            struct PopEvent {
+                clock::time_point time;
+                uint32_t occupancy;
+                // Since the token was pushed, negative for tokens that the
+                // queue was initialized with
+                clock::duration dwell_time;
+            };
+
+            static const size_t kNumMaxTraceEvents = 10000;
+
+            FifoSampler(std::string name, size_t capacity);
+
+            // Time stamps for pushing and popping, same as for StageSampler
+            static clock::time_point now();
+
+            void enter_push(const clock::time_point& time, size_t occupancy);
+
+            // Tokens that were never pushed have a default enqueue_time
+            void enter_pop(
+                const clock::time_point& time, 
+                size_t occupancy, 
+                const clock::time_point& enqueue_time);
+
+            // e.g. "UnmapPboStage -> UnpackPboToTextureStage"
+            const std::string& name() const { return name_; }
+            size_t capacity() const { return capacity_; }
+
+            size_t number_of_push_events() const { return num_push_events_; }
+            size_t number_of_pop_events() const { return num_pop_events_; }
+
+            // throw if out of bounds
+            const PushEvent& get_push_event(size_t idx) const;
+            const PopEvent& get_pop_event(size_t idx) const;
+
+            // Events that didn't fit anymore
+            size_t push_overflow() const { return push_overflow_; }
+            size_t pop_overflow() const { return pop_overflow_; }
+
+        private:
+
+            std::string name_;
+            size_t capacity_;
+
+            std::vector<PushEvent> push_events_;
+            size_t num_push_events_;
+            size_t push_overflow_;
+
+            // Written by the consumer only, keep it off the producer's lines
+            char padding_[kCacheLineSize];
+
+            std::vector<PopEvent> pop_events_;
+            size_t num_pop_events_;
+            size_t pop_overflow_;
+
+        };
+
+        // One line summary of occupancy and dwell times
+        std::ostream& operator<< (std::ostream& out, const FifoSampler& v);
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_FIFO_SAMPLER_H
@@ -0,0 +1,205 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+
+#include "FillMappedPBOStage.h"
+#include "UnmapPBOStage.h"
+#include "ProgramOptions.h"
+#include "StreamComposition.h"
+#include "StreamSource.h"
+#include "Frame.h"
+
+namespace fb = toa::frame_bender;
+
+fb::FillMappedPBOStage::FillMappedPBOStage(
+    const PboMemVector& startup_pipeline_pbos,
+    ImageFormat pbo_image_format,
+    bool dbg_bypass_copy,
+    bool pbo_memory_is_persistently_mapped) : 
+        head_composition_(nullptr),
+        dbg_bypass_copy_(dbg_bypass_copy),
+        pbo_memory_is_persistently_mapped_(pbo_memory_is_persistently_mapped),
+        copy_engine_(
+            ProgramOptions::global().pipeline_host_copy_kernel(),
+            ProgramOptions::global().pipeline_host_copy_num_threads()),
+        num_frames_filled_(0),
+        num_frames_copied_(0)
+{
+    std::vector<TokenGL> init;
+
+    size_t buffer_size = pbo_image_format.image_byte_size();
+
+    // These need to be pre-mapped, see CopyHostToMappedPBOStage
+    for (auto& pbo : startup_pipeline_pbos) {
+
+        GLbitfield access = UnmapPBOStage::pbo_access;
+
+        if (pbo_memory_is_persistently_mapped_)
+            access |= GL_MAP_PERSISTENT_BIT;
+
+        uint8_t* buffer_data = gl::utils::map_pbo(
+            pbo.pbo_id, 
+            buffer_size, 
+            UnmapPBOStage::pbo_target, 
+            access);
+
+        if (buffer_data == nullptr) {
+            FB_LOG_CRITICAL 
+                << "Couldn't map pbo '" << pbo.pbo_id 
+                << "' during construction of Fill stage.";
+            throw std::runtime_error("Mapped buffer was null.");
+        }
+
+        init.push_back(TokenGL(
+            0,
+            pbo.pbo_id,
+            pbo_image_format,
+            Time(0, 1),
+            0,
+            nullptr,
+            buffer_data
+            ));
+    }
+
+    SampleFunction fnc;
+
+    if (ProgramOptions::global().sample_stages()) {
+        fnc = std::bind(&StageSampler::sample, &sampler_, std::placeholders::_1);
+    }
+
+    // Named like FrameCompositionInputStage, as this is the head of the 
+    // pipeline for throughput statistics and traces.
+    stage_ = utils::create_producer_stage<TokenGL>(
+        "FrameInput",
+        std::bind(
+            &FillMappedPBOStage::perform, 
+            this, 
+            std::placeholders::_1),
+        std::move(init),
+        std::move(fnc));
+
+    FB_LOG_INFO << "Input frames are filled into mapped PBOs in place, if the source supports it.";
+
+}
+
+fb::FillMappedPBOStage::~FillMappedPBOStage() {
+
+    if (ProgramOptions::global().sample_stages()) {
+        auto stats = sampler_.collect_statistics();
+        for (const auto& stat : stats) {
+            FB_LOG_INFO << stage_.name() << ": " << stat;
+        }
+    }
+
+    FB_LOG_INFO 
+        << stage_.name() << ": Filled " << num_frames_filled_ 
+        << " frames in place, copied " << num_frames_copied_ << " frames.";
+
+    stage_.flush([](TokenGL& el){
+        if (el.gl_fence && glIsSync(el.gl_fence)) {
+          glDeleteSync(el.gl_fence);
+          el.gl_fence = 0;
+        }
+    });
+}
+
+void fb::FillMappedPBOStage::set_composition(StreamComposition* composition) {
+
+    head_composition_.store(composition);
+
+    if (composition != nullptr) {
+        FB_LOG_INFO << "Transitioned '" << composition->name() << "' into running state.";
+    } else {
+        FB_LOG_INFO << "Canceling stage (composition==nullptr).";
+    }
+
+}
+
+fb::StageCommand fb::FillMappedPBOStage::perform(TokenGL& token_out) {
+
+    // Get snapshot
+    StreamComposition* composition = head_composition_.load();
+
+    if (composition == nullptr || 
+        composition->first_source().state() == StreamSource::State::END_OF_STREAM) {
+        return StageCommand::STOP_EXECUTION;
+    }
+
+    StreamSource& source = composition->first_source();
+
+    if (source.can_fill_in_place()) {
+
+        bool frame_available = source.fill_frame(
+            token_out.buffer, 
+            token_out.format, 
+            token_out.time_stamp);
+
+        FB_ASSERT_MESSAGE(
+            frame_available, 
+            "Could not fill frame from input source during upload.");
+
+        num_frames_filled_++;
+
+    } else {
+
+        Frame frame;
+        bool frame_available = source.pop_frame(frame);
+
+        FB_ASSERT_MESSAGE(
+            frame_available && frame.is_valid(), 
+            "Could not retrieve frame from input source during upload.");
+
+        if (token_out.format != frame.image_format()) {
+            FB_LOG_CRITICAL << "Image format mismatch. Input: " 
+                << frame.image_format() << ", output: " 
+                << token_out.format << ".";
+            return StageCommand::STOP_EXECUTION;
+        }
+
+        if (!dbg_bypass_copy_) {
+            copy_engine_.copy(
+                token_out.buffer, 
+                frame.image_data(), 
+                token_out.format.image_byte_size());
+        }
+
+        token_out.time_stamp = frame.time();
+
+        source.invalidate_frame(std::move(frame));
+
+        num_frames_copied_++;
+    }
+
+#ifdef DEBUG_PIPE_FLOW
+
+    FB_LOG_DEBUG << stage_.name() << ": Filled frame '" << token_out.time_stamp << "' into mapped memory of PBO '" << token_out.id << "'.";
+
+#endif
+
+    token_out.composition = composition;
+    token_out.trace_id = trace_ids_.next();
+
+    sampler_.enter_trace_id(token_out.trace_id);
+
+    return StageCommand::NO_CHANGE;
+
+}
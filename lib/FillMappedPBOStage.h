@@ -0,0 +1,110 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_FILL_MAPPED_PBO_STAGE_H
+#define TOA_FRAME_BENDER_FILL_MAPPED_PBO_STAGE_H
+
+#include <vector>
+#include <atomic>
+#include "Stage.h"
+#include "StageDataTypes.h"
+#include "StageSampler.h"
+#include "PipelineStage.h"
+#include "HostCopy.h"
+
+#include "Utils.h"
+
+namespace toa { 
+
+    namespace frame_bender {
+
+        class StreamComposition;
+
+        /**
+         * Zero-copy alternative to FrameCompositionInputStage followed by 
+         * CopyHostToMappedPBOStage. The composition's source writes its 
+         * frames straight into the mapped upload PBOs (see 
+         * StreamSource::fill_frame()), so there is neither a host copy nor
+         * an intermediate Frame. Sources which can't fill in place are 
+         * still served, by popping their frame and copying it into the PBO.
+         */
+        class FillMappedPBOStage : public utils::NoCopyingOrMoving, public PipelineStage  {
+
+        public:
+
+            typedef Stage<NO_INPUT, TokenGL> StageType;
+
+            FillMappedPBOStage(
+                // Same as for CopyHostToMappedPBOStage, these are expected 
+                // to be "unmapped" and also define the pipeline size of 
+                // this stage. The creator has to keep them valid as long as
+                // this stage exists.
+                const PboMemVector& startup_pipeline_pbos,
+                ImageFormat pbo_image_format,
+                bool dbg_bypass_copy,
+                bool pbo_memory_is_persistently_mapped);
+
+            ~FillMappedPBOStage();
+
+            // thread safe
+            void set_composition(StreamComposition* composition);
+
+            void execute() override { stage_.execute(); }
+            PipelineStatus status() const override { return stage_.status(); }
+            size_t input_queue_num_elements() const override { return stage_.input_queue_num_elements(); }
+            bool has_tokens_available() const override { return stage_.has_tokens_available(); }
+            const std::string& name() const override { return stage_.name(); }
+            size_t output_queue_size() const override { return stage_.output_queue_size(); } 
+            void set_wake_sampler(WakeSampleFunction sampler) override { stage_.set_wake_sampler(std::move(sampler)); }
+            std::vector<std::unique_ptr<FifoSampler>> sample_input_queues() override { return stage_.sample_input_queues(); }
+
+            const StageType& stage() const { return stage_; }
+
+            const StageSampler& sampler() const { return sampler_; }
+
+        private:
+
+            StageCommand perform(TokenGL& token_out);
+
+            StageType stage_;
+
+            std::atomic<StreamComposition*> head_composition_;
+
+            TraceIdGenerator trace_ids_;
+            StageSampler sampler_;
+
+            const bool dbg_bypass_copy_;
+
+            bool pbo_memory_is_persistently_mapped_;
+
+            // For sources which can't fill in place
+            HostCopyEngine copy_engine_;
+
+            // Frames filled in place vs. copied, for the summary
+            size_t num_frames_filled_;
+            size_t num_frames_copied_;
+        };        
+
+    }
+
+}
+
+#endif // TOA_FRAME_BENDER_FILL_MAPPED_PBO_STAGE_H
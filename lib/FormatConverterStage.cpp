@@ -47,6 +47,13 @@ fb::FormatConverterStage::~FormatConverterStage() {
         for (const auto& stat : stats) {
             FB_LOG_INFO << stage_.name() << ": " << stat;
         }
+
+        for (size_t i = 0; i < stripe_samplers_.size(); ++i) {
+            auto stripe_stats = stripe_samplers_[i]->collect_statistics();
+            for (const auto& stat : stripe_stats) {
+                FB_LOG_INFO << stage_.name() << " (stripe " << i << "): " << stat;
+            }
+        }
     }
 
     glDeleteProgram(program_id_);
@@ -95,6 +102,10 @@ fb::FormatConverterStage::ConversionShaderMap
 
             Mode mode = static_cast<Mode>(i);
 
+            // No shaders involved, see CpuFormatConverter::is_supported
+            if (mode == Mode::cpu_simd)
+                continue;
+
             // Encoder
 
             auto key = std::make_tuple(
@@ -203,6 +214,38 @@ void fb::FormatConverterStage::initialize_resources(size_t num_of_buffers, const
 
         FB_LOG_INFO << "FormatConverter '" << name << "' will execute in pass-through-mode only.";
 
+    } else if (mode_ == Mode::cpu_simd) {
+
+        cpu_converter_ = utils::make_unique<CpuFormatConverter>(
+            input_format_,
+            output_format_,
+            chroma_filter_,
+            ProgramOptions::global().enable_linear_space_rendering(),
+            ProgramOptions::global().cpu_format_conversion_simd_level(),
+            ProgramOptions::global().cpu_format_conversion_num_threads());
+
+        if (ProgramOptions::global().sample_stages()) {
+
+            std::vector<SampleFunction> stripe_functions;
+
+            for (size_t i = 0; i < cpu_converter_->num_stripes(); ++i) {
+                stripe_samplers_.push_back(utils::make_unique<StageSampler>());
+                stripe_functions.push_back(std::bind(
+                    &StageSampler::sample, 
+                    stripe_samplers_.back().get(), 
+                    std::placeholders::_1));
+            }
+
+            cpu_converter_->set_stripe_sample_functions(std::move(stripe_functions));
+
+        }
+
+        // Host-side staging memory for reading back / uploading the textures
+        cpu_input_frame_ = Frame(input_format_, Time(0, 1), false);
+        cpu_output_frame_ = Frame(output_format_, Time(0, 1), false);
+
+        FB_LOG_INFO << "FormatConverter '" << name << "' will convert on the CPU.";
+
     } else {
 
         // TODO-DEF: see above for making this more generic
@@ -225,7 +268,7 @@ void fb::FormatConverterStage::initialize_resources(size_t num_of_buffers, const
         std::vector<std::string> fragment_shader_preprocessor_macros;
         std::vector<std::string> compute_shader_preprocessor_macros;
 
-        if (mode_ != Mode::glsl_430_compute && mode_ != Mode::glsl_430_compute_no_shared) {
+        if (renders_to_framebuffer()) {
             quad_ = utils::make_unique<gl::Quad>(flip_image ? gl::Quad::UV_ORIGIN::UPPER_LEFT : gl::Quad::UV_ORIGIN::LOWER_LEFT);
         }
 
@@ -362,7 +405,7 @@ void fb::FormatConverterStage::initialize_resources(size_t num_of_buffers, const
             throw std::invalid_argument("Incompatible formats requested for converter.");
         }
 
-        if (mode_ != Mode::glsl_430_compute && mode_ != Mode::glsl_430_compute_no_shared) {
+        if (renders_to_framebuffer()) {
 
             // Add the common stuff for each version.
             fragment_shader_preprocessor_macros.push_back("#line 1 \n");
@@ -451,7 +494,7 @@ void fb::FormatConverterStage::initialize_resources(size_t num_of_buffers, const
 
     }
 
-    if (mode_ != Mode::glsl_430_compute && mode_ != Mode::glsl_430_compute_no_shared) {
+    if (renders_to_framebuffer()) {
 
         fbo_ids_ = std::vector<GLuint>(
             num_of_buffers,
@@ -493,7 +536,7 @@ void fb::FormatConverterStage::initialize_resources(size_t num_of_buffers, const
 
     }
 
-    if (mode_ != Mode::glsl_430_compute && mode_ != Mode::glsl_430_compute_no_shared) {
+    if (renders_to_framebuffer()) {
 
         FB_ASSERT(fbo_ids_.size() == texture_ids_.size());
 
@@ -609,77 +652,85 @@ fb::StageCommand fb::FormatConverterStage::perform(
         << tex_out_token.id << "'.";
 #endif
 
-    // TODO: maybe we should create three separate blocks of implementations
-    // THis interleaved if/else fashion is a bit hard to read.
+    if (mode_ == Mode::cpu_simd) {
 
-    // Bind source frame
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, tex_in_token.id);
+        convert_on_cpu(tex_in_token, tex_out_token);
 
-    if (mode_ != Mode::glsl_430_compute && mode_ != Mode::glsl_430_compute_no_shared) {
+    } else {
 
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, tex_out_token.fbo_id);
-        glViewportIndexedf(
-            0, 
-            0, 
-            0, 
-            static_cast<GLfloat>(viewport_width_), 
-            static_cast<GLfloat>(viewport_height_));
+        // TODO: maybe we should create three separate blocks of implementations
+        // THis interleaved if/else fashion is a bit hard to read.
 
-    }
+        // Bind source frame
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, tex_in_token.id);
 
-    if (mode_ == Mode::glsl_420 || 
-        mode_ == Mode::glsl_420_no_buffer_attachment_ext || 
-        mode_ == Mode::glsl_430_compute || 
-        mode_ == Mode::glsl_430_compute_no_shared) 
-    {
+        if (mode_ != Mode::glsl_430_compute && mode_ != Mode::glsl_430_compute_no_shared) {
 
-        // Binding the target image
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, tex_out_token.fbo_id);
+            glViewportIndexedf(
+                0, 
+                0, 
+                0, 
+                static_cast<GLfloat>(viewport_width_), 
+                static_cast<GLfloat>(viewport_height_));
 
-        // TODO: think about the binding ID
-        // TODO: target image is always bound to ID 1!
-        glBindImageTexture(
-            1, 
-            tex_out_token.id, 
-            0, 
-            GL_FALSE, 
-            0, 
-            GL_WRITE_ONLY, 
-            tex_out_token.format.gl_native_format().tex_internal_format);
+        }
 
-    }
+        if (mode_ == Mode::glsl_420 || 
+            mode_ == Mode::glsl_420_no_buffer_attachment_ext || 
+            mode_ == Mode::glsl_430_compute || 
+            mode_ == Mode::glsl_430_compute_no_shared) 
+        {
 
-    glBindProgramPipeline(pipeline_id_);
+            // Binding the target image
 
-    if (mode_ == Mode::glsl_430_compute || mode_ == Mode::glsl_430_compute_no_shared) {
+            // TODO: think about the binding ID
+            // TODO: target image is always bound to ID 1!
+            glBindImageTexture(
+                1, 
+                tex_out_token.id, 
+                0, 
+                GL_FALSE, 
+                0, 
+                GL_WRITE_ONLY, 
+                tex_out_token.format.gl_native_format().tex_internal_format);
+
+        }
+
+        glBindProgramPipeline(pipeline_id_);
+
+        if (mode_ == Mode::glsl_430_compute || mode_ == Mode::glsl_430_compute_no_shared) {
 
         
-        glDispatchCompute(
-            num_work_groups_x_, 
-            num_work_groups_y_,
-            1
-            );
+            glDispatchCompute(
+                num_work_groups_x_, 
+                num_work_groups_y_,
+                1
+                );
 
-    } else {
+        } else {
 
-        // Draw the quad
-        quad_->draw();
+            // Draw the quad
+            quad_->draw();
 
-    }
+        }
 
-    if (mode_ == Mode::glsl_420 || 
-        mode_ == Mode::glsl_420_no_buffer_attachment_ext || 
-        mode_ == Mode::glsl_430_compute ||
-        mode_ == Mode::glsl_430_compute_no_shared)
-    {
-        glMemoryBarrier(gl_barrier_bitfield_);
-    }
+        if (mode_ == Mode::glsl_420 || 
+            mode_ == Mode::glsl_420_no_buffer_attachment_ext || 
+            mode_ == Mode::glsl_430_compute ||
+            mode_ == Mode::glsl_430_compute_no_shared)
+        {
+            glMemoryBarrier(gl_barrier_bitfield_);
+        }
 
-    glBindProgramPipeline(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+        glBindProgramPipeline(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        if (mode_ != Mode::glsl_430_compute && mode_ != Mode::glsl_430_compute_no_shared) {    
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        }
 
-    if (mode_ != Mode::glsl_430_compute && mode_ != Mode::glsl_430_compute_no_shared) {    
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
     }
 
     if (gl_sampler_)
@@ -695,6 +746,11 @@ fb::StageCommand fb::FormatConverterStage::perform(
     // pass through timestamp
     tex_out_token.time_stamp = tex_in_token.time_stamp;
 
+    // and the frame
+    tex_out_token.trace_id = tex_in_token.trace_id;
+
+    sampler_.enter_trace_id(tex_in_token.trace_id);
+
     if (enable_gl_upstream_synchronization_)
         tex_in_token.gl_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
@@ -704,6 +760,50 @@ fb::StageCommand fb::FormatConverterStage::perform(
     return StageCommand::NO_CHANGE;
 }
 
+void fb::FormatConverterStage::convert_on_cpu(
+    const TokenGL& tex_in_token, 
+    const TokenGL& tex_out_token)
+{
+
+    const ImageFormat::GLFormatInfo& in_gl = input_format_.gl_native_format();
+    const ImageFormat::GLFormatInfo& out_gl = output_format_.gl_native_format();
+
+    // Make sure we are reading from / writing to client memory
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Note that this implicitly waits for the GPU to finish writing to the 
+    // input texture.
+    glBindTexture(GL_TEXTURE_2D, tex_in_token.id);
+    glPixelStorei(GL_PACK_ALIGNMENT, in_gl.byte_alignment);
+    glGetTexImage(
+        GL_TEXTURE_2D, 
+        0, 
+        in_gl.data_format, 
+        in_gl.data_type, 
+        cpu_input_frame_.image_data());
+
+    cpu_converter_->convert(
+        cpu_input_frame_.image_data(), 
+        cpu_output_frame_.image_data());
+
+    glBindTexture(GL_TEXTURE_2D, tex_out_token.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, out_gl.byte_alignment);
+    glTexSubImage2D(
+        GL_TEXTURE_2D, 
+        0, 
+        0, 
+        0, 
+        out_gl.tex_width, 
+        out_gl.tex_height, 
+        out_gl.data_format, 
+        out_gl.data_type, 
+        cpu_output_frame_.image_data());
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+}
+
 std::ostream& fb::operator<< (std::ostream& out, const Mode& v) {
 
     switch (v) {
@@ -722,6 +822,9 @@ std::ostream& fb::operator<< (std::ostream& out, const Mode& v) {
     case Mode::glsl_430_compute_no_shared:
         out << "glsl_430_compute_no_shared";
         break;
+    case Mode::cpu_simd:
+        out << "cpu_simd";
+        break;
     default:
         out << "<unknown>";
         break;
@@ -748,6 +851,8 @@ std::istream& fb::operator>>(std::istream& in, Mode& v) {
         v = fb::Mode::glsl_430_compute;    
     else if (token == "glsl_430_compute_no_shared")
         v = fb::Mode::glsl_430_compute_no_shared;    
+    else if (token == "cpu_simd")
+        v = fb::Mode::cpu_simd;
     else {
         in.setstate(std::ios::failbit);
     }
@@ -34,6 +34,8 @@
 #include "Logging.h"
 #include "PipelineStage.h"
 #include "FormatOptions.h"
+#include "CpuFormatConverter.h"
+#include "Frame.h"
 
 #include "Utils.h"
 
@@ -81,13 +83,20 @@ namespace toa {
             void execute() override { stage_.execute(); }
             PipelineStatus status() const override { return stage_.status(); }
             size_t input_queue_num_elements() const override { return stage_.input_queue_num_elements(); }
+            bool has_tokens_available() const override { return stage_.has_tokens_available(); }
             const std::string& name() const override { return stage_.name(); }
             size_t output_queue_size() const override { return stage_.output_queue_size(); } 
+            void set_wake_sampler(WakeSampleFunction sampler) override { stage_.set_wake_sampler(std::move(sampler)); }
+            std::vector<std::unique_ptr<FifoSampler>> sample_input_queues() override { return stage_.sample_input_queues(); }
 
             const StageType& stage() const { return stage_; }
 
             const StageSampler& sampler() const { return sampler_; }
 
+            // Per-stripe timing of the CPU conversion, only populated in 
+            // Mode::cpu_simd if stage sampling is enabled.
+            const std::vector<std::unique_ptr<StageSampler>>& stripe_samplers() const { return stripe_samplers_; }
+
         private:
 
             // DEBUG: remove me
@@ -95,10 +104,22 @@ namespace toa {
                 return (input_format_.pixel_format() == ImageFormat::PixelFormat::YUV_10BIT_V210);
             }
 
+            // False for the compute shader and CPU modes, which write to
+            // the target texture directly.
+            bool renders_to_framebuffer() const {
+                return mode_ != Mode::glsl_430_compute && 
+                    mode_ != Mode::glsl_430_compute_no_shared && 
+                    mode_ != Mode::cpu_simd;
+            }
+
             void initialize_resources(size_t num_of_buffers, const std::string& name);
 
             StageCommand perform(TokenGL& tex_in_token, TokenGL& tex_out_token);
 
+            // Reads back the input texture, converts on the host and uploads
+            // the result into the output texture.
+            void convert_on_cpu(const TokenGL& tex_in_token, const TokenGL& tex_out_token);
+
             StageType stage_;
 
             // TODO: Extend if other parameters can be part of the conversion
@@ -148,6 +169,12 @@ namespace toa {
             bool deal_with_excess_threads_;
 
             ChromaFilter chroma_filter_;
+
+            // Only used in Mode::cpu_simd
+            std::unique_ptr<CpuFormatConverter> cpu_converter_;
+            Frame cpu_input_frame_;
+            Frame cpu_output_frame_;
+            std::vector<std::unique_ptr<StageSampler>> stripe_samplers_;
         };   
 
         std::ostream& operator<< (std::ostream& out, const Mode& v);
@@ -194,6 +221,17 @@ namespace toa {
                 mode_ = Mode::glsl_330;
             }
 
+            if (mode_ == Mode::cpu_simd && 
+                !CpuFormatConverter::is_supported(input_format_, output_format_)) 
+            {
+                FB_LOG_WARNING 
+                    << "No CPU format conversion available from '" 
+                    << input_format_.pixel_format() << "' to '" 
+                    << output_format_.pixel_format() << "', falling back to '" 
+                    << Mode::glsl_420_no_buffer_attachment_ext << "'.";
+                mode_ = Mode::glsl_420_no_buffer_attachment_ext;
+            }
+
             // TODO-DEF: how could we make this more generic?
             if (input_format_.pixel_format() == ImageFormat::PixelFormat::YUV_10BIT_V210 && 
                 output_format_.pixel_format() != ImageFormat::PixelFormat::YUV_10BIT_V210) 
@@ -276,14 +314,14 @@ namespace toa {
             auto itr_tex = std::begin(texture_ids_);
             auto itr_fbo = std::begin(fbo_ids_);
 
-            if (mode_ != Mode::glsl_430_compute && mode_ != Mode::glsl_430_compute_no_shared) {
+            if (renders_to_framebuffer()) {
                 FB_ASSERT(texture_ids_.size() == fbo_ids_.size());
             }
 
             for (;itr_tex != std::end(texture_ids_); ++itr_tex) {
 
                 GLuint fbo_id = 0;
-                if (mode_ != Mode::glsl_430_compute && mode_ != Mode::glsl_430_compute_no_shared) {
+                if (renders_to_framebuffer()) {
                     fbo_id = *itr_fbo;
                 }
 
@@ -31,6 +31,8 @@ namespace toa {
             glsl_420_no_buffer_attachment_ext,
             glsl_430_compute,
             glsl_430_compute_no_shared,
+            // Host-side conversion, see CpuFormatConverter
+            cpu_simd,
             count
         };
 
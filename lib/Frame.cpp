@@ -22,6 +22,7 @@
 #include "Precompile.h"
 #include "Frame.h"
 #include "Logging.h"
+#include "HostCopy.h"
 
 #include "Utils.h"
 
@@ -31,6 +32,19 @@
 namespace bf = boost::filesystem;
 namespace fb = toa::frame_bender;
 
+namespace {
+
+    // Owner of borrowed frame memory, see Frame::create_view()
+    class BorrowedFrameMemory : public fb::FrameMemoryOwner {
+    public:
+        void release(uint8_t*, size_t) override {}
+    };
+
+    // Leaked on purpose, views might be destroyed during static destruction
+    BorrowedFrameMemory* const borrowed_frame_memory = new BorrowedFrameMemory();
+
+}
+
 // TODO :C++11 please use delegatin constructors or default class member
 // initialization...
 
@@ -43,8 +57,7 @@ fb::Frame fb::Frame::create_copy(const Frame& f) {
 
     FB_ASSERT(new_frame.image_data_size() == f.image_data_size());
 
-    // TODO: use Intel IPP optimized copy in here?
-    memcpy(
+    host_copy::copy(
         new_frame.image_data(),
         f.image_data(),
         f.image_data_size());
@@ -53,11 +66,27 @@ fb::Frame fb::Frame::create_copy(const Frame& f) {
 
 }
 
+fb::Frame fb::Frame::create_view(
+    ImageFormat format,
+    Time time,
+    bool end_of_sequence,
+    uint8_t* data)
+{
+
+    return Frame(
+        format,
+        time,
+        end_of_sequence,
+        FrameMemoryPtr(
+            data,
+            FrameMemoryDeleter(borrowed_frame_memory, format.image_byte_size())));
+
+}
+
 fb::Frame::Frame() :
     is_valid_(false),
     image_format_(ImageFormat::kInvalid()),
     marks_end_of_sequence_(false),
-    image_data_{nullptr, &boost::alignment::aligned_free},
     image_data_size_(0)
 {
 }
@@ -69,19 +98,44 @@ fb::Frame::~Frame() {
 fb::Frame::Frame(
     ImageFormat format,
     Time time,
-    bool end_of_sequence) :
+    bool end_of_sequence,
+    FramePool& pool) :
         is_valid_(false),
         time_(time),
         image_format_(format),
         marks_end_of_sequence_(end_of_sequence),
-        image_data_{nullptr, &boost::alignment::aligned_free},
         image_data_size_(0)
 {
 
     image_data_size_ = image_format_.image_byte_size();
-    image_data_ = FrameMemoryPtr{reinterpret_cast<uint8_t*>(boost::alignment::aligned_alloc(64, image_data_size_)), &boost::alignment::aligned_free};
-      
-     //  std::unique_ptr<uint8_t[]>(new uint8_t[image_data_size_]);
+    image_data_ = pool.acquire(image_data_size_);
+
+    if (!MEM_IS_ALIGNED(image_data_.get(), 64)) {
+        FB_LOG_WARNING << "Frame data is not aligned to 64-byte boundary. This results in suboptimal performance.";
+    }
+
+    is_valid_ = true;
+}
+
+fb::Frame::Frame(
+    ImageFormat format,
+    Time time,
+    bool end_of_sequence,
+    FrameMemoryPtr data) :
+        is_valid_(false),
+        time_(time),
+        image_format_(format),
+        marks_end_of_sequence_(end_of_sequence),
+        image_data_(std::move(data)),
+        image_data_size_(0)
+{
+
+    image_data_size_ = image_format_.image_byte_size();
+
+    if (image_data_ == nullptr) {
+        FB_LOG_ERROR << "Can't create frame around null image data.";
+        throw std::invalid_argument("Frame data must not be null.");
+    }
 
     if (!MEM_IS_ALIGNED(image_data_.get(), 64)) {
         FB_LOG_WARNING << "Frame data is not aligned to 64-byte boundary. This results in suboptimal performance.";
@@ -188,31 +242,17 @@ void fb::Frame::dump_to_file(
 
     } else {
 
-        if (word_size == 0) {
-            FB_LOG_ERROR << "Invalid word size '" << word_size << "'.";
-            throw std::invalid_argument("Invalid word size.");
-        }
-
-        if ((image_data_size_ % word_size) != 0) {
-            
-            FB_LOG_ERROR 
-                << "Can't swap endiannes for word size " 
-                << word_size << "because image_size is not a multiple of that.";
-
-            throw std::invalid_argument("Invalid word size for endian-swap.");
-        }
+        // Swapped on a copy, the frame itself stays as it is
+        Frame swapped = create_copy(*this);
 
-        for (size_t i = 0; i<image_data_size_; i += word_size) {
+        host_copy::swap_bytes(
+            swapped.image_data(), 
+            swapped.image_data_size(), 
+            word_size);
 
-            for (size_t j = 0; j<word_size; ++j) {
-
-                out_stream.write(
-                    reinterpret_cast<const char*>(&image_data_.get()[i + (word_size - j - 1)]),
-                    1);
-
-            }
-
-        }
+        out_stream.write(
+            reinterpret_cast<const char*>(swapped.image_data()), 
+            swapped.image_data_size());
 
     }
 
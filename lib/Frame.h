@@ -29,8 +29,7 @@
 #include "ImageFormat.h"
 #include "FrameTime.h"
 #include "Utils.h"
-
-#include <boost/align/aligned_alloc.hpp>
+#include "FramePool.h"
 
 namespace toa {
     namespace frame_bender {
@@ -43,15 +42,38 @@ namespace toa {
             // copying in user code.
             static Frame create_copy(const Frame& f);
 
+            // Creates a frame that merely borrows data, e.g. a mapped PBO. 
+            // The memory is never released by the frame, so whoever hands 
+            // out the view has to make sure it outlives the frame.
+            static Frame create_view(
+                ImageFormat format,
+                Time time,
+                bool end_of_sequence,
+                uint8_t* data);
+
             Frame();
             ~Frame();
 
             // Creates a frame with the specified dimensions and properties
             // allocates its memory, copies the data and sets the other properties
+            // The memory is taken from (and given back to) the global frame
+            // pool, unless another pool is passed.
+            Frame(
+                ImageFormat format,
+                Time time,
+                bool end_of_sequence,
+                FramePool& pool = FramePool::global()
+                );
+
+            // Creates a frame around payload memory that somebody else 
+            // provides, e.g. pages of a memory-mapped file. The memory has 
+            // to hold at least format.image_byte_size() bytes, and is handed 
+            // back to its owner when the frame is destroyed.
             Frame(
                 ImageFormat format,
                 Time time,
-                bool end_of_sequence
+                bool end_of_sequence,
+                FrameMemoryPtr data
                 );
 
             // Default move and copy operators are fine, since we are
@@ -92,9 +114,8 @@ namespace toa {
             // returns size of image data in bytes.
             size_t image_data_size() const;
 
-            // Currently only supports raw-file dumping
-            // Note that byte swapping during writeout is not well optimized
-            // and might take much more time than without swapping.
+            // Currently only supports raw-file dumping. Writes synchronously,
+            // see FrameWriter for writing a stream of frames.
             void dump_to_file(
                 const std::string& file_path,
                 bool swap_endianness = false,
@@ -103,8 +124,6 @@ namespace toa {
 
         private:
 
-            using FrameMemoryPtr = std::unique_ptr<uint8_t, decltype(&boost::alignment::aligned_free)>;
-
             // TODO-C++11: use default and delted functions here!
             Frame& operator=(const Frame&);
             Frame(const Frame&);
@@ -34,8 +34,14 @@
 #include "ImageFormat.h"
 #include "Frame.h"
 #include "StreamSource.h"
+#include "FrameCodec.h"
+#include "FrameWriter.h"
+#include "SequenceContainer.h"
+#include "HostCopy.h"
 #include "StreamComposition.h"
 #include "StreamDispatch.h"
+#include "TraceFormat.h"
+#include "SampleClock.h"
 #include "StreamRenderer.h"
 
 #endif // TOA_FRAME_BENDER_H
\ No newline at end of file
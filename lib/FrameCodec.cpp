@@ -0,0 +1,380 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "FrameCodec.h"
+#include "Logging.h"
+
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+namespace fb = toa::frame_bender;
+
+namespace {
+
+    // Prediction applied before the LZ stage, stored as the first byte of
+    // every compressed frame.
+    enum Predictor : uint8_t {
+        kPredictorNone = 0,
+        // Every 10 bit component of a V210 word minus the same component of
+        // the word one row above.
+        kPredictorV210Rows = 1
+    };
+
+    const size_t kMinMatch = 4;
+    const size_t kMaxOffset = 65535;
+    const size_t kHashBits = 16;
+    // Matches end this many bytes before the end of the input at the 
+    // latest, so that hashing never reads past it.
+    const size_t kLastLiterals = 5;
+    // Granularity of the decoder's fast paths
+    const size_t kFastCopySize = 16;
+
+    // The three 10 bit components of a V210 word, and the top bit of each
+    // of them. Bits 30 and 31 are passed through unchanged.
+    const uint32_t kV210Lanes = 0x3FFFFFFF;
+    const uint32_t kV210LaneHighBits = 0x20080200;
+
+    void fail(const char* msg) {
+        FB_LOG_ERROR << "Could not decompress frame: " << msg;
+        throw std::runtime_error("Corrupt compressed frame.");
+    }
+
+    inline uint32_t read32(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t read64(const uint8_t* p) {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline size_t hash(uint32_t v) {
+        return (v * 2654435761u) >> (32 - kHashBits);
+    }
+
+    void write_length(std::vector<uint8_t>& out, size_t length) {
+        for (; length >= 255; length -= 255)
+            out.push_back(255);
+        out.push_back(static_cast<uint8_t>(length));
+    }
+
+    size_t read_length(const uint8_t*& ip, const uint8_t* iend) {
+        size_t length = 0;
+        uint8_t b;
+        do {
+            if (ip == iend)
+                fail("truncated length.");
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+        return length;
+    }
+
+    // One LZ sequence: a token (4 bits literal count, 4 bits match length
+    // minus kMinMatch, 15 meaning that more length bytes follow), the 
+    // literals and, unless it is the last sequence, a 16 bit offset.
+    void write_sequence(
+        std::vector<uint8_t>& out, 
+        const uint8_t* literals, 
+        size_t num_literals, 
+        size_t offset, 
+        size_t match_length) 
+    {
+        const size_t literal_code = std::min<size_t>(num_literals, 15);
+        const size_t match_code = match_length == 0 ? 0 : std::min<size_t>(match_length - kMinMatch, 15);
+
+        out.push_back(static_cast<uint8_t>(literal_code << 4 | match_code));
+
+        if (literal_code == 15)
+            write_length(out, num_literals - 15);
+
+        out.insert(out.end(), literals, literals + num_literals);
+
+        if (match_length == 0)
+            return;
+
+        out.push_back(static_cast<uint8_t>(offset & 0xFF));
+        out.push_back(static_cast<uint8_t>(offset >> 8));
+
+        if (match_code == 15)
+            write_length(out, match_length - kMinMatch - 15);
+    }
+
+    // Copies a match that may overlap its own output, i.e. a repeated 
+    // pattern of length offset. Doubles the copied distance on every step,
+    // so that long runs (e.g. flat V210 residuals) don't degrade into a 
+    // byte loop. Short ones are cheaper as a byte loop after all.
+    inline void copy_match(uint8_t* op, size_t offset, size_t length) {
+
+        if (length <= 32) {
+            const uint8_t* src = op - offset;
+            for (size_t i = 0; i < length; ++i)
+                op[i] = src[i];
+            return;
+        }
+
+        size_t distance = offset;
+        while (length > 0) {
+            const size_t n = std::min(distance, length);
+            std::memcpy(op, op - distance, n);
+            op += n;
+            length -= n;
+            distance += n;
+        }
+    }
+
+    inline uint32_t v210_lanes_sub(uint32_t a, uint32_t b) {
+        const uint32_t x = a & kV210Lanes;
+        const uint32_t y = b & kV210Lanes;
+        const uint32_t d = ((x | kV210LaneHighBits) - (y & ~kV210LaneHighBits)) ^ ((x ^ ~y) & kV210LaneHighBits);
+        return (d & kV210Lanes) | (a & ~kV210Lanes);
+    }
+
+    inline uint32_t v210_lanes_add(uint32_t d, uint32_t b) {
+        const uint32_t x = d & kV210Lanes;
+        const uint32_t y = b & kV210Lanes;
+        const uint32_t s = ((x & ~kV210LaneHighBits) + (y & ~kV210LaneHighBits)) ^ ((x ^ y) & kV210LaneHighBits);
+        return (s & kV210Lanes) | (d & ~kV210Lanes);
+    }
+
+    // Byte size of a row, if format can be predicted row by row, else 0
+    size_t v210_row_byte_size(const fb::ImageFormat& format) {
+
+        if (format.pixel_format() != fb::ImageFormat::PixelFormat::YUV_10BIT_V210 || format.height() < 2)
+            return 0;
+
+        const size_t row_byte_size = format.image_byte_size() / format.height();
+
+        if (row_byte_size * format.height() != format.image_byte_size() || row_byte_size % sizeof(uint32_t) != 0)
+            return 0;
+
+        return row_byte_size;
+    }
+
+}
+
+void fb::frame_codec::lz_compress(
+    const uint8_t* data, 
+    size_t byte_size, 
+    std::vector<uint8_t>& out) 
+{
+
+    FB_ASSERT_MESSAGE(byte_size < (uint64_t(1) << 32), "Frames of 4 GiB and more are not supported.");
+
+    size_t anchor = 0;
+
+    if (byte_size >= kMinMatch + kLastLiterals) {
+
+        std::vector<uint32_t> table(size_t(1) << kHashBits, 0);
+
+        const size_t match_limit = byte_size - kLastLiterals;
+        size_t pos = 1;
+        size_t num_misses = 0;
+
+        while (pos + kMinMatch <= match_limit) {
+
+            const uint32_t v = read32(data + pos);
+            const size_t h = hash(v);
+            size_t candidate = table[h];
+            table[h] = static_cast<uint32_t>(pos);
+
+            if (candidate >= pos || pos - candidate > kMaxOffset || read32(data + candidate) != v) {
+                // Skips faster through data that doesn't compress
+                pos += 1 + (num_misses++ >> 6);
+                continue;
+            }
+
+            size_t length = kMinMatch;
+
+            while (pos + length + sizeof(uint64_t) <= match_limit && read64(data + candidate + length) == read64(data + pos + length))
+                length += sizeof(uint64_t);
+
+            while (pos + length < match_limit && data[candidate + length] == data[pos + length])
+                ++length;
+
+            while (pos > anchor && candidate > 0 && data[pos - 1] == data[candidate - 1]) {
+                --pos;
+                --candidate;
+                ++length;
+            }
+
+            write_sequence(out, data + anchor, pos - anchor, pos - candidate, length);
+
+            pos += length;
+            anchor = pos;
+            num_misses = 0;
+
+            // Improves the chance that the next match is found right away
+            if (pos + kMinMatch <= match_limit)
+                table[hash(read32(data + pos - 2))] = static_cast<uint32_t>(pos - 2);
+        }
+    }
+
+    write_sequence(out, data + anchor, byte_size - anchor, 0, 0);
+
+}
+
+void fb::frame_codec::lz_decompress(
+    const uint8_t* src, 
+    size_t src_size, 
+    uint8_t* dst, 
+    size_t dst_size) 
+{
+
+    const uint8_t* ip = src;
+    const uint8_t* const iend = src + src_size;
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + dst_size;
+
+    for (;;) {
+
+        if (ip == iend)
+            fail("truncated sequence.");
+
+        const uint8_t token = *ip++;
+
+        size_t num_literals = token >> 4;
+        if (num_literals == 15)
+            num_literals += read_length(ip, iend);
+
+        if (num_literals > static_cast<size_t>(iend - ip) || num_literals > static_cast<size_t>(oend - op))
+            fail("literals out of bounds.");
+
+        // Short runs are copied with one fixed-size copy, if there is room
+        // for the overshoot (which is overwritten by what follows)
+        if (num_literals <= kFastCopySize && iend - ip >= static_cast<ptrdiff_t>(kFastCopySize) && oend - op >= static_cast<ptrdiff_t>(kFastCopySize))
+            std::memcpy(op, ip, kFastCopySize);
+        else
+            std::memcpy(op, ip, num_literals);
+
+        op += num_literals;
+        ip += num_literals;
+
+        // The last sequence has no match
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            fail("truncated offset.");
+
+        const size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+
+        size_t length = (token & 15) + kMinMatch;
+        if ((token & 15) == 15)
+            length += read_length(ip, iend);
+
+        if (offset == 0 || offset > static_cast<size_t>(op - dst) || length > static_cast<size_t>(oend - op))
+            fail("match out of bounds.");
+
+        if (offset >= kFastCopySize && oend - op >= static_cast<ptrdiff_t>(length + kFastCopySize)) {
+            for (size_t i = 0; i < length; i += kFastCopySize)
+                std::memcpy(op + i, op + i - offset, kFastCopySize);
+        } else {
+            copy_match(op, offset, length);
+        }
+
+        op += length;
+    }
+
+    if (op != oend)
+        fail("unexpected image size.");
+
+}
+
+std::vector<uint8_t> fb::frame_codec::compress(
+    const uint8_t* data, 
+    const ImageFormat& format) 
+{
+
+    const size_t byte_size = format.image_byte_size();
+    const size_t row_byte_size = v210_row_byte_size(format);
+
+    std::vector<uint8_t> out;
+    // Most frames end up way smaller, this saves the first few reallocations
+    out.reserve(byte_size / 4);
+
+    if (row_byte_size == 0) {
+        out.push_back(kPredictorNone);
+        lz_compress(data, byte_size, out);
+        out.shrink_to_fit();
+        return out;
+    }
+
+    std::vector<uint32_t> residuals(byte_size / sizeof(uint32_t));
+
+    const uint32_t* src = reinterpret_cast<const uint32_t*>(data);
+    const size_t row_size = row_byte_size / sizeof(uint32_t);
+
+    std::copy(src, src + row_size, residuals.begin());
+
+    for (size_t i = row_size; i < residuals.size(); ++i)
+        residuals[i] = v210_lanes_sub(src[i], src[i - row_size]);
+
+    out.push_back(kPredictorV210Rows);
+    lz_compress(reinterpret_cast<const uint8_t*>(residuals.data()), byte_size, out);
+
+    out.shrink_to_fit();
+    return out;
+
+}
+
+void fb::frame_codec::decompress(
+    const std::vector<uint8_t>& compressed, 
+    uint8_t* data, 
+    const ImageFormat& format) 
+{
+
+    if (compressed.empty())
+        fail("no data.");
+
+    const size_t byte_size = format.image_byte_size();
+    const uint8_t predictor = compressed.front();
+
+    if (predictor != kPredictorNone && predictor != kPredictorV210Rows)
+        fail("unknown prediction.");
+
+    const size_t row_byte_size = v210_row_byte_size(format);
+
+    if (predictor == kPredictorV210Rows && row_byte_size == 0)
+        fail("row prediction doesn't match the format.");
+
+    lz_decompress(compressed.data() + 1, compressed.size() - 1, data, byte_size);
+
+    if (predictor == kPredictorV210Rows) {
+
+        FB_ASSERT(MEM_IS_ALIGNED(data, sizeof(uint32_t)));
+
+        uint32_t* words = reinterpret_cast<uint32_t*>(data);
+        const size_t row_size = row_byte_size / sizeof(uint32_t);
+        const size_t num_words = byte_size / sizeof(uint32_t);
+
+        // Row by row, each one depends on the one restored before
+        for (size_t i = row_size; i < num_words; ++i)
+            words[i] = v210_lanes_add(words[i], words[i - row_size]);
+    }
+
+}
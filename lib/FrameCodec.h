@@ -0,0 +1,77 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_FRAME_CODEC_H
+#define TOA_FRAME_BENDER_FRAME_CODEC_H
+
+#include <vector>
+#include <cstdint>
+
+#include "ImageFormat.h"
+
+namespace toa {
+    namespace frame_bender {
+
+        // Lossless compression of frame images, for holding long sequences 
+        // in memory (see CompressedImageSequence). The entropy coder is a 
+        // byte-oriented LZ77 variant in the spirit of LZ4: no Huffman stage,
+        // so that decoding is mostly memcpy and keeps up with playback. 
+        // V210 images are first delta-predicted against the previous row, 
+        // which turns the mostly smooth video into long runs of small 
+        // values that the LZ stage can pick up.
+        namespace frame_codec {
+
+            // Compresses the image of a frame of the given format, which 
+            // holds format.image_byte_size() bytes. The result carries the 
+            // prediction that was used, so decompress() only needs the 
+            // format again.
+            std::vector<uint8_t> compress(
+                const uint8_t* data, 
+                const ImageFormat& format);
+
+            // Restores format.image_byte_size() bytes into data. Throws 
+            // std::runtime_error if compressed is corrupt or hasn't been 
+            // compressed for this format. Thread-safe.
+            void decompress(
+                const std::vector<uint8_t>& compressed, 
+                uint8_t* data, 
+                const ImageFormat& format);
+
+            // The LZ stage on its own. lz_compress appends to out.
+            void lz_compress(
+                const uint8_t* data, 
+                size_t byte_size, 
+                std::vector<uint8_t>& out);
+
+            // Throws std::runtime_error unless src decodes to exactly 
+            // dst_size bytes.
+            void lz_decompress(
+                const uint8_t* src, 
+                size_t src_size, 
+                uint8_t* dst, 
+                size_t dst_size);
+
+        }
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_FRAME_CODEC_H
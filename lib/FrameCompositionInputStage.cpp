@@ -115,6 +115,9 @@ fb::StageCommand fb::FrameCompositionInputStage::perform(TokenFrame& token_out)
 
             token_out.frame = std::move(frame);
             token_out.composition = composition;
+            token_out.trace_id = trace_ids_.next();
+
+            sampler_.enter_trace_id(token_out.trace_id);
 
         } else {
             status = StageCommand::STOP_EXECUTION;
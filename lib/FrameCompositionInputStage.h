@@ -55,8 +55,11 @@ namespace toa {
             void execute() override { stage_.execute(); }
             PipelineStatus status() const override { return stage_.status(); }
             size_t input_queue_num_elements() const override { return stage_.input_queue_num_elements(); }
+            bool has_tokens_available() const override { return stage_.has_tokens_available(); }
             const std::string& name() const override { return stage_.name(); }
             size_t output_queue_size() const override { return stage_.output_queue_size(); } 
+            void set_wake_sampler(WakeSampleFunction sampler) override { stage_.set_wake_sampler(std::move(sampler)); }
+            std::vector<std::unique_ptr<FifoSampler>> sample_input_queues() override { return stage_.sample_input_queues(); }
 
             const StageType& stage() const { return stage_; }
 
@@ -70,6 +73,8 @@ namespace toa {
 
             // TODO: shall be replaced with *many* compositions
             std::atomic<StreamComposition*> head_composition_;
+
+            TraceIdGenerator trace_ids_;
             StageSampler sampler_;
         };        
 
@@ -48,6 +48,8 @@ fb::StageCommand fb::FrameCompositionOutputStage::perform(TokenFrame& token_in)
 
     StageCommand answer = StageCommand::NO_CHANGE;
 
+    sampler_.enter_trace_id(token_in.trace_id);
+
     if (token_in.composition->output_callback_)
         token_in.composition->output_callback_(token_in.frame);
 
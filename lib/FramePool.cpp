@@ -0,0 +1,361 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "FramePool.h"
+#include "StageSampler.h"
+#include "Logging.h"
+
+namespace fb = toa::frame_bender;
+
+namespace {
+
+    // Touching one byte per page is enough to have it mapped
+    const size_t kPageSize = 4096;
+
+    size_t next_power_of_two(size_t v) {
+        size_t answer = 1;
+        while (answer < v)
+            answer <<= 1;
+        return answer;
+    }
+
+}
+
+void fb::FrameMemoryDeleter::operator()(uint8_t* data) const {
+
+    if (owner != nullptr)
+        owner->release(data, byte_size);
+    else
+        huge_pages::free(data, byte_size, HugePages::OFF);
+
+}
+
+fb::detail::BufferFreeList::BufferFreeList(size_t capacity) :
+    cells_(new Cell[next_power_of_two(std::max<size_t>(capacity, 1))]),
+    mask_(next_power_of_two(std::max<size_t>(capacity, 1)) - 1),
+    push_position_(0),
+    pop_position_(0)
+{
+
+    for (size_t i = 0; i <= mask_; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+        cells_[i].data = nullptr;
+    }
+
+}
+
+bool fb::detail::BufferFreeList::push(uint8_t* data) {
+
+    size_t position = push_position_.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+
+    for (;;) {
+
+        cell = &cells_[position & mask_];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+        if (diff == 0) {
+            // Our turn, unless some other producer was faster
+            if (push_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            // The consumer of the previous lap hasn't been here yet: full
+            return false;
+        } else {
+            position = push_position_.load(std::memory_order_relaxed);
+        }
+
+    }
+
+    cell->data = data;
+    cell->sequence.store(position + 1, std::memory_order_release);
+
+    return true;
+
+}
+
+bool fb::detail::BufferFreeList::pop(uint8_t*& data) {
+
+    size_t position = pop_position_.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+
+    for (;;) {
+
+        cell = &cells_[position & mask_];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+        if (diff == 0) {
+            if (pop_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            // Nothing has been pushed to this cell yet: empty
+            return false;
+        } else {
+            position = pop_position_.load(std::memory_order_relaxed);
+        }
+
+    }
+
+    data = cell->data;
+    cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+
+    return true;
+
+}
+
+const size_t fb::FramePool::kAlignment;
+const size_t fb::FramePool::kMaxNumFormats;
+const size_t fb::FramePool::kDefaultMaxCachedBuffers;
+
+namespace {
+
+    // Intentionally leaked, see header
+    fb::FramePool* const global_frame_pool = new fb::FramePool();
+
+}
+
+fb::FramePool& fb::FramePool::global() {
+    return *global_frame_pool;
+}
+
+fb::FramePool::EventLog::EventLog() :
+    times(new clock::rep[StageSampler::kNumMaxTraceEvents]),
+    num_events(0)
+{
+}
+
+fb::FramePool::FramePool(size_t max_cached_buffers, HugePages huge_pages) :
+    huge_pages_(huge_pages),
+    records_events_(false)
+{
+
+    for (size_t i = 0; i < kMaxNumFormats; ++i)
+        buckets_.push_back(utils::make_unique<Bucket>(max_cached_buffers));
+
+}
+
+fb::FramePool::~FramePool() {
+
+    for (auto& bucket : buckets_) {
+        uint8_t* data = nullptr;
+        while (bucket->free_list.pop(data))
+            huge_pages::free(data, bucket->byte_size.load(), huge_pages_);
+    }
+
+}
+
+void fb::FramePool::set_huge_pages(HugePages huge_pages) {
+
+    if (huge_pages == huge_pages_)
+        return;
+
+    if (buckets_.front()->byte_size.load() != 0) {
+        FB_LOG_ERROR << "Can't change the huge page mode of a frame pool that has already been used.";
+        throw std::logic_error("Frame pool has already been used.");
+    }
+
+    huge_pages_ = huge_pages;
+
+    FB_LOG_INFO << "Frame memory is allocated with huge pages set to '" << huge_pages_ << "'.";
+
+}
+
+fb::FrameMemoryPtr fb::FramePool::acquire(size_t byte_size) {
+
+    if (byte_size == 0)
+        return FrameMemoryPtr(nullptr, FrameMemoryDeleter());
+
+    Bucket* bucket = find_or_claim_bucket(byte_size);
+
+    if (bucket == nullptr) {
+        // Not pooled, simply gets freed again
+        return FrameMemoryPtr(huge_pages::allocate(byte_size, HugePages::OFF), FrameMemoryDeleter());
+    }
+
+    uint8_t* data = nullptr;
+
+    if (bucket->free_list.pop(data)) {
+        bucket->num_hits.fetch_add(1, std::memory_order_relaxed);
+        record_event(Event::HIT);
+    } else {
+        data = allocate(byte_size);
+        bucket->num_allocations.fetch_add(1, std::memory_order_relaxed);
+        record_event(Event::ALLOCATION);
+    }
+
+    return FrameMemoryPtr(data, FrameMemoryDeleter(this, byte_size));
+
+}
+
+void fb::FramePool::reserve(size_t byte_size, size_t count) {
+
+    Bucket* bucket = find_or_claim_bucket(byte_size);
+
+    if (bucket == nullptr) {
+        FB_LOG_WARNING 
+            << "Can't reserve frame memory of " << byte_size 
+            << " bytes, the pool already serves " << kMaxNumFormats << " other sizes.";
+        return;
+    }
+
+    if (count > bucket->free_list.capacity()) {
+        FB_LOG_WARNING 
+            << "Can only reserve " << bucket->free_list.capacity() 
+            << " buffers of " << byte_size << " bytes, requested were " << count << ".";
+        count = bucket->free_list.capacity();
+    }
+
+    // Take out what's already there, so that we can count it
+    std::vector<uint8_t*> buffers;
+    uint8_t* data = nullptr;
+    while (buffers.size() < count && bucket->free_list.pop(data))
+        buffers.push_back(data);
+
+    while (buffers.size() < count) {
+        buffers.push_back(allocate(byte_size));
+        bucket->num_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    for (auto buffer : buffers) {
+        if (!bucket->free_list.push(buffer)) {
+            huge_pages::free(buffer, byte_size, huge_pages_);
+            bucket->num_frees.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+}
+
+std::vector<fb::FramePool::Statistics> fb::FramePool::statistics() const {
+
+    std::vector<Statistics> answer;
+
+    for (const auto& bucket : buckets_) {
+
+        const size_t byte_size = bucket->byte_size.load();
+        if (byte_size == 0)
+            continue;
+
+        Statistics stats;
+        stats.byte_size = byte_size;
+        stats.num_hits = bucket->num_hits.load();
+        stats.num_allocations = bucket->num_allocations.load();
+        stats.num_frees = bucket->num_frees.load();
+        answer.push_back(stats);
+
+    }
+
+    return answer;
+
+}
+
+void fb::FramePool::fill_sampler(StageSampler& sampler) const {
+
+    const StageExecutionState states[] = {
+        StageExecutionState::INPUT_TOKEN_AVAILABLE,
+        StageExecutionState::OUTPUT_TOKEN_AVAILABLE,
+        StageExecutionState::EXECUTE_END
+    };
+
+    std::map<StageExecutionState, std::string> name_overrides;
+    name_overrides[states[static_cast<size_t>(Event::HIT)]] = "POOL_HIT";
+    name_overrides[states[static_cast<size_t>(Event::ALLOCATION)]] = "POOL_ALLOCATION";
+    name_overrides[states[static_cast<size_t>(Event::FREE)]] = "POOL_FREE";
+    sampler.set_name_overrides(std::move(name_overrides));
+
+    for (size_t i = 0; i < event_logs_.size(); ++i) {
+
+        const EventLog& log = event_logs_[i];
+        const size_t num_events = std::min(log.num_events.load(), static_cast<size_t>(StageSampler::kNumMaxTraceEvents));
+
+        for (size_t j = 0; j < num_events; ++j)
+            sampler.enter_sample(states[i], clock::time_point(clock::duration(log.times[j])));
+
+    }
+
+}
+
+fb::FramePool::Bucket* fb::FramePool::find_or_claim_bucket(size_t byte_size) {
+
+    for (auto& bucket : buckets_) {
+
+        size_t bucket_size = bucket->byte_size.load(std::memory_order_acquire);
+
+        if (bucket_size == byte_size)
+            return bucket.get();
+
+        // Buckets are claimed in order, an unused one means that nobody 
+        // else has claimed this size yet.
+        if (bucket_size == 0) {
+            if (bucket->byte_size.compare_exchange_strong(bucket_size, byte_size))
+                return bucket.get();
+            if (bucket_size == byte_size)
+                return bucket.get();
+        }
+
+    }
+
+    return nullptr;
+
+}
+
+void fb::FramePool::release(uint8_t* data, size_t byte_size) {
+
+    Bucket* bucket = find_or_claim_bucket(byte_size);
+
+    if (bucket != nullptr && bucket->free_list.push(data))
+        return;
+
+    huge_pages::free(data, byte_size, bucket != nullptr ? huge_pages_ : HugePages::OFF);
+
+    if (bucket != nullptr) {
+        bucket->num_frees.fetch_add(1, std::memory_order_relaxed);
+        record_event(Event::FREE);
+    }
+
+}
+
+void fb::FramePool::record_event(Event event) {
+
+    if (!records_events_.load(std::memory_order_relaxed))
+        return;
+
+    EventLog& log = event_logs_[static_cast<size_t>(event)];
+    const size_t idx = log.num_events.fetch_add(1, std::memory_order_relaxed);
+
+    if (idx < StageSampler::kNumMaxTraceEvents)
+        log.times[idx] = clock::now().time_since_epoch().count();
+
+}
+
+uint8_t* fb::FramePool::allocate(size_t byte_size) const {
+
+    uint8_t* data = huge_pages::allocate(byte_size, huge_pages_);
+
+    // Fault in every page now rather than when the first frame is written
+    for (size_t offset = 0; offset < byte_size; offset += kPageSize)
+        data[offset] = 0;
+
+    return data;
+
+}
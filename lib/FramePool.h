@@ -0,0 +1,216 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_FRAME_POOL_H
+#define TOA_FRAME_BENDER_FRAME_POOL_H
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Utils.h"
+#include "ChronoUtils.h"
+#include "HugePages.h"
+
+namespace toa {
+    namespace frame_bender {
+
+        class FramePool;
+        class StageSampler;
+
+        // Anything a frame's payload can come from, e.g. a pool or a 
+        // memory-mapped file. It gets the payload back when the frame is 
+        // done with it.
+        class FrameMemoryOwner {
+        public:
+            virtual ~FrameMemoryOwner() {}
+            virtual void release(uint8_t* data, size_t byte_size) = 0;
+        };
+
+        // Hands the payload back to the owner it came from, or frees it if 
+        // it didn't come from any.
+        struct FrameMemoryDeleter {
+
+            FrameMemoryOwner* owner;
+            size_t byte_size;
+
+            FrameMemoryDeleter() : owner(nullptr), byte_size(0) {}
+            FrameMemoryDeleter(FrameMemoryOwner* owner, size_t byte_size) : 
+                owner(owner), byte_size(byte_size) {}
+
+            void operator()(uint8_t* data) const;
+        };
+
+        typedef std::unique_ptr<uint8_t, FrameMemoryDeleter> FrameMemoryPtr;
+
+        namespace detail {
+
+            // Bounded multi-producer/multi-consumer queue of buffer pointers
+            // after Dmitry Vyukov. Every cell carries a sequence number 
+            // which tells producers and consumers whether it's their turn,
+            // so neither side ever takes a lock.
+            class BufferFreeList : utils::NoCopyingOrMoving {
+
+            public:
+
+                // Capacity is rounded up to the next power of two
+                explicit BufferFreeList(size_t capacity);
+
+                bool push(uint8_t* data);
+                bool pop(uint8_t*& data);
+
+                size_t capacity() const { return mask_ + 1; }
+
+            private:
+
+                struct Cell {
+                    std::atomic<size_t> sequence;
+                    uint8_t* data;
+                };
+
+                std::unique_ptr<Cell[]> cells_;
+                size_t mask_;
+
+                char padding_0_[kCacheLineSize];
+                std::atomic<size_t> push_position_;
+                char padding_1_[kCacheLineSize];
+                std::atomic<size_t> pop_position_;
+                char padding_2_[kCacheLineSize];
+
+            };
+
+        }
+
+        // Recycles the page-aligned payload memory of frames, keyed by 
+        // the payload's byte size (i.e. the image format). Frames return 
+        // their memory automatically when they are destroyed. Acquiring and 
+        // releasing is lock-free; only the first use of a new byte size 
+        // claims one of the pool's buckets, with a compare-and-swap.
+        // A pool must outlive every frame that was created from it.
+        class FramePool : public FrameMemoryOwner, utils::NoCopyingOrMoving {
+
+        public:
+
+            static const size_t kAlignment = 4096;
+            static const size_t kMaxNumFormats = 8;
+            static const size_t kDefaultMaxCachedBuffers = 32;
+
+            // The pool used by Frame by default. Never destroyed, since 
+            // frames might still be released during static destruction.
+            static FramePool& global();
+
+            // Any buffer that is released while max_cached_buffers are 
+            // already cached for its byte size is freed.
+            explicit FramePool(
+                size_t max_cached_buffers = kDefaultMaxCachedBuffers,
+                HugePages huge_pages = HugePages::OFF);
+            ~FramePool();
+
+            // Throws std::logic_error if the pool has already been used, 
+            // as its buffers must all be backed the same way.
+            void set_huge_pages(HugePages huge_pages);
+            HugePages huge_pages() const { return huge_pages_; }
+
+            // Reuses a cached buffer if there is one, otherwise allocates
+            // a new one and touches all of its pages, so that writing the
+            // first frame into it won't page fault.
+            FrameMemoryPtr acquire(size_t byte_size);
+
+            // Allocates (and pre-faults) buffers ahead of time until at least 
+            // count buffers of byte_size are cached.
+            void reserve(size_t byte_size, size_t count);
+
+            struct Statistics {
+                size_t byte_size;
+                // acquire() calls served from the cache
+                size_t num_hits;
+                // acquire() calls that had to allocate
+                size_t num_allocations;
+                // released buffers that didn't fit into the cache anymore
+                size_t num_frees;
+            };
+
+            // One entry for each byte size that has been used
+            std::vector<Statistics> statistics() const;
+
+            // If enabled, the time of every hit, allocation and free is 
+            // recorded (up to StageSampler::kNumMaxTraceEvents each), to be 
+            // written into the trace via fill_sampler().
+            void set_records_events(bool b) { records_events_ = b; }
+
+            // Hits are entered as INPUT_TOKEN_AVAILABLE, allocations as
+            // OUTPUT_TOKEN_AVAILABLE and frees as EXECUTE_END events, named
+            // accordingly.
+            void fill_sampler(StageSampler& sampler) const;
+
+        private:
+
+            enum class Event : size_t {
+                HIT,
+                ALLOCATION,
+                FREE,
+                COUNT
+            };
+
+            struct Bucket {
+
+                explicit Bucket(size_t max_cached_buffers) :
+                    byte_size(0),
+                    free_list(max_cached_buffers),
+                    num_hits(0),
+                    num_allocations(0),
+                    num_frees(0) {}
+
+                // 0 while the bucket is unused
+                std::atomic<size_t> byte_size;
+                detail::BufferFreeList free_list;
+                std::atomic<size_t> num_hits;
+                std::atomic<size_t> num_allocations;
+                std::atomic<size_t> num_frees;
+            };
+
+            struct EventLog {
+                EventLog();
+                std::unique_ptr<clock::rep[]> times;
+                std::atomic<size_t> num_events;
+            };
+
+            // Returns nullptr if all buckets are taken by other byte sizes
+            Bucket* find_or_claim_bucket(size_t byte_size);
+
+            void release(uint8_t* data, size_t byte_size) override;
+
+            void record_event(Event event);
+
+            uint8_t* allocate(size_t byte_size) const;
+
+            std::vector<std::unique_ptr<Bucket>> buckets_;
+            HugePages huge_pages_;
+            std::atomic<bool> records_events_;
+            std::array<EventLog, static_cast<size_t>(Event::COUNT)> event_logs_;
+
+        };
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_FRAME_POOL_H
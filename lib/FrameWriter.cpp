@@ -0,0 +1,453 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "FrameWriter.h"
+#include "HostCopy.h"
+#include "Logging.h"
+#include "ProgramOptions.h"
+#include "StageSampler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace bf = boost::filesystem;
+namespace fb = toa::frame_bender;
+
+namespace {
+
+#ifndef _WIN32
+
+    size_t pwrite_fully(int fd, const uint8_t* data, size_t byte_size, uint64_t offset) {
+
+        size_t num_written = 0;
+        errno = 0;
+
+        while (num_written < byte_size) {
+
+            ssize_t result = ::pwrite(fd, data + num_written, byte_size - num_written, offset + num_written);
+
+            if (result < 0 && errno == EINTR)
+                continue;
+
+            if (result <= 0)
+                break;
+
+            num_written += static_cast<size_t>(result);
+        }
+
+        return num_written;
+    }
+
+#endif
+
+}
+
+const size_t fb::FrameWriter::kDefaultQueueSize;
+const size_t fb::FrameWriter::kDefaultPreallocateFrameCount;
+const char* const fb::FrameWriter::kSingleFileName = "frames.raw";
+
+fb::FrameWriter::FrameWriter(
+    const std::string& output_folder,
+    OutputLayout layout,
+    bool swap_endianness,
+    size_t swap_word_size,
+    size_t queue_size,
+    size_t num_writer_threads,
+    size_t preallocate_frame_count) :
+        output_folder_(output_folder),
+        layout_(layout),
+        swap_endianness_(swap_endianness),
+        swap_word_size_(swap_word_size),
+        queue_size_(queue_size),
+        preallocate_frame_count_(preallocate_frame_count),
+        file_descriptor_(-1),
+        file_allocated_size_(0),
+        file_written_size_(0),
+        num_frames_in_flight_(0),
+        stop_requested_(false),
+        next_frame_index_(0),
+        num_frames_written_(0),
+        num_backpressure_stalls_(0),
+        backpressure_time_(clock::duration::zero())
+{
+
+    if (queue_size_ == 0)
+        throw std::invalid_argument("Output queue size must not be zero.");
+
+    if (num_writer_threads == 0)
+        throw std::invalid_argument("Output writer thread count must not be zero.");
+
+    if (swap_endianness_ && swap_word_size_ == 0) {
+        FB_LOG_ERROR << "Invalid word size '" << swap_word_size_ << "'.";
+        throw std::invalid_argument("Invalid word size.");
+    }
+
+    bf::path output_path(output_folder_);
+
+    if (bf::exists(output_path) && !bf::is_directory(output_path)) {
+        FB_LOG_ERROR << "Directory '" << output_path.string() << "' already exists, but is not a directory.";
+        throw std::invalid_argument("Invalid output directory.");
+    }
+
+    if (!bf::exists(output_path)) {
+        FB_LOG_INFO << "Directory '" << output_path.string() << "' did not exist, creating directory.";
+        bf::create_directories(output_path);
+    }
+
+    if (layout_ == OutputLayout::SINGLE_FILE) {
+
+#ifdef _WIN32
+        FB_LOG_ERROR << "Writing all frames into a single file is not supported on this platform.";
+        throw std::runtime_error("OutputLayout::SINGLE_FILE is not supported on Windows.");
+#else
+        const std::string file_path = (output_path / kSingleFileName).string();
+
+        file_descriptor_ = ::open(file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (file_descriptor_ < 0) {
+            FB_LOG_ERROR << "Could not open output file '" << file_path << "': " << std::strerror(errno);
+            throw std::runtime_error("Could not open output file.");
+        }
+#endif
+
+    }
+
+    if (ProgramOptions::global().sample_stages()) {
+
+        std::map<StageExecutionState, std::string> name_overrides;
+        name_overrides[StageExecutionState::EXECUTE_BEGIN] = "WRITE_BEGIN";
+        name_overrides[StageExecutionState::EXECUTE_END] = "WRITE_END";
+        name_overrides[StageExecutionState::TASK_BEGIN] = "BACKPRESSURE_BEGIN";
+        name_overrides[StageExecutionState::TASK_END] = "BACKPRESSURE_END";
+
+        sampler_ = utils::make_unique<StageSampler>(name_overrides);
+    }
+
+    for (size_t i = 0; i<num_writer_threads; ++i)
+        writer_threads_.push_back(std::thread(&FrameWriter::write_frames, this));
+
+    FB_LOG_INFO 
+        << "Writing output frames " 
+        << (layout_ == OutputLayout::SINGLE_FILE ? "into a single file" : "into one file each") 
+        << " in '" << output_folder_ << "' on " << num_writer_threads 
+        << " thread(s), queueing up to " << queue_size_ << " frames.";
+
+}
+
+fb::FrameWriter::~FrameWriter() {
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_requested_ = true;
+    }
+
+    // The writers drain the queue before they quit
+    frame_queued_.notify_all();
+
+    for (auto& t : writer_threads_)
+        t.join();
+
+#ifndef _WIN32
+    if (file_descriptor_ >= 0) {
+
+        // Cut off what has been preallocated, but not written
+        if (::ftruncate(file_descriptor_, static_cast<off_t>(file_written_size_)) != 0) {
+            FB_LOG_ERROR << "Could not truncate output file: " << std::strerror(errno);
+        }
+
+        ::close(file_descriptor_);
+    }
+#endif
+
+    FB_LOG_INFO 
+        << "Wrote " << num_frames_written_ << " of " << next_frame_index_ 
+        << " output frames, " << num_backpressure_stalls_ << " backpressure stalls, waited for "
+        << boost::chrono::duration_cast<boost::chrono::milliseconds>(backpressure_time_) 
+        << " in total.";
+
+}
+
+void fb::FrameWriter::write(const Frame& frame) {
+
+    rethrow_writer_error();
+
+    // Copied outside of the lock, the writers don't need to wait for that
+    QueuedFrame queued_frame;
+    queued_frame.index = next_frame_index_++;
+    queued_frame.frame = Frame::create_copy(frame);
+
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+
+        if (queue_.size() >= queue_size_) {
+
+            const clock::time_point stall_begin = clock::now();
+
+            frame_taken_.wait(lock, [&]() { 
+                return queue_.size() < queue_size_ || writer_error_; 
+            });
+
+            const clock::time_point stall_end = clock::now();
+
+            num_backpressure_stalls_++;
+            backpressure_time_ += stall_end - stall_begin;
+
+            if (sampler_) {
+                sampler_->enter_sample(StageExecutionState::TASK_BEGIN, stall_begin);
+                sampler_->enter_sample(StageExecutionState::TASK_END, stall_end);
+            }
+        }
+
+        if (!writer_error_)
+            queue_.push_back(std::move(queued_frame));
+    }
+
+    rethrow_writer_error();
+
+    frame_queued_.notify_one();
+
+}
+
+void fb::FrameWriter::flush() {
+
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        frame_taken_.wait(lock, [&]() { 
+            return (queue_.empty() && num_frames_in_flight_ == 0) || writer_error_; 
+        });
+    }
+
+    rethrow_writer_error();
+
+}
+
+void fb::FrameWriter::rethrow_writer_error() {
+
+    std::exception_ptr error;
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        error = writer_error_;
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+
+}
+
+void fb::FrameWriter::write_frames() {
+
+    for (;;) {
+
+        QueuedFrame queued_frame;
+
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            frame_queued_.wait(lock, [&]() { 
+                return stop_requested_ || !queue_.empty(); 
+            });
+
+            if (queue_.empty())
+                break;
+
+            queued_frame = std::move(queue_.front());
+            queue_.pop_front();
+            num_frames_in_flight_++;
+        }
+
+        // Makes room for write()
+        frame_taken_.notify_all();
+
+        try {
+
+            write_frame(queued_frame.index, queued_frame.frame);
+
+        } catch (...) {
+
+            FB_LOG_ERROR << "Writing output frame " << queued_frame.index << " failed.";
+
+            std::lock_guard<std::mutex> lock(lock_);
+            if (!writer_error_)
+                writer_error_ = std::current_exception();
+
+        }
+
+        // Back to the pool, before anybody waits for it
+        queued_frame.frame = Frame();
+
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            num_frames_in_flight_--;
+        }
+
+        frame_taken_.notify_all();
+
+    }
+
+}
+
+void fb::FrameWriter::write_frame(size_t index, Frame& frame) {
+
+    const clock::time_point write_begin = clock::now();
+
+    // The frame is our own copy, so it can be swapped in place
+    if (swap_endianness_)
+        host_copy::swap_bytes(frame.image_data(), frame.image_data_size(), swap_word_size_);
+
+    if (layout_ == OutputLayout::SINGLE_FILE) {
+        write_at(index, frame);
+    } else {
+        std::ostringstream oss;
+        oss << std::setfill('0') << std::setw(8) << index << ".raw";
+        write_file((bf::path(output_folder_) / oss.str()).string(), frame);
+    }
+
+    const clock::time_point write_end = clock::now();
+
+    num_frames_written_++;
+
+    if (sampler_) {
+        std::lock_guard<std::mutex> lock(sampler_lock_);
+        sampler_->enter_sample(StageExecutionState::EXECUTE_BEGIN, write_begin);
+        sampler_->enter_sample(StageExecutionState::EXECUTE_END, write_end);
+    }
+
+}
+
+void fb::FrameWriter::write_file(const std::string& file_path, const Frame& frame) {
+
+    bf::ofstream out_stream(bf::path(file_path), std::ios::out | std::ios::binary);
+
+    out_stream.write(
+        reinterpret_cast<const char*>(frame.image_data()), 
+        frame.image_data_size());
+
+    out_stream.close();
+
+    if (!out_stream.good()) {
+        FB_LOG_ERROR << "Could not write output frame '" << file_path << "'.";
+        throw std::runtime_error("Could not write output frame.");
+    }
+
+}
+
+void fb::FrameWriter::write_at(size_t index, const Frame& frame) {
+
+#ifdef _WIN32
+    throw std::logic_error("OutputLayout::SINGLE_FILE is not supported on Windows.");
+#else
+
+    const uint64_t byte_size = frame.image_data_size();
+    const uint64_t offset = static_cast<uint64_t>(index) * byte_size;
+
+#ifdef __linux__
+    {
+        std::lock_guard<std::mutex> lock(file_lock_);
+
+        if (preallocate_frame_count_ != 0 && offset + byte_size > file_allocated_size_) {
+
+            const uint64_t allocate_end = offset + byte_size * preallocate_frame_count_;
+
+            if (::fallocate(file_descriptor_, 0, static_cast<off_t>(file_allocated_size_), static_cast<off_t>(allocate_end - file_allocated_size_)) == 0) {
+                file_allocated_size_ = allocate_end;
+            } else {
+                // E.g. not supported by the file system, just don't try again
+                FB_LOG_WARNING << "Could not preallocate output file: " << std::strerror(errno);
+                preallocate_frame_count_ = 0;
+            }
+        }
+    }
+#endif
+
+    const size_t num_written = pwrite_fully(file_descriptor_, frame.image_data(), byte_size, offset);
+    const int write_error = errno;
+
+    if (num_written != byte_size) {
+        FB_LOG_ERROR 
+            << "Could only write " << num_written << " of " << byte_size 
+            << " bytes of output frame " << index 
+            << (write_error != 0 ? ": " + std::string(std::strerror(write_error)) : ".");
+        throw std::runtime_error("Could not write output frame.");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(file_lock_);
+        file_written_size_ = std::max(file_written_size_, offset + byte_size);
+    }
+
+#endif
+
+}
+
+std::ostream& fb::operator<< (std::ostream& out, const fb::OutputLayout& v)
+{
+
+    switch (v) {
+
+        case fb::OutputLayout::FILE_PER_FRAME:
+            out << "files";
+            break;
+
+        case fb::OutputLayout::SINGLE_FILE:
+            out << "single_file";
+            break;
+
+        default:
+            out << "<unknown>";
+            break;
+
+    }
+
+    return out;
+
+}
+
+std::istream& fb::operator>>(std::istream& in, fb::OutputLayout& v) {
+
+    std::string token;
+    in >> token;
+
+    std::transform(token.begin(), token.end(),token.begin(), ::tolower);
+
+    if (token == "files")
+        v = OutputLayout::FILE_PER_FRAME;
+    else if (token == "single_file")
+        v = OutputLayout::SINGLE_FILE;
+    else {
+        in.setstate(std::ios::failbit);
+    }
+
+    return in;
+
+}
@@ -0,0 +1,164 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_FRAME_WRITER_H
+#define TOA_FRAME_BENDER_FRAME_WRITER_H
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <iosfwd>
+
+#include "Utils.h"
+#include "Frame.h"
+#include "ChronoUtils.h"
+
+namespace toa {
+    namespace frame_bender {
+
+        class StageSampler;
+
+        // How FrameWriter lays out the frames on disk
+        enum class OutputLayout {
+            // One raw file per frame, named by frame index
+            FILE_PER_FRAME,
+            // All frames appended to one raw file, see FrameWriter
+            SINGLE_FILE
+        };
+
+        std::ostream& operator<< (std::ostream& out, const OutputLayout& v);
+        std::istream& operator>>(std::istream& in, OutputLayout& v);
+
+        /**
+         * Writes output frames to disk without holding up whoever produces 
+         * them. write() copies the frame into a pooled frame and queues it, 
+         * a few writer threads take it from there, byte-swap it if 
+         * requested and write it out. Only if the queue is full, write() 
+         * has to wait for the writers, which is counted and sampled as 
+         * backpressure.
+         * 
+         * With OutputLayout::SINGLE_FILE, each frame is written at its own 
+         * offset (frame index * frame size), so that writers never have to 
+         * wait for each other. The file is grown ahead of the writers with 
+         * fallocate() in steps of preallocate_frame_count frames (Linux 
+         * only), which avoids fragmentation and per-write metadata updates.
+         */
+        class FrameWriter : public utils::NoCopyingOrMoving {
+
+        public:
+
+            static const size_t kDefaultQueueSize = 8;
+            static const size_t kDefaultPreallocateFrameCount = 64;
+
+            // Name of the file within output_folder for SINGLE_FILE
+            static const char* const kSingleFileName;
+
+            FrameWriter(
+                const std::string& output_folder, // Created if it doesn't exist
+                OutputLayout layout = OutputLayout::FILE_PER_FRAME,
+                bool swap_endianness = false,
+                size_t swap_word_size = 2,
+                size_t queue_size = kDefaultQueueSize,
+                size_t num_writer_threads = 1,
+                size_t preallocate_frame_count = kDefaultPreallocateFrameCount);
+
+            // Writes all frames that are still queued
+            ~FrameWriter();
+
+            // Queues a copy of the frame. Must always be called from the 
+            // same thread. Rethrows the first error of a writer thread.
+            void write(const Frame& frame);
+
+            // Blocks until all queued frames have been written. Rethrows the
+            // first error of a writer thread.
+            void flush();
+
+            size_t num_frames_queued() const { return next_frame_index_; }
+            size_t num_frames_written() const { return num_frames_written_; }
+
+            // Number of times write() found the queue full, and how long 
+            // it waited in total
+            size_t num_backpressure_stalls() const { return num_backpressure_stalls_; }
+            clock::duration backpressure_time() const { return backpressure_time_; }
+
+            // If stages are sampled: every write to disk as EXECUTE_BEGIN 
+            // and EXECUTE_END, every backpressure stall as TASK_BEGIN and 
+            // TASK_END.
+            const StageSampler* sampler() const { return sampler_.get(); }
+
+        private:
+
+            struct QueuedFrame {
+                size_t index;
+                Frame frame;
+            };
+
+            void write_frames();
+            void write_frame(size_t index, Frame& frame);
+            void write_file(const std::string& file_path, const Frame& frame);
+            void write_at(size_t index, const Frame& frame);
+            void rethrow_writer_error();
+
+            std::string output_folder_;
+            OutputLayout layout_;
+            bool swap_endianness_;
+            size_t swap_word_size_;
+            size_t queue_size_;
+            size_t preallocate_frame_count_;
+
+            std::unique_ptr<StageSampler> sampler_;
+            // Writer threads sample concurrently
+            std::mutex sampler_lock_;
+
+            // SINGLE_FILE only
+            int file_descriptor_;
+            std::mutex file_lock_;
+            uint64_t file_allocated_size_;
+            uint64_t file_written_size_;
+
+            std::mutex lock_;
+            // Signaled by write(), when it queued a frame or on shutdown
+            std::condition_variable frame_queued_;
+            // Signaled by the writers, when they took or wrote a frame
+            std::condition_variable frame_taken_;
+            std::deque<QueuedFrame> queue_;
+            size_t num_frames_in_flight_;
+            bool stop_requested_;
+            std::exception_ptr writer_error_;
+
+            size_t next_frame_index_;
+            std::atomic<size_t> num_frames_written_;
+            size_t num_backpressure_stalls_;
+            clock::duration backpressure_time_;
+
+            std::vector<std::thread> writer_threads_;
+        };
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_FRAME_WRITER_H
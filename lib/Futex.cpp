@@ -0,0 +1,103 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "Futex.h"
+
+#ifdef __linux__
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace fb = toa::frame_bender;
+
+#ifdef __linux__
+
+namespace {
+
+    static_assert(
+        sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), 
+        "The futex syscall requires a plain 32-bit word.");
+
+    long futex(std::atomic<uint32_t>& word, int op, uint32_t value) {
+        return syscall(
+            SYS_futex, 
+            reinterpret_cast<uint32_t*>(&word), 
+            op, 
+            value, 
+            nullptr, 
+            nullptr, 
+            0);
+    }
+
+}
+
+void fb::Futex::wait(uint32_t expected) {
+
+    // Returns immediately with EAGAIN if the value has changed already, or 
+    // with EINTR on signals. Both are fine, the caller checks again.
+    futex(value_, FUTEX_WAIT_PRIVATE, expected);
+
+}
+
+void fb::Futex::increment_and_wake(bool wake_all) {
+
+    value_.fetch_add(1, std::memory_order_release);
+    futex(value_, FUTEX_WAKE_PRIVATE, wake_all ? INT_MAX : 1);
+
+}
+
+#else
+
+void fb::Futex::wait(uint32_t expected) {
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [&]{ return value_.load() != expected; });
+
+}
+
+void fb::Futex::increment_and_wake(bool wake_all) {
+
+    {
+        // The lock makes sure that we can't increment in between the check
+        // and the wait of a sleeping thread.
+        std::lock_guard<std::mutex> lock(mutex_);
+        value_.fetch_add(1, std::memory_order_release);
+    }
+
+    if (wake_all)
+        condition_.notify_all();
+    else
+        condition_.notify_one();
+
+}
+
+#endif
+
+void fb::Futex::increment_and_wake_one() {
+    increment_and_wake(false);
+}
+
+void fb::Futex::increment_and_wake_all() {
+    increment_and_wake(true);
+}
@@ -0,0 +1,75 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_FUTEX_H
+#define TOA_FRAME_BENDER_FUTEX_H
+
+#include <atomic>
+#include <cstdint>
+
+#ifndef __linux__
+#include <condition_variable>
+#include <mutex>
+#endif
+
+#include "Utils.h"
+
+namespace toa {
+    namespace frame_bender {
+
+        // A 32-bit counter that threads can sleep on until it changes. Uses
+        // the futex syscall on Linux and falls back to a mutex/condition 
+        // variable pair elsewhere. Waking is cheap if nobody is sleeping, 
+        // but callers are still expected to track waiters themselves and 
+        // only call wake_*() if there is any.
+        class Futex : public utils::NoCopyingOrMoving {
+
+        public:
+
+            Futex() : value_(0) {}
+
+            uint32_t value() const { return value_.load(std::memory_order_acquire); }
+
+            // Blocks as long as the value is equal to expected. Might also 
+            // return spuriously, so always check the actual condition again.
+            void wait(uint32_t expected);
+
+            // Increments the value and wakes up one (or all) sleeping threads.
+            void increment_and_wake_one();
+            void increment_and_wake_all();
+
+        private:
+
+            void increment_and_wake(bool wake_all);
+
+            std::atomic<uint32_t> value_;
+
+#ifndef __linux__
+            std::mutex mutex_;
+            std::condition_variable condition_;
+#endif
+
+        };
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_FUTEX_H
@@ -0,0 +1,206 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "HostCopy.h"
+#include "CpuFeatures.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace fb = toa::frame_bender;
+
+namespace {
+
+    void copy_standard(uint8_t* dst, const uint8_t* src, size_t byte_size) {
+        memcpy(dst, src, byte_size);
+    }
+
+    // Chunks of a split copy start at cache line boundaries, so that no two
+    // threads write to the same line.
+    const size_t kChunkAlignment = 64;
+
+}
+
+fb::HostCopyKernel fb::host_copy::max_kernel() {
+
+    const cpu::Features& f = cpu::features();
+
+    if (f.avx2)
+        return HostCopyKernel::avx2_stream;
+
+    if (f.sse2)
+        return HostCopyKernel::sse2_stream;
+
+    return HostCopyKernel::standard;
+
+}
+
+fb::HostCopyKernel fb::host_copy::clamp_kernel(HostCopyKernel requested) {
+
+    HostCopyKernel max = max_kernel();
+
+    if (static_cast<int32_t>(requested) > static_cast<int32_t>(max)) {
+        FB_LOG_WARNING 
+            << "Requested host copy kernel '" << requested 
+            << "' is not supported by this CPU, falling back to '" 
+            << max << "'.";
+        return max;
+    }
+
+    return requested;
+
+}
+
+fb::host_copy::CopyFunction fb::host_copy::copy_function(HostCopyKernel kernel) {
+
+    switch (kernel) {
+    case HostCopyKernel::sse2_stream:
+        return &copy_stream_sse2;
+    case HostCopyKernel::avx2_stream:
+        return &copy_stream_avx2;
+    default:
+        return &copy_standard;
+    }
+
+}
+
+void fb::host_copy::copy(uint8_t* dst, const uint8_t* src, size_t byte_size) {
+
+    static const CopyFunction best = copy_function(max_kernel());
+    best(dst, src, byte_size);
+
+}
+
+void fb::host_copy::swap_bytes(uint8_t* data, size_t byte_size, size_t word_size) {
+
+    if (word_size == 0 || byte_size % word_size != 0) {
+        FB_LOG_ERROR 
+            << "Can't swap bytes of " << byte_size << " bytes in words of " 
+            << word_size << " bytes.";
+        throw std::invalid_argument("Invalid word size for endian-swap.");
+    }
+
+    static const bool use_avx2 = cpu::features().avx2;
+
+    switch (word_size) {
+
+    case 1:
+        break;
+
+    case 2:
+        (use_avx2 ? &swap_bytes_16_avx2 : &swap_bytes_16_sse2)(data, byte_size);
+        break;
+
+    case 4:
+        (use_avx2 ? &swap_bytes_32_avx2 : &swap_bytes_32_sse2)(data, byte_size);
+        break;
+
+    default:
+        for (size_t i = 0; i<byte_size; i += word_size)
+            std::reverse(data + i, data + i + word_size);
+        break;
+    }
+
+}
+
+fb::HostCopyEngine::HostCopyEngine(
+    HostCopyKernel max_kernel,
+    size_t num_threads,
+    size_t min_split_size) :
+        kernel_(host_copy::clamp_kernel(max_kernel)),
+        copy_function_(host_copy::copy_function(kernel_)),
+        min_split_size_(std::max(min_split_size, kChunkAlignment))
+{
+
+    if (num_threads != 1) {
+        worker_pool_ = utils::make_unique<WorkerPool>(num_threads);
+        if (worker_pool_->num_workers() == 1)
+            worker_pool_.reset();
+    }
+
+}
+
+void fb::HostCopyEngine::copy(uint8_t* dst, const uint8_t* src, size_t byte_size) {
+
+    if (!worker_pool_ || byte_size < min_split_size_) {
+        copy_function_(dst, src, byte_size);
+        return;
+    }
+
+    const size_t num_workers = worker_pool_->num_workers();
+
+    size_t chunk_size = (byte_size + num_workers - 1) / num_workers;
+    chunk_size = (chunk_size + kChunkAlignment - 1) / kChunkAlignment * kChunkAlignment;
+
+    const size_t num_chunks = (byte_size + chunk_size - 1) / chunk_size;
+    const host_copy::CopyFunction copy_function = copy_function_;
+
+    worker_pool_->run(num_chunks, [=](size_t chunk, size_t) {
+        const size_t offset = chunk * chunk_size;
+        copy_function(dst + offset, src + offset, std::min(chunk_size, byte_size - offset));
+    });
+
+}
+
+std::ostream& fb::operator<< (std::ostream& out, const HostCopyKernel& v) {
+
+    switch (v) {
+    case HostCopyKernel::standard:
+        out << "memcpy";
+        break;
+    case HostCopyKernel::sse2_stream:
+        out << "sse2_stream";
+        break;
+    case HostCopyKernel::avx2_stream:
+        out << "avx2_stream";
+        break;
+    default:
+        out << "<unknown>";
+        break;
+    }
+
+    return out;
+
+}
+
+std::istream& fb::operator>>(std::istream& in, HostCopyKernel& v) {
+
+    std::string token;
+    in >> token;
+
+    std::transform(token.begin(), token.end(),token.begin(), ::tolower);
+
+    if (token == "memcpy")
+        v = HostCopyKernel::standard;
+    else if (token == "sse2_stream")
+        v = HostCopyKernel::sse2_stream;
+    else if (token == "avx2_stream")
+        v = HostCopyKernel::avx2_stream;
+    else {
+        in.setstate(std::ios::failbit);
+    }
+
+    return in;
+
+}
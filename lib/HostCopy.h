@@ -0,0 +1,114 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_HOST_COPY_H
+#define TOA_FRAME_BENDER_HOST_COPY_H
+
+#include <memory>
+#include <iosfwd>
+#include <cstdint>
+
+#include "HostCopyKernels.h"
+#include "WorkerPool.h"
+#include "Utils.h"
+
+namespace toa {
+    namespace frame_bender {
+
+        // How frame-sized buffers are copied on the host. Like 
+        // cpu::SimdLevel, the kernels are ordered by the instruction set 
+        // they require.
+        enum class HostCopyKernel : int32_t {
+            // Plain memcpy, i.e. whatever the C library does
+            standard,
+            // 128 bit non-temporal stores
+            sse2_stream,
+            // 256 bit non-temporal stores
+            avx2_stream,
+            count
+        };
+
+        std::ostream& operator<< (std::ostream& out, const HostCopyKernel& v);
+        std::istream& operator>>(std::istream& in, HostCopyKernel& v);
+
+        namespace host_copy {
+
+            // Best kernel the current CPU is able to execute.
+            HostCopyKernel max_kernel();
+
+            // Returns the requested kernel, clamped to what the CPU supports.
+            HostCopyKernel clamp_kernel(HostCopyKernel requested);
+
+            CopyFunction copy_function(HostCopyKernel kernel);
+
+            // Copies on the calling thread with the best kernel, for 
+            // occasional copies that don't have a HostCopyEngine at hand. 
+            // Thread-safe.
+            void copy(uint8_t* dst, const uint8_t* src, size_t byte_size);
+
+            // Reverses the byte order of every word_size byte word in data, 
+            // in place, e.g. for writing big-endian files. 16 and 32 bit 
+            // words are swapped with the best SIMD kernel the CPU supports, 
+            // other sizes bytewise. Throws std::invalid_argument if 
+            // word_size is 0 or byte_size isn't a multiple of it.
+            void swap_bytes(uint8_t* data, size_t byte_size, size_t word_size);
+
+        }
+
+        // Copies frames with one of the kernels above, optionally splitting 
+        // large copies into chunks that are copied in parallel on a small 
+        // worker pool. A single core often can't saturate the memory bus 
+        // (especially with write-combined PBO memory as destination), a 
+        // few of them can.
+        class HostCopyEngine : public utils::NoCopyingOrMoving {
+
+        public:
+
+            // Copies smaller than this are never split
+            static const size_t kDefaultMinSplitSize = 1 << 20;
+
+            HostCopyEngine(
+                HostCopyKernel max_kernel,
+                // Number of threads a copy is split across. 1 copies on the
+                // calling thread only, 0 uses one per hardware thread.
+                size_t num_threads = 1,
+                size_t min_split_size = kDefaultMinSplitSize);
+
+            // Only thread-safe if num_threads() is 1, a multi-threaded 
+            // engine must not be used by more than one thread at a time.
+            void copy(uint8_t* dst, const uint8_t* src, size_t byte_size);
+
+            HostCopyKernel kernel() const { return kernel_; }
+            size_t num_threads() const { return worker_pool_ ? worker_pool_->num_workers() : 1; }
+
+        private:
+
+            HostCopyKernel kernel_;
+            host_copy::CopyFunction copy_function_;
+            size_t min_split_size_;
+            std::unique_ptr<WorkerPool> worker_pool_;
+
+        };
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_HOST_COPY_H
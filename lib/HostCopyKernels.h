@@ -0,0 +1,66 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_HOST_COPY_KERNELS_H
+#define TOA_FRAME_BENDER_HOST_COPY_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Copy kernels with non-temporal (streaming) stores, i.e. the destination 
+// bypasses the cache. This is what we want for frame-sized copies: the 
+// destination is either write-combined PBO memory, or a frame which won't be
+// read again by this core any time soon. The source may have any alignment,
+// the kernels align the destination themselves.
+//
+// Same as for V210CpuKernels.h, this header must stay free of any 
+// non-trivial includes, since it is included by translation units that are 
+// compiled with ISA-specific compiler flags.
+
+namespace toa {
+    namespace frame_bender {
+        namespace host_copy {
+
+            typedef void (*CopyFunction)(
+                uint8_t* dst, 
+                const uint8_t* src, 
+                size_t byte_size);
+
+            void copy_stream_sse2(uint8_t* dst, const uint8_t* src, size_t byte_size);
+
+            void copy_stream_avx2(uint8_t* dst, const uint8_t* src, size_t byte_size);
+
+            // Reverse the byte order of every 16 or 32 bit word in data, in
+            // place. byte_size must be a multiple of the word size, data 
+            // may have any alignment.
+            typedef void (*SwapFunction)(uint8_t* data, size_t byte_size);
+
+            void swap_bytes_16_sse2(uint8_t* data, size_t byte_size);
+            void swap_bytes_32_sse2(uint8_t* data, size_t byte_size);
+
+            void swap_bytes_16_avx2(uint8_t* data, size_t byte_size);
+            void swap_bytes_32_avx2(uint8_t* data, size_t byte_size);
+
+        }
+    }
+}
+
+#endif // TOA_FRAME_BENDER_HOST_COPY_KERNELS_H
@@ -0,0 +1,132 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+// Note: this translation unit is compiled with AVX2 code generation enabled,
+// see V210CpuKernelsAVX2.cpp for what that means for includes.
+
+#include "HostCopyKernels.h"
+
+#include <immintrin.h>
+
+namespace {
+
+    const size_t kAlignment = 32;
+    const size_t kBlockSize = 128;
+    const size_t kPrefetchDistance = 512;
+
+    void copy_bytes(uint8_t* dst, const uint8_t* src, size_t byte_size) {
+        for (size_t i = 0; i<byte_size; ++i)
+            dst[i] = src[i];
+    }
+
+}
+
+void toa::frame_bender::host_copy::copy_stream_avx2(
+    uint8_t* dst, 
+    const uint8_t* src, 
+    size_t byte_size)
+{
+
+    // Streaming stores need an aligned destination
+    size_t head = (kAlignment - (reinterpret_cast<uintptr_t>(dst) & (kAlignment - 1))) & (kAlignment - 1);
+    if (head > byte_size)
+        head = byte_size;
+
+    copy_bytes(dst, src, head);
+    dst += head;
+    src += head;
+    byte_size -= head;
+
+    const size_t num_blocks = byte_size / kBlockSize;
+
+    for (size_t i = 0; i<num_blocks; ++i, src += kBlockSize, dst += kBlockSize) {
+
+        // Prefetching past the end of the source is harmless
+        _mm_prefetch(reinterpret_cast<const char*>(src + kPrefetchDistance), _MM_HINT_NTA);
+        _mm_prefetch(reinterpret_cast<const char*>(src + kPrefetchDistance + 64), _MM_HINT_NTA);
+
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 32));
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 64));
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 96));
+
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst), a);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + 32), b);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + 64), c);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + 96), d);
+    }
+
+    // Streaming stores are weakly ordered, make them visible before 
+    // whoever waits for this copy reads the destination.
+    _mm_sfence();
+
+    copy_bytes(dst, src, byte_size - num_blocks * kBlockSize);
+
+}
+
+namespace {
+
+    void swap_bytes_avx2(uint8_t* data, size_t byte_size, const __m256i& shuffle, size_t word_size) {
+
+        const size_t num_vectors = byte_size / 32;
+
+        for (size_t i = 0; i<num_vectors; ++i, data += 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), _mm256_shuffle_epi8(v, shuffle));
+        }
+
+        for (size_t i = 0; i + word_size <= byte_size - num_vectors * 32; i += word_size) {
+            for (size_t j = 0; j<word_size / 2; ++j) {
+                const uint8_t b = data[i + j];
+                data[i + j] = data[i + word_size - 1 - j];
+                data[i + word_size - 1 - j] = b;
+            }
+        }
+
+    }
+
+}
+
+void toa::frame_bender::host_copy::swap_bytes_16_avx2(
+    uint8_t* data, 
+    size_t byte_size)
+{
+
+    const __m256i shuffle = _mm256_setr_epi8(
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+    swap_bytes_avx2(data, byte_size, shuffle, 2);
+
+}
+
+void toa::frame_bender::host_copy::swap_bytes_32_avx2(
+    uint8_t* data, 
+    size_t byte_size)
+{
+
+    const __m256i shuffle = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    swap_bytes_avx2(data, byte_size, shuffle, 4);
+
+}
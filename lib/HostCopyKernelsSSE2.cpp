@@ -0,0 +1,132 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+// Note: see V210CpuKernelsAVX2.cpp, this translation unit must not include
+// Precompile.h or any other header with inline functions shared with other
+// translation units. SSE2 is part of x86-64, so no extra flags are needed.
+
+#include "HostCopyKernels.h"
+
+#include <emmintrin.h>
+
+namespace {
+
+    const size_t kAlignment = 16;
+    const size_t kBlockSize = 64;
+    const size_t kPrefetchDistance = 512;
+
+    void copy_bytes(uint8_t* dst, const uint8_t* src, size_t byte_size) {
+        for (size_t i = 0; i<byte_size; ++i)
+            dst[i] = src[i];
+    }
+
+}
+
+void toa::frame_bender::host_copy::copy_stream_sse2(
+    uint8_t* dst, 
+    const uint8_t* src, 
+    size_t byte_size)
+{
+
+    // Streaming stores need an aligned destination
+    size_t head = (kAlignment - (reinterpret_cast<uintptr_t>(dst) & (kAlignment - 1))) & (kAlignment - 1);
+    if (head > byte_size)
+        head = byte_size;
+
+    copy_bytes(dst, src, head);
+    dst += head;
+    src += head;
+    byte_size -= head;
+
+    const size_t num_blocks = byte_size / kBlockSize;
+
+    for (size_t i = 0; i<num_blocks; ++i, src += kBlockSize, dst += kBlockSize) {
+
+        // Prefetching past the end of the source is harmless
+        _mm_prefetch(reinterpret_cast<const char*>(src + kPrefetchDistance), _MM_HINT_NTA);
+
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst), a);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), d);
+    }
+
+    // Streaming stores are weakly ordered, make them visible before 
+    // whoever waits for this copy reads the destination.
+    _mm_sfence();
+
+    copy_bytes(dst, src, byte_size - num_blocks * kBlockSize);
+
+}
+
+void toa::frame_bender::host_copy::swap_bytes_16_sse2(
+    uint8_t* data, 
+    size_t byte_size)
+{
+
+    const size_t num_vectors = byte_size / 16;
+
+    for (size_t i = 0; i<num_vectors; ++i, data += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(data), 
+            _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+
+    for (size_t i = 0; i + 1 < byte_size - num_vectors * 16; i += 2) {
+        const uint8_t b = data[i];
+        data[i] = data[i + 1];
+        data[i + 1] = b;
+    }
+
+}
+
+void toa::frame_bender::host_copy::swap_bytes_32_sse2(
+    uint8_t* data, 
+    size_t byte_size)
+{
+
+    const size_t num_vectors = byte_size / 16;
+
+    for (size_t i = 0; i<num_vectors; ++i, data += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        // Swap the 16 bit halves of each word, then the bytes of each half
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(data), 
+            _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+
+    for (size_t i = 0; i + 3 < byte_size - num_vectors * 16; i += 4) {
+        const uint8_t b0 = data[i];
+        const uint8_t b1 = data[i + 1];
+        data[i] = data[i + 3];
+        data[i + 1] = data[i + 2];
+        data[i + 2] = b1;
+        data[i + 3] = b0;
+    }
+
+}
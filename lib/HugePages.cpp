@@ -0,0 +1,221 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "HugePages.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+#include <boost/align/aligned_alloc.hpp>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace fb = toa::frame_bender;
+
+namespace {
+
+    // Page-aligned, so that frames can be the target of O_DIRECT reads
+    const size_t kHeapAlignment = 4096;
+
+    // Only warn once about a fallback, not for every frame
+#ifdef __linux__
+    std::atomic<bool> has_warned_about_hugetlb(false);
+#else
+    std::atomic<bool> has_warned_about_platform(false);
+#endif
+
+    size_t round_up_to_huge_page(size_t byte_size) {
+        return (byte_size + fb::huge_pages::kHugePageSize - 1) & ~(fb::huge_pages::kHugePageSize - 1);
+    }
+
+    uint8_t* allocate_heap(size_t byte_size) {
+
+        void* data = boost::alignment::aligned_alloc(kHeapAlignment, byte_size);
+
+        if (data == nullptr)
+            throw std::bad_alloc();
+
+        return reinterpret_cast<uint8_t*>(data);
+    }
+
+#ifdef __linux__
+
+    uint8_t* map_explicit(size_t mapped_size) {
+
+#ifdef MAP_HUGETLB
+        void* data = mmap(
+            nullptr, 
+            mapped_size, 
+            PROT_READ | PROT_WRITE, 
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, 
+            -1, 
+            0);
+
+        if (data != MAP_FAILED)
+            return reinterpret_cast<uint8_t*>(data);
+#endif
+
+        if (!has_warned_about_hugetlb.exchange(true)) {
+            FB_LOG_WARNING 
+                << "Could not map explicit huge pages (is vm.nr_hugepages "
+                << "large enough?), falling back to transparent huge pages.";
+        }
+
+        return nullptr;
+    }
+
+    uint8_t* map_transparent(size_t mapped_size) {
+
+        // Anonymous mappings are only page-aligned, but THP can only back
+        // 2 MiB aligned ranges. Map an extra huge page and trim both ends.
+        const size_t oversized = mapped_size + fb::huge_pages::kHugePageSize;
+
+        void* raw = mmap(
+            nullptr, 
+            oversized, 
+            PROT_READ | PROT_WRITE, 
+            MAP_PRIVATE | MAP_ANONYMOUS, 
+            -1, 
+            0);
+
+        if (raw == MAP_FAILED)
+            throw std::bad_alloc();
+
+        const uintptr_t raw_begin = reinterpret_cast<uintptr_t>(raw);
+        const uintptr_t aligned_begin = (raw_begin + fb::huge_pages::kHugePageSize - 1) & ~(fb::huge_pages::kHugePageSize - 1);
+        const uintptr_t aligned_end = aligned_begin + mapped_size;
+        const uintptr_t raw_end = raw_begin + oversized;
+
+        if (aligned_begin != raw_begin)
+            munmap(raw, aligned_begin - raw_begin);
+
+        if (raw_end != aligned_end)
+            munmap(reinterpret_cast<void*>(aligned_end), raw_end - aligned_end);
+
+        void* data = reinterpret_cast<void*>(aligned_begin);
+
+#ifdef MADV_HUGEPAGE
+        if (madvise(data, mapped_size, MADV_HUGEPAGE) != 0) {
+            FB_LOG_DEBUG << "madvise(MADV_HUGEPAGE) failed, THP might be disabled.";
+        }
+#endif
+
+        return reinterpret_cast<uint8_t*>(data);
+    }
+
+#endif
+
+}
+
+std::ostream& fb::operator<< (std::ostream& out, const HugePages& v) {
+
+    switch (v) {
+    case HugePages::OFF:
+        out << "off";
+        break;
+    case HugePages::TRANSPARENT:
+        out << "transparent";
+        break;
+    case HugePages::EXPLICIT:
+        out << "explicit";
+        break;
+    default:
+        out << "<unknown>";
+        break;
+    }
+
+    return out;
+
+}
+
+std::istream& fb::operator>>(std::istream& in, HugePages& v) {
+
+    std::string token;
+    in >> token;
+
+    std::transform(token.begin(), token.end(),token.begin(), ::tolower);
+
+    if (token == "off")
+        v = HugePages::OFF;
+    else if (token == "transparent")
+        v = HugePages::TRANSPARENT;
+    else if (token == "explicit")
+        v = HugePages::EXPLICIT;
+    else {
+        in.setstate(std::ios::failbit);
+    }
+
+    return in;
+
+}
+
+uint8_t* fb::huge_pages::allocate(size_t byte_size, HugePages mode) {
+
+#ifdef __linux__
+
+    if (mode == HugePages::OFF)
+        return allocate_heap(byte_size);
+
+    const size_t mapped_size = round_up_to_huge_page(byte_size);
+
+    if (mode == HugePages::EXPLICIT) {
+        uint8_t* data = map_explicit(mapped_size);
+        if (data != nullptr)
+            return data;
+    }
+
+    return map_transparent(mapped_size);
+
+#else
+
+    if (mode != HugePages::OFF && !has_warned_about_platform.exchange(true)) {
+        FB_LOG_WARNING << "Huge pages are not supported on this platform, using regular pages.";
+    }
+
+    return allocate_heap(byte_size);
+
+#endif
+
+}
+
+void fb::huge_pages::free(uint8_t* data, size_t byte_size, HugePages mode) {
+
+    if (data == nullptr)
+        return;
+
+#ifdef __linux__
+
+    // Both huge page modes are plain mappings of the same rounded size
+    if (mode != HugePages::OFF) {
+        munmap(data, round_up_to_huge_page(byte_size));
+        return;
+    }
+
+#endif
+
+    boost::alignment::aligned_free(data);
+
+}
@@ -0,0 +1,67 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_HUGE_PAGES_H
+#define TOA_FRAME_BENDER_HUGE_PAGES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace toa {
+    namespace frame_bender {
+
+        // How frame payloads are backed by memory pages. A 2160p V210 frame
+        // spans thousands of regular 4 KiB pages, but only about a dozen 
+        // 2 MiB pages, which takes a lot of pressure off the TLB when 
+        // copying whole frames.
+        enum class HugePages {
+            // Regular page-aligned (4 KiB) heap memory
+            OFF,
+            // 2 MiB aligned anonymous mapping with madvise(MADV_HUGEPAGE),
+            // the kernel backs it with huge pages if it can (THP)
+            TRANSPARENT,
+            // Explicit huge pages with MAP_HUGETLB, which must have been 
+            // reserved (vm.nr_hugepages). Falls back to TRANSPARENT.
+            EXPLICIT
+        };
+
+        std::ostream& operator<< (std::ostream& out, const HugePages& v);
+        std::istream& operator>>(std::istream& in, HugePages& v);
+
+        namespace huge_pages {
+
+            const size_t kHugePageSize = 2 * 1024 * 1024;
+
+            // Returns memory aligned to at least 4 KiB. Throws 
+            // std::bad_alloc on failure. Modes that aren't available on this
+            // platform fall back to the next best one.
+            uint8_t* allocate(size_t byte_size, HugePages mode);
+
+            // Must be called with the same size and mode as allocate()
+            void free(uint8_t* data, size_t byte_size, HugePages mode);
+
+        }
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_HUGE_PAGES_H
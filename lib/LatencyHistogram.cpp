@@ -0,0 +1,253 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "LatencyHistogram.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace fb = toa::frame_bender;
+
+namespace {
+
+    // v must not be zero
+    inline int32_t count_leading_zeros(uint64_t v) {
+
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanReverse64(&index, v);
+        return 63 - static_cast<int32_t>(index);
+#else
+        return __builtin_clzll(v);
+#endif
+
+    }
+
+}
+
+fb::LatencyHistogram::LatencyHistogram(
+    int64_t highest_trackable_ns,
+    int32_t significant_digits) : 
+        highest_trackable_ns_(highest_trackable_ns),
+        significant_digits_(significant_digits),
+        sub_bucket_half_count_magnitude_(0),
+        sub_bucket_half_count_(0),
+        sub_bucket_mask_(0),
+        total_count_(0),
+        minimum_(std::numeric_limits<int64_t>::max()),
+        maximum_(0)
+{
+
+    if (significant_digits < 1 || significant_digits > 5) {
+        FB_LOG_ERROR << "Histogram precision of " << significant_digits << " significant digits is out of range [1, 5].";
+        throw std::invalid_argument("Invalid number of significant digits.");
+    }
+
+    if (highest_trackable_ns < 2) {
+        FB_LOG_ERROR << "Histogram must track values of at least 2 ns, but " << highest_trackable_ns << " was given.";
+        throw std::invalid_argument("Invalid highest trackable value.");
+    }
+
+    // Within the first bucket, every value has its own sub-bucket, up to 
+    // where a unit step is below the requested precision.
+    int64_t largest_value_with_single_unit_resolution = 2;
+    for (int32_t i = 0; i<significant_digits; ++i)
+        largest_value_with_single_unit_resolution *= 10;
+
+    int32_t sub_bucket_count_magnitude = 0;
+    while ((int64_t(1) << sub_bucket_count_magnitude) < largest_value_with_single_unit_resolution)
+        sub_bucket_count_magnitude++;
+
+    sub_bucket_half_count_magnitude_ = std::max(sub_bucket_count_magnitude, 1) - 1;
+
+    const int64_t sub_bucket_count = int64_t(1) << (sub_bucket_half_count_magnitude_ + 1);
+    sub_bucket_half_count_ = sub_bucket_count / 2;
+    sub_bucket_mask_ = sub_bucket_count - 1;
+
+    // Every further bucket doubles the range covered
+    int64_t smallest_untrackable_value = sub_bucket_count;
+    size_t bucket_count = 1;
+
+    while (smallest_untrackable_value <= highest_trackable_ns_) {
+
+        if (smallest_untrackable_value > std::numeric_limits<int64_t>::max() / 2) {
+            bucket_count++;
+            break;
+        }
+
+        smallest_untrackable_value <<= 1;
+        bucket_count++;
+    }
+
+    // All but the first bucket only use their upper half, the lower half is
+    // covered by the previous one.
+    counts_.resize((bucket_count + 1) * static_cast<size_t>(sub_bucket_half_count_), 0);
+
+}
+
+size_t fb::LatencyHistogram::index_of(int64_t value) const {
+
+    const int32_t bucket_index = 
+        64 - count_leading_zeros(static_cast<uint64_t>(value | sub_bucket_mask_)) - 
+        (sub_bucket_half_count_magnitude_ + 1);
+
+    const int64_t sub_bucket_index = value >> bucket_index;
+
+    return static_cast<size_t>(
+        (static_cast<int64_t>(bucket_index + 1) << sub_bucket_half_count_magnitude_) + 
+        (sub_bucket_index - sub_bucket_half_count_));
+
+}
+
+int64_t fb::LatencyHistogram::value_at_index(size_t index) const {
+
+    int32_t bucket_index = static_cast<int32_t>(index >> sub_bucket_half_count_magnitude_) - 1;
+    int64_t sub_bucket_index = 
+        static_cast<int64_t>(index & static_cast<size_t>(sub_bucket_half_count_ - 1)) + 
+        sub_bucket_half_count_;
+
+    if (bucket_index < 0) {
+        sub_bucket_index -= sub_bucket_half_count_;
+        bucket_index = 0;
+    }
+
+    return sub_bucket_index << bucket_index;
+
+}
+
+int64_t fb::LatencyHistogram::highest_equivalent_value(int64_t value) const {
+
+    const int32_t bucket_index = 
+        64 - count_leading_zeros(static_cast<uint64_t>(value | sub_bucket_mask_)) - 
+        (sub_bucket_half_count_magnitude_ + 1);
+
+    const int64_t lowest_equivalent_value = (value >> bucket_index) << bucket_index;
+
+    return lowest_equivalent_value + (int64_t(1) << bucket_index) - 1;
+
+}
+
+void fb::LatencyHistogram::record(int64_t value_ns, uint64_t count) {
+
+    if (count == 0)
+        return;
+
+    int64_t clamped = std::min(std::max(value_ns, int64_t(0)), highest_trackable_ns_);
+
+    counts_[index_of(clamped)] += count;
+    total_count_ += count;
+
+    minimum_ = std::min(minimum_, value_ns);
+    maximum_ = std::max(maximum_, value_ns);
+
+}
+
+void fb::LatencyHistogram::merge(const LatencyHistogram& other) {
+
+    if (!has_same_layout(other)) {
+        FB_LOG_ERROR 
+            << "Can't merge a histogram up to " << other.highest_trackable_ns_ 
+            << " ns with " << other.significant_digits_ << " significant digits "
+            << "into one up to " << highest_trackable_ns_ << " ns with " 
+            << significant_digits_ << " significant digits.";
+        throw std::invalid_argument("Histogram layouts don't match.");
+    }
+
+    if (other.total_count_ == 0)
+        return;
+
+    for (size_t i = 0; i<counts_.size(); ++i)
+        counts_[i] += other.counts_[i];
+
+    total_count_ += other.total_count_;
+    minimum_ = std::min(minimum_, other.minimum_);
+    maximum_ = std::max(maximum_, other.maximum_);
+
+}
+
+void fb::LatencyHistogram::clear() {
+
+    std::fill(std::begin(counts_), std::end(counts_), 0);
+    total_count_ = 0;
+    minimum_ = std::numeric_limits<int64_t>::max();
+    maximum_ = 0;
+
+}
+
+int64_t fb::LatencyHistogram::value_at_percentile(double percentile) const {
+
+    if (total_count_ == 0)
+        return 0;
+
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+
+    uint64_t count_at_percentile = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total_count_) + 0.5);
+    count_at_percentile = std::max(count_at_percentile, uint64_t(1));
+
+    uint64_t count_so_far = 0;
+
+    for (size_t i = 0; i<counts_.size(); ++i) {
+
+        count_so_far += counts_[i];
+
+        if (count_so_far >= count_at_percentile) {
+            int64_t value = highest_equivalent_value(value_at_index(i));
+            return std::max(minimum_, std::min(value, maximum_));
+        }
+
+    }
+
+    return maximum_;
+
+}
+
+void fb::LatencyHistogram::add_count_at_index(size_t index, uint64_t count) {
+
+    if (index >= counts_.size())
+        throw std::out_of_range("Histogram index is out of range.");
+
+    if (count == 0)
+        return;
+
+    counts_[index] += count;
+    total_count_ += count;
+
+    int64_t value = value_at_index(index);
+
+    minimum_ = std::min(minimum_, value);
+    maximum_ = std::max(maximum_, highest_equivalent_value(value));
+
+}
+
+bool fb::LatencyHistogram::has_same_layout(const LatencyHistogram& other) const {
+
+    return 
+        highest_trackable_ns_ == other.highest_trackable_ns_ && 
+        significant_digits_ == other.significant_digits_;
+
+}
@@ -0,0 +1,112 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_LATENCY_HISTOGRAM_H
+#define TOA_FRAME_BENDER_LATENCY_HISTOGRAM_H
+
+#include <vector>
+#include <cstdint>
+
+namespace toa {
+    namespace frame_bender {
+
+        // High-dynamic-range histogram of nanosecond values, after Gil Tene's
+        // HdrHistogram. Buckets are powers of two, each split into linear 
+        // sub-buckets, so that any value is kept to significant_digits 
+        // decimal digits of precision, from 1 ns up to highest_trackable_ns.
+        // Recording is O(1), with a fixed memory footprint independent of 
+        // the number of values recorded.
+        //
+        // Histograms of the same layout can be merged, e.g. the same 
+        // statistic over multiple runs. The counts are exposed by index, 
+        // which is how they are stored in the trace format.
+        class LatencyHistogram {
+
+        public:
+
+            static const int64_t kDefaultHighestTrackableNs = 10000000000; // 10 s
+            static const int32_t kDefaultSignificantDigits = 3;
+
+            // Throws std::invalid_argument if significant_digits is not 
+            // within [1, 5], or highest_trackable_ns is less than 2.
+            explicit LatencyHistogram(
+                int64_t highest_trackable_ns = kDefaultHighestTrackableNs,
+                int32_t significant_digits = kDefaultSignificantDigits);
+
+            // Negative values are recorded as zero, values larger than
+            // highest_trackable_ns() as highest_trackable_ns(). minimum() and
+            // maximum() still see them as they are.
+            void record(int64_t value_ns, uint64_t count = 1);
+
+            // Throws std::invalid_argument if the layouts don't match
+            void merge(const LatencyHistogram& other);
+
+            void clear();
+
+            // percentile in [0, 100]. Returns the largest value equivalent
+            // to the one at the given percentile (i.e. within the precision
+            // of the histogram), but never more than maximum(). Zero if 
+            // nothing was recorded.
+            int64_t value_at_percentile(double percentile) const;
+
+            uint64_t total_count() const { return total_count_; }
+            int64_t minimum() const { return total_count_ != 0 ? minimum_ : 0; }
+            int64_t maximum() const { return maximum_; }
+
+            int64_t highest_trackable_ns() const { return highest_trackable_ns_; }
+            int32_t significant_digits() const { return significant_digits_; }
+
+            // For storing and restoring histograms
+            size_t num_counts() const { return counts_.size(); }
+            uint64_t count_at_index(size_t index) const { return counts_.at(index); }
+
+            // Throws std::out_of_range if index >= num_counts(). Minimum and 
+            // maximum are taken from the index' value range.
+            void add_count_at_index(size_t index, uint64_t count);
+
+            // The smallest value counted at the given index
+            int64_t value_at_index(size_t index) const;
+
+            bool has_same_layout(const LatencyHistogram& other) const;
+
+        private:
+
+            size_t index_of(int64_t value) const;
+            int64_t highest_equivalent_value(int64_t value) const;
+
+            int64_t highest_trackable_ns_;
+            int32_t significant_digits_;
+
+            int32_t sub_bucket_half_count_magnitude_;
+            int64_t sub_bucket_half_count_;
+            int64_t sub_bucket_mask_;
+
+            std::vector<uint64_t> counts_;
+            uint64_t total_count_;
+            int64_t minimum_;
+            int64_t maximum_;
+
+        };
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_LATENCY_HISTOGRAM_H
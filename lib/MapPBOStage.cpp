@@ -101,6 +101,9 @@ fb::StageCommand fb::MapPBOStage::perform(
     token_out.composition = token_in.composition;
     token_out.time_stamp = token_in.time_stamp;
     token_out.id = token_in.id;
+    token_out.trace_id = token_in.trace_id;
+
+    sampler_.enter_trace_id(token_in.trace_id);
 
     if (!pbo_memory_is_persistently_mapped_) {
 
@@ -117,6 +120,7 @@ fb::StageCommand fb::MapPBOStage::perform(
 
     token_in.composition = nullptr;
     token_in.time_stamp = Time(0, 1);
+    token_in.trace_id = kNoTraceId;
     token_in.id = upstream_token.id;
     token_in.gl_fence = 0;
     token_in.fbo_id = 0;
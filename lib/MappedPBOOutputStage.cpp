@@ -0,0 +1,69 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+
+#include "MappedPBOOutputStage.h"
+#include "StreamComposition.h"
+#include "ProgramOptions.h"
+
+namespace fb = toa::frame_bender;
+
+fb::MappedPBOOutputStage::~MappedPBOOutputStage() {
+    
+    if (ProgramOptions::global().sample_stages()) {
+        auto stats = sampler_.collect_statistics();
+        for (const auto& stat : stats) {
+            FB_LOG_INFO << stage_.name() << ": " << stat;
+        }
+    }
+}
+
+fb::StageCommand fb::MappedPBOOutputStage::perform(TokenGL& token_in) {
+
+    sampler_.enter_trace_id(token_in.trace_id);
+
+    if (token_in.format != format_) {
+        FB_LOG_CRITICAL << "Image format mismatch.";
+        return StageCommand::STOP_EXECUTION;
+    }
+
+#ifdef DEBUG_PIPE_FLOW
+
+    FB_LOG_DEBUG << stage_.name() << ": Delivering mapped memory of PBO '" << token_in.id << "' at '" << token_in.time_stamp << "'.";
+
+#endif
+
+    if (token_in.composition->output_callback_) {
+
+        // The view must not outlive this call, once we return the token
+        // (and with it the mapped memory) goes back upstream.
+        const Frame view = Frame::create_view(
+            format_,
+            token_in.time_stamp,
+            false,
+            token_in.buffer);
+
+        token_in.composition->output_callback_(view);
+    }
+
+    return StageCommand::NO_CHANGE;
+}
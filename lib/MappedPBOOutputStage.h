@@ -0,0 +1,121 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_MAPPED_PBO_OUTPUT_STAGE_H
+#define TOA_FRAME_BENDER_MAPPED_PBO_OUTPUT_STAGE_H
+
+#include "Stage.h"
+#include "Frame.h"
+#include "StageDataTypes.h"
+#include "StageSampler.h"
+#include "PipelineStage.h"
+#include "ProgramOptions.h"
+
+#include "Utils.h"
+
+namespace toa {
+
+    namespace frame_bender {
+
+        class StreamComposition;
+
+        /**
+         * Zero-copy alternative to CopyMappedPBOToHostStage followed by 
+         * FrameCompositionOutputStage. The output callback receives a 
+         * borrowed, read-only frame which points directly into the mapped 
+         * download PBO. The PBO token goes back upstream to the map stage 
+         * only once the callback returned, i.e. the frame handed to the 
+         * callback is only valid for the duration of the call. Consumers 
+         * that need the image for longer have to copy it themselves (e.g. 
+         * with Frame::create_copy).
+         * This is a consumer node, i.e. no other outputs from this stage.
+         */
+        class MappedPBOOutputStage : public utils::NoCopyingOrMoving, public PipelineStage  {
+
+        public:
+
+            typedef Stage<TokenGL, NO_OUTPUT> StageType;
+
+            template <typename InputStage>
+            MappedPBOOutputStage(
+                ImageFormat frame_format,
+                const InputStage& input_stage);
+
+            ~MappedPBOOutputStage();
+
+            void execute() override { stage_.execute(); }
+            PipelineStatus status() const override { return stage_.status(); }
+            size_t input_queue_num_elements() const override { return stage_.input_queue_num_elements(); }
+            bool has_tokens_available() const override { return stage_.has_tokens_available(); }
+            const std::string& name() const override { return stage_.name(); }
+            size_t output_queue_size() const override { return stage_.output_queue_size(); } 
+            void set_wake_sampler(WakeSampleFunction sampler) override { stage_.set_wake_sampler(std::move(sampler)); }
+            std::vector<std::unique_ptr<FifoSampler>> sample_input_queues() override { return stage_.sample_input_queues(); }
+
+            const StageType& stage() const { return stage_; }
+
+            const StageSampler& sampler() const { return sampler_; }
+
+        private:
+
+            StageCommand perform(TokenGL& token_in);
+
+            StageType stage_;
+
+            StageSampler sampler_;
+
+            ImageFormat format_;
+
+        };        
+
+        template <typename InputStage>
+        MappedPBOOutputStage::MappedPBOOutputStage(
+            ImageFormat frame_format,
+            const InputStage& input_stage) :
+                format_(frame_format)
+        {
+
+            SampleFunction fnc;
+
+            if (ProgramOptions::global().sample_stages()) {
+                fnc = std::bind(&StageSampler::sample, &sampler_, std::placeholders::_1);
+            }
+
+            // Same name as FrameCompositionOutputStage, so that traces of 
+            // both output modes line up for the analysis scripts.
+            stage_ = utils::create_consumer_stage<typename InputStage::StageType>(
+                "FrameOutput",
+                std::bind(
+                    &MappedPBOOutputStage::perform, 
+                    this, 
+                    std::placeholders::_1),
+                input_stage.stage(),
+                std::move(fnc));
+
+            FB_LOG_INFO << "Output frames are delivered zero-copy from mapped PBOs.";
+
+        }
+
+    }
+
+}
+
+#endif // TOA_FRAME_BENDER_MAPPED_PBO_OUTPUT_STAGE_H
@@ -118,6 +118,11 @@ fb::StageCommand fb::PackTextureToPBOStage::perform(
     // Pass through timestamp 
     pbo_out_token.time_stamp = dst_tex_in_token.time_stamp;
 
+    // and the frame
+    pbo_out_token.trace_id = dst_tex_in_token.trace_id;
+
+    sampler_.enter_trace_id(dst_tex_in_token.trace_id);
+
     //short_sleep(microseconds(800));
 
     return answer;
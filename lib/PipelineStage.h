@@ -24,6 +24,8 @@
 
 #include "Stage.h"
 #include <string>
+#include <vector>
+#include <memory>
 
 namespace toa {
     namespace frame_bender {
@@ -35,8 +37,11 @@ namespace toa {
             virtual void execute() = 0;
             virtual PipelineStatus status() const = 0;
             virtual size_t input_queue_num_elements() const = 0;
+            virtual bool has_tokens_available() const = 0;
             virtual const std::string& name() const = 0;
             virtual size_t output_queue_size() const = 0;
+            virtual void set_wake_sampler(WakeSampleFunction sampler) = 0;
+            virtual std::vector<std::unique_ptr<FifoSampler>> sample_input_queues() = 0;
 
         };
 
@@ -214,6 +214,28 @@ fb::ProgramOptions::ProgramOptions(int argc, const char* argv[]) {
             ("input.sequence.loop_count",
             po::value<size_t>(&input_sequence_loop_count_)->default_value(10),
             "Number of times to replay the input sequence.")
+            ("input.sequence.reader",
+            po::value<fb::SequenceReader>(&input_sequence_reader_)->default_value(fb::SequenceReader::PREFETCH),
+            "How the input sequence is read: prefetch (everything is read "
+            "into memory up front), mmap (frames are memory-mapped on demand, "
+            "not on Windows), stream (a reader thread reads frames from "
+            "disk, for sequences that don't fit into memory) or container "
+            "(input.sequence.id names a file written by pack-sequence, "
+            "frames are memory-mapped from it, not on Windows) or compressed "
+            "(like prefetch, but frames are held compressed in memory and "
+            "decompressed ahead of the pipeline).")
+            ("input.sequence.read_ahead_count",
+            po::value<size_t>(&input_sequence_read_ahead_count_)->default_value(8),
+            "Number of frames the mmap, stream, container and compressed readers keep "
+            "ahead of the pipeline. At most 32.")
+            ("input.sequence.decode_thread_count",
+            po::value<size_t>(&input_sequence_decode_thread_count_)->default_value(2),
+            "Number of threads the compressed reader decompresses frames on. "
+            "0 uses one per hardware thread.")
+            ("input.sequence.direct_io_is_enabled",
+            po::value<bool>(&input_sequence_direct_io_is_enabled_)->default_value(true),
+            "If true, the stream reader bypasses the file cache (O_DIRECT, "
+            "Linux only), so that replays measure the disk.")
             ("input.sequence.image_origin",
             po::value<fb::ImageFormat::Origin>(&input_sequence_origin_)->default_value(fb::ImageFormat::Origin::UPPER_LEFT),
             "Image origin of the input sequence's frames.")
@@ -253,6 +275,11 @@ fb::ProgramOptions::ProgramOptions(int argc, const char* argv[]) {
             "Skip the first N frames for calculating the statistics summary. "
             "Use this value 'warmup' of the pipeline execution in order to "
             "retrieve more accurate statistics.")
+            ("profiling.statistics.percentiles",
+            po::value<std::vector<double>>(&statistics_percentiles_)->multitoken()->default_value(
+                std::vector<double>{ 50.0, 90.0, 99.0, 99.9, 99.99 }, "50 90 99 99.9 99.99"),
+            "The percentiles (in [0, 100]) reported for each statistic, "
+            "in addition to the median. Add one line per percentile.")
             ("debug.host_input_copy_is_enabled",
             po::value<bool>(&enable_host_copy_upload_)->default_value(true),
             "Enable/Disable host-side copy operation into mapped GPU memory "
@@ -295,6 +322,18 @@ fb::ProgramOptions::ProgramOptions(int argc, const char* argv[]) {
             ("render.format_conversion.v210.encode.chroma_filter_type",
             po::value<fb::ChromaFilter>(&v210_encode_glsl_chroma_filter_)->default_value(ChromaFilter::basic),
             "Sets the complexity of the filter for YCbCr 422 encoding (decimation filter).")
+            ("render.format_conversion.cpu.simd_level",
+            po::value<cpu::SimdLevel>(&cpu_format_conversion_simd_level_)->default_value(cpu::SimdLevel::avx2),
+            "Sets the highest instruction set the CPU format converter may use "
+            "(scalar, sse41 or avx2). Falls back to the best supported level "
+            "of the host CPU. Only effective if render.format_conversion_mode "
+            "is set to cpu_simd.")
+            ("render.format_conversion.cpu.num_threads",
+            po::value<size_t>(&cpu_format_conversion_num_threads_)->default_value(1),
+            "Sets the number of threads each CPU format converter uses, every "
+            "thread converts a horizontal stripe of the image. A value of 0 "
+            "uses one thread per hardware thread. Only effective if "
+            "render.format_conversion_mode is set to cpu_simd.")
             ("player.user_input_is_enabled",
             po::value<bool>(&enable_window_user_input_)->default_value(true),
             "Must be enabled in order to react to user input evenst (mouse/keyboard).")
@@ -310,6 +349,21 @@ fb::ProgramOptions::ProgramOptions(int argc, const char* argv[]) {
             ("write_output_swap_endianness_word_size",
             po::value<size_t>(&write_output_swap_endianness_word_size_)->default_value(2),
             "Sets the word size for any byte-swapping.")
+            ("output.layout",
+            po::value<fb::OutputLayout>(&write_output_layout_)->default_value(fb::OutputLayout::FILE_PER_FRAME),
+            "How output frames are written: files (one raw file per frame) or "
+            "single_file (all frames appended to one raw file, not on Windows).")
+            ("output.queue_size",
+            po::value<size_t>(&write_output_queue_size_)->default_value(8),
+            "Number of output frames that may be queued for the writer "
+            "threads before the pipeline has to wait for them.")
+            ("output.writer_thread_count",
+            po::value<size_t>(&write_output_writer_thread_count_)->default_value(1),
+            "Number of threads writing output frames to disk.")
+            ("output.preallocate_frame_count",
+            po::value<size_t>(&write_output_preallocate_frame_count_)->default_value(64),
+            "For the single_file layout, the output file is grown ahead of the "
+            "writers by this many frames (Linux only). 0 disables preallocation.")
             ("enable_linear_space_rendering",
             po::value<bool>(&enable_linear_space_rendering_)->default_value(true),
             "If enabled, rendering is performed in linear-space RGB. This "
@@ -337,6 +391,37 @@ fb::ProgramOptions::ProgramOptions(int argc, const char* argv[]) {
             ("pipeline.upload.unpack_to_format_converter_load_constraint_count",
             po::value<size_t>(&pipeline_upload_unpack_to_format_converter_load_constraint_count_)->default_value(0),
             "See above.")
+            ("pipeline.waiting_policy",
+            po::value<WaitingPolicy>(&pipeline_waiting_policy_)->default_value(WaitingPolicy::SPIN),
+            "Sets how pipeline stages wait for tokens: spin (yield in a loop, "
+            "lowest latency but keeps a core busy per thread), block (sleep "
+            "right away) or hybrid (spin for pipeline.hybrid_spin_time_us, then "
+            "sleep).")
+            ("pipeline.hybrid_spin_time_us",
+            po::value<size_t>(&pipeline_hybrid_spin_time_us_)->default_value(50),
+            "Time in microseconds a stage spins before it sleeps, if "
+            "pipeline.waiting_policy is set to hybrid.")
+            ("pipeline.frame_huge_pages",
+            po::value<HugePages>(&pipeline_frame_huge_pages_)->default_value(HugePages::OFF),
+            "Backs frame payloads with 2 MiB pages to reduce TLB misses when "
+            "copying frames: off, transparent (madvise, if THP is enabled) or "
+            "explicit (MAP_HUGETLB, requires reserved huge pages, falls back "
+            "to transparent).")
+            ("pipeline.host_worker_count",
+            po::value<size_t>(&pipeline_host_worker_count_)->default_value(0),
+            "If not zero, the host-side stages of the ASYNC_INPUT and "
+            "ASYNC_OUTPUT phases are run by a shared pool of this many "
+            "work-stealing threads instead of one dedicated thread per phase.")
+            ("pipeline.host_copy.kernel",
+            po::value<HostCopyKernel>(&pipeline_host_copy_kernel_)->default_value(HostCopyKernel::avx2_stream),
+            "Sets how the host copy stages copy frames from and to mapped "
+            "PBOs: memcpy, or with non-temporal stores (sse2_stream or "
+            "avx2_stream). Falls back to the best kernel supported by the host "
+            "CPU. Not effective if built with FB_USE_INTEL_IPP_FOR_HOST_COPY.")
+            ("pipeline.host_copy.num_threads",
+            po::value<size_t>(&pipeline_host_copy_num_threads_)->default_value(1),
+            "Sets the number of threads each host copy stage splits its copies "
+            "across. A value of 0 uses one thread per hardware thread.")
             ("profiling.trace_output_file",
             po::value<std::string>(&trace_output_file_)->default_value(""),
             "If profiling.stage_sampling_is_enabled is active, and if the "
@@ -350,6 +435,24 @@ fb::ProgramOptions::ProgramOptions(int argc, const char* argv[]) {
             po::value<std::string>(&profiling_trace_name_)->default_value(""),
             "The name of the tracing can optionally be overriden by this parameter. "
             "If not set, the name of the configuration file will be used instead.")
+            ("profiling.trace_streaming.is_enabled",
+            po::value<bool>(&trace_streaming_is_enabled_)->default_value(false),
+            "If enabled, all sampled events are continuously written to "
+            "profiling.trace_output_file while running, instead of only the "
+            "first 10000 events per stage and event type at the end. Use this "
+            "for long runs. The events are then not held in memory, so the "
+            "session statistics and the trace cut in the log are left out.")
+            ("profiling.trace_streaming.segment_count",
+            po::value<size_t>(&trace_streaming_segment_count_)->default_value(256),
+            "The number of segments (of 1024 events each) that the trace "
+            "stream allocates up front. Sampling waits for a segment if all of "
+            "them are waiting to be written.")
+            ("profiling.sample_clock",
+            po::value<SampleClockSource>(&profiling_sample_clock_)->default_value(SampleClockSource::steady),
+            "Where stage samples take their time stamps from, either 'steady' "
+            "(the OS' steady clock) or 'tsc' (the CPU's time stamp counter, "
+            "calibrated against the steady clock). The TSC is cheaper to read, "
+            "but requires an invariant TSC, otherwise steady is used.")
             ;
         
         // TODO: add any eventual validation methods for folders validation
@@ -433,6 +536,14 @@ fb::ProgramOptions::ProgramOptions(int argc, const char* argv[]) {
         po::store(po::parse_command_line(argc, argv, cmdline_options), vm);
         po::notify(vm);
 
+        for (double percentile : statistics_percentiles_) {
+            if (!(percentile >= 0.0 && percentile <= 100.0)) {
+                throw po::validation_error(
+                    po::validation_error::invalid_option_value, 
+                    "profiling.statistics.percentiles");
+            }
+        }
+
         std::ostringstream oss_config;
 
         for (const auto& entry : vm) {
@@ -456,8 +567,16 @@ fb::ProgramOptions::ProgramOptions(int argc, const char* argv[]) {
             const Time* const time_val = boost::any_cast<const Time>(value);
             const Mode * const fmt_conv_stage_mode_val = boost::any_cast<const Mode >(value);
             const ChromaFilter* const chroma_filter_val = boost::any_cast<const ChromaFilter>(value);
+            const cpu::SimdLevel* const simd_level_val = boost::any_cast<const cpu::SimdLevel>(value);
             const StreamDispatch::FlagContainer* const opt_flag_val = boost::any_cast<const StreamDispatch::FlagContainer>(value);
             const gl::Context::DebugSeverity* const gl_debug_sev_val = boost::any_cast<const gl::Context::DebugSeverity>(value);
+            const WaitingPolicy* const waiting_policy_val = boost::any_cast<const WaitingPolicy>(value);
+            const HugePages* const huge_pages_val = boost::any_cast<const HugePages>(value);
+            const HostCopyKernel* const host_copy_kernel_val = boost::any_cast<const HostCopyKernel>(value);
+            const SequenceReader* const sequence_reader_val = boost::any_cast<const SequenceReader>(value);
+            const OutputLayout* const output_layout_val = boost::any_cast<const OutputLayout>(value);
+            const SampleClockSource* const sample_clock_val = boost::any_cast<const SampleClockSource>(value);
+            const std::vector<double>* const double_vec_val = boost::any_cast<const std::vector<double>>(value);
 
             if (bool_val != nullptr) {
                 oss_config << std::boolalpha << *bool_val;
@@ -479,6 +598,8 @@ fb::ProgramOptions::ProgramOptions(int argc, const char* argv[]) {
                 oss_config << *fmt_conv_stage_mode_val;
             } else if (chroma_filter_val != nullptr) {
                 oss_config << *chroma_filter_val;
+            } else if (simd_level_val != nullptr) {
+                oss_config << *simd_level_val;
             } else if (opt_flag_val != nullptr) {
 
                 for (size_t i = 0; i<static_cast<size_t>(StreamDispatch::Flags::COUNT); ++i) {
@@ -494,6 +615,28 @@ fb::ProgramOptions::ProgramOptions(int argc, const char* argv[]) {
 
             } else if (gl_debug_sev_val != nullptr) {
                 oss_config << *gl_debug_sev_val;
+            } else if (waiting_policy_val != nullptr) {
+                oss_config << *waiting_policy_val;
+            } else if (huge_pages_val != nullptr) {
+                oss_config << *huge_pages_val;
+            } else if (host_copy_kernel_val != nullptr) {
+                oss_config << *host_copy_kernel_val;
+            } else if (sequence_reader_val != nullptr) {
+                oss_config << *sequence_reader_val;
+            } else if (output_layout_val != nullptr) {
+                oss_config << *output_layout_val;
+            } else if (sample_clock_val != nullptr) {
+                oss_config << *sample_clock_val;
+            } else if (double_vec_val != nullptr) {
+
+                for (size_t i = 0; i<double_vec_val->size(); ++i) {
+                    if (i != 0) {
+                        oss_config << "\n";
+                        oss_config << entry.first << "=";
+                    }
+                    oss_config << (*double_vec_val)[i];
+                }
+
             } else {
                 throw std::runtime_error("Missing a type in options print-out.");
             }
@@ -640,6 +783,22 @@ size_t fb::ProgramOptions::input_sequence_loop_count() const {
     return input_sequence_loop_count_;
 }
 
+fb::SequenceReader fb::ProgramOptions::input_sequence_reader() const {
+    return input_sequence_reader_;
+}
+
+size_t fb::ProgramOptions::input_sequence_read_ahead_count() const {
+    return input_sequence_read_ahead_count_;
+}
+
+bool fb::ProgramOptions::input_sequence_direct_io_is_enabled() const {
+    return input_sequence_direct_io_is_enabled_;
+}
+
+size_t fb::ProgramOptions::input_sequence_decode_thread_count() const {
+    return input_sequence_decode_thread_count_;
+}
+
 fb::ImageFormat::Origin fb::ProgramOptions::input_sequence_origin() const {
     return input_sequence_origin_;
 }
@@ -688,6 +847,10 @@ size_t fb::ProgramOptions::statistics_skip_first_num_frames() const {
     return statistics_skip_first_num_frames_;
 }
 
+const std::vector<double>& fb::ProgramOptions::statistics_percentiles() const {
+    return statistics_percentiles_;
+}
+
 bool fb::ProgramOptions::enable_host_copy_upload() const {
     return enable_host_copy_upload_;
 }
@@ -736,6 +899,14 @@ fb::ChromaFilter fb::ProgramOptions::v210_encode_glsl_chroma_filter() const {
     return v210_encode_glsl_chroma_filter_;
 }
 
+fb::cpu::SimdLevel fb::ProgramOptions::cpu_format_conversion_simd_level() const {
+    return cpu_format_conversion_simd_level_;
+}
+
+size_t fb::ProgramOptions::cpu_format_conversion_num_threads() const {
+    return cpu_format_conversion_num_threads_;
+}
+
 bool fb::ProgramOptions::enable_window_user_input() const {
     return enable_window_user_input_;
 }
@@ -759,6 +930,26 @@ size_t fb::ProgramOptions::write_output_swap_endianness_word_size() const
     return write_output_swap_endianness_word_size_;
 }
 
+fb::OutputLayout fb::ProgramOptions::write_output_layout() const
+{
+    return write_output_layout_;
+}
+
+size_t fb::ProgramOptions::write_output_queue_size() const
+{
+    return write_output_queue_size_;
+}
+
+size_t fb::ProgramOptions::write_output_writer_thread_count() const
+{
+    return write_output_writer_thread_count_;
+}
+
+size_t fb::ProgramOptions::write_output_preallocate_frame_count() const
+{
+    return write_output_preallocate_frame_count_;
+}
+
 bool fb::ProgramOptions::enable_linear_space_rendering() const
 {
     return enable_linear_space_rendering_;
@@ -794,6 +985,36 @@ size_t fb::ProgramOptions::pipeline_upload_unpack_to_format_converter_load_const
     return pipeline_upload_unpack_to_format_converter_load_constraint_count_;
 }
 
+fb::WaitingPolicy fb::ProgramOptions::pipeline_waiting_policy() const
+{
+    return pipeline_waiting_policy_;
+}
+
+size_t fb::ProgramOptions::pipeline_hybrid_spin_time_us() const
+{
+    return pipeline_hybrid_spin_time_us_;
+}
+
+size_t fb::ProgramOptions::pipeline_host_worker_count() const
+{
+    return pipeline_host_worker_count_;
+}
+
+fb::HugePages fb::ProgramOptions::pipeline_frame_huge_pages() const
+{
+    return pipeline_frame_huge_pages_;
+}
+
+fb::HostCopyKernel fb::ProgramOptions::pipeline_host_copy_kernel() const
+{
+    return pipeline_host_copy_kernel_;
+}
+
+size_t fb::ProgramOptions::pipeline_host_copy_num_threads() const
+{
+    return pipeline_host_copy_num_threads_;
+}
+
 const std::string& fb::ProgramOptions::trace_output_file() const
 {
 
@@ -831,3 +1052,24 @@ const std::string& fb::ProgramOptions::profiling_trace_name() const
     return profiling_trace_name_;
 
 }
+
+bool fb::ProgramOptions::trace_streaming_is_enabled() const
+{
+
+    return trace_streaming_is_enabled_;
+
+}
+
+size_t fb::ProgramOptions::trace_streaming_segment_count() const
+{
+
+    return trace_streaming_segment_count_;
+
+}
+
+fb::SampleClockSource fb::ProgramOptions::profiling_sample_clock() const
+{
+
+    return profiling_sample_clock_;
+
+}
@@ -24,14 +24,21 @@
 
 #include <string>
 #include <stdexcept>
+#include <vector>
 
 #include "Logging.h"
 #include "ImageFormat.h"
 #include "Quad.h"
 #include "FrameTime.h"
 #include "FormatOptions.h"
+#include "CpuFeatures.h"
 #include "StreamDispatch.h"
 #include "Context.h"
+#include "HugePages.h"
+#include "HostCopy.h"
+#include "StreamSource.h"
+#include "FrameWriter.h"
+#include "SampleClock.h"
 
 #ifndef _MSC_VER
 #define NOEXCEPT noexcept
@@ -106,6 +113,10 @@ namespace toa {
             const Time& input_sequence_frame_duration() const;
             ImageFormat::Transfer input_sequence_transfer() const;
             size_t input_sequence_loop_count() const;
+            SequenceReader input_sequence_reader() const;
+            size_t input_sequence_read_ahead_count() const;
+            bool input_sequence_direct_io_is_enabled() const;
+            size_t input_sequence_decode_thread_count() const;
             const std::string& textures_folder() const; 
 
             ImageFormat::PixelFormat render_pixel_format() const;
@@ -122,6 +133,7 @@ namespace toa {
             bool force_passthrough_renderer() const;
 
             size_t statistics_skip_first_num_frames() const;
+            const std::vector<double>& statistics_percentiles() const;
 
             bool enable_upload_gl_timer_queries() const;
             bool enable_render_gl_timer_queries() const;
@@ -138,6 +150,9 @@ namespace toa {
             ChromaFilter v210_decode_glsl_chroma_filter() const;
             ChromaFilter v210_encode_glsl_chroma_filter() const;
 
+            cpu::SimdLevel cpu_format_conversion_simd_level() const;
+            size_t cpu_format_conversion_num_threads() const;
+
             bool enable_window_user_input() const;
 
             const std::string& write_output_folder() const;
@@ -145,6 +160,10 @@ namespace toa {
 
             bool write_output_swap_endianness() const;
             size_t write_output_swap_endianness_word_size() const;
+            OutputLayout write_output_layout() const;
+            size_t write_output_queue_size() const;
+            size_t write_output_writer_thread_count() const;
+            size_t write_output_preallocate_frame_count() const;
             bool enable_linear_space_rendering() const;
 
             const StreamDispatch::FlagContainer& optimization_flags() const;
@@ -157,6 +176,13 @@ namespace toa {
             size_t pipeline_download_format_converter_to_pack_load_constraint_count() const;
             size_t pipeline_upload_unpack_to_format_converter_load_constraint_count() const;
 
+            WaitingPolicy pipeline_waiting_policy() const;
+            size_t pipeline_hybrid_spin_time_us() const;
+            size_t pipeline_host_worker_count() const;
+            HugePages pipeline_frame_huge_pages() const;
+            HostCopyKernel pipeline_host_copy_kernel() const;
+            size_t pipeline_host_copy_num_threads() const;
+
             const std::string& trace_output_file() const;
 
             const std::string& config_output_file() const;
@@ -164,6 +190,9 @@ namespace toa {
             void write_config_to_file(const std::string& file_path) const;
 
             const std::string& profiling_trace_name() const;
+            bool trace_streaming_is_enabled() const;
+            size_t trace_streaming_segment_count() const;
+            SampleClockSource profiling_sample_clock() const;
 
         private:
 
@@ -209,6 +238,10 @@ namespace toa {
             Time input_sequence_frame_duration_;
             bool sample_stages_;
             size_t input_sequence_loop_count_;
+            SequenceReader input_sequence_reader_;
+            size_t input_sequence_read_ahead_count_;
+            bool input_sequence_direct_io_is_enabled_;
+            size_t input_sequence_decode_thread_count_;
             bool enable_output_stages_;
             bool enable_input_stages_;
             bool enable_render_stages_;
@@ -216,6 +249,7 @@ namespace toa {
             bool enable_host_copy_upload_;
             bool enable_host_copy_download_;
             size_t statistics_skip_first_num_frames_;
+            std::vector<double> statistics_percentiles_;
             bool enable_upload_gl_timer_queries_;
             bool enable_render_gl_timer_queries_;
             bool enable_download_gl_timer_queries_;
@@ -228,6 +262,9 @@ namespace toa {
             ChromaFilter v210_decode_glsl_chroma_filter_;
             ChromaFilter v210_encode_glsl_chroma_filter_;
 
+            cpu::SimdLevel cpu_format_conversion_simd_level_;
+            size_t cpu_format_conversion_num_threads_;
+
             bool enable_window_user_input_;
 
             std::string write_output_folder_;
@@ -235,6 +272,10 @@ namespace toa {
 
             bool write_output_swap_endianness_;
             size_t write_output_swap_endianness_word_size_;
+            OutputLayout write_output_layout_;
+            size_t write_output_queue_size_;
+            size_t write_output_writer_thread_count_;
+            size_t write_output_preallocate_frame_count_;
 
             bool enable_linear_space_rendering_;
 
@@ -247,6 +288,13 @@ namespace toa {
             size_t pipeline_download_format_converter_to_pack_load_constraint_count_;
             size_t pipeline_upload_unpack_to_format_converter_load_constraint_count_;
 
+            WaitingPolicy pipeline_waiting_policy_;
+            size_t pipeline_hybrid_spin_time_us_;
+            size_t pipeline_host_worker_count_;
+            HugePages pipeline_frame_huge_pages_;
+            HostCopyKernel pipeline_host_copy_kernel_;
+            size_t pipeline_host_copy_num_threads_;
+
             std::string trace_output_file_;
 
             std::string config_output_file_contents_;
@@ -254,6 +302,10 @@ namespace toa {
             std::string config_output_file_;
 
             std::string profiling_trace_name_;
+
+            bool trace_streaming_is_enabled_;
+            size_t trace_streaming_segment_count_;
+            SampleClockSource profiling_sample_clock_;
         };
 
         class InvalidInput : public std::exception {
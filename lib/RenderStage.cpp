@@ -190,6 +190,11 @@ fb::StageCommand fb::RenderStage::perform(
     // pass through timestamp
     dst_tex_out_token.time_stamp = src_tex_in_token.time_stamp;
 
+    // and the frame
+    dst_tex_out_token.trace_id = src_tex_in_token.trace_id;
+
+    sampler_.enter_trace_id(src_tex_in_token.trace_id);
+
     // The format should be passthrough, conversion is either done before or 
     // after.
     dst_tex_out_token.format = src_tex_in_token.format;
@@ -0,0 +1,341 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "SampleClock.h"
+#include "CpuFeatures.h"
+#include "Logging.h"
+
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace fb = toa::frame_bender;
+
+namespace {
+
+    struct TscSample {
+        uint64_t tsc;
+        int64_t ns;
+    };
+
+    // Set by select() only
+    bool use_tsc = false;
+    bool use_rdtscp = false;
+    TscSample first_sample = { 0, 0 };
+
+    // The conversion parameters are read by all sampling threads without 
+    // locking, a sequence counter tells them whether they read a consistent
+    // set. Only one thread writes at a time, see calibration_is_running.
+    std::atomic<uint32_t> calibration_sequence(0);
+    std::atomic<uint64_t> base_tsc(0);
+    std::atomic<int64_t> base_ns(0);
+    std::atomic<double> ns_per_tick(0.0);
+
+    std::atomic<uint64_t> next_calibration_tsc(std::numeric_limits<uint64_t>::max());
+    std::atomic_flag calibration_is_running = ATOMIC_FLAG_INIT;
+
+    inline uint64_t read_tsc_raw() {
+
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        // RDTSCP waits for all previous instructions, i.e. the sample isn't
+        // taken before the work it is supposed to follow
+        if (use_rdtscp) {
+            unsigned int aux = 0;
+            return __rdtscp(&aux);
+        }
+
+        return __rdtsc();
+#else
+        return 0;
+#endif
+
+    }
+
+    // Brackets a clock reading with two TSC readings, and keeps the tightest
+    // bracket of a few, i.e. the one which most likely wasn't preempted.
+    TscSample take_sample() {
+
+        TscSample best = { 0, 0 };
+        uint64_t best_width = std::numeric_limits<uint64_t>::max();
+
+        for (int i = 0; i<5; ++i) {
+
+            uint64_t before = read_tsc_raw();
+            int64_t ns = fb::clock::now().time_since_epoch().count();
+            uint64_t after = read_tsc_raw();
+
+            if (after - before < best_width) {
+                best_width = after - before;
+                best.tsc = before + (after - before)/2;
+                best.ns = ns;
+            }
+
+        }
+
+        return best;
+
+    }
+
+    void store_calibration(uint64_t tsc, int64_t ns, double ns_per_tick_value, uint64_t period_ticks) {
+
+        uint32_t sequence = calibration_sequence.load(std::memory_order_relaxed);
+
+        calibration_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        base_tsc.store(tsc, std::memory_order_relaxed);
+        base_ns.store(ns, std::memory_order_relaxed);
+        ns_per_tick.store(ns_per_tick_value, std::memory_order_relaxed);
+
+        calibration_sequence.store(sequence + 2, std::memory_order_release);
+
+        next_calibration_tsc.store(tsc + period_ticks, std::memory_order_relaxed);
+
+    }
+
+    struct Calibration {
+        uint64_t base_tsc;
+        int64_t base_ns;
+        double ns_per_tick;
+    };
+
+    inline int64_t convert(const Calibration& c, uint64_t tsc) {
+
+        // Signed, the TSC might have been read before the last calibration
+        int64_t delta = static_cast<int64_t>(tsc - c.base_tsc);
+
+        return c.base_ns + static_cast<int64_t>(static_cast<double>(delta) * c.ns_per_tick);
+
+    }
+
+    // If read_tsc is set, the TSC is read while the loaded calibration is 
+    // current. Converting a TSC read earlier with a later calibration could
+    // move time backwards by a little, as consecutive calibrations only agree
+    // where the later one is based.
+    inline Calibration load_calibration(uint64_t* tsc) {
+
+        Calibration c;
+        uint32_t sequence = 0;
+
+        do {
+
+            sequence = calibration_sequence.load(std::memory_order_acquire);
+
+            c.base_tsc = base_tsc.load(std::memory_order_relaxed);
+            c.base_ns = base_ns.load(std::memory_order_relaxed);
+            c.ns_per_tick = ns_per_tick.load(std::memory_order_relaxed);
+
+            if (tsc != nullptr)
+                *tsc = read_tsc_raw();
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+        } while ((sequence & 1) != 0 || sequence != calibration_sequence.load(std::memory_order_relaxed));
+
+        return c;
+
+    }
+
+    uint64_t period_ticks(double ns_per_tick_value) {
+        return static_cast<uint64_t>(static_cast<double>(fb::sample_clock::kRecalibrationPeriodMs) * 1e6 / ns_per_tick_value);
+    }
+
+}
+
+fb::SampleClockSource fb::sample_clock::select(SampleClockSource requested) {
+
+    use_tsc = false;
+
+    if (requested != SampleClockSource::tsc)
+        return SampleClockSource::steady;
+
+    const cpu::Features& features = cpu::features();
+
+    if (!features.invariant_tsc) {
+        FB_LOG_WARNING << "CPU has no invariant TSC, sampling with the steady clock instead.";
+        return SampleClockSource::steady;
+    }
+
+    use_rdtscp = features.rdtscp;
+
+    first_sample = take_sample();
+    std::this_thread::sleep_for(std::chrono::milliseconds(kInitialCalibrationMs));
+    TscSample second_sample = take_sample();
+
+    double initial_ns_per_tick = 
+        static_cast<double>(second_sample.ns - first_sample.ns) / 
+        static_cast<double>(second_sample.tsc - first_sample.tsc);
+
+    store_calibration(
+        second_sample.tsc, 
+        second_sample.ns, 
+        initial_ns_per_tick, 
+        period_ticks(initial_ns_per_tick));
+
+    use_tsc = true;
+
+    FB_LOG_INFO 
+        << "Sampling with the TSC" << (use_rdtscp ? " (RDTSCP)" : "") 
+        << " at " << 1e3 / initial_ns_per_tick << " MHz.";
+
+    return SampleClockSource::tsc;
+
+}
+
+fb::SampleClockSource fb::sample_clock::selected() {
+
+    return use_tsc ? SampleClockSource::tsc : SampleClockSource::steady;
+
+}
+
+fb::clock::time_point fb::sample_clock::now() {
+
+    if (!use_tsc)
+        return clock::now();
+
+    uint64_t tsc = 0;
+    Calibration c = load_calibration(&tsc);
+
+    if (tsc >= next_calibration_tsc.load(std::memory_order_relaxed))
+        calibrate();
+
+    return clock::time_point(clock::duration(convert(c, tsc)));
+
+}
+
+uint64_t fb::sample_clock::read_tsc() {
+
+    return read_tsc_raw();
+
+}
+
+fb::clock::time_point fb::sample_clock::tsc_to_time(uint64_t tsc) {
+
+    return clock::time_point(clock::duration(convert(load_calibration(nullptr), tsc)));
+
+}
+
+void fb::sample_clock::calibrate() {
+
+    if (!use_tsc)
+        throw std::runtime_error("TSC is not selected as sample clock.");
+
+    // Somebody else is on it already
+    if (calibration_is_running.test_and_set(std::memory_order_acquire))
+        return;
+
+    TscSample sample = take_sample();
+
+    // The longer the interval, the more accurate the frequency
+    double long_term_ns_per_tick = 
+        static_cast<double>(sample.ns - first_sample.ns) / 
+        static_cast<double>(sample.tsc - first_sample.tsc);
+
+    uint64_t ticks = period_ticks(long_term_ns_per_tick);
+    int64_t period_ns = kRecalibrationPeriodMs * 1000000;
+
+    // Rather than stepping to where clock is, which could move time 
+    // backwards, we continue from where we are and slew towards clock over 
+    // the next period. Only large offsets are stepped. The new calibration 
+    // is based as late as possible, as samples converted until it is stored
+    // only agree with it up to there.
+    Calibration current = load_calibration(nullptr);
+
+    uint64_t base = read_tsc_raw();
+    int64_t continued_ns = convert(current, base);
+    int64_t clock_ns = sample.ns + static_cast<int64_t>(static_cast<double>(base - sample.tsc) * long_term_ns_per_tick);
+    int64_t offset_ns = continued_ns - clock_ns;
+
+    if (offset_ns > -period_ns/2 && offset_ns < period_ns/2) {
+
+        double slewed_ns_per_tick = 
+            static_cast<double>(period_ns - offset_ns) / static_cast<double>(ticks);
+
+        store_calibration(base, continued_ns, slewed_ns_per_tick, ticks);
+
+    } else {
+
+        FB_LOG_WARNING 
+            << "TSC was off by " << offset_ns << " ns from the steady clock, "
+            << "stepping it.";
+
+        store_calibration(base, clock_ns, long_term_ns_per_tick, ticks);
+
+    }
+
+    calibration_is_running.clear(std::memory_order_release);
+
+}
+
+double fb::sample_clock::tsc_ticks_per_second() {
+
+    if (!use_tsc)
+        return 0.0;
+
+    return 1e9 / ns_per_tick.load(std::memory_order_relaxed);
+
+}
+
+std::ostream& fb::operator<< (std::ostream& out, const SampleClockSource& v) {
+
+    switch (v) {
+    case SampleClockSource::steady:
+        out << "steady";
+        break;
+    case SampleClockSource::tsc:
+        out << "tsc";
+        break;
+    default:
+        out << "<unknown>";
+        break;
+    }
+
+    return out;
+
+}
+
+std::istream& fb::operator>>(std::istream& in, SampleClockSource& v) {
+
+    std::string token;
+    in >> token;
+
+    std::transform(token.begin(), token.end(),token.begin(), ::tolower);
+
+    if (token == "steady")
+        v = SampleClockSource::steady;
+    else if (token == "tsc")
+        v = SampleClockSource::tsc;
+    else {
+        in.setstate(std::ios::failbit);
+    }
+
+    return in;
+
+}
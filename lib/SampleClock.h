@@ -0,0 +1,86 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_SAMPLE_CLOCK_H
+#define TOA_FRAME_BENDER_SAMPLE_CLOCK_H
+
+#include <iosfwd>
+#include <cstdint>
+
+#include "ChronoUtils.h"
+
+namespace toa {
+    namespace frame_bender {
+
+        // Where StageSampler::sample() takes its time stamps from
+        enum class SampleClockSource : int32_t {
+            // clock::now(), i.e. the OS' steady clock
+            steady,
+            // The CPU's time stamp counter, calibrated against clock
+            tsc,
+            count
+        };
+
+        std::ostream& operator<< (std::ostream& out, const SampleClockSource& v);
+        std::istream& operator>>(std::istream& in, SampleClockSource& v);
+
+        // Time stamps for sampling. Reading the TSC is a lot cheaper than 
+        // going through the OS for every sample, which adds up with a 
+        // handful of samples per stage and frame. TSC readings are converted
+        // into the time domain of clock, so that they can be mixed freely 
+        // with clock::now() and GL times (see gl::SyncPoint).
+        //
+        // The TSC frequency is measured once on select(), and refit against
+        // clock from then on about every kRecalibrationPeriodMs (by whichever
+        // sampling thread comes across it first), over the whole duration 
+        // since select(). Refits never move time backwards.
+        namespace sample_clock {
+
+            static const int64_t kInitialCalibrationMs = 20;
+            static const int64_t kRecalibrationPeriodMs = 1000;
+
+            // Not thread-safe, call before sampling starts. Falls back to 
+            // steady if the CPU has no invariant TSC. Returns the source
+            // in use.
+            SampleClockSource select(SampleClockSource requested);
+
+            SampleClockSource selected();
+
+            // Comparable with clock::now(), thread-safe.
+            clock::time_point now();
+
+            // Only valid if the TSC was selected
+            uint64_t read_tsc();
+            clock::time_point tsc_to_time(uint64_t tsc);
+
+            // Refits the TSC against clock right away, also done 
+            // periodically by now(). Only valid if the TSC was selected.
+            void calibrate();
+
+            // As currently calibrated, zero if the TSC isn't used
+            double tsc_ticks_per_second();
+
+        }
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_SAMPLE_CLOCK_H
@@ -0,0 +1,396 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "SequenceContainer.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/filesystem.hpp>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace bf = boost::filesystem;
+namespace fb = toa::frame_bender;
+
+namespace {
+
+    const char kMagic[8] = { 'F', 'B', 'S', 'E', 'Q', 0, 0, 0 };
+
+    // Byte positions of the header fields
+    const size_t kVersionPos = 8;
+    const size_t kWidthPos = 16;
+    const size_t kHeightPos = 20;
+    const size_t kPixelFormatPos = 24;
+    const size_t kTransferPos = 28;
+    const size_t kChromaticityPos = 32;
+    const size_t kOriginPos = 36;
+    const size_t kDurationNumeratorPos = 40;
+    const size_t kDurationDenominatorPos = 48;
+    const size_t kNumFramesPos = 56;
+    const size_t kFrameByteSizePos = 64;
+    const size_t kPayloadAlignmentPos = 72;
+    const size_t kIndexOffsetPos = 80;
+
+    void put_u32(std::vector<uint8_t>& buf, size_t pos, uint32_t v) {
+        for (size_t i = 0; i<4; ++i)
+            buf[pos + i] = static_cast<uint8_t>(v >> (8*i));
+    }
+
+    void put_u64(std::vector<uint8_t>& buf, size_t pos, uint64_t v) {
+        for (size_t i = 0; i<8; ++i)
+            buf[pos + i] = static_cast<uint8_t>(v >> (8*i));
+    }
+
+    uint32_t get_u32(const std::vector<uint8_t>& buf, size_t pos) {
+        uint32_t v = 0;
+        for (size_t i = 0; i<4; ++i)
+            v |= static_cast<uint32_t>(buf[pos + i]) << (8*i);
+        return v;
+    }
+
+    uint64_t get_u64(const std::vector<uint8_t>& buf, size_t pos) {
+        uint64_t v = 0;
+        for (size_t i = 0; i<8; ++i)
+            v |= static_cast<uint64_t>(buf[pos + i]) << (8*i);
+        return v;
+    }
+
+    uint64_t padded_size(uint64_t byte_size) {
+        const uint64_t alignment = fb::sequence_container::kPayloadAlignment;
+        return (byte_size + alignment - 1) / alignment * alignment;
+    }
+
+    void invalid_container(const std::string& file_path, const std::string& reason) {
+        FB_LOG_ERROR << "'" << file_path << "' is not a valid sequence container: " << reason;
+        throw std::runtime_error("Invalid sequence container.");
+    }
+
+}
+
+fb::SequenceContainerWriter::SequenceContainerWriter(
+    const std::string& file_path,
+    const ImageFormat& image_format,
+    const Time& frame_duration) :
+        file_path_(file_path),
+        image_format_(image_format),
+        frame_duration_(frame_duration),
+        write_offset_(0),
+        is_finished_(false)
+{
+
+    if (image_format_.image_byte_size() == 0)
+        throw std::invalid_argument("Can't write a sequence with an empty image format.");
+
+    out_.open(file_path_, std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!out_.good()) {
+        FB_LOG_ERROR << "Can't open '" << file_path_ << "' for writing.";
+        throw std::runtime_error("Can't create sequence container.");
+    }
+
+    padding_.resize(
+        static_cast<size_t>(padded_size(image_format_.image_byte_size()) - image_format_.image_byte_size()), 
+        0);
+
+    // Zeroed placeholder, which is no valid header until finish() 
+    // overwrites it.
+    std::vector<uint8_t> header(sequence_container::kHeaderSize, 0);
+    out_.write(reinterpret_cast<const char*>(header.data()), header.size());
+    write_offset_ = header.size();
+
+}
+
+fb::SequenceContainerWriter::~SequenceContainerWriter() {
+
+    if (!is_finished_) {
+        try {
+            finish();
+        } catch (const std::exception& e) {
+            FB_LOG_ERROR << "Could not finish sequence container '" << file_path_ << "': " << e.what();
+        }
+    }
+
+}
+
+void fb::SequenceContainerWriter::add_frame(const uint8_t* data) {
+
+    if (is_finished_)
+        throw std::logic_error("Sequence container has already been finished.");
+
+    frame_offsets_.push_back(write_offset_);
+
+    out_.write(reinterpret_cast<const char*>(data), image_format_.image_byte_size());
+
+    if (!padding_.empty())
+        out_.write(reinterpret_cast<const char*>(padding_.data()), padding_.size());
+
+    if (!out_.good()) {
+        FB_LOG_ERROR << "Writing frame " << frame_offsets_.size() - 1 << " to '" << file_path_ << "' failed.";
+        throw std::runtime_error("Writing sequence container failed.");
+    }
+
+    write_offset_ += padded_size(image_format_.image_byte_size());
+
+}
+
+void fb::SequenceContainerWriter::finish() {
+
+    if (is_finished_)
+        return;
+
+    is_finished_ = true;
+
+    const uint64_t index_offset = write_offset_;
+
+    std::vector<uint8_t> index(frame_offsets_.size() * sizeof(uint64_t));
+    for (size_t i = 0; i<frame_offsets_.size(); ++i)
+        put_u64(index, i * sizeof(uint64_t), frame_offsets_[i]);
+
+    out_.write(reinterpret_cast<const char*>(index.data()), index.size());
+
+    std::vector<uint8_t> header(sequence_container::kHeaderSize, 0);
+    std::memcpy(header.data(), kMagic, sizeof(kMagic));
+    put_u32(header, kVersionPos, sequence_container::kVersion);
+    put_u32(header, kWidthPos, image_format_.width());
+    put_u32(header, kHeightPos, image_format_.height());
+    put_u32(header, kPixelFormatPos, static_cast<uint32_t>(image_format_.pixel_format()));
+    put_u32(header, kTransferPos, static_cast<uint32_t>(image_format_.transfer()));
+    put_u32(header, kChromaticityPos, static_cast<uint32_t>(image_format_.chromaticity()));
+    put_u32(header, kOriginPos, static_cast<uint32_t>(image_format_.origin()));
+    put_u64(header, kDurationNumeratorPos, static_cast<uint64_t>(frame_duration_.numerator()));
+    put_u64(header, kDurationDenominatorPos, static_cast<uint64_t>(frame_duration_.denominator()));
+    put_u64(header, kNumFramesPos, frame_offsets_.size());
+    put_u64(header, kFrameByteSizePos, image_format_.image_byte_size());
+    put_u64(header, kPayloadAlignmentPos, sequence_container::kPayloadAlignment);
+    put_u64(header, kIndexOffsetPos, index_offset);
+
+    out_.seekp(0, std::ios::beg);
+    out_.write(reinterpret_cast<const char*>(header.data()), header.size());
+    out_.close();
+
+    if (out_.fail()) {
+        FB_LOG_ERROR << "Writing the index of '" << file_path_ << "' failed.";
+        throw std::runtime_error("Writing sequence container failed.");
+    }
+
+}
+
+fb::SequenceContainerReader::SequenceContainerReader(const std::string& file_path) :
+    file_path_(file_path)
+#ifndef _WIN32
+    , fd_(-1)
+#endif
+{
+
+    if (!bf::is_regular_file(bf::path(file_path_)))
+        throw std::invalid_argument("Sequence container '" + file_path_ + "' does not exist.");
+
+    const uintmax_t file_size = bf::file_size(bf::path(file_path_));
+
+    if (file_size < sequence_container::kHeaderSize)
+        invalid_container(file_path_, "too small.");
+
+#ifdef _WIN32
+    in_.open(file_path_, std::ios::in | std::ios::binary);
+    if (!in_.good()) {
+        FB_LOG_ERROR << "Can't open '" << file_path_ << "'.";
+        throw std::runtime_error("Can't open sequence container.");
+    }
+#else
+    fd_ = ::open(file_path_.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        FB_LOG_ERROR << "Can't open '" << file_path_ << "': " << std::strerror(errno);
+        throw std::runtime_error("Can't open sequence container.");
+    }
+#endif
+
+    // From here on, the file must be closed again if we throw
+    try {
+
+        std::vector<uint8_t> header(sequence_container::kHeaderSize);
+
+        auto read_at = [&](uint64_t offset, uint8_t* data, size_t byte_size) {
+#ifdef _WIN32
+            in_.seekg(offset, std::ios::beg);
+            in_.read(reinterpret_cast<char*>(data), byte_size);
+            if (!in_.good())
+                invalid_container(file_path_, "truncated.");
+#else
+            size_t num_read = 0;
+            while (num_read < byte_size) {
+                ssize_t result = ::pread(fd_, data + num_read, byte_size - num_read, offset + num_read);
+                if (result < 0 && errno == EINTR)
+                    continue;
+                if (result <= 0)
+                    invalid_container(file_path_, "truncated.");
+                num_read += static_cast<size_t>(result);
+            }
+#endif
+        };
+
+        read_at(0, header.data(), header.size());
+
+        if (std::memcmp(header.data(), kMagic, sizeof(kMagic)) != 0)
+            invalid_container(file_path_, "missing signature (or it has not been finished).");
+
+        if (get_u32(header, kVersionPos) != sequence_container::kVersion)
+            invalid_container(file_path_, "unsupported version " + std::to_string(get_u32(header, kVersionPos)) + ".");
+
+        const uint32_t pixel_format = get_u32(header, kPixelFormatPos);
+        const uint32_t transfer = get_u32(header, kTransferPos);
+        const uint32_t chromaticity = get_u32(header, kChromaticityPos);
+        const uint32_t origin = get_u32(header, kOriginPos);
+
+        if (pixel_format >= static_cast<uint32_t>(ImageFormat::PixelFormat::INVALID) ||
+            transfer >= static_cast<uint32_t>(ImageFormat::Transfer::COUNT) ||
+            chromaticity > static_cast<uint32_t>(ImageFormat::Chromaticity::SRGB) ||
+            origin > static_cast<uint32_t>(ImageFormat::Origin::UPPER_LEFT))
+        {
+            invalid_container(file_path_, "invalid image format.");
+        }
+
+        image_format_ = ImageFormat(
+            get_u32(header, kWidthPos),
+            get_u32(header, kHeightPos),
+            static_cast<ImageFormat::Transfer>(transfer),
+            static_cast<ImageFormat::Chromaticity>(chromaticity),
+            static_cast<ImageFormat::PixelFormat>(pixel_format),
+            static_cast<ImageFormat::Origin>(origin));
+
+        const int64_t duration_denominator = static_cast<int64_t>(get_u64(header, kDurationDenominatorPos));
+
+        if (duration_denominator <= 0)
+            invalid_container(file_path_, "invalid frame duration.");
+
+        frame_duration_ = Time(
+            static_cast<int64_t>(get_u64(header, kDurationNumeratorPos)),
+            duration_denominator);
+
+        if (get_u64(header, kFrameByteSizePos) != image_format_.image_byte_size())
+            invalid_container(file_path_, "frame size doesn't match the image format.");
+
+        const uint64_t num_frames = get_u64(header, kNumFramesPos);
+        const uint64_t index_offset = get_u64(header, kIndexOffsetPos);
+
+        if (index_offset > file_size || num_frames > (file_size - index_offset) / sizeof(uint64_t))
+            invalid_container(file_path_, "index out of bounds.");
+
+        std::vector<uint8_t> index(static_cast<size_t>(num_frames * sizeof(uint64_t)));
+
+        if (!index.empty())
+            read_at(index_offset, index.data(), index.size());
+
+        frame_offsets_.resize(static_cast<size_t>(num_frames));
+
+        for (size_t i = 0; i<frame_offsets_.size(); ++i) {
+
+            frame_offsets_[i] = get_u64(index, i * sizeof(uint64_t));
+
+            if (frame_offsets_[i] % sequence_container::kPayloadAlignment != 0 ||
+                frame_offsets_[i] < sequence_container::kHeaderSize ||
+                frame_offsets_[i] + image_format_.image_byte_size() > index_offset) 
+            {
+                invalid_container(file_path_, "invalid offset of frame " + std::to_string(i) + ".");
+            }
+        }
+
+    } catch (...) {
+#ifndef _WIN32
+        ::close(fd_);
+#endif
+        throw;
+    }
+
+#ifndef _WIN32
+    // We mostly read front to back, so let the kernel read ahead further
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#endif
+
+}
+
+fb::SequenceContainerReader::~SequenceContainerReader() {
+
+#ifndef _WIN32
+    if (fd_ >= 0)
+        ::close(fd_);
+#endif
+
+}
+
+uint64_t fb::SequenceContainerReader::frame_offset(size_t frame_index) const {
+
+    if (frame_index >= frame_offsets_.size())
+        throw std::out_of_range("Frame index out of range.");
+
+    return frame_offsets_[frame_index];
+
+}
+
+void fb::SequenceContainerReader::read_frame(size_t frame_index, uint8_t* data) const {
+
+    const uint64_t offset = frame_offset(frame_index);
+    const size_t byte_size = image_format_.image_byte_size();
+
+#ifdef _WIN32
+
+    std::lock_guard<std::mutex> lock(in_lock_);
+
+    in_.seekg(offset, std::ios::beg);
+    in_.read(reinterpret_cast<char*>(data), byte_size);
+
+    if (!in_.good()) {
+        FB_LOG_ERROR << "Reading frame " << frame_index << " of '" << file_path_ << "' failed.";
+        throw std::runtime_error("Reading sequence container failed.");
+    }
+
+#else
+
+    size_t num_read = 0;
+
+    while (num_read < byte_size) {
+
+        ssize_t result = ::pread(fd_, data + num_read, byte_size - num_read, offset + num_read);
+
+        if (result < 0 && errno == EINTR)
+            continue;
+
+        if (result <= 0) {
+            FB_LOG_ERROR 
+                << "Reading frame " << frame_index << " of '" << file_path_ << "' failed" 
+                << (result < 0 ? ": " + std::string(std::strerror(errno)) : ".");
+            throw std::runtime_error("Reading sequence container failed.");
+        }
+
+        num_read += static_cast<size_t>(result);
+    }
+
+#endif
+
+}
@@ -0,0 +1,151 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_SEQUENCE_CONTAINER_H
+#define TOA_FRAME_BENDER_SEQUENCE_CONTAINER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <mutex>
+#include <cstdint>
+
+#include "Utils.h"
+#include "ImageFormat.h"
+#include "FrameTime.h"
+
+namespace toa {
+    namespace frame_bender {
+
+        // A whole image sequence packed into a single file, so that a 
+        // sequence can be opened without listing, matching and sorting 
+        // thousands of frame files, and read with large sequential I/O.
+        //
+        // Layout (all integers little-endian):
+        //
+        // | header (kHeaderSize bytes)                                     |
+        // | frame 0 payload, padded to a multiple of kPayloadAlignment    |
+        // | ...                                                           |
+        // | frame N-1 payload, padded                                     |
+        // | index: N x uint64 byte offsets of the payloads                |
+        //
+        // The header holds the ImageFormat, the frame duration, the number 
+        // of frames and the position of the index. Since every payload 
+        // starts at a page boundary, single frames can be memory-mapped or 
+        // read with O_DIRECT, and any frame is found in O(1) via the index.
+        namespace sequence_container {
+
+            const uint32_t kVersion = 1;
+            const size_t kHeaderSize = 4096;
+            const size_t kPayloadAlignment = 4096;
+
+            // File extension used by the pack-sequence tool
+            const char* const kFileExtension = ".fbseq";
+
+        }
+
+        // Writes a container front to back. The index and header are only 
+        // written by finish(), a container that hasn't been finished is 
+        // rejected by the reader.
+        class SequenceContainerWriter : utils::NoCopyingOrMoving {
+
+        public:
+
+            // Throws std::runtime_error if the file can't be created
+            SequenceContainerWriter(
+                const std::string& file_path,
+                const ImageFormat& image_format,
+                const Time& frame_duration);
+
+            // Finishes the container, if that hasn't been done yet
+            ~SequenceContainerWriter();
+
+            // Appends a frame of image_format().image_byte_size() bytes
+            void add_frame(const uint8_t* data);
+
+            void finish();
+
+            const ImageFormat& image_format() const { return image_format_; }
+            size_t num_frames() const { return frame_offsets_.size(); }
+
+        private:
+
+            std::string file_path_;
+            ImageFormat image_format_;
+            Time frame_duration_;
+            std::ofstream out_;
+            std::vector<uint64_t> frame_offsets_;
+            uint64_t write_offset_;
+            std::vector<uint8_t> padding_;
+            bool is_finished_;
+
+        };
+
+        // Reads the header and index of a container. Frames are accessed 
+        // by index in O(1), either by copying them or by mapping them.
+        class SequenceContainerReader : utils::NoCopyingOrMoving {
+
+        public:
+
+            // Throws std::runtime_error if the file can't be opened or isn't
+            // a (finished) container.
+            explicit SequenceContainerReader(const std::string& file_path);
+            ~SequenceContainerReader();
+
+            const std::string& file_path() const { return file_path_; }
+            const ImageFormat& image_format() const { return image_format_; }
+            const Time& frame_duration() const { return frame_duration_; }
+            size_t num_frames() const { return frame_offsets_.size(); }
+
+            // Byte offset of the frame's page-aligned payload in the file
+            uint64_t frame_offset(size_t frame_index) const;
+
+            // Copies the frame's payload into data, which must hold 
+            // image_format().image_byte_size() bytes. Thread-safe.
+            void read_frame(size_t frame_index, uint8_t* data) const;
+
+#ifndef _WIN32
+            // The open file, e.g. for mapping frames at frame_offset(). Valid
+            // as long as the reader exists.
+            int file_descriptor() const { return fd_; }
+#endif
+
+        private:
+
+            std::string file_path_;
+            ImageFormat image_format_;
+            Time frame_duration_;
+            std::vector<uint64_t> frame_offsets_;
+
+#ifdef _WIN32
+            mutable std::ifstream in_;
+            mutable std::mutex in_lock_;
+#else
+            int fd_;
+#endif
+
+        };
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_SEQUENCE_CONTAINER_H
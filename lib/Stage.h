@@ -30,6 +30,7 @@
 #include "Utils.h"
 #include "CircularFifo.h"
 #include "CircularFifoHelpers.h"
+#include "FifoSampler.h"
 #include "Logging.h"
 
 #ifndef _MSC_VER
@@ -71,14 +72,16 @@ namespace toa {
             typedef OutputElement TokenElementType;
             TokenElementType element;
             StageCommand command; // TODO-C++11: add class member initialization with a sensible value.
+            // Stamped when pushed into a sampled queue, see FifoSampler
+            clock::time_point enqueue_time;
 
             OutputToken() : command(StageCommand::NO_CHANGE) {}
             ~OutputToken() {}
-            OutputToken& operator=(const OutputToken& other) { this->element = other.element; this->command = other.command; return *this; }
+            OutputToken& operator=(const OutputToken& other) { this->element = other.element; this->command = other.command; this->enqueue_time = other.enqueue_time; return *this; }
 
-            OutputToken(const OutputToken& other) : element(other.element), command(other.command) { }
-            OutputToken& operator=(OutputToken&& other) { this->element = std::move(other.element); this->command = other.command; return *this; }
-            OutputToken(OutputToken&& other) : element(std::move(other.element)), command(other.command) {}
+            OutputToken(const OutputToken& other) : element(other.element), command(other.command), enqueue_time(other.enqueue_time) { }
+            OutputToken& operator=(OutputToken&& other) { this->element = std::move(other.element); this->command = other.command; this->enqueue_time = other.enqueue_time; return *this; }
+            OutputToken(OutputToken&& other) : element(std::move(other.element)), command(other.command), enqueue_time(other.enqueue_time) {}
 
         };
 
@@ -94,7 +97,9 @@ namespace toa {
                 std::weak_ptr<typename InputStageType::OutputFifoType>& input_fifo_downstream);
         }
 
-        static const WaitingPolicy kDefaultWaitingPolicy = WaitingPolicy::SPIN;
+        // Whether HYBRID fifos spin, park or both is chosen at runtime via 
+        // default_wait_settings().
+        static const WaitingPolicy kDefaultWaitingPolicy = WaitingPolicy::HYBRID;
 
         // Might have to get more in the future
         // TODO: make note that EXECUTE_BEGIN/EXECUTE_END is also sampled for
@@ -150,6 +155,42 @@ namespace toa {
 
         typedef std::function<void(StageExecutionState)> SampleFunction;
 
+        // Use as the sampler type of a Stage to compile sampling away.
+        struct NoSampling {
+            void operator()(StageExecutionState) const {}
+        };
+
+        namespace detail {
+
+            template <typename Sampler>
+            inline void sample(Sampler& sampler, StageExecutionState state) {
+                sampler(state);
+            }
+
+            inline void sample(SampleFunction& sampler, StageExecutionState state) {
+                if (sampler)
+                    sampler(state);
+            }
+
+            inline void sample(NoSampling&, StageExecutionState) {}
+
+            // Adapt the single-argument tasks of producers and consumers
+            template <typename OutputElement, typename Task>
+            struct ProducerTask {
+                Task task;
+                explicit ProducerTask(Task task) : task(std::move(task)) {}
+                StageCommand operator()(NO_INPUT&, OutputElement& out) { return task(out); }
+            };
+
+            template <typename InputElement, typename Task>
+            struct ConsumerTask {
+                Task task;
+                explicit ConsumerTask(Task task) : task(std::move(task)) {}
+                StageCommand operator()(InputElement& in, NO_OUTPUT&) { return task(in); }
+            };
+
+        }
+
         // TODO: make sure that you forbid circles or multiple connections...
         //      do this by find a friend way, and setting a flag in the constructor/destructor 
         // TODO: document that void* is forbidden as a type
@@ -161,7 +202,16 @@ namespace toa {
         // TODO: document that the token that contains STOP_EXECUTION is not considered anymore.
         // TODO: Make the waiting police an additional template argument?
         // TODO: add generically collected performance data?
-        template <typename InputElement, typename OutputElement>
+        //
+        // Task and Sampler can be any callables, the defaults are the type-
+        // erased std::function versions. Stages that are created with the 
+        // utils::make_*_stage() factories use the concrete types instead, 
+        // which lets the compiler inline the task and drop NoSampling calls.
+        template <
+            typename InputElement, 
+            typename OutputElement,
+            typename TaskType = std::function<StageCommand(InputElement&, OutputElement&)>,
+            typename SamplerType = SampleFunction>
         class Stage {
 
         public:
@@ -183,7 +233,8 @@ namespace toa {
             // TODO: docuent that this will not be executed when cancel token has been encountered. 
             // TODO: consider installing a cancel callback lambda
             // TODO: create a helper function where you could use auto... 
-            typedef std::function<StageCommand(InputType&, OutputType&)> Task;
+            typedef TaskType Task;
+            typedef SamplerType Sampler;
 
             // TODO: the queue feeder should take care of setting the current state...
 
@@ -194,16 +245,21 @@ namespace toa {
             //      -> add upstream to it?
             // TODO: could think about being fail safe in the sense that the destructor
             // send a last HAS_BEEN_KILLED token into one of the queues... 
-            template <typename InputInputType>
+            // InputStageType must be a Stage with InputType as its output
+            template <typename InputStageType>
             Stage(
                 std::string name,
                 Task task, 
                 std::vector<OutputType> output_queue_initialization,
-                const Stage<InputInputType, InputType>& input_stage,
-                SampleFunction sampler = SampleFunction()
+                const InputStageType& input_stage,
+                Sampler sampler = Sampler()
                 );
 
-            Stage() : is_valid_(false) {}
+            Stage() : 
+                input_downstream_(nullptr), 
+                input_upstream_(nullptr), 
+                status_(PipelineStatus::INITIALIZING),
+                is_valid_(false) {}
 
             // TODO: how should execute behave if state is not ready to run?
             void execute();
@@ -211,8 +267,8 @@ namespace toa {
             // TODO: document as thread-safe
             PipelineStatus status() const { return status_.load(); }
 
-            Stage<InputElement, OutputElement>& operator=(Stage<InputElement, OutputElement>&& other);
-            Stage<InputElement, OutputElement>(Stage<InputElement, OutputElement>&& other);
+            Stage& operator=(Stage&& other);
+            Stage(Stage&& other);
 
             const std::string& name() const { return name_; }
 
@@ -225,7 +281,15 @@ namespace toa {
                 std::weak_ptr<typename InputStageType::OutputFifoType>& input_fifo_upstream,
                 std::weak_ptr<typename InputStageType::OutputFifoType>& input_fifo_downstream);
 
-            size_t input_queue_num_elements() const { if (input_downstream_.lock()) { return input_downstream_.lock()->had_num_elements(); } return 0; }
+            size_t input_queue_num_elements() const { if (input_downstream_ != nullptr) { return input_downstream_->had_num_elements(); } return 0; }
+
+            // True if both an input and an output token are queued, i.e. 
+            // execute() won't have to wait for either of them. Only reliable
+            // on the thread that executes this stage.
+            bool has_tokens_available() const {
+                return (input_downstream_ == nullptr || input_downstream_->had_num_elements() != 0) &&
+                    (!output_upstream_ || output_upstream_->had_num_elements() != 0);
+            }
 
             size_t output_queue_size() const { if (output_downstream_) { return output_downstream_->size(); } return 0;}
 
@@ -233,15 +297,36 @@ namespace toa {
 
             void flush(FlushTask task);
 
+            // Reports how long it took this stage to resume after it was 
+            // woken up from waiting for an input or output token. Must be 
+            // set before the pipeline runs.
+            void set_wake_sampler(WakeSampleFunction sampler);
+
+            // Samples both queues between the input stage and this stage, 
+            // i.e. the one that tokens are passed on through and the one 
+            // they are returned through. Returns no samplers for producers.
+            // Must be called before the pipeline runs, the samplers must 
+            // outlive it.
+            std::vector<std::unique_ptr<FifoSampler>> sample_input_queues();
+
         private:
 
-            Stage<InputElement, OutputElement>& operator=(const Stage<InputElement, OutputElement>&);
-            Stage<InputElement, OutputElement>(const Stage<InputElement, OutputElement>&);
+            Stage& operator=(const Stage&);
+            Stage(const Stage&);
+
+            // The input stage owns the input fifos and must outlive this
+            // stage. The weak pointers are only used to check this in debug
+            // builds, the raw ones are used per token to avoid locking.
+            void assert_input_fifos_alive() const;
 
             std::string name_;
+            std::string input_stage_name_;
 
-            std::weak_ptr<InputFifoType> input_downstream_;
-            std::weak_ptr<InputFifoType> input_upstream_;
+            InputFifoType* input_downstream_;
+            InputFifoType* input_upstream_;
+
+            std::weak_ptr<InputFifoType> input_downstream_owner_;
+            std::weak_ptr<InputFifoType> input_upstream_owner_;
 
             std::shared_ptr<OutputFifoType> output_downstream_;
             std::shared_ptr<OutputFifoType> output_upstream_;
@@ -252,7 +337,7 @@ namespace toa {
 
             bool is_valid_;
 
-            SampleFunction sampler_;
+            Sampler sampler_;
         };
 
         namespace utils {
@@ -284,6 +369,34 @@ namespace toa {
                     const InputStage& input_stage,
                     SampleFunction sampler = SampleFunction());
 
+            // Same as above, but keeping the concrete task and sampler types.
+            // Pass NoSampling() as the sampler to disable sampling.
+
+            template <typename OutputElement, typename Task, typename Sampler>
+            Stage<NO_INPUT, OutputElement, detail::ProducerTask<OutputElement, Task>, Sampler>
+                make_producer_stage(
+                    std::string name,
+                    Task task,
+                    std::vector<OutputElement> output_queue_initialization,
+                    Sampler sampler);
+
+            template <typename OutputElement, typename InputStage, typename Task, typename Sampler>
+            Stage<typename InputStage::OutputType, OutputElement, Task, Sampler>
+                make_stage(
+                    std::string name,
+                    Task task,
+                    std::vector<OutputElement> output_queue_initialization,
+                    const InputStage& input_stage,
+                    Sampler sampler);
+
+            template <typename InputStage, typename Task, typename Sampler>
+            Stage<typename InputStage::OutputType, NO_OUTPUT, detail::ConsumerTask<typename InputStage::OutputType, Task>, Sampler>
+                make_consumer_stage(
+                    std::string name,
+                    Task task,
+                    const InputStage& input_stage,
+                    Sampler sampler);
+
 
         }
 
@@ -106,6 +106,14 @@ namespace toa {
             {
             }
 
+            template <>
+			STATIC_TSPL void initialize_output_fifos<WaitingCircularFifo<OutputTokenNoOutput, WaitingPolicy::HYBRID>>(
+                std::vector<NO_OUTPUT>,
+                std::shared_ptr<WaitingCircularFifo<OutputTokenNoOutput, WaitingPolicy::HYBRID>>&,
+                std::shared_ptr<WaitingCircularFifo<OutputTokenNoOutput, WaitingPolicy::HYBRID>>&) 
+            {
+            }
+
             template <typename InputStageType>
             static void initialize_input_fifos_references(
                 const InputStageType& input_stage,
@@ -126,19 +134,19 @@ namespace toa {
 
             template <typename InputFifoType>
             static bool get_token_from_input(
-                const std::weak_ptr<InputFifoType>& input_fifo, 
+                InputFifoType* input_fifo, 
                 typename InputFifoType::ElementType& token)
             {
 
                 static_assert(!std::is_same<InputFifoType, NO_INPUT_STAGE::InputFifoType>::value, "Sanity check failed.");
-                FB_ASSERT(!input_fifo.expired());
-                return input_fifo.lock()->pop(token);
+                FB_ASSERT(input_fifo != nullptr);
+                return input_fifo->pop(token);
 
             }
 
             template <>
 			STATIC_TSPL bool get_token_from_input<NO_INPUT_STAGE::InputFifoType>(
-                const std::weak_ptr<NO_INPUT_STAGE::InputFifoType>&, 
+                NO_INPUT_STAGE::InputFifoType*, 
                 typename NO_INPUT_STAGE::InputFifoType::ElementType& token)
             {
                 return true;
@@ -177,28 +185,35 @@ namespace toa {
                 return true;
             }
 
+            template <>
+			STATIC_TSPL bool get_token_from_output<WaitingCircularFifo<OutputTokenNoOutput, WaitingPolicy::HYBRID>>(
+                const std::shared_ptr<WaitingCircularFifo<OutputTokenNoOutput, WaitingPolicy::HYBRID>>&,
+                typename WaitingCircularFifo<OutputTokenNoOutput, WaitingPolicy::HYBRID>::ElementType&,
+                bool wait_for_element)
+            {
+                return true;
+            }
+
             // TODO: use rvalues or perfect forwarding for tokens?
 
             template <typename InputFifoType>
             static bool put_token_to_input_upstream(
-                const std::weak_ptr<InputFifoType>& input_fifo, 
+                InputFifoType* input_fifo, 
                 typename InputFifoType::ElementType token)
             {
                 static_assert(
                     !std::is_same<InputFifoType, NO_INPUT_STAGE::OutputFifoType>::value, 
                     "Compilation logic error: Should not have reached this.");
 
-                auto fifo = input_fifo.lock();
-
                 FB_ASSERT_MESSAGE(
-                    static_cast<bool>(fifo),
+                    input_fifo != nullptr,
                     "Crticial memory management issue: input-upstream fifo is gone.");
-                return fifo->push(std::move(token));
+                return input_fifo->push(std::move(token));
             }
 
             template <>
 			STATIC_TSPL bool put_token_to_input_upstream<NO_INPUT_STAGE::OutputFifoType>(
-                const std::weak_ptr<NO_INPUT_STAGE::OutputFifoType>& input_fifo, 
+                NO_INPUT_STAGE::OutputFifoType*, 
                 typename NO_INPUT_STAGE::OutputFifoType::ElementType token)
             {
                 return true;
@@ -236,22 +251,69 @@ namespace toa {
 
                 return true;
             }
+
+            template <>
+			STATIC_TSPL bool put_token_to_output_downstream<WaitingCircularFifo<OutputTokenNoOutput, WaitingPolicy::HYBRID>>(
+                const std::shared_ptr<WaitingCircularFifo<OutputTokenNoOutput, WaitingPolicy::HYBRID>>& , 
+                typename WaitingCircularFifo<OutputTokenNoOutput, WaitingPolicy::HYBRID>::ElementType )
+            {
+
+                return true;
+            }
+
+            // Queue sampling, see FifoSampler. Fifos are null where a stage
+            // has no input or output.
+
+            template <typename FifoType>
+            static inline void stamp_token(
+                const FifoType* fifo, 
+                typename FifoType::ElementType& token)
+            {
+                if (fifo != nullptr && fifo->sampler() != nullptr)
+                    token.enqueue_time = FifoSampler::now();
+            }
+
+            // After pushing a token that was stamped with stamp_token()
+            template <typename FifoType>
+            static inline void sample_push(
+                const FifoType* fifo, 
+                const clock::time_point& enqueue_time)
+            {
+                if (fifo != nullptr && fifo->sampler() != nullptr)
+                    fifo->sampler()->enter_push(enqueue_time, fifo->had_num_elements());
+            }
+
+            template <typename FifoType>
+            static inline void sample_pop(
+                const FifoType* fifo, 
+                const typename FifoType::ElementType& token)
+            {
+                if (fifo != nullptr && fifo->sampler() != nullptr)
+                    fifo->sampler()->enter_pop(FifoSampler::now(), fifo->had_num_elements(), token.enqueue_time);
+            }
         }
 
-        template <typename InputElement, typename OutputElement>
-        template <typename InputInputType>
-        Stage<InputElement, OutputElement>::Stage(
+        template <typename InputElement, typename OutputElement, typename TaskType, typename SamplerType>
+        template <typename InputStageType>
+        Stage<InputElement, OutputElement, TaskType, SamplerType>::Stage(
             std::string name,
             Task task, 
             std::vector<OutputElement> output_queue_initialization,
-            const Stage<InputInputType, InputElement>& input_stage,
-            SampleFunction sampler) :
+            const InputStageType& input_stage,
+            Sampler sampler) :
                 name_(std::move(name)),
+                input_stage_name_(input_stage.name()),
+                input_downstream_(nullptr),
+                input_upstream_(nullptr),
                 task_(std::move(task)),
                 status_(PipelineStatus::INITIALIZING),
                 is_valid_(true),
                 sampler_(std::move(sampler))
         {
+            static_assert(
+                std::is_same<typename InputStageType::OutputType, InputElement>::value,
+                "The input stage's output type must match this stage's input type.");
+
             // Initialize output queues
 
             detail::initialize_output_fifos(
@@ -261,10 +323,13 @@ namespace toa {
 
             detail::initialize_input_fifos_references(
                 input_stage,
-                input_upstream_,
-                input_downstream_
+                input_upstream_owner_,
+                input_downstream_owner_
                 );
 
+            input_upstream_ = input_upstream_owner_.lock().get();
+            input_downstream_ = input_downstream_owner_.lock().get();
+
             status_.store(PipelineStatus::READY_TO_EXECUTE);
 
             detail::log_stage_construction<InputElement>(input_stage.name(), name_);
@@ -275,8 +340,8 @@ namespace toa {
                 FB_LOG_DEBUG << "Stage '" << name_ << "' is a consumer (no output).";
             }
 
-            if (input_downstream_.lock()) {
-                FB_LOG_DEBUG << "Stage '" << name_ << "': input-queue-size (referenced): " << input_downstream_.lock()->size() << ".";
+            if (input_downstream_ != nullptr) {
+                FB_LOG_DEBUG << "Stage '" << name_ << "': input-queue-size (referenced): " << input_downstream_->size() << ".";
             }
 
             if (!is_consumer) {
@@ -285,12 +350,15 @@ namespace toa {
 
         }
 
-        template <typename InputElement, typename OutputElement>
-        Stage<InputElement, OutputElement>::Stage(
-            Stage<InputElement, OutputElement>&& other) : 
+        template <typename InputElement, typename OutputElement, typename TaskType, typename SamplerType>
+        Stage<InputElement, OutputElement, TaskType, SamplerType>::Stage(
+            Stage&& other) : 
                 name_(std::move(other.name_)),
-                input_downstream_(std::move(other.input_downstream_)),
-                input_upstream_(std::move(other.input_upstream_)),
+                input_stage_name_(std::move(other.input_stage_name_)),
+                input_downstream_(other.input_downstream_),
+                input_upstream_(other.input_upstream_),
+                input_downstream_owner_(std::move(other.input_downstream_owner_)),
+                input_upstream_owner_(std::move(other.input_upstream_owner_)),
                 output_downstream_(std::move(other.output_downstream_)),
                 output_upstream_(std::move(other.output_upstream_)),
                 task_(std::move(other.task_)),
@@ -300,13 +368,16 @@ namespace toa {
         {
         }
 
-        template <typename InputElement, typename OutputElement>
-        Stage<InputElement, OutputElement>& Stage<InputElement, OutputElement>::operator=(
-            Stage<InputElement, OutputElement>&& other)
+        template <typename InputElement, typename OutputElement, typename TaskType, typename SamplerType>
+        Stage<InputElement, OutputElement, TaskType, SamplerType>& Stage<InputElement, OutputElement, TaskType, SamplerType>::operator=(
+            Stage&& other)
         {
             name_ = std::move(other.name_);
-            input_downstream_ = std::move(other.input_downstream_);
-            input_upstream_ = std::move(other.input_upstream_);
+            input_stage_name_ = std::move(other.input_stage_name_);
+            input_downstream_ = other.input_downstream_;
+            input_upstream_ = other.input_upstream_;
+            input_downstream_owner_ = std::move(other.input_downstream_owner_);
+            input_upstream_owner_ = std::move(other.input_upstream_owner_);
             output_downstream_ = std::move(other.output_downstream_);
             output_upstream_ = std::move(other.output_upstream_);
             task_ = std::move(other.task_);
@@ -316,8 +387,20 @@ namespace toa {
             return *this;
         }
 
-        template <typename InputElement, typename OutputElement>
-        void Stage<InputElement, OutputElement>::execute() {
+        template <typename InputElement, typename OutputElement, typename TaskType, typename SamplerType>
+        void Stage<InputElement, OutputElement, TaskType, SamplerType>::assert_input_fifos_alive() const {
+
+            // Producers don't have any input fifos
+            FB_ASSERT_MESSAGE(
+                (input_downstream_ == nullptr || !input_downstream_owner_.expired()),
+                "Input stage was destroyed before this stage.");
+            FB_ASSERT_MESSAGE(
+                (input_upstream_ == nullptr || !input_upstream_owner_.expired()),
+                "Input stage was destroyed before this stage.");
+        }
+
+        template <typename InputElement, typename OutputElement, typename TaskType, typename SamplerType>
+        void Stage<InputElement, OutputElement, TaskType, SamplerType>::execute() {
 
             if (!is_valid_) {
                 FB_LOG_ERROR 
@@ -334,8 +417,9 @@ namespace toa {
                 throw std::runtime_error("Stage not ready to be executed.");
             }
 
-            if (sampler_)
-                sampler_(StageExecutionState::EXECUTE_BEGIN);
+            detail::sample(sampler_, StageExecutionState::EXECUTE_BEGIN);
+
+            assert_input_fifos_alive();
 
             // Get input token from input downstream
             // Note that we usually assume that this will wait/block when
@@ -351,8 +435,9 @@ namespace toa {
 
             FB_ASSERT(token_available);
 
-            if (sampler_)
-                sampler_(StageExecutionState::INPUT_TOKEN_AVAILABLE);
+            detail::sample_pop(input_downstream_, token_input);
+
+            detail::sample(sampler_, StageExecutionState::INPUT_TOKEN_AVAILABLE);
 
             // Get available output token from output upstream
             // Note that for Stages with NO_OUTPUT, this is specialzied to
@@ -365,8 +450,9 @@ namespace toa {
 
             FB_ASSERT(token_available);
 
-            if (sampler_)
-                sampler_(StageExecutionState::OUTPUT_TOKEN_AVAILABLE);
+            detail::sample_pop(output_upstream_.get(), token_output);
+
+            detail::sample(sampler_, StageExecutionState::OUTPUT_TOKEN_AVAILABLE);
 
             // if input token says we are stopped, exit
             if (token_input.command == StageCommand::STOP_EXECUTION) {
@@ -395,16 +481,14 @@ namespace toa {
 
             if (status_ == PipelineStatus::READY_TO_EXECUTE) {
                 
-                if (sampler_)
-                    sampler_(StageExecutionState::TASK_BEGIN);
+                detail::sample(sampler_, StageExecutionState::TASK_BEGIN);
 
                 // call task with both
                 StageCommand command_from_task = task_(
                     token_input.element, 
                     token_output.element);
 
-                if (sampler_)
-                    sampler_(StageExecutionState::TASK_END);
+                detail::sample(sampler_, StageExecutionState::TASK_END);
 
                 // TODO: think if you need BOTH directions (see above
                 // distribution of commands)
@@ -423,25 +507,34 @@ namespace toa {
             }
 
             // Put input token back to input upstream
+            detail::stamp_token(input_upstream_, token_input);
+            const clock::time_point input_enqueue_time = token_input.enqueue_time;
+
             bool put_success = detail::put_token_to_input_upstream<InputFifoType>(
                 input_upstream_, 
                 std::move(token_input));
 
             FB_ASSERT(put_success);
 
+            detail::sample_push(input_upstream_, input_enqueue_time);
+
             // Put output token to output downstream
+            detail::stamp_token(output_downstream_.get(), token_output);
+            const clock::time_point output_enqueue_time = token_output.enqueue_time;
+
             put_success = detail::put_token_to_output_downstream<OutputFifoType>(
                 output_downstream_,
                 std::move(token_output));
 
             FB_ASSERT(put_success);
 
-            if (sampler_)
-                sampler_(StageExecutionState::EXECUTE_END);
+            detail::sample_push(output_downstream_.get(), output_enqueue_time);
+
+            detail::sample(sampler_, StageExecutionState::EXECUTE_END);
         }
 
-        template <typename InputElement, typename OutputElement>
-        void Stage<InputElement, OutputElement>::flush(FlushTask flush_task) {
+        template <typename InputElement, typename OutputElement, typename TaskType, typename SamplerType>
+        void Stage<InputElement, OutputElement, TaskType, SamplerType>::flush(FlushTask flush_task) {
 
             if (!is_valid_) {
                 FB_LOG_ERROR 
@@ -478,6 +571,42 @@ namespace toa {
             }
         }
 
+        template <typename InputElement, typename OutputElement, typename TaskType, typename SamplerType>
+        void Stage<InputElement, OutputElement, TaskType, SamplerType>::set_wake_sampler(WakeSampleFunction sampler) {
+
+            // This stage is the consumer of both its input downstream and 
+            // its output upstream queue.
+            if (input_downstream_ != nullptr)
+                input_downstream_->set_wake_sampler(sampler);
+
+            if (output_upstream_)
+                output_upstream_->set_wake_sampler(sampler);
+        }
+
+        template <typename InputElement, typename OutputElement, typename TaskType, typename SamplerType>
+        std::vector<std::unique_ptr<FifoSampler>> Stage<InputElement, OutputElement, TaskType, SamplerType>::sample_input_queues() {
+
+            std::vector<std::unique_ptr<FifoSampler>> samplers;
+
+            if (input_downstream_ == nullptr)
+                return samplers;
+
+            FB_ASSERT(input_upstream_ != nullptr);
+
+            samplers.push_back(utils::make_unique<FifoSampler>(
+                input_stage_name_ + " -> " + name_, 
+                input_downstream_->size()));
+
+            samplers.push_back(utils::make_unique<FifoSampler>(
+                name_ + " -> " + input_stage_name_ + " (return)", 
+                input_upstream_->size()));
+
+            input_downstream_->set_sampler(samplers[0].get());
+            input_upstream_->set_sampler(samplers[1].get());
+
+            return samplers;
+        }
+
         namespace utils {
 
             // Convenience factory methods
@@ -553,6 +682,65 @@ namespace toa {
                 return new_stage;
             }
 
+            template <typename OutputElement, typename Task, typename Sampler>
+            Stage<NO_INPUT, OutputElement, detail::ProducerTask<OutputElement, Task>, Sampler>
+                make_producer_stage(
+                    std::string name,
+                    Task task,
+                    std::vector<OutputElement> output_queue_initialization,
+                    Sampler sampler)
+            {
+                typedef detail::ProducerTask<OutputElement, Task> WrappedTask;
+
+                Stage<NO_INPUT, OutputElement, WrappedTask, Sampler> new_stage(
+                    std::move(name),
+                    WrappedTask(std::move(task)),
+                    std::move(output_queue_initialization),
+                    NO_INPUT_STAGE::get(),
+                    std::move(sampler));
+
+                return new_stage;
+            }
+
+            template <typename OutputElement, typename InputStage, typename Task, typename Sampler>
+            Stage<typename InputStage::OutputType, OutputElement, Task, Sampler>
+                make_stage(
+                    std::string name,
+                    Task task,
+                    std::vector<OutputElement> output_queue_initialization,
+                    const InputStage& input_stage,
+                    Sampler sampler)
+            {
+                Stage<typename InputStage::OutputType, OutputElement, Task, Sampler> new_stage(
+                    std::move(name),
+                    std::move(task),
+                    std::move(output_queue_initialization),
+                    input_stage,
+                    std::move(sampler));
+
+                return new_stage;
+            }
+
+            template <typename InputStage, typename Task, typename Sampler>
+            Stage<typename InputStage::OutputType, NO_OUTPUT, detail::ConsumerTask<typename InputStage::OutputType, Task>, Sampler>
+                make_consumer_stage(
+                    std::string name,
+                    Task task,
+                    const InputStage& input_stage,
+                    Sampler sampler)
+            {
+                typedef detail::ConsumerTask<typename InputStage::OutputType, Task> WrappedTask;
+
+                Stage<typename InputStage::OutputType, NO_OUTPUT, WrappedTask, Sampler> new_stage(
+                    std::move(name),
+                    WrappedTask(std::move(task)),
+                    std::vector<NO_OUTPUT>(),
+                    input_stage,
+                    std::move(sampler));
+
+                return new_stage;
+            }
+
         }
 
 
@@ -28,6 +28,7 @@
 #include <glad/glad.h>
 #include "FrameTime.h"
 #include "Frame.h"
+#include "TraceId.h"
 
 namespace toa {
 
@@ -53,6 +54,7 @@ namespace toa {
             GLuint fbo_id;
             Time time_stamp;
             uint8_t* buffer;
+            TraceId trace_id;
 
             TokenGL() : 
                 gl_fence(0), 
@@ -61,7 +63,8 @@ namespace toa {
                 composition(nullptr),
                 fbo_id(0),
                 time_stamp(0, 1),
-                buffer(nullptr) {}
+                buffer(nullptr),
+                trace_id(kNoTraceId) {}
 
             TokenGL(GLsync gl_fence, 
                     GLuint id,
@@ -76,7 +79,8 @@ namespace toa {
                         composition(composition),
                         fbo_id(fbo_id),
                         time_stamp(time_stamp),
-                        buffer(buffer) {}
+                        buffer(buffer),
+                        trace_id(kNoTraceId) {}
         };
 
         // TODO-C++11: replace with =default or =delete
@@ -85,22 +89,27 @@ namespace toa {
 
             Frame frame;
             StreamComposition* composition;
+            TraceId trace_id;
 
-            TokenFrame() : composition(nullptr) {}
+            TokenFrame() : composition(nullptr), trace_id(kNoTraceId) {}
             TokenFrame(Frame f, StreamComposition* c) : 
-                frame(std::move(f)), composition(c) {}
+                frame(std::move(f)), composition(c), trace_id(kNoTraceId) {}
 
             TokenFrame& operator=(TokenFrame&& other) {
                 this->frame = std::move(other.frame);
                 this->composition = other.composition;
+                this->trace_id = other.trace_id;
                 other.composition = nullptr;
+                other.trace_id = kNoTraceId;
                 return *this;
             }
 
             TokenFrame(TokenFrame&& other) :
                 frame(std::move(other.frame)),
-                composition(other.composition) {
+                composition(other.composition),
+                trace_id(other.trace_id) {
                     other.composition = nullptr;
+                    other.trace_id = kNoTraceId;
             }
 
         private:
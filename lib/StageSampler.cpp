@@ -21,23 +21,96 @@
  */
 #include "Precompile.h"
 #include "StageSampler.h"
+#include "TraceFormat.h"
+#include "SampleClock.h"
+#include "ProgramOptions.h"
 #include <algorithm>
-#include <limits>
+#include <cmath>
 #include <sstream>
+#include <unordered_map>
 
 namespace fb = toa::frame_bender;
 namespace bc = boost::chrono;
 
+namespace {
+
+    // Fills in everything but the name and the states, from the deltas
+    // recorded into s.histogram and their sums
+    void finish_statistic(fb::StageSampler::Statistic& s, double sum_ns, double sum_squared_ns) {
+
+        const fb::LatencyHistogram& histogram = s.histogram;
+
+        s.num_samples = static_cast<size_t>(histogram.total_count());
+
+        s.minimum = fb::clock::duration(histogram.minimum());
+        s.maximum = fb::clock::duration(histogram.maximum());
+
+        double num_samples_d = static_cast<double>(s.num_samples);
+        double average_d = sum_ns / num_samples_d;
+
+        s.average = fb::clock::duration(static_cast<fb::clock::duration::rep>(average_d));
+
+        s.median = fb::clock::duration(histogram.value_at_percentile(50.0));
+
+        for (double percentile : fb::ProgramOptions::global().statistics_percentiles()) {
+            fb::StageSampler::Percentile p = { percentile, fb::clock::duration(histogram.value_at_percentile(percentile)) };
+            s.percentiles.push_back(p);
+        }
+
+        // Sample variance from the sums, as the deltas aren't kept
+        double variance_d = 0.0;
+
+        if (s.num_samples > 1)
+            variance_d = std::max((sum_squared_ns - sum_ns * average_d) / (num_samples_d - 1.0), 0.0);
+
+        s.std_deviation = fb::clock::duration(static_cast<fb::clock::duration::rep>(std::sqrt(variance_d)));
+
+    }
+
+}
+
 fb::StageSampler::StageSampler(const std::map<StageExecutionState, std::string>& name_overrides)
-    : name_overrides_(name_overrides)
+    : has_trace_ids_(false),
+      name_overrides_(name_overrides),
+      stream_(nullptr),
+      stream_id_(0)
 {
 
     sample_overflow_.fill(false);
+    stream_segments_.fill(nullptr);
+    trace_ids_.fill(kNoTraceId);
+
+    // See collect_statistics()
+    const StageExecutionState delta_states[kNumDeltaStatistics][2] = {
+        { StageExecutionState::TASK_BEGIN, StageExecutionState::TASK_END },
+        { StageExecutionState::EXECUTE_BEGIN, StageExecutionState::EXECUTE_END },
+        { StageExecutionState::EXECUTE_BEGIN, StageExecutionState::INPUT_TOKEN_AVAILABLE },
+        { StageExecutionState::EXECUTE_BEGIN, StageExecutionState::OUTPUT_TOKEN_AVAILABLE },
+        { StageExecutionState::GL_TASK_BEGIN, StageExecutionState::GL_TASK_END }
+    };
+
+    delta_recorder_of_end_state_.fill(nullptr);
+    last_events_.fill(TraceEvent::min());
+
+    for (size_t i = 0; i<kNumDeltaStatistics; ++i) {
+
+        DeltaRecorder& recorder = delta_recorders_[i];
+
+        recorder.begin_state = delta_states[i][0];
+        recorder.end_state = delta_states[i][1];
+        recorder.sum_ns = 0.0;
+        recorder.sum_squared_ns = 0.0;
+
+        delta_recorder_of_end_state_[static_cast<size_t>(recorder.end_state)] = &recorder;
+
+    }
 
     // Report size
-    size_t byte_size = 0;
+    size_t byte_size = sizeof(trace_ids_);
     for (const auto& e : trace_times_)
         byte_size += e.size() * sizeof(EventTrace::value_type);
+    for (const auto& recorder : delta_recorders_)
+        byte_size += recorder.histogram.num_counts() * sizeof(uint64_t);
 
     FB_LOG_DEBUG << "StageSampler uses " << byte_size << " bytes for trace data.";
 
@@ -56,16 +129,100 @@ fb::StageSampler::StageSampler(const std::map<StageExecutionState, std::string>&
 
 }
 
+fb::StageSampler::~StageSampler() {
+
+    TraceStream* stream = stream_.load();
+
+    if (stream != nullptr)
+        stream->detach(*this);
+
+}
+
 void fb::StageSampler::enter_sample(StageExecutionState state, const clock::time_point& time) {
 
-    auto& itr = trace_iterators_[static_cast<size_t>(state)];
-    auto end_itr = trace_end_iterators_[static_cast<size_t>(state)];
+    TraceStream* stream = stream_.load(std::memory_order_acquire);
+
+    if (stream != nullptr) {
+
+        // Streamed events go into the segment only. Only the thread 
+        // sampling this state touches its segment, the stream is only 
+        // locked once a segment is full.
+        TraceSegment*& segment = stream_segments_[static_cast<size_t>(state)];
+
+        if (segment == nullptr || segment->num_events == TraceSegment::kNumMaxEvents)
+            segment = stream->exchange_segment(segment, stream_id_, state);
+
+        if (segment != nullptr) {
+            segment->trace_ids[segment->num_events] = kNoTraceId;
+            segment->events[segment->num_events++] = time;
+        } else {
+            stream->count_dropped_event();
+        }
 
-    if (itr != end_itr) {
-        *itr = time;
-        itr++;
     } else {
-        sample_overflow_[static_cast<size_t>(state)]++;
+
+        auto& itr = trace_iterators_[static_cast<size_t>(state)];
+        auto end_itr = trace_end_iterators_[static_cast<size_t>(state)];
+
+        if (itr != end_itr) {
+            *itr = time;
+            itr++;
+        } else {
+            sample_overflow_[static_cast<size_t>(state)]++;
+        }
+
+    }
+
+    // Deltas are recorded right away, so that statistics aren't bound to 
+    // the events held in here
+    last_events_[static_cast<size_t>(state)] = time;
+
+    DeltaRecorder* recorder = delta_recorder_of_end_state_[static_cast<size_t>(state)];
+
+    if (recorder != nullptr) {
+
+        const TraceEvent& begin = last_events_[static_cast<size_t>(recorder->begin_state)];
+
+        if (begin != TraceEvent::min()) {
+
+            const clock::duration::rep delta = (time - begin).count();
+            const double delta_d = static_cast<double>(delta);
+
+            recorder->sum_ns += delta_d;
+            recorder->sum_squared_ns += delta_d * delta_d;
+            recorder->histogram.record(delta);
+
+        }
+
+    }
+
+}
+
+void fb::StageSampler::enter_trace_id(TraceId id) {
+
+    const size_t task_begin = static_cast<size_t>(StageExecutionState::TASK_BEGIN);
+
+    if (stream_.load(std::memory_order_acquire) != nullptr) {
+
+        // Still ours, segments are only handed over on the next sample
+        TraceSegment* segment = stream_segments_[task_begin];
+
+        if (segment != nullptr && segment->num_events != 0) {
+            segment->trace_ids[segment->num_events - 1] = id;
+            segment->has_trace_ids = segment->has_trace_ids || (id != kNoTraceId);
+        }
+
+    } else {
+
+        // The last TASK_BEGIN sample is only held in here if there was no 
+        // overflow yet
+        size_t num_tasks = number_of_sampled_trace_events(StageExecutionState::TASK_BEGIN);
+
+        if (num_tasks != 0 && sample_overflow_[task_begin] == 0) {
+            trace_ids_[num_tasks - 1] = id;
+            has_trace_ids_ = has_trace_ids_ || (id != kNoTraceId);
+        }
+
     }
 
 }
@@ -73,7 +230,7 @@ void fb::StageSampler::enter_sample(StageExecutionState state, const clock::time
 void fb::StageSampler::sample(StageExecutionState state) 
 {
 
-    clock::time_point sample_time = clock::now();
+    clock::time_point sample_time = sample_clock::now();
     enter_sample(state, sample_time);
 
 }
@@ -135,91 +292,79 @@ fb::StageSampler::Statistic fb::StageSampler::build_delta_statistic(
     }
 
     s.name = oss.str();
+    s.begin_state = begin_state;
+    s.end_state = end_state;
 
-    EventTrace::const_iterator start_trace = std::begin(begin_sampler.trace_times_[start_idx]);
-    EventTrace::const_iterator start_trace_end = begin_sampler.trace_iterators_[start_idx];
-    size_t start_num_traces = std::distance(start_trace, start_trace_end);
-
-    EventTrace::const_iterator end_trace = std::begin(end_sampler.trace_times_[end_idx]);
-    EventTrace::const_iterator end_trace_end = end_sampler.trace_iterators_[end_idx];
-    size_t end_num_traces = std::distance(end_trace, end_trace_end);
-
-    if (start_num_traces < end_num_traces) {
-        FB_LOG_ERROR << "Can't calculate statistics with incoherent traces, start_num_traces is less than end_num_traces.";
-        throw std::runtime_error("Incoherent number of traces, can't calculate statistics.");
-    }
-
-    auto itr_starts = start_trace;
-    auto itr_ends = end_trace;
-
-    s.num_samples = start_num_traces;
+    size_t start_num_traces = begin_sampler.number_of_sampled_trace_events(begin_state);
+    size_t end_num_traces = end_sampler.number_of_sampled_trace_events(end_state);
 
-    clock::duration::rep min_count = std::numeric_limits<clock::duration::rep>::max();
-    clock::duration::rep max_count = std::numeric_limits<clock::duration::rep>::min();
+    const EventTrace& start_trace = begin_sampler.trace_times_[start_idx];
+    const EventTrace& end_trace = end_sampler.trace_times_[end_idx];
 
-    uintmax_t sum = 0;
+    // Binned right away for median and percentiles (rather than sorting 
+    // all of them)
+    double sum_ns = 0.0;
+    double sum_squared_ns = 0.0;
 
-    std::vector<clock::duration> delta_times;
-    delta_times.reserve(start_num_traces);
+    auto record = [&](clock::duration::rep delta) {
+        const double delta_d = static_cast<double>(delta);
+        sum_ns += delta_d;
+        sum_squared_ns += delta_d * delta_d;
+        s.histogram.record(delta);
+    };
 
-    // calculate average
+    bool pair_by_trace_id = 
+        (&begin_sampler != &end_sampler) && 
+        begin_sampler.has_trace_ids() && 
+        end_sampler.has_trace_ids();
 
-    for (;itr_ends != end_trace_end; ++itr_starts, ++itr_ends) {
+    if (pair_by_trace_id) {
 
-        auto delta = *itr_ends - *itr_starts;
-        sum += delta.count();
+        // Task index of each frame in the begin sampler. Events of other 
+        // states line up with the tasks within one sampler.
+        size_t num_begin_tasks = std::min(
+            start_num_traces, 
+            begin_sampler.number_of_sampled_trace_events(StageExecutionState::TASK_BEGIN));
 
-        min_count = std::min(min_count, delta.count());
-        max_count = std::max(max_count, delta.count());
+        std::unordered_map<TraceId, size_t> begin_task_of_frame;
+        begin_task_of_frame.reserve(num_begin_tasks);
 
-        delta_times.push_back(delta);
-    }
+        for (size_t i = 0; i<num_begin_tasks; ++i) {
+            if (begin_sampler.trace_ids_[i] != kNoTraceId)
+                begin_task_of_frame.insert(std::make_pair(begin_sampler.trace_ids_[i], i));
+        }
 
-    s.minimum = clock::duration(min_count);
-    s.maximum = clock::duration(max_count);
+        size_t num_end_tasks = std::min(
+            end_num_traces, 
+            end_sampler.number_of_sampled_trace_events(StageExecutionState::TASK_BEGIN));
 
-    s.average = clock::duration(sum / s.num_samples);
+        for (size_t j = 0; j<num_end_tasks; ++j) {
 
-    // Calculate median
+            auto itr = begin_task_of_frame.find(end_sampler.trace_ids_[j]);
 
-    // Sorts ascending
-    std::sort(std::begin(delta_times), std::end(delta_times));
+            if (itr != std::end(begin_task_of_frame))
+                record((end_trace[j] - start_trace[itr->second]).count());
 
-    bool is_odd = ((start_num_traces % 2) == 1);
+        }
 
-    if (is_odd) {
-        s.median = delta_times.at(start_num_traces/2);
     } else {
-        auto a = delta_times.at(start_num_traces/2).count();
-        auto b = delta_times.at(start_num_traces/2 -1).count();
-        s.median = clock::duration((a + b)/2);
-    }
-
-    // Calculate stddev
 
-    double sum_d = static_cast<double>(sum);
-    double expected = sum_d / s.num_samples;
-    double num_samples_d = static_cast<double>(s.num_samples);
-    double sum_squared_expectancies_d = 0.0f;
+        if (start_num_traces < end_num_traces) {
+            FB_LOG_ERROR << "Can't calculate statistics with incoherent traces, start_num_traces is less than end_num_traces.";
+            throw std::runtime_error("Incoherent number of traces, can't calculate statistics.");
+        }
 
-    itr_starts = start_trace;
-    itr_ends = end_trace;
-
-    for (;itr_starts != start_trace_end; ++itr_starts, ++itr_ends) {
-
-        auto diff = *itr_ends - *itr_starts;
-
-        double diff_d = static_cast<double>(diff.count());
-
-        double diff_to_expected = (diff_d - expected);
-        sum_squared_expectancies_d += diff_to_expected*diff_to_expected;
+        for (size_t i = 0; i<end_num_traces; ++i)
+            record((end_trace[i] - start_trace[i]).count());
 
     }
 
-    double stddev_d = std::sqrt((sum_squared_expectancies_d / (num_samples_d-1)));
-    uintmax_t stddev = static_cast<uintmax_t>(stddev_d);
+    if (s.histogram.total_count() == 0) {
+        FB_LOG_ERROR << "Statistic '" << s.name << "' has no pairs of events to calculate statistics from.";
+        throw std::runtime_error("No samples to calculate statistics from.");
+    }
 
-    s.std_deviation = clock::duration(stddev);
+    finish_statistic(s, sum_ns, sum_squared_ns);
 
     return s;
 }
@@ -243,6 +388,23 @@ const fb::StageSampler::TraceEvent& fb::StageSampler::get_trace_event(
 
 }
 
+fb::TraceId fb::StageSampler::get_trace_id(size_t idx) const
+{
+
+    size_t num_tasks = number_of_sampled_trace_events(StageExecutionState::TASK_BEGIN);
+
+    if (!(idx < num_tasks)) {
+        FB_LOG_ERROR 
+            << "Index " << idx 
+            << " is larger than the number of sampled tasks (" 
+            << num_tasks << ").";
+        throw std::invalid_argument("Trace index out-of-range.");
+    }
+
+    return trace_ids_[idx];
+
+}
+
 size_t fb::StageSampler::number_of_sampled_trace_events(StageExecutionState state) const {
 
     EventTrace::const_iterator itr = std::begin(trace_times_[static_cast<size_t>(state)]);
@@ -254,25 +416,34 @@ size_t fb::StageSampler::number_of_sampled_trace_events(StageExecutionState stat
         
 }
 
-std::vector<fb::StageSampler::Statistic> fb::StageSampler::collect_statistics() const
+fb::StageSampler::Statistic fb::StageSampler::make_statistic(const DeltaRecorder& recorder) const
 {
 
-    std::vector<fb::StageSampler::Statistic> answer;
+    Statistic s;
+
+    std::ostringstream oss;
+    oss << get_name(recorder.begin_state) << "<->" << get_name(recorder.end_state);
+
+    s.name = oss.str();
+    s.begin_state = recorder.begin_state;
+    s.end_state = recorder.end_state;
+    s.histogram = recorder.histogram;
+
+    finish_statistic(s, recorder.sum_ns, recorder.sum_squared_ns);
 
-    if (number_of_sampled_trace_events(StageExecutionState::TASK_BEGIN) != 0)
-        answer.push_back(build_delta_statistic(*this, StageExecutionState::TASK_BEGIN, *this, StageExecutionState::TASK_END));
+    return s;
 
-    if (number_of_sampled_trace_events(StageExecutionState::EXECUTE_BEGIN) != 0)
-        answer.push_back(build_delta_statistic(*this, StageExecutionState::EXECUTE_BEGIN, *this, StageExecutionState::EXECUTE_END));
+}
 
-    if (number_of_sampled_trace_events(StageExecutionState::EXECUTE_BEGIN) != 0)
-        answer.push_back(build_delta_statistic(*this, StageExecutionState::EXECUTE_BEGIN, *this, StageExecutionState::INPUT_TOKEN_AVAILABLE));
+std::vector<fb::StageSampler::Statistic> fb::StageSampler::collect_statistics() const
+{
 
-    if (number_of_sampled_trace_events(StageExecutionState::EXECUTE_BEGIN) != 0)
-        answer.push_back(build_delta_statistic(*this, StageExecutionState::EXECUTE_BEGIN, *this, StageExecutionState::OUTPUT_TOKEN_AVAILABLE));
+    std::vector<fb::StageSampler::Statistic> answer;
 
-    if (number_of_sampled_trace_events(StageExecutionState::GL_TASK_BEGIN) != 0)
-        answer.push_back(build_delta_statistic(*this, StageExecutionState::GL_TASK_BEGIN, *this, StageExecutionState::GL_TASK_END));
+    for (const auto& recorder : delta_recorders_) {
+        if (recorder.histogram.total_count() != 0)
+            answer.push_back(make_statistic(recorder));
+    }
 
     return answer;
 
@@ -286,6 +457,8 @@ std::ostream& fb::operator<< (std::ostream& out, const StageSampler::Statistic&
     out << "minimum: " << bc::duration_cast<bc::microseconds>(v.minimum) << ", ";
     out << "maximum: " << bc::duration_cast<bc::microseconds>(v.maximum) << ", ";
     out << "stddev: " << bc::duration_cast<bc::microseconds>(v.std_deviation) << ", ";
+    for (const auto& p : v.percentiles)
+        out << "p" << p.percentile << ": " << bc::duration_cast<bc::microseconds>(p.value) << ", ";
     out << "num_samples: " << v.num_samples << "].";
 
     return out;
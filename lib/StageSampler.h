@@ -24,17 +24,22 @@
 
 #include <array>
 #include <vector>
+#include <atomic>
 
 #include "Utils.h"
 #include "ChronoUtils.h"
 #include <iosfwd>
 #include "Stage.h"
+#include "LatencyHistogram.h"
+#include "TraceId.h"
 
 namespace toa {
     namespace frame_bender {
 
         // TODO: think about using thread-clock?
         class TraceFormatWriter;
+        class TraceStream;
+        struct TraceSegment;
 
         class StageSampler : public utils::NoCopyingOrMoving {
 
@@ -42,22 +47,51 @@ namespace toa {
 
             typedef clock::time_point TraceEvent;
 
+            struct Percentile {
+                // in [0, 100]
+                double percentile;
+                clock::duration value;
+            };
+
             struct Statistic {
                 std::string name;
+                StageExecutionState begin_state;
+                StageExecutionState end_state;
                 clock::duration average;
                 clock::duration minimum;
                 clock::duration maximum;
                 clock::duration std_deviation;
+                // From the histogram, i.e. to its precision
                 clock::duration median;
                 size_t num_samples;
+                // As of ProgramOptions::statistics_percentiles()
+                std::vector<Percentile> percentiles;
+                // Of all deltas, can be merged with the same statistic of 
+                // other runs
+                LatencyHistogram histogram;
             };
 
             StageSampler(
                 const std::map<StageExecutionState, std::string>& name_overrides = std::map<StageExecutionState, std::string>());
 
+            // Detaches from the TraceStream, if any
+            ~StageSampler();
+
             void sample(StageExecutionState state);
             void enter_sample(StageExecutionState state, const clock::time_point& time);
 
+            // Records the frame that the current task works on, i.e. the one
+            // of the last TASK_BEGIN sample. Called from within the task, 
+            // nothing is recorded if TASK_BEGIN isn't sampled.
+            void enter_trace_id(TraceId id);
+
+            // The deltas of TASK_BEGIN->TASK_END, EXECUTE_BEGIN->EXECUTE_END,
+            // EXECUTE_BEGIN->INPUT_TOKEN_AVAILABLE, 
+            // EXECUTE_BEGIN->OUTPUT_TOKEN_AVAILABLE and 
+            // GL_TASK_BEGIN->GL_TASK_END, of those that were sampled. Each 
+            // delta is recorded when its end state is sampled (against the 
+            // last sample of its begin state), so these cover all events, 
+            // not only the first kNumMaxTraceEvents held in here.
             std::vector<Statistic> collect_statistics() const;
 
             static const size_t kNumMaxTraceEvents = 10000;
@@ -67,12 +101,28 @@ namespace toa {
 
             size_t number_of_sampled_trace_events(StageExecutionState state) const;
 
+            // The frame of the idx-th TASK_BEGIN event, kNoTraceId if the
+            // task didn't report one. Throws if out of bounds.
+            TraceId get_trace_id(size_t idx) const;
+
+            // Whether any task reported a frame
+            bool has_trace_ids() const { return has_trace_ids_; }
+
             void set_name_overrides(std::map<StageExecutionState, std::string> overrides);
 
             std::string get_name(StageExecutionState state) const;
 
             friend class TraceFormatWriter;
+            friend class TraceStream;
+
+            // Whether events are written to a TraceStream instead of being 
+            // held in here (the ones sampled before attaching are kept)
+            bool is_streamed() const { return stream_.load() != nullptr; }
 
+            // From the events held in here. If both samplers are different 
+            // and have trace IDs, the events of the same frame are paired 
+            // (per task, see enter_trace_id()). Otherwise the i-th events of
+            // both are paired.
             static Statistic build_delta_statistic(
                 const StageSampler& begin_sampler,
                 StageExecutionState begin_state,
@@ -83,6 +133,21 @@ namespace toa {
 
         private:
 
+            // See collect_statistics()
+            static const size_t kNumDeltaStatistics = 5;
+
+            struct DeltaRecorder {
+                StageExecutionState begin_state;
+                StageExecutionState end_state;
+                // For the average and the standard deviation, the histogram 
+                // only keeps the deltas to its precision
+                double sum_ns;
+                double sum_squared_ns;
+                LatencyHistogram histogram;
+            };
+
+            Statistic make_statistic(const DeltaRecorder& recorder) const;
+
             typedef std::array<TraceEvent, kNumMaxTraceEvents> EventTrace;
 
             typedef std::array<EventTrace, static_cast<size_t>(StageExecutionState::NUMBER_OF_STATES)> TraceTimes;
@@ -94,8 +159,25 @@ namespace toa {
             TraceIterators trace_end_iterators_;
             std::array<size_t, static_cast<size_t>(StageExecutionState::NUMBER_OF_STATES)> sample_overflow_;
 
+            // Parallel to the TASK_BEGIN events
+            std::array<TraceId, kNumMaxTraceEvents> trace_ids_;
+            bool has_trace_ids_;
+
             std::map<StageExecutionState, std::string> name_overrides_;
 
+            std::array<DeltaRecorder, kNumDeltaStatistics> delta_recorders_;
+            // Indexed by state, nullptr if the state doesn't end a delta
+            std::array<DeltaRecorder*, static_cast<size_t>(StageExecutionState::NUMBER_OF_STATES)> delta_recorder_of_end_state_;
+            // The last sample of each state, TraceEvent::min() if none
+            std::array<TraceEvent, static_cast<size_t>(StageExecutionState::NUMBER_OF_STATES)> last_events_;
+
+            // Managed by TraceStream::attach() and detach(). Mutable, as 
+            // streaming doesn't change what is sampled, and stages only hand 
+            // out their samplers as const.
+            mutable std::atomic<TraceStream*> stream_;
+            mutable uint32_t stream_id_;
+            mutable std::array<TraceSegment*, static_cast<size_t>(StageExecutionState::NUMBER_OF_STATES)> stream_segments_;
+
         };
 
         // Prints a readable report
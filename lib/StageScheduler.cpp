@@ -0,0 +1,247 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "StageScheduler.h"
+
+#include <chrono>
+#include <thread>
+
+namespace fb = toa::frame_bender;
+
+namespace {
+
+    // Maximum number of times a worker executes the same stage before it 
+    // moves on to its next job, so that a busy stage can't starve others.
+    const size_t kMaxExecutionsPerTurn = 4;
+
+    // Idle workers keep polling for a few turns, then yield and finally
+    // sleep, so that an idle phase doesn't keep a core busy.
+    const size_t kPollingIdleTurns = 16;
+    const size_t kYieldingIdleTurns = 256;
+    const auto kIdleSleepTime = std::chrono::microseconds(50);
+
+    void back_off(size_t idle_turns) {
+
+        if (idle_turns < kPollingIdleTurns)
+            return;
+
+        if (idle_turns < kYieldingIdleTurns)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(kIdleSleepTime);
+
+    }
+
+}
+
+fb::StageScheduler::StageScheduler(std::string name, size_t num_workers) :
+    name_(std::move(name)),
+    num_jobs_(0),
+    num_unfinished_jobs_(0),
+    aborted_(false),
+    num_executions_(0),
+    num_steals_(0)
+{
+
+    if (num_workers == 0)
+        throw std::invalid_argument("A stage scheduler needs at least one worker.");
+
+    for (size_t i = 0; i < num_workers; ++i)
+        workers_.push_back(utils::make_unique<Worker>());
+
+}
+
+void fb::StageScheduler::add_job(const Job& job) {
+
+    if (job.stage == nullptr)
+        throw std::invalid_argument("Can't schedule a nullptr stage.");
+
+    // Distribute the stages round-robin, a job will find its way to an
+    // idle worker anyway.
+    Worker& worker = *workers_[num_jobs_ % workers_.size()];
+    
+    std::lock_guard<std::mutex> guard(worker.lock);
+    worker.jobs.push_back(job);
+    ++num_jobs_;
+
+}
+
+void fb::StageScheduler::run() {
+
+    if (num_jobs_ == 0) {
+        FB_LOG_WARNING << "Scheduler '" << name_ << "' has no stages, not executing at all.";
+        return;
+    }
+
+    num_unfinished_jobs_ = num_jobs_;
+    aborted_ = false;
+    num_executions_ = 0;
+    num_steals_ = 0;
+
+    FB_LOG_INFO 
+        << "Starting scheduler '" << name_ << "' with " << num_jobs_ 
+        << " stages on " << workers_.size() << " workers.";
+
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < workers_.size(); ++i)
+        helpers.push_back(std::thread(&StageScheduler::work, this, i));
+
+    work(0);
+
+    for (auto& helper : helpers)
+        helper.join();
+
+    // Finished jobs have been dropped, anything left over was aborted
+    for (auto& worker : workers_)
+        worker->jobs.clear();
+    
+    num_jobs_ = 0;
+
+    FB_LOG_INFO 
+        << "Scheduler '" << name_ << "' is done executing (" 
+        << num_executions_.load() << " executions, " 
+        << num_steals_.load() << " steals).";
+
+}
+
+fb::StageScheduler::Statistics fb::StageScheduler::statistics() const {
+
+    Statistics answer;
+    answer.num_executions = num_executions_.load();
+    answer.num_steals = num_steals_.load();
+    return answer;
+
+}
+
+void fb::StageScheduler::work(size_t worker_index) {
+
+    size_t idle_turns = 0;
+
+    while (num_unfinished_jobs_.load() != 0 && !aborted_.load()) {
+
+        Job job;
+        if (!take_own_job(worker_index, job) && !steal_job(worker_index, job)) {
+            back_off(idle_turns++);
+            continue;
+        }
+
+        size_t num_executed = 0;
+
+        try {
+
+            while (num_executed < kMaxExecutionsPerTurn && 
+                   job.stage->status() == PipelineStatus::READY_TO_EXECUTE &&
+                   is_runnable(job))
+            {
+                job.stage->execute();
+                ++num_executed;
+            }
+
+        } catch (const std::exception& e) {
+            FB_LOG_CRITICAL 
+                << "Scheduler '" << name_ << "' caught an exception in stage '" 
+                << job.stage->name() << "': " << e.what() << ".";
+            aborted_ = true;
+            break;
+        }
+
+        num_executions_.fetch_add(num_executed, std::memory_order_relaxed);
+
+        if (job.stage->status() == PipelineStatus::READY_TO_EXECUTE)
+            return_job(worker_index, job);
+        else
+            num_unfinished_jobs_.fetch_sub(1);
+
+        if (num_executed == 0) {
+            back_off(idle_turns++);
+        } else {
+            idle_turns = 0;
+        }
+
+    }
+
+}
+
+bool fb::StageScheduler::take_own_job(size_t worker_index, Job& job) {
+
+    Worker& worker = *workers_[worker_index];
+
+    std::lock_guard<std::mutex> guard(worker.lock);
+
+    if (worker.jobs.empty())
+        return false;
+
+    job = worker.jobs.front();
+    worker.jobs.pop_front();
+
+    return true;
+
+}
+
+bool fb::StageScheduler::steal_job(size_t thief_index, Job& job) {
+
+    for (size_t i = 1; i < workers_.size(); ++i) {
+
+        Worker& victim = *workers_[(thief_index + i) % workers_.size()];
+
+        std::lock_guard<std::mutex> guard(victim.lock);
+
+        if (victim.jobs.empty())
+            continue;
+
+        // Owners take jobs from the front and return them to the back, so
+        // the back is the job that the victim would get to last.
+        job = victim.jobs.back();
+        victim.jobs.pop_back();
+
+        num_steals_.fetch_add(1, std::memory_order_relaxed);
+
+        return true;
+
+    }
+
+    return false;
+
+}
+
+void fb::StageScheduler::return_job(size_t worker_index, const Job& job) {
+
+    Worker& worker = *workers_[worker_index];
+
+    std::lock_guard<std::mutex> guard(worker.lock);
+    worker.jobs.push_back(job);
+
+}
+
+bool fb::StageScheduler::is_runnable(const Job& job) {
+
+    if (job.input_load_constraint != 0 &&
+        job.previous_stage != nullptr &&
+        job.stage->input_queue_num_elements() < job.input_load_constraint &&
+        job.previous_stage->status() == PipelineStatus::READY_TO_EXECUTE)
+    {
+        return false;
+    }
+
+    return job.stage->has_tokens_available();
+
+}
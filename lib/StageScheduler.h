@@ -0,0 +1,122 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_STAGE_SCHEDULER_H
+#define TOA_FRAME_BENDER_STAGE_SCHEDULER_H
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Utils.h"
+#include "PipelineStage.h"
+
+namespace toa {
+    namespace frame_bender {
+
+        // Runs a set of CPU-only pipeline stages on a pool of worker threads.
+        // Each stage is a job that is owned by exactly one worker at a time,
+        // so a stage never executes concurrently with itself. A worker only
+        // executes a stage if it has both an input and an output token 
+        // available, otherwise it moves on to its next job. Workers that 
+        // run out of runnable jobs steal from the other workers' queues.
+        // Stages must not issue any GL calls, as they may run on any worker.
+        class StageScheduler final : utils::NoCopyingOrMoving {
+
+        public:
+
+            struct Job {
+
+                PipelineStage* stage;
+                PipelineStage* previous_stage;
+                // Same as for the dispatch phases, the stage won't execute
+                // until this many tokens are in its input queue, as long 
+                // as the previous stage is still running.
+                size_t input_load_constraint;
+
+                Job() : 
+                    stage(nullptr), 
+                    previous_stage(nullptr), 
+                    input_load_constraint(0) {}
+
+                Job(
+                    PipelineStage* stage, 
+                    PipelineStage* previous_stage = nullptr,
+                    size_t input_load_constraint = 0) :
+                        stage(stage),
+                        previous_stage(previous_stage),
+                        input_load_constraint(input_load_constraint) {}
+            };
+
+            struct Statistics {
+                size_t num_executions;
+                size_t num_steals;
+            };
+
+            StageScheduler(std::string name, size_t num_workers);
+
+            // Must not be called while run() is active.
+            void add_job(const Job& job);
+
+            bool empty() const { return num_jobs_ == 0; }
+
+            // Runs all jobs until each of their stages has stopped. The 
+            // calling thread acts as one of the workers.
+            void run();
+
+            Statistics statistics() const;
+
+            const std::string& name() const { return name_; }
+            size_t num_workers() const { return workers_.size(); }
+
+        private:
+
+            struct Worker {
+                std::mutex lock;
+                std::deque<Job> jobs;
+            };
+
+            void work(size_t worker_index);
+
+            bool take_own_job(size_t worker_index, Job& job);
+            bool steal_job(size_t thief_index, Job& job);
+            void return_job(size_t worker_index, const Job& job);
+
+            static bool is_runnable(const Job& job);
+
+            std::string name_;
+            std::vector<std::unique_ptr<Worker>> workers_;
+            size_t num_jobs_;
+
+            std::atomic<size_t> num_unfinished_jobs_;
+            std::atomic<bool> aborted_;
+            std::atomic<size_t> num_executions_;
+            std::atomic<size_t> num_steals_;
+
+        };
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_STAGE_SCHEDULER_H
@@ -39,6 +39,7 @@ namespace toa {
         class StreamDispatch;
         class LocklessQueue; 
         class FrameCompositionOutputStage;
+        class MappedPBOOutputStage;
 
         /**
          * A stream composition is defined as the rendered output of N inputs.
@@ -49,6 +50,7 @@ namespace toa {
 
             // TODO: could we make this cleaner?
             friend class FrameCompositionOutputStage;
+            friend class MappedPBOOutputStage;
 
             typedef std::string ID;
             typedef std::function<void (const Frame& f)> OutputCallback;
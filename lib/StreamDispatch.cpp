@@ -22,7 +22,9 @@
 #include "Precompile.h"
 #include <algorithm>
 #include <functional>
+#include <iterator>
 #include <iostream>
+#include <sstream>
 
 #include <boost/filesystem.hpp>
 
@@ -43,13 +45,38 @@
 #include "ByPassDownloadStage.h"
 #include "ByPassUploadStage.h"
 #include "FrameCompositionOutputStage.h"
+#include "MappedPBOOutputStage.h"
 #include "FrameCompositionInputStage.h"
 #include "CopyHostToMappedPBOStage.h"
+#include "FillMappedPBOStage.h"
 #include "UnmapPBOStage.h"
+#include "StageScheduler.h"
+#include "FramePool.h"
 
 namespace fb = toa::frame_bender;
 namespace bf = boost::filesystem;
 
+namespace {
+
+    typedef std::vector<std::pair<std::string, const fb::StageSampler*>> NamedSamplers;
+
+    // Each stripe of a CPU format conversion shows up as a stage of its own,
+    // right after the converter that owns it.
+    void add_stripe_samplers(
+        NamedSamplers& named_samplers, 
+        const fb::FormatConverterStage& stage) 
+    {
+        const auto& samplers = stage.stripe_samplers();
+
+        for (size_t i = 0; i < samplers.size(); ++i) {
+            std::ostringstream oss;
+            oss << stage.name() << " (stripe " << i << "/" << samplers.size() << ")";
+            named_samplers.push_back(std::make_pair(oss.str(), samplers[i].get()));
+        }
+    }
+
+}
+
 fb::StreamDispatch::StreamDispatch(
     std::string name,
     gl::Context* main_context,
@@ -63,6 +90,7 @@ fb::StreamDispatch::StreamDispatch(
         origin_format_(origin_format),
         render_format_(render_format),
         stop_threads_(false),
+        trace_stream_(nullptr),
         gl_context_master_(main_context),
         active_composition_(nullptr),
         enable_output_stages_(enable_output_stages),
@@ -72,7 +100,9 @@ fb::StreamDispatch::StreamDispatch(
         impl_async_input_(flags[static_cast<size_t>(Flags::ASYNC_INPUT)]),
         impl_async_output_(flags[static_cast<size_t>(Flags::ASYNC_OUTPUT)]),
         impl_use_arb_persistent_mapping_(flags[static_cast<size_t>(Flags::ARB_PERSISTENT_MAPPING)]),
-        impl_copy_pbo_before_download_(flags[static_cast<size_t>(Flags::COPY_PBO_BEFORE_DOWNLOAD)])
+        impl_copy_pbo_before_download_(flags[static_cast<size_t>(Flags::COPY_PBO_BEFORE_DOWNLOAD)]),
+        impl_zero_copy_output_(flags[static_cast<size_t>(Flags::ZERO_COPY_OUTPUT)]),
+        impl_zero_copy_input_(flags[static_cast<size_t>(Flags::ZERO_COPY_INPUT)])
 {
 
     if (main_context == nullptr)
@@ -126,6 +156,10 @@ fb::StreamDispatch::StreamDispatch(
         }
     }
 
+    if (impl_zero_copy_output_ && !impl_use_arb_persistent_mapping_) {
+        FB_LOG_INFO << "Zero-copy output without persistently-mapped buffers, PBOs are re-mapped for every frame.";
+    }
+
     if (impl_use_multiple_gl_contexts_) {
     
         FB_LOG_INFO << "Using multiple GL contexts for upload/render/download.";
@@ -139,7 +173,23 @@ fb::StreamDispatch::StreamDispatch(
         FB_LOG_INFO << "Using a single GL context for upload/render/download.";
     }
 
+    default_wait_settings() = WaitSettings::for_policy(
+        ProgramOptions::global().pipeline_waiting_policy(),
+        microseconds(ProgramOptions::global().pipeline_hybrid_spin_time_us()));
+
+    FB_LOG_INFO 
+        << "Pipeline stages wait for tokens with policy '" 
+        << ProgramOptions::global().pipeline_waiting_policy() << "'.";
+
+    // Lets the trace show where frame payloads were allocated
+    FramePool::global().set_records_events(ProgramOptions::global().sample_stages());
+
     define_pipeline();
+
+    if (ProgramOptions::global().sample_stages()) {
+        attach_wake_samplers();
+        attach_queue_samplers();
+    }
     
     if (impl_use_multiple_gl_contexts_) {
 
@@ -148,11 +198,42 @@ fb::StreamDispatch::StreamDispatch(
 
     }
 
+    // The host-side phases don't touch GL, so instead of a dedicated thread
+    // per phase they can share a pool of work-stealing workers.
+    const size_t host_worker_count = ProgramOptions::global().pipeline_host_worker_count();
+
+    if (host_worker_count != 0 && (impl_async_input_ || impl_async_output_)) {
+
+        host_stage_scheduler_ = utils::make_unique<StageScheduler>("host_stages", host_worker_count);
+
+        for (const auto& execution : host_copy_input_async_thread_stages_) {
+            host_stage_scheduler_->add_job(StageScheduler::Job(
+                execution.stage,
+                execution.previous_stage,
+                execution.input_load_constraint));
+        }
+
+        for (const auto& execution : host_copy_output_async_thread_stages_) {
+            host_stage_scheduler_->add_job(StageScheduler::Job(
+                execution.stage,
+                execution.previous_stage,
+                execution.input_load_constraint));
+        }
+
+        FB_LOG_INFO 
+            << "Asynchronous host-side stages are scheduled on " 
+            << host_worker_count << " work-stealing threads.";
+
+        host_stage_scheduler_thread_ = std::thread(&StreamDispatch::execute_host_stage_scheduler, this);
+
+    }
+
     if (impl_async_input_) {
 
         FB_LOG_INFO << "Input frame handling and copying is asynchronous to OpenGL upload.";
 
-        host_copy_input_async_thread_ = std::thread(&StreamDispatch::execute_host_copy_input_async, this);
+        if (!host_stage_scheduler_)
+            host_copy_input_async_thread_ = std::thread(&StreamDispatch::execute_host_copy_input_async, this);
 
     } else {
 
@@ -164,7 +245,8 @@ fb::StreamDispatch::StreamDispatch(
 
         FB_LOG_INFO << "Output frame handling and copying is asynchronous to OpenGL download.";
 
-        host_copy_output_async_thread_ = std::thread(&StreamDispatch::execute_host_copy_output_async, this);
+        if (!host_stage_scheduler_)
+            host_copy_output_async_thread_ = std::thread(&StreamDispatch::execute_host_copy_output_async, this);
 
     } else {
 
@@ -207,7 +289,8 @@ fb::StreamDispatch::StreamDispatch(
         << "', upload-memcpy='" << host_copy_input_async_thread_.get_id()
         << "', render='" << gl_master_thread_.get_id()
         << "', download-memcpy='" << host_copy_output_async_thread_.get_id()
-        << "', download='" << gl_download_async_thread_.get_id() << "'.";
+        << "', download='" << gl_download_async_thread_.get_id()
+        << "', host-scheduler='" << host_stage_scheduler_thread_.get_id() << "'.";
 
 }
 
@@ -230,16 +313,37 @@ fb::StreamDispatch::~StreamDispatch() {
     if (host_copy_output_async_thread_.joinable())
         host_copy_output_async_thread_.join();
 
+    if (host_stage_scheduler_thread_.joinable())
+        host_stage_scheduler_thread_.join();
+
     FB_LOG_DEBUG << "Joined dispatch threads.";
 
+    for (const auto& wake_sampler : wake_samplers_) {
+        for (const auto& statistic : wake_sampler.second->collect_statistics())
+            FB_LOG_INFO << wake_sampler.first << ": " << statistic;
+    }
+
+    for (const auto& queue_sampler : queue_samplers_)
+        FB_LOG_INFO << *queue_sampler;
+
+    for (const auto& stats : FramePool::global().statistics()) {
+        const size_t num_acquired = stats.num_hits + stats.num_allocations;
+        FB_LOG_INFO 
+            << "Frame pool (" << stats.byte_size << " bytes): " 
+            << stats.num_allocations << " allocations, " 
+            << stats.num_hits << " hits (" 
+            << (num_acquired != 0 ? 100.0 * stats.num_hits / num_acquired : 0.0) 
+            << "%), " << stats.num_frees << " frees.";
+    }
+
     // Print summarizing statistics, if we have sampled.
     if (ProgramOptions::global().sample_stages()) {
 
         // TODO: make user option
         const size_t in_point = ProgramOptions::global().statistics_skip_first_num_frames();
         
-        const StageSampler& head_sampler = enable_input_stages_ ? frame_composition_input_stage_->sampler() : by_pass_upload_stage_->sampler();
-        const StageSampler& output_sampler = enable_output_stages_ ? frame_composition_output_stage_->sampler() : by_pass_download_stage_->sampler();
+        const StageSampler& head_sampler = input_sampler();
+        const StageSampler& output_sampler = this->output_sampler();
         size_t num_samples_available = head_sampler.number_of_sampled_trace_events(StageExecutionState::TASK_BEGIN);
         if (num_samples_available > 200) {
 
@@ -333,11 +437,8 @@ fb::StreamDispatch::~StreamDispatch() {
                     FB_LOG_INFO << "-----";
                     for (size_t i = first_frame; i<last_frame; ++i) {
 
-                        auto begin_frame_input = make_relative_micros(frame_composition_input_stage_->sampler().get_trace_event(StageExecutionState::TASK_BEGIN, i));
-                        auto end_frame_input = make_relative_micros(frame_composition_input_stage_->sampler().get_trace_event(StageExecutionState::TASK_END, i));
-
-                        auto begin_copy= make_relative_micros(copy_host_to_mapped_pbo_up_stage_->sampler().get_trace_event(StageExecutionState::TASK_BEGIN, i));
-                        auto end_copy = make_relative_micros(copy_host_to_mapped_pbo_up_stage_->sampler().get_trace_event(StageExecutionState::TASK_END, i));
+                        auto begin_frame_input = make_relative_micros(head_sampler.get_trace_event(StageExecutionState::TASK_BEGIN, i));
+                        auto end_frame_input = make_relative_micros(head_sampler.get_trace_event(StageExecutionState::TASK_END, i));
 
                         auto begin_unmap = make_relative_micros(unmap_pbo_up_stage_->sampler().get_trace_event(StageExecutionState::TASK_BEGIN, i));
                         auto end_unmap = make_relative_micros(unmap_pbo_up_stage_->sampler().get_trace_event(StageExecutionState::TASK_END, i));
@@ -346,7 +447,14 @@ fb::StreamDispatch::~StreamDispatch() {
                         auto end_unpack = make_relative_micros(unpack_pbo_to_texture_stage_->sampler().get_trace_event(StageExecutionState::TASK_END, i));
 
                         format_trace("In", i, begin_frame_input, end_frame_input);
-                        format_trace("Copy", i, begin_copy, end_copy);
+
+                        // Input is filled in place for zero-copy input
+                        if (copy_host_to_mapped_pbo_up_stage_) {
+                            auto begin_copy = make_relative_micros(copy_host_to_mapped_pbo_up_stage_->sampler().get_trace_event(StageExecutionState::TASK_BEGIN, i));
+                            auto end_copy = make_relative_micros(copy_host_to_mapped_pbo_up_stage_->sampler().get_trace_event(StageExecutionState::TASK_END, i));
+                            format_trace("Copy", i, begin_copy, end_copy);
+                        }
+
                         format_trace("Unmap", i, begin_unmap, end_unmap);
                         format_trace("Unpack", i, begin_unpack, end_unpack);
 
@@ -449,15 +557,19 @@ fb::StreamDispatch::~StreamDispatch() {
                         auto begin_map = make_relative_micros(map_pbo_down_stage_->sampler().get_trace_event(StageExecutionState::TASK_BEGIN, i));
                         auto end_map = make_relative_micros(map_pbo_down_stage_->sampler().get_trace_event(StageExecutionState::TASK_END, i));
 
-                        auto begin_copy = make_relative_micros(copy_mapped_pbo_down_stage->sampler().get_trace_event(StageExecutionState::TASK_BEGIN, i));
-                        auto end_copy = make_relative_micros(copy_mapped_pbo_down_stage->sampler().get_trace_event(StageExecutionState::TASK_END, i));
-
-                        auto begin_deliver = make_relative_micros(frame_composition_output_stage_->sampler().get_trace_event(StageExecutionState::TASK_BEGIN, i));
-                        auto end_deliver = make_relative_micros(frame_composition_output_stage_->sampler().get_trace_event(StageExecutionState::TASK_END, i));
+                        auto begin_deliver = make_relative_micros(output_sampler.get_trace_event(StageExecutionState::TASK_BEGIN, i));
+                        auto end_deliver = make_relative_micros(output_sampler.get_trace_event(StageExecutionState::TASK_END, i));
 
                         format_trace("Pack", i, begin_pack, end_pack);
                         format_trace("Map", i, begin_map, end_map);
-                        format_trace("Copy", i, begin_copy, end_copy);
+
+                        // There is no copy stage for zero-copy output
+                        if (copy_mapped_pbo_down_stage) {
+                            auto begin_copy = make_relative_micros(copy_mapped_pbo_down_stage->sampler().get_trace_event(StageExecutionState::TASK_BEGIN, i));
+                            auto end_copy = make_relative_micros(copy_mapped_pbo_down_stage->sampler().get_trace_event(StageExecutionState::TASK_END, i));
+                            format_trace("Copy", i, begin_copy, end_copy);
+                        }
+
                         format_trace("Out", i, begin_deliver, end_deliver);
 
                         FB_LOG_INFO << "-----";
@@ -518,6 +630,9 @@ fb::StreamDispatch::~StreamDispatch() {
     if (copy_host_to_mapped_pbo_up_stage_)
         copy_host_to_mapped_pbo_up_stage_.reset();
 
+    if (fill_mapped_pbo_up_stage_)
+        fill_mapped_pbo_up_stage_.reset();
+
     if (unmap_pbo_up_stage_)
         unmap_pbo_up_stage_.reset();
 
@@ -562,6 +677,9 @@ fb::StreamDispatch::~StreamDispatch() {
     if (copy_mapped_pbo_down_stage)
         copy_mapped_pbo_down_stage.reset();    
 
+    if (mapped_pbo_output_stage_)
+        mapped_pbo_output_stage_.reset();
+
     // Cleanup shared OGL buffers
     if (!download_pbo_ids_.empty()) {
         glDeleteBuffers(
@@ -576,21 +694,33 @@ fb::StreamDispatch::~StreamDispatch() {
 
 }
 
-void fb::StreamDispatch::write_trace_file(
-    const std::string& file_path, 
-    const std::string& configuration_name_prefix)
-{
+void fb::StreamDispatch::add_trace_sampler(std::string name, const StageSampler& sampler) {
 
-    const ProgramOptions& po = ProgramOptions::global();
+    external_samplers_.push_back(std::make_pair(std::move(name), &sampler));
 
-    bf::path config_file_path = po.config_file();
+}
 
-    std::string session_name = po.profiling_trace_name().empty() ? config_file_path.stem().string() : po.profiling_trace_name();
+void fb::StreamDispatch::stream_trace_file(TraceStream& stream) {
 
-    // TODO: define session name
-    // TODO: add program option string?
+    if (trace_stream_ != nullptr) {
+        FB_LOG_ERROR << "Trace is already streamed to '" << trace_stream_->file_path() << "'.";
+        throw std::runtime_error("Trace is already streamed.");
+    }
+
+    // Stages which never park still get their wake sampler attached, we 
+    // can't know that up front.
+    for (const auto& trace_sampler : trace_samplers(true))
+        stream.attach(trace_sampler.first, *trace_sampler.second);
+
+    trace_stream_ = &stream;
+
+}
+
+std::vector<std::pair<std::string, const fb::StageSampler*>> fb::StreamDispatch::trace_samplers(
+    bool include_idle_wake_samplers)
+{
 
-    TraceFormatWriter format_writer(file_path, session_name, gl_info_);
+    NamedSamplers samplers;
 
     // TODO-DEF: should really be based on a common interface !
 
@@ -598,87 +728,178 @@ void fb::StreamDispatch::write_trace_file(
     // and should reflect the chrononical order of the pipeline
 
     if (by_pass_upload_stage_) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             by_pass_upload_stage_->name(), 
-            by_pass_upload_stage_->sampler());
+            &by_pass_upload_stage_->sampler()));
     }
 
     if (frame_composition_input_stage_) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             frame_composition_input_stage_->name(), 
-            frame_composition_input_stage_->sampler());
+            &frame_composition_input_stage_->sampler()));
     }
 
     if (copy_host_to_mapped_pbo_up_stage_) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             copy_host_to_mapped_pbo_up_stage_->name(), 
-            copy_host_to_mapped_pbo_up_stage_->sampler());
+            &copy_host_to_mapped_pbo_up_stage_->sampler()));
+    }
+
+    if (fill_mapped_pbo_up_stage_) {
+        samplers.push_back(std::make_pair(
+            fill_mapped_pbo_up_stage_->name(), 
+            &fill_mapped_pbo_up_stage_->sampler()));
     }
 
     if (unmap_pbo_up_stage_) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             unmap_pbo_up_stage_->name(), 
-            unmap_pbo_up_stage_->sampler());
+            &unmap_pbo_up_stage_->sampler()));
     }
 
     if (unpack_pbo_to_texture_stage_) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             unpack_pbo_to_texture_stage_->name(), 
-            unpack_pbo_to_texture_stage_->sampler());
+            &unpack_pbo_to_texture_stage_->sampler()));
     }
 
     if (format_converter_stage_input_to_render_) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             format_converter_stage_input_to_render_->name(), 
-            format_converter_stage_input_to_render_->sampler());
+            &format_converter_stage_input_to_render_->sampler()));
+        add_stripe_samplers(samplers, *format_converter_stage_input_to_render_);
     }
 
     if (render_stage_) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             render_stage_->name(), 
-            render_stage_->sampler());
+            &render_stage_->sampler()));
     }
 
     if (format_converter_stage_render_to_output_) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             format_converter_stage_render_to_output_->name(), 
-            format_converter_stage_render_to_output_->sampler());
+            &format_converter_stage_render_to_output_->sampler()));
+        add_stripe_samplers(samplers, *format_converter_stage_render_to_output_);
     }
 
     if (pack_texture_to_pbo_stage_) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             pack_texture_to_pbo_stage_->name(), 
-            pack_texture_to_pbo_stage_->sampler());
+            &pack_texture_to_pbo_stage_->sampler()));
     }
 
     if (map_pbo_down_stage_) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             map_pbo_down_stage_->name(), 
-            map_pbo_down_stage_->sampler());
+            &map_pbo_down_stage_->sampler()));
     }
 
     if (copy_mapped_pbo_down_stage) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             copy_mapped_pbo_down_stage->name(), 
-            copy_mapped_pbo_down_stage->sampler());
+            &copy_mapped_pbo_down_stage->sampler()));
     }
 
     if (frame_composition_output_stage_) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             frame_composition_output_stage_->name(), 
-            frame_composition_output_stage_->sampler());
+            &frame_composition_output_stage_->sampler()));
+    }
+
+    if (mapped_pbo_output_stage_) {
+        samplers.push_back(std::make_pair(
+            mapped_pbo_output_stage_->name(), 
+            &mapped_pbo_output_stage_->sampler()));
     }
 
     if (by_pass_download_stage_) {
-        format_writer.add_stage_sampler(
+        samplers.push_back(std::make_pair(
             by_pass_download_stage_->name(), 
-            by_pass_download_stage_->sampler());
+            &by_pass_download_stage_->sampler()));
+    }
+
+    // Time between a producer signaling a parked stage and that stage 
+    // running again. Only stages that actually parked have any samples.
+    for (const auto& wake_sampler : wake_samplers_) {
+        if (include_idle_wake_samplers || 
+            wake_sampler.second->number_of_sampled_trace_events(StageExecutionState::TASK_BEGIN) != 0) 
+        {
+            samplers.push_back(std::make_pair(
+                wake_sampler.first,
+                wake_sampler.second.get()));
+        }
+    }
+
+    // Sources which sample their own events, e.g. read underruns
+    for (auto& composition : compositions_) {
+        const StreamSource& source = composition.second.first_source();
+        if (source.sampler() != nullptr)
+            samplers.push_back(std::make_pair(source.name(), source.sampler()));
+    }
+
+    samplers.insert(
+        std::end(samplers), 
+        std::begin(external_samplers_), 
+        std::end(external_samplers_));
+
+
+    return samplers;
+
+}
+
+void fb::StreamDispatch::write_trace_file(
+    const std::string& file_path, 
+    const std::string& configuration_name_prefix)
+{
+
+    const ProgramOptions& po = ProgramOptions::global();
+
+    bf::path config_file_path = po.config_file();
+
+    std::string session_name = po.profiling_trace_name().empty() ? config_file_path.stem().string() : po.profiling_trace_name();
+
+    // TODO: define session name
+    // TODO: add program option string?
+
+    std::unique_ptr<TraceFormatWriter> writer;
+
+    if (trace_stream_ != nullptr) {
+
+        if (bf::path(file_path) != bf::path(trace_stream_->file_path())) {
+            FB_LOG_WARNING 
+                << "Trace is streamed to '" << trace_stream_->file_path() 
+                << "', ignoring '" << file_path << "'.";
+        }
+
+        writer = utils::make_unique<TraceFormatWriter>(*trace_stream_, session_name, gl_info_);
+
+    } else {
+
+        writer = utils::make_unique<TraceFormatWriter>(file_path, session_name, gl_info_);
+
+    }
+
+    TraceFormatWriter& format_writer = *writer;
+
+    for (const auto& trace_sampler : trace_samplers(false)) {
+        format_writer.add_stage_sampler(
+            trace_sampler.first, 
+            *trace_sampler.second);
     }
 
+    for (const auto& queue_sampler : queue_samplers_)
+        format_writer.add_fifo_sampler(*queue_sampler);
+
+    // Every frame payload allocation and pool hit, see FramePool::fill_sampler()
+    auto frame_pool_sampler = utils::make_unique<StageSampler>();
+    FramePool::global().fill_sampler(*frame_pool_sampler);
+    format_writer.add_stage_sampler("FramePool", *frame_pool_sampler);
+
     const size_t in_point = ProgramOptions::global().statistics_skip_first_num_frames();
 
-    const StageSampler& head_sampler = enable_input_stages_ ? frame_composition_input_stage_->sampler() : by_pass_upload_stage_->sampler();
-    const StageSampler& output_sampler = enable_output_stages_ ? frame_composition_output_stage_->sampler() : by_pass_download_stage_->sampler();
+    const StageSampler& head_sampler = input_sampler();
+    const StageSampler& output_sampler = this->output_sampler();
 
     size_t num_samples_available = head_sampler.number_of_sampled_trace_events(StageExecutionState::TASK_BEGIN);
 
@@ -724,6 +945,10 @@ void fb::StreamDispatch::write_trace_file(
             static_cast<int64_t>(latency_stat.median.count()),
 			static_cast<float>(millisecs_per_frame));
 
+    } else if (head_sampler.is_streamed()) {
+        FB_LOG_INFO 
+            << "Won't write session statistics to trace file, the events of "
+            << "streamed stages are only held in the trace file.";
     } else {
         FB_LOG_WARNING 
             << "Won't write session statistics to trace file, number of samples is too little (" 
@@ -733,6 +958,9 @@ void fb::StreamDispatch::write_trace_file(
 
 
     format_writer.flush();
+
+    // Finished along with the writer
+    trace_stream_ = nullptr;
 }
 
 fb::StreamComposition::ID fb::StreamDispatch::get_unique_id_for_name(const std::string& name) const
@@ -813,7 +1041,9 @@ void fb::StreamDispatch::start_composition(
 
     // Note that this is just hacky (though non-blocking) way of only allowing
     // one stream to be dealt with at a time.
-    if (enable_input_stages_)
+    if (fill_mapped_pbo_up_stage_)
+        fill_mapped_pbo_up_stage_->set_composition(&itr->second);
+    else if (enable_input_stages_)
         frame_composition_input_stage_->set_composition(&itr->second);
     else
         by_pass_upload_stage_->set_composition(&itr->second);
@@ -839,7 +1069,9 @@ void fb::StreamDispatch::stop_composition(const StreamComposition::ID& id) {
 
     //running_compositions_.erase(res);
     
-    if (enable_input_stages_)
+    if (fill_mapped_pbo_up_stage_)
+        fill_mapped_pbo_up_stage_->set_composition(nullptr);
+    else if (enable_input_stages_)
         frame_composition_input_stage_->set_composition(nullptr);
     else
         by_pass_upload_stage_->set_composition(nullptr);
@@ -963,37 +1195,66 @@ void fb::StreamDispatch::define_pipeline() {
             unmap_to_unpack_pbo_ids.push_back(upload_pbos[idx]);
         }
 
-        frame_composition_input_stage_ = utils::make_unique<FrameCompositionInputStage>(
-            ProgramOptions::global().frame_input_pipeline_size()
-            );
+        if (impl_zero_copy_input_) {
 
-        host_upload_executor->push_back(PipelineStageExecution(
-            frame_composition_input_stage_.get()
-            ));
+            // The source fills the mapped PBOs itself
+            fill_mapped_pbo_up_stage_ = utils::make_unique<FillMappedPBOStage>(
+                copy_to_unmap_pbo_ids,
+                origin_format_,
+                !ProgramOptions::global().enable_host_copy_upload(),
+                impl_use_arb_persistent_mapping_);
 
-        copy_host_to_mapped_pbo_up_stage_ = utils::make_unique<CopyHostToMappedPBOStage>(
-            copy_to_unmap_pbo_ids,
-            origin_format_,
-            *frame_composition_input_stage_,
-            !ProgramOptions::global().enable_host_copy_upload(),
-            impl_use_arb_persistent_mapping_);
+            host_upload_executor->push_back(PipelineStageExecution(
+                fill_mapped_pbo_up_stage_.get()
+                ));
 
-        host_upload_executor->push_back(PipelineStageExecution(
-            copy_host_to_mapped_pbo_up_stage_.get(),
-            frame_composition_input_stage_.get()
-            ));
+            unmap_pbo_up_stage_ = utils::make_unique<UnmapPBOStage>(
+                unmap_to_unpack_pbo_ids,
+                origin_format_,
+                *fill_mapped_pbo_up_stage_,
+                enable_upload_gl_timer_queries_,
+                impl_use_arb_persistent_mapping_);
 
-        unmap_pbo_up_stage_ = utils::make_unique<UnmapPBOStage>(
-            unmap_to_unpack_pbo_ids,
-            origin_format_,
-            *copy_host_to_mapped_pbo_up_stage_,
-            enable_upload_gl_timer_queries_,
-            impl_use_arb_persistent_mapping_);
+            gl_upload_executor->push_back(PipelineStageExecution(
+                unmap_pbo_up_stage_.get(),
+                fill_mapped_pbo_up_stage_.get()
+                ));
 
-        gl_upload_executor->push_back(PipelineStageExecution(
-            unmap_pbo_up_stage_.get(),
-            copy_host_to_mapped_pbo_up_stage_.get()
-            ));
+        } else {
+
+            frame_composition_input_stage_ = utils::make_unique<FrameCompositionInputStage>(
+                ProgramOptions::global().frame_input_pipeline_size()
+                );
+
+            host_upload_executor->push_back(PipelineStageExecution(
+                frame_composition_input_stage_.get()
+                ));
+
+            copy_host_to_mapped_pbo_up_stage_ = utils::make_unique<CopyHostToMappedPBOStage>(
+                copy_to_unmap_pbo_ids,
+                origin_format_,
+                *frame_composition_input_stage_,
+                !ProgramOptions::global().enable_host_copy_upload(),
+                impl_use_arb_persistent_mapping_);
+
+            host_upload_executor->push_back(PipelineStageExecution(
+                copy_host_to_mapped_pbo_up_stage_.get(),
+                frame_composition_input_stage_.get()
+                ));
+
+            unmap_pbo_up_stage_ = utils::make_unique<UnmapPBOStage>(
+                unmap_to_unpack_pbo_ids,
+                origin_format_,
+                *copy_host_to_mapped_pbo_up_stage_,
+                enable_upload_gl_timer_queries_,
+                impl_use_arb_persistent_mapping_);
+
+            gl_upload_executor->push_back(PipelineStageExecution(
+                unmap_pbo_up_stage_.get(),
+                copy_host_to_mapped_pbo_up_stage_.get()
+                ));
+
+        }
 
         unpack_pbo_to_texture_stage_ = utils::make_unique<UnpackPBOToTextureStage>(
             ProgramOptions::global().source_texture_rr_count(),
@@ -1234,27 +1495,45 @@ void fb::StreamDispatch::define_pipeline() {
             ProgramOptions::global().pipeline_download_pack_to_map_load_constraint_count()
             ));
 
-        copy_mapped_pbo_down_stage = std::unique_ptr<CopyMappedPBOToHostStage>(
-            new CopyMappedPBOToHostStage(
-                ProgramOptions::global().frame_output_cache_count(),
-                origin_format_,
-                *map_pbo_down_stage_,
-                !ProgramOptions::global().enable_host_copy_download()
-            ));
+        if (impl_zero_copy_output_) {
 
-        host_download_executor->push_back(PipelineStageExecution(
-            copy_mapped_pbo_down_stage.get(),
-            map_pbo_down_stage_.get()
-            ));
+            // Callbacks read straight from the mapped PBO, which goes back
+            // to the map stage once the callback returned.
+            mapped_pbo_output_stage_ = std::unique_ptr<MappedPBOOutputStage>(
+                new MappedPBOOutputStage(
+                    origin_format_,
+                    *map_pbo_down_stage_));
 
-        frame_composition_output_stage_ = std::unique_ptr<FrameCompositionOutputStage>(
-            new FrameCompositionOutputStage(
-                *copy_mapped_pbo_down_stage));
+            host_download_executor->push_back(PipelineStageExecution(
+                mapped_pbo_output_stage_.get(),
+                map_pbo_down_stage_.get()
+                ));
 
-        host_download_executor->push_back(PipelineStageExecution(
-            frame_composition_output_stage_.get(),
-            copy_mapped_pbo_down_stage.get()
-            ));
+        } else {
+
+            copy_mapped_pbo_down_stage = std::unique_ptr<CopyMappedPBOToHostStage>(
+                new CopyMappedPBOToHostStage(
+                    ProgramOptions::global().frame_output_cache_count(),
+                    origin_format_,
+                    *map_pbo_down_stage_,
+                    !ProgramOptions::global().enable_host_copy_download()
+                ));
+
+            host_download_executor->push_back(PipelineStageExecution(
+                copy_mapped_pbo_down_stage.get(),
+                map_pbo_down_stage_.get()
+                ));
+
+            frame_composition_output_stage_ = std::unique_ptr<FrameCompositionOutputStage>(
+                new FrameCompositionOutputStage(
+                    *copy_mapped_pbo_down_stage));
+
+            host_download_executor->push_back(PipelineStageExecution(
+                frame_composition_output_stage_.get(),
+                copy_mapped_pbo_down_stage.get()
+                ));
+
+        }
 
         if (impl_use_multiple_gl_contexts_)
             gl_shared_context_download_async_->detach();
@@ -1323,6 +1602,66 @@ std::string fb::StreamDispatch::executions_to_string(const std::vector<PipelineS
 
 }
 
+void fb::StreamDispatch::attach_wake_samplers() {
+
+    std::map<StageExecutionState, std::string> name_overrides;
+    name_overrides[StageExecutionState::TASK_BEGIN] = "WAKE_SIGNALED";
+    name_overrides[StageExecutionState::TASK_END] = "WOKEN_UP";
+
+    const std::vector<PipelineStageExecution>* all_executions[] = {
+        &host_copy_input_async_thread_stages_,
+        &gl_upload_async_thread_stages_,
+        &gl_master_thread_stages_,
+        &gl_download_async_thread_stages_,
+        &host_copy_output_async_thread_stages_
+    };
+
+    for (auto executions : all_executions) {
+
+        for (const auto& execution : *executions) {
+
+            auto sampler = utils::make_unique<StageSampler>(name_overrides);
+            StageSampler* sampler_ptr = sampler.get();
+
+            execution.stage->set_wake_sampler(
+                [sampler_ptr](const clock::time_point& signaled, const clock::time_point& woken) {
+                    sampler_ptr->enter_sample(StageExecutionState::TASK_BEGIN, signaled);
+                    sampler_ptr->enter_sample(StageExecutionState::TASK_END, woken);
+                });
+
+            wake_samplers_.push_back(std::make_pair(execution.stage->name() + " (wake)", std::move(sampler)));
+        }
+
+    }
+
+}
+
+void fb::StreamDispatch::attach_queue_samplers() {
+
+    const std::vector<PipelineStageExecution>* all_executions[] = {
+        &host_copy_input_async_thread_stages_,
+        &gl_upload_async_thread_stages_,
+        &gl_master_thread_stages_,
+        &gl_download_async_thread_stages_,
+        &host_copy_output_async_thread_stages_
+    };
+
+    for (auto executions : all_executions) {
+
+        for (const auto& execution : *executions) {
+
+            auto samplers = execution.stage->sample_input_queues();
+
+            std::move(
+                std::begin(samplers), 
+                std::end(samplers), 
+                std::back_inserter(queue_samplers_));
+        }
+
+    }
+
+}
+
 void fb::StreamDispatch::run_pipeline_stages(
     const std::vector<PipelineStageExecution>& executions,
     const std::string& name) 
@@ -1442,6 +1781,32 @@ void fb::StreamDispatch::run_pipeline_stages(
 
 }
 
+const fb::StageSampler& fb::StreamDispatch::input_sampler() const
+{
+
+    if (!enable_input_stages_)
+        return by_pass_upload_stage_->sampler();
+
+    if (fill_mapped_pbo_up_stage_)
+        return fill_mapped_pbo_up_stage_->sampler();
+
+    return frame_composition_input_stage_->sampler();
+
+}
+
+const fb::StageSampler& fb::StreamDispatch::output_sampler() const
+{
+
+    if (!enable_output_stages_)
+        return by_pass_download_stage_->sampler();
+
+    if (mapped_pbo_output_stage_)
+        return mapped_pbo_output_stage_->sampler();
+
+    return frame_composition_output_stage_->sampler();
+
+}
+
 void fb::StreamDispatch::wait_for_composition()
 {
 
@@ -1585,6 +1950,33 @@ void fb::StreamDispatch::execute_host_copy_output_async() {
 
 }
 
+void fb::StreamDispatch::execute_host_stage_scheduler() {
+
+    static const std::string name = "host_stage_scheduler";
+
+    try {
+
+        wait_for_composition();
+
+        host_stage_scheduler_->run();
+
+        FB_LOG_DEBUG 
+            << "Thread '" << name << "' ('" 
+            << std::this_thread::get_id() << "') is done.";
+
+        // Takes over from host_copy_output_async
+        if (impl_async_output_) {
+            FB_LOG_DEBUG << "Calling completion handler from " << name << ".";
+            if (active_composition_completion_handler_)
+                active_composition_completion_handler_();
+        }
+
+    } catch (const std::exception& e) {
+        FB_LOG_CRITICAL << "Thread '" << name << "' caught exception: '" << e.what() << "'.";
+    }    
+
+}
+
 fb::PboMemVector fb::StreamDispatch::create_and_initialize_pbos(
     size_t num,
     size_t byte_size,
@@ -1691,6 +2083,12 @@ std::ostream& fb::operator<< (std::ostream& out, const fb::StreamDispatch::Flags
     case StreamDispatch::Flags::COPY_PBO_BEFORE_DOWNLOAD:
         out << "COPY_PBO_BEFORE_DOWNLOAD";
         break;
+    case StreamDispatch::Flags::ZERO_COPY_OUTPUT:
+        out << "ZERO_COPY_OUTPUT";
+        break;
+    case StreamDispatch::Flags::ZERO_COPY_INPUT:
+        out << "ZERO_COPY_INPUT";
+        break;
     default:
         out << "<unknown>";
         break;
@@ -1717,6 +2115,10 @@ std::istream& fb::operator>>(std::istream& in, StreamDispatch::Flags& v) {
         v = fb::StreamDispatch::Flags::ARB_PERSISTENT_MAPPING;
     else if (token == "COPY_PBO_BEFORE_DOWNLOAD")
         v = fb::StreamDispatch::Flags::COPY_PBO_BEFORE_DOWNLOAD;
+    else if (token == "ZERO_COPY_OUTPUT")
+        v = fb::StreamDispatch::Flags::ZERO_COPY_OUTPUT;
+    else if (token == "ZERO_COPY_INPUT")
+        v = fb::StreamDispatch::Flags::ZERO_COPY_INPUT;
     else {
         in.setstate(std::ios::failbit);
     }
@@ -46,6 +46,9 @@ namespace toa {
 
         class StreamRenderer;
         class StreamSource;
+        class StageSampler;
+        class StageScheduler;
+        class TraceStream;
 
         class FrameCompositionInputStage;
         class CopyHostToMappedPBOStage;
@@ -60,6 +63,8 @@ namespace toa {
         class ByPassUploadStage;
 
         class FrameCompositionOutputStage;
+        class MappedPBOOutputStage;
+        class FillMappedPBOStage;
 
         class StreamDispatch final : utils::NoCopyingOrMoving {
 
@@ -87,6 +92,16 @@ namespace toa {
                 // Might improve performance on NVIDIA cards
                 COPY_PBO_BEFORE_DOWNLOAD,
 
+                // output callbacks get a read-only view into the mapped 
+                // download PBO instead of a host copy, best combined with 
+                // ARB_PERSISTENT_MAPPING
+                ZERO_COPY_OUTPUT,
+
+                // sources which support it write their frames straight into
+                // the mapped upload PBO, instead of a host frame which is 
+                // copied afterwards
+                ZERO_COPY_INPUT,
+
                 COUNT
             };
 
@@ -152,7 +167,22 @@ namespace toa {
                 const std::string& file_path, 
                 const std::string& configurat_name_prefix);
 
+            // Adds the samples of something outside of the dispatch (e.g. 
+            // the FrameWriter) to the trace file. The sampler must outlive 
+            // the next write_trace_file() call.
+            void add_trace_sampler(std::string name, const StageSampler& sampler);
+
+            // Streams all events into stream while running, instead of the 
+            // first StageSampler::kNumMaxTraceEvents only. write_trace_file()
+            // then finishes the stream instead of writing a file of its own.
+            // Call after create_composition() and add_trace_sampler().
+            void stream_trace_file(TraceStream& stream);
+
         private:
+
+            // Everything that goes into the trace file (except the FramePool),
+            // in the order of the pipeline.
+            std::vector<std::pair<std::string, const StageSampler*>> trace_samplers(bool include_idle_wake_samplers);
              
             enum class TransferDirection {
                 UPLOAD,
@@ -176,12 +206,25 @@ namespace toa {
             void execute_gl_master();
             void execute_gl_download_async();
             void execute_host_copy_output_async();
+            void execute_host_stage_scheduler();
 
             void initialize_gl_buffers();
             void define_pipeline();
 
+            // Samples the wake-up latency of every stage that was defined
+            void attach_wake_samplers();
+
+            // Samples the occupancy and dwell times of the queues between 
+            // the stages that were defined
+            void attach_queue_samplers();
+
             void wait_for_composition();
 
+            // First and last stage of the pipeline, depending on which 
+            // input and output stages are in use
+            const StageSampler& input_sampler() const;
+            const StageSampler& output_sampler() const;
+
             StreamComposition::ID get_unique_id_for_name(const std::string& name) const;
 
             std::string name_;
@@ -239,10 +282,16 @@ namespace toa {
             std::thread host_copy_output_async_thread_;
             std::vector<PipelineStageExecution> host_copy_output_async_thread_stages_;
 
+            // Runs the stages of both host_copy_*_async phases instead of 
+            // their threads, if pipeline.host_worker_count is set
+            std::thread host_stage_scheduler_thread_;
+            std::unique_ptr<StageScheduler> host_stage_scheduler_;
+
             std::unique_ptr<ByPassUploadStage> by_pass_upload_stage_;
 
             std::unique_ptr<FrameCompositionInputStage> frame_composition_input_stage_;
             std::unique_ptr<CopyHostToMappedPBOStage> copy_host_to_mapped_pbo_up_stage_;
+            std::unique_ptr<FillMappedPBOStage> fill_mapped_pbo_up_stage_;
             std::unique_ptr<UnmapPBOStage> unmap_pbo_up_stage_;
 
             std::unique_ptr<UnpackPBOToTextureStage> unpack_pbo_to_texture_stage_;
@@ -253,9 +302,20 @@ namespace toa {
             std::unique_ptr<MapPBOStage> map_pbo_down_stage_;
             std::unique_ptr<CopyMappedPBOToHostStage> copy_mapped_pbo_down_stage;
             std::unique_ptr<FrameCompositionOutputStage> frame_composition_output_stage_;
+            std::unique_ptr<MappedPBOOutputStage> mapped_pbo_output_stage_;
             
             std::unique_ptr<ByPassDownloadStage> by_pass_download_stage_;
 
+            // Named after the stage they sample, in pipeline order
+            std::vector<std::pair<std::string, std::unique_ptr<StageSampler>>> wake_samplers_;
+
+            // Two per pair of connected stages, in pipeline order
+            std::vector<std::unique_ptr<FifoSampler>> queue_samplers_;
+
+            std::vector<std::pair<std::string, const StageSampler*>> external_samplers_;
+
+            TraceStream* trace_stream_;
+
             gl::Context * const gl_context_master_;
             std::unique_ptr<gl::Context> gl_shared_context_upload_async_;
             std::unique_ptr<gl::Context> gl_shared_context_download_async_;
@@ -282,6 +342,8 @@ namespace toa {
             bool impl_async_output_;
             bool impl_use_arb_persistent_mapping_;
             bool impl_copy_pbo_before_download_;
+            bool impl_zero_copy_output_;
+            bool impl_zero_copy_input_;
 
             gl::utils::GLInfo gl_info_;
 
@@ -27,13 +27,191 @@
 #include "StreamSource.h"
 #include "Logging.h"
 #include "ProgramOptions.h"
+#include "StageSampler.h"
+#include "SequenceContainer.h"
+#include "FrameCodec.h"
+#include "WorkerPool.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace bf = boost::filesystem;
 namespace fb = toa::frame_bender;
 
+namespace {
+
+    // Returns the files within frame_folder (relative to the global 
+    // program.sequences_location) that match regex_pattern, in order.
+    std::vector<bf::path> list_sequence_files(
+        const std::string& frame_folder,
+        const std::string& regex_pattern) 
+    {
+
+        bf::path frames_folder_path = bf::path(fb::ProgramOptions::global().input_sequences_folder());
+        frames_folder_path /= bf::path(frame_folder);
+
+        if (!bf::exists(frames_folder_path))
+            throw std::invalid_argument("Path '" + frames_folder_path.string() +"' does not exist.");
+
+        if (!bf::is_directory(frames_folder_path))
+            throw std::invalid_argument("Path '" + frame_folder +"' is not a folder.");
+
+        std::vector<bf::path> filtered_files;
+
+        std::regex frame_pattern_regex(regex_pattern);
+
+        for (auto it = bf::directory_iterator(frames_folder_path); it != bf::directory_iterator(); ++it) {
+
+            if (std::regex_match(it->path().filename().string(), frame_pattern_regex))
+                filtered_files.push_back(it->path());
+
+        }
+
+        if (filtered_files.empty()) {
+            FB_LOG_ERROR << "No files in folder '" << frames_folder_path << "' matched with pattern '" << regex_pattern << "'.";
+            throw std::runtime_error("Input sequence is empty.");
+        }
+
+        std::sort(std::begin(filtered_files), std::end(filtered_files));
+
+        return filtered_files;
+    }
+
+    void check_frame_file_size(
+        const bf::path& file_path, 
+        const fb::ImageFormat& image_format) 
+    {
+
+        auto byte_size = bf::file_size(file_path);
+
+        if (image_format.image_byte_size() != byte_size) {
+            FB_LOG_ERROR 
+                << "Unexpected byte size of image on disk vs. specified format. "
+                << "Disk: " << byte_size << " bytes, format requires " 
+                << image_format.image_byte_size() << " bytes. Format: ["
+                << image_format << "].";
+            throw std::runtime_error("Invalid image size. Check format.");
+        }
+
+    }
+
+#ifndef _WIN32
+
+    // Unmaps the payloads of frames that MmapImageSequence created
+    class MappedFrameMemory : public fb::FrameMemoryOwner {
+    public:
+        void release(uint8_t* data, size_t byte_size) override {
+            if (::munmap(data, byte_size) != 0) {
+                FB_LOG_ERROR << "Could not unmap frame memory: " << std::strerror(errno);
+            }
+        }
+    };
+
+    // Never destroyed, frames might still be released during static 
+    // destruction.
+    MappedFrameMemory* const mapped_frame_memory = new MappedFrameMemory();
+
+    // Maps byte_size bytes of the open file at offset (which must be 
+    // page-aligned) as a frame's payload. The mapping keeps the file 
+    // referenced, even after fd has been closed.
+    fb::FrameMemoryPtr map_frame(
+        int fd, 
+        uint64_t offset, 
+        size_t byte_size, 
+        const std::string& file_path) 
+    {
+
+        // Private, so that frames stay writable without ever touching the 
+        // file.
+        void* data = ::mmap(nullptr, byte_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, static_cast<off_t>(offset));
+
+        if (data == MAP_FAILED) {
+            FB_LOG_ERROR << "Could not map frame of '" << file_path << "' at " << offset << ": " << std::strerror(errno);
+            throw std::runtime_error("Could not map frame.");
+        }
+
+        // Starts reading the pages in the background, so that they are 
+        // resident by the time the frame gets uploaded.
+        if (::madvise(data, byte_size, MADV_WILLNEED) != 0) {
+            FB_LOG_DEBUG << "madvise(MADV_WILLNEED) failed for '" << file_path << "': " << std::strerror(errno);
+        }
+
+        return fb::FrameMemoryPtr(
+            static_cast<uint8_t*>(data), 
+            fb::FrameMemoryDeleter(mapped_frame_memory, byte_size));
+
+    }
+
+    fb::FrameMemoryPtr map_frame_file(const std::string& file_path, size_t byte_size) {
+
+        int fd = ::open(file_path.c_str(), O_RDONLY);
+
+        if (fd < 0) {
+            FB_LOG_ERROR << "Could not open frame '" << file_path << "': " << std::strerror(errno);
+            throw std::runtime_error("Could not open frame file.");
+        }
+
+        fb::FrameMemoryPtr data;
+
+        try {
+            data = map_frame(fd, 0, byte_size, file_path);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+
+        ::close(fd);
+
+        return data;
+
+    }
+
+#endif
+
+#ifdef __linux__
+
+    // O_DIRECT transfers must be aligned to the logical block size of the
+    // device, which is at most a page.
+    const size_t kDirectIoAlignment = 4096;
+
+    // Only warn once about a fallback, not for every frame
+    std::atomic<bool> has_warned_about_direct_io(false);
+
+    // Returns the number of bytes read, which is less than byte_size on
+    // errors (errno is set) or if the file is shorter.
+    size_t pread_fully(int fd, uint8_t* data, size_t byte_size, size_t offset) {
+
+        size_t num_read = 0;
+        errno = 0;
+
+        while (num_read < byte_size) {
+
+            ssize_t result = ::pread(fd, data + num_read, byte_size - num_read, offset + num_read);
+
+            if (result < 0 && errno == EINTR)
+                continue;
+
+            if (result <= 0)
+                break;
+
+            num_read += static_cast<size_t>(result);
+        }
+
+        return num_read;
+    }
+
+#endif
+
+}
+
 fb::StreamSource::StreamSource(std::string name)
     : name_(std::move(name)), state_(State::INITIALIZED)
 
@@ -51,7 +229,7 @@ bool fb::StreamSource::pop_frame(Frame& out_frame) {
         throw std::runtime_error("Can't pop frame for invalid reader state in '" + name_ + "'.");
     }
 
-    bool success = input_queue_->pop(out_frame);
+    bool success = input_queue_->pop(out_frame) || wait_for_frame(out_frame);
 
     if (success) {
 
@@ -76,6 +254,35 @@ void fb::StreamSource::invalidate_frame(Frame&& f) {
     // does nothing
 }
 
+bool fb::StreamSource::wait_for_frame(Frame&) {
+    return false;
+}
+
+bool fb::StreamSource::fill_frame(uint8_t* data, const ImageFormat& format, Time& time) {
+
+    if (!can_fill_in_place()) {
+        FB_LOG_ERROR << "Source '" << name_ << "' can't fill frames in place.";
+        throw std::runtime_error("Source '" + name_ + "' can't fill frames in place.");
+    }
+
+    if (state_ == State::INITIALIZED || state_ == State::END_OF_STREAM) {
+        throw std::runtime_error("Can't fill frame for invalid reader state in '" + name_ + "'.");
+    }
+
+    bool success = fill_next_frame(data, format, time);
+
+    if (!success) {
+        FB_LOG_ERROR << "StreamSource exhausted, could not fill frame.";
+    }
+
+    return success;
+}
+
+bool fb::StreamSource::fill_next_frame(uint8_t*, const ImageFormat&, Time&) {
+    // Not reached, fill_frame() checks can_fill_in_place() first
+    return false;
+}
+
 std::ostream& fb::operator<< (std::ostream& out, const fb::StreamSource::State& v)
 {
 
@@ -103,6 +310,66 @@ std::ostream& fb::operator<< (std::ostream& out, const fb::StreamSource::State&
 
 }
 
+std::ostream& fb::operator<< (std::ostream& out, const fb::SequenceReader& v)
+{
+
+    switch (v) {
+
+        case fb::SequenceReader::PREFETCH:
+            out << "prefetch";
+            break;
+
+        case fb::SequenceReader::MMAP:
+            out << "mmap";
+            break;
+
+        case fb::SequenceReader::STREAM:
+            out << "stream";
+            break;
+
+        case fb::SequenceReader::CONTAINER:
+            out << "container";
+            break;
+
+        case fb::SequenceReader::COMPRESSED:
+            out << "compressed";
+            break;
+
+        default:
+            out << "<unknown>";
+            break;
+
+    }
+
+    return out;
+
+}
+
+std::istream& fb::operator>>(std::istream& in, fb::SequenceReader& v) {
+
+    std::string token;
+    in >> token;
+
+    std::transform(token.begin(), token.end(),token.begin(), ::tolower);
+
+    if (token == "prefetch")
+        v = SequenceReader::PREFETCH;
+    else if (token == "mmap")
+        v = SequenceReader::MMAP;
+    else if (token == "stream")
+        v = SequenceReader::STREAM;
+    else if (token == "container")
+        v = SequenceReader::CONTAINER;
+    else if (token == "compressed")
+        v = SequenceReader::COMPRESSED;
+    else {
+        in.setstate(std::ios::failbit);
+    }
+
+    return in;
+
+}
+
 fb::PrefetchedImageSequence::PrefetchedImageSequence(
     const std::string& frame_folder,
     const std::string& regex_pattern,
@@ -117,45 +384,11 @@ fb::PrefetchedImageSequence::PrefetchedImageSequence(
 
 {
     
-    bf::path frames_folder_path = bf::path(ProgramOptions::global().input_sequences_folder());
-    frames_folder_path /= bf::path(frame_folder);
-
-    if (!bf::exists(frames_folder_path))
-        throw std::invalid_argument("Path '" + frames_folder_path.string() +"' does not exist.");
-
-    if (!bf::is_directory(frames_folder_path))
-        throw std::invalid_argument("Path '" + frame_folder +"' is not a folder.");
-
-    // iterator of the file system
-    auto dir_start = bf::directory_iterator(frames_folder_path);
-
-    std::vector<bf::directory_entry> filtered_files;
-
-    std::regex frame_pattern_regex(regex_pattern);
-
-    std::copy_if(
-        dir_start, 
-        bf::directory_iterator(), 
-        std::back_inserter(filtered_files),
-        [&](const bf::directory_entry& entry) {
-
-            bool does_match = std::regex_match(
-                entry.path().filename().string(), 
-                frame_pattern_regex);
-
-            return does_match;
-    });
-
-    if (filtered_files.empty()) {
-        FB_LOG_ERROR << "No files in folder '" << frames_folder_path << "' matched with pattern '" << regex_pattern << "'.";
-        throw std::runtime_error("Input sequence is empty.");
-    }
-
-    std::sort(std::begin(filtered_files), std::end(filtered_files));
+    auto filtered_files = list_sequence_files(frame_folder, regex_pattern);
 
     uintmax_t total_size = 0;
     for (const auto& entry : filtered_files)
-        total_size += bf::file_size(entry.path());
+        total_size += bf::file_size(entry);
 
     FB_LOG_INFO << 
         "Prefetching " << filtered_files.size() << " frames from folder '" 
@@ -174,7 +407,7 @@ fb::PrefetchedImageSequence::PrefetchedImageSequence(
     
     end_time_stamp_ = frame_duration_ * (filtered_files.size() * loop_count_ -1);
 
-    for (const auto& frame_dir_entry : filtered_files) {
+    for (const auto& frame_file : filtered_files) {
 
         Frame f(
             image_format,
@@ -184,19 +417,10 @@ fb::PrefetchedImageSequence::PrefetchedImageSequence(
         
         time_stamp += frame_duration;
 
-        auto byte_size = bf::file_size(frame_dir_entry.path());
-
-        if (f.image_data_size() != byte_size) {
-            FB_LOG_ERROR 
-                << "Unexpected byte size of image on disk vs. specified format. "
-                << "Disk: " << byte_size << " bytes, format requires " 
-                << f.image_data_size() << " bytes. Format: ["
-                << f.image_format() << "].";
-            throw std::runtime_error("Invalid image size. Check format.");
-        }
+        check_frame_file_size(frame_file, image_format);
 
         bf::ifstream frame_reader(
-            frame_dir_entry.path(),
+            frame_file,
             std::ios::in | std::ios::binary);
 
         FB_ASSERT(frame_reader.good());
@@ -262,3 +486,922 @@ void fb::PrefetchedImageSequence::invalidate_frame(Frame&& f) {
 
 }
 
+
+
+const size_t fb::MmapImageSequence::kDefaultPrefetchCount;
+
+fb::MmapImageSequence::MmapImageSequence(
+    const std::string& frame_folder,
+    const std::string& regex_pattern,
+    const ImageFormat& image_format,
+    const Time& frame_duration,
+    size_t loop_count,
+    size_t prefetch_count) :
+        StreamSource("Mmap ('" + frame_folder + "/" + regex_pattern +"')"),
+        image_format_(image_format),
+        frame_duration_(frame_duration),
+        loop_count_(loop_count),
+        prefetch_count_(prefetch_count),
+        next_frame_index_(0)
+{
+
+#ifdef _WIN32
+    FB_LOG_ERROR << "Memory-mapped image sequences are not supported on this platform.";
+    throw std::runtime_error("MmapImageSequence is not supported on Windows.");
+#else
+
+    if (prefetch_count_ == 0 || prefetch_count_ > input_queue_->size()) {
+        FB_LOG_ERROR 
+            << "Invalid prefetch count " << prefetch_count_ 
+            << ", must be within [1, " << input_queue_->size() << "].";
+        throw std::invalid_argument("Invalid prefetch count.");
+    }
+
+    if (loop_count_ == 0)
+        throw std::invalid_argument("Loop count must not be zero.");
+
+    auto filtered_files = list_sequence_files(frame_folder, regex_pattern);
+
+    // Only stats the files, the contents are read on demand
+    for (const auto& frame_file : filtered_files) {
+        check_frame_file_size(frame_file, image_format_);
+        frame_files_.push_back(frame_file.string());
+    }
+
+    FB_LOG_INFO << 
+        "Mapping " << frame_files_.size() << " frames from folder '" 
+        << frame_folder << "' with pattern '" << regex_pattern << "' on demand, "
+        << "prefetching " << prefetch_count_ << " frames.";
+
+    FB_LOG_INFO << "First frame : '" << frame_files_.front() << "'.";
+    FB_LOG_INFO << "Last frame : '" << frame_files_.back() << "'.";
+
+    FB_LOG_INFO << "Frame duration is '" << frame_duration_ << "'.";
+
+    size_t cnt = 0;
+    while (cnt < prefetch_count_ && queue_next_frame())
+        cnt++;
+
+    FB_LOG_INFO << "Preheated fifo with " << cnt << " mapped frames.";
+
+    state_ = State::READY_TO_READ;
+
+#endif
+
+}
+
+bool fb::MmapImageSequence::queue_next_frame() {
+
+    if (next_frame_index_ == num_frames())
+        return false;
+
+#ifdef _WIN32
+    return false;
+#else
+
+    const std::string& file_path = frame_files_[next_frame_index_ % frame_files_.size()];
+
+    Frame f(
+        image_format_,
+        frame_duration_ * static_cast<int64_t>(next_frame_index_),
+        next_frame_index_ + 1 == num_frames(),
+        map_frame_file(file_path, image_format_.image_byte_size()));
+
+    // We are the only thread working on the queue, see 
+    // PrefetchedImageSequence
+    bool success = input_queue_->push(std::move(f));
+    FB_ASSERT(success);
+
+    next_frame_index_++;
+
+    return true;
+
+#endif
+
+}
+
+void fb::MmapImageSequence::frame_has_been_used(const Frame& frame) {
+
+    // Keeps the prefetch window filled
+    queue_next_frame();
+
+    if (frame.marks_end_of_sequence()) {
+        FB_ASSERT(state_ == State::READY_TO_READ);
+        state_ = State::END_OF_STREAM;
+    }
+
+}
+
+void fb::MmapImageSequence::invalidate_frame(Frame&& f) {
+
+    Frame released(std::move(f));
+
+}
+
+const size_t fb::StreamingImageSequence::kDefaultReadAheadCount;
+
+fb::StreamingImageSequence::StreamingImageSequence(
+    const std::string& frame_folder,
+    const std::string& regex_pattern,
+    const ImageFormat& image_format,
+    const Time& frame_duration,
+    size_t loop_count,
+    size_t read_ahead_count,
+    bool use_direct_io) :
+        StreamSource("Stream ('" + frame_folder + "/" + regex_pattern +"')"),
+        image_format_(image_format),
+        frame_duration_(frame_duration),
+        loop_count_(loop_count),
+        read_ahead_count_(read_ahead_count),
+        use_direct_io_(use_direct_io),
+        stop_requested_(false),
+        reader_is_done_(false),
+        num_underruns_(0),
+        underrun_time_(clock::duration::zero())
+{
+
+    if (read_ahead_count_ == 0 || read_ahead_count_ > input_queue_->size()) {
+        FB_LOG_ERROR 
+            << "Invalid read-ahead count " << read_ahead_count_ 
+            << ", must be within [1, " << input_queue_->size() << "].";
+        throw std::invalid_argument("Invalid read-ahead count.");
+    }
+
+    if (loop_count_ == 0)
+        throw std::invalid_argument("Loop count must not be zero.");
+
+#ifndef __linux__
+    if (use_direct_io_) {
+        FB_LOG_WARNING << "Direct I/O is not supported on this platform, reading through the file cache.";
+        use_direct_io_ = false;
+    }
+#endif
+
+    auto filtered_files = list_sequence_files(frame_folder, regex_pattern);
+
+    for (const auto& frame_file : filtered_files) {
+        check_frame_file_size(frame_file, image_format_);
+        frame_files_.push_back(frame_file.string());
+    }
+
+    if (ProgramOptions::global().sample_stages()) {
+
+        std::map<StageExecutionState, std::string> name_overrides;
+        name_overrides[StageExecutionState::EXECUTE_BEGIN] = "READ_BEGIN";
+        name_overrides[StageExecutionState::EXECUTE_END] = "READ_END";
+        name_overrides[StageExecutionState::TASK_BEGIN] = "UNDERRUN_BEGIN";
+        name_overrides[StageExecutionState::TASK_END] = "UNDERRUN_END";
+
+        sampler_ = utils::make_unique<StageSampler>(name_overrides);
+    }
+
+    FB_LOG_INFO << 
+        "Streaming " << frame_files_.size() << " frames from folder '" 
+        << frame_folder << "' with pattern '" << regex_pattern << "', reading "
+        << read_ahead_count_ << " frames ahead" 
+        << (use_direct_io_ ? " with direct I/O." : ".");
+
+    FB_LOG_INFO << "First frame : '" << frame_files_.front() << "'.";
+    FB_LOG_INFO << "Last frame : '" << frame_files_.back() << "'.";
+
+    FB_LOG_INFO << "Frame duration is '" << frame_duration_ << "'.";
+
+    reader_thread_ = std::thread(&StreamingImageSequence::read_frames, this);
+
+    // Fill the read-ahead window before anybody starts consuming
+    const size_t num_preheated = std::min(read_ahead_count_, num_frames());
+
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        frame_queued_.wait(lock, [&]() { 
+            return reader_is_done_ || input_queue_->had_num_elements() >= num_preheated; 
+        });
+    }
+
+    if (reader_error_) {
+        reader_thread_.join();
+        std::rethrow_exception(reader_error_);
+    }
+
+    FB_LOG_INFO << "Preheated fifo with " << input_queue_->had_num_elements() << " frames.";
+
+    state_ = State::READY_TO_READ;
+}
+
+fb::StreamingImageSequence::~StreamingImageSequence() {
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_requested_ = true;
+    }
+
+    frame_consumed_.notify_one();
+
+    if (reader_thread_.joinable())
+        reader_thread_.join();
+
+    FB_LOG_INFO 
+        << name_ << ": " << num_underruns_ << " underruns, waited for " 
+        << boost::chrono::duration_cast<boost::chrono::milliseconds>(underrun_time_) 
+        << " in total.";
+
+}
+
+void fb::StreamingImageSequence::read_frames() {
+
+    try {
+
+        for (size_t idx = 0; idx < num_frames(); ++idx) {
+
+            {
+                std::unique_lock<std::mutex> lock(lock_);
+                frame_consumed_.wait(lock, [&]() { 
+                    return stop_requested_ || input_queue_->had_num_elements() < read_ahead_count_; 
+                });
+            }
+
+            if (stop_requested_)
+                break;
+
+            // From the global pool, so the memory of consumed frames is 
+            // reused once they have been invalidated.
+            Frame f(
+                image_format_,
+                frame_duration_ * static_cast<int64_t>(idx),
+                idx + 1 == num_frames());
+
+            if (sampler_)
+                sampler_->sample(StageExecutionState::EXECUTE_BEGIN);
+
+            read_frame_file(frame_files_[idx % frame_files_.size()], f);
+
+            if (sampler_)
+                sampler_->sample(StageExecutionState::EXECUTE_END);
+
+            // The reader is the only producer of the queue
+            bool success = input_queue_->push(std::move(f));
+            FB_ASSERT(success);
+
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+            }
+
+            frame_queued_.notify_one();
+
+        }
+
+    } catch (...) {
+
+        FB_LOG_ERROR << "Reading frames failed for '" << name_ << "'.";
+        reader_error_ = std::current_exception();
+
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        reader_is_done_ = true;
+    }
+
+    frame_queued_.notify_one();
+
+}
+
+void fb::StreamingImageSequence::read_frame_file(
+    const std::string& file_path, 
+    Frame& frame)
+{
+
+    const size_t byte_size = frame.image_data_size();
+
+#ifdef __linux__
+
+    bool is_direct = use_direct_io_ && MEM_IS_ALIGNED(frame.image_data(), kDirectIoAlignment);
+    bool direct_io_failed = false;
+
+    int fd = ::open(file_path.c_str(), O_RDONLY | (is_direct ? O_DIRECT : 0));
+
+    if (fd < 0 && is_direct && errno == EINVAL) {
+        // The file system doesn't support O_DIRECT at all
+        is_direct = false;
+        direct_io_failed = true;
+        fd = ::open(file_path.c_str(), O_RDONLY);
+    }
+
+    if (fd < 0) {
+        FB_LOG_ERROR << "Could not open frame '" << file_path << "': " << std::strerror(errno);
+        throw std::runtime_error("Could not open frame file.");
+    }
+
+    size_t num_read = 0;
+
+    if (is_direct) {
+
+        // Direct transfers have to be a multiple of the block size, the 
+        // remainder is read through the page cache below.
+        const size_t direct_size = byte_size & ~(kDirectIoAlignment - 1);
+
+        num_read = pread_fully(fd, frame.image_data(), direct_size, 0);
+
+        if (num_read < direct_size && errno == EINVAL) {
+            // Unsupported alignment for this device
+            direct_io_failed = true;
+        }
+
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_DIRECT);
+    }
+
+    num_read += pread_fully(fd, frame.image_data() + num_read, byte_size - num_read, num_read);
+    int read_error = errno;
+
+    ::close(fd);
+
+    if (direct_io_failed) {
+
+        // Don't try again for the following frames
+        use_direct_io_ = false;
+
+        if (!has_warned_about_direct_io.exchange(true)) {
+            FB_LOG_WARNING << "Direct I/O is not supported for '" << file_path << "', reading through the file cache.";
+        }
+    }
+
+    if (num_read != byte_size) {
+        FB_LOG_ERROR 
+            << "Could only read " << num_read << " of " << byte_size 
+            << " bytes of frame '" << file_path << "'" 
+            << (read_error != 0 ? ": " + std::string(std::strerror(read_error)) : ".");
+        throw std::runtime_error("Could not read frame file.");
+    }
+
+#else
+
+    bf::ifstream frame_reader(
+        bf::path(file_path),
+        std::ios::in | std::ios::binary);
+
+    frame_reader.read(
+        reinterpret_cast<char*>(frame.image_data()), 
+        byte_size);
+
+    if (!frame_reader.good()) {
+        FB_LOG_ERROR << "Could not read frame '" << file_path << "'.";
+        throw std::runtime_error("Could not read frame file.");
+    }
+
+#endif
+
+}
+
+bool fb::StreamingImageSequence::wait_for_frame(Frame& out_frame) {
+
+    const clock::time_point underrun_begin = clock::now();
+
+    bool success = false;
+
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        frame_queued_.wait(lock, [&]() { 
+            success = input_queue_->pop(out_frame);
+            return success || reader_is_done_;
+        });
+    }
+
+    if (reader_error_)
+        std::rethrow_exception(reader_error_);
+
+    const clock::time_point underrun_end = clock::now();
+
+    num_underruns_++;
+    underrun_time_ += underrun_end - underrun_begin;
+
+    if (sampler_) {
+        sampler_->enter_sample(StageExecutionState::TASK_BEGIN, underrun_begin);
+        sampler_->enter_sample(StageExecutionState::TASK_END, underrun_end);
+    }
+
+    FB_LOG_DEBUG 
+        << name_ << ": Underrun, waited " 
+        << boost::chrono::duration_cast<boost::chrono::microseconds>(underrun_end - underrun_begin)
+        << " for the reader.";
+
+    return success;
+
+}
+
+void fb::StreamingImageSequence::frame_has_been_used(const Frame& frame) {
+
+    // Make room for the reader
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+    }
+
+    frame_consumed_.notify_one();
+
+    if (frame.marks_end_of_sequence()) {
+        FB_ASSERT(state_ == State::READY_TO_READ);
+        state_ = State::END_OF_STREAM;
+    }
+
+}
+
+void fb::StreamingImageSequence::invalidate_frame(Frame&& f) {
+
+    Frame released(std::move(f));
+
+}
+
+const size_t fb::CompressedImageSequence::kDefaultDecodeThreadCount;
+
+fb::CompressedImageSequence::CompressedImageSequence(
+    const std::string& frame_folder,
+    const std::string& regex_pattern,
+    const ImageFormat& image_format,
+    const Time& frame_duration,
+    size_t loop_count,
+    size_t read_ahead_count,
+    size_t decode_thread_count) :
+        StreamSource("Compressed ('" + frame_folder + "/" + regex_pattern +"')"),
+        compressed_data_size_(0),
+        image_format_(image_format),
+        frame_duration_(frame_duration),
+        loop_count_(loop_count),
+        read_ahead_count_(read_ahead_count),
+        stop_requested_(false),
+        decoder_is_done_(false),
+        num_underruns_(0),
+        underrun_time_(clock::duration::zero())
+{
+
+    if (read_ahead_count_ == 0 || read_ahead_count_ > input_queue_->size()) {
+        FB_LOG_ERROR 
+            << "Invalid read-ahead count " << read_ahead_count_ 
+            << ", must be within [1, " << input_queue_->size() << "].";
+        throw std::invalid_argument("Invalid read-ahead count.");
+    }
+
+    if (loop_count_ == 0)
+        throw std::invalid_argument("Loop count must not be zero.");
+
+    auto filtered_files = list_sequence_files(frame_folder, regex_pattern);
+
+    for (const auto& frame_file : filtered_files)
+        check_frame_file_size(frame_file, image_format_);
+
+    decode_pool_ = utils::make_unique<WorkerPool>(decode_thread_count);
+
+    FB_LOG_INFO << 
+        "Compressing " << filtered_files.size() << " frames from folder '" 
+        << frame_folder << "' with pattern '" << regex_pattern << "' on " 
+        << decode_pool_->num_workers() << " thread(s).";
+
+    FB_LOG_INFO << "First frame : '" << filtered_files.front() << "'.";
+    FB_LOG_INFO << "Last frame : '" << filtered_files.back() << "'.";
+
+    FB_LOG_INFO << "Frame duration is '" << frame_duration_ << "'.";
+
+    compressed_frames_.resize(filtered_files.size());
+
+    // Each worker reads into its own buffer and compresses from there, so 
+    // that only as many frames as there are workers are ever uncompressed
+    std::vector<std::vector<uint8_t>> read_buffers(decode_pool_->num_workers());
+
+    decode_pool_->run(filtered_files.size(), [&](size_t file_index, size_t worker_index) {
+
+        std::vector<uint8_t>& buffer = read_buffers[worker_index];
+        buffer.resize(image_format_.image_byte_size());
+
+        bf::ifstream frame_reader(
+            filtered_files[file_index],
+            std::ios::in | std::ios::binary);
+
+        frame_reader.read(
+            reinterpret_cast<char*>(buffer.data()), 
+            buffer.size());
+
+        if (!frame_reader.good()) {
+            FB_LOG_ERROR << "Could not read frame '" << filtered_files[file_index] << "'.";
+            throw std::runtime_error("Could not read frame file.");
+        }
+
+        compressed_frames_[file_index] = frame_codec::compress(buffer.data(), image_format_);
+
+    });
+
+    for (const auto& compressed_frame : compressed_frames_)
+        compressed_data_size_ += compressed_frame.size();
+
+    const uintmax_t uncompressed_size = static_cast<uintmax_t>(image_format_.image_byte_size()) * compressed_frames_.size();
+
+    FB_LOG_INFO 
+        << "Compressed " << std::setprecision(4) << static_cast<float>(uncompressed_size) / 1e6f 
+        << "mb into " << static_cast<float>(compressed_data_size_) / 1e6f << "mb, ratio " 
+        << static_cast<float>(uncompressed_size) / static_cast<float>(std::max<uintmax_t>(compressed_data_size_, 1)) << ":1.";
+
+    if (ProgramOptions::global().sample_stages()) {
+
+        std::map<StageExecutionState, std::string> name_overrides;
+        name_overrides[StageExecutionState::EXECUTE_BEGIN] = "DECOMPRESS_BEGIN";
+        name_overrides[StageExecutionState::EXECUTE_END] = "DECOMPRESS_END";
+        name_overrides[StageExecutionState::TASK_BEGIN] = "UNDERRUN_BEGIN";
+        name_overrides[StageExecutionState::TASK_END] = "UNDERRUN_END";
+
+        sampler_ = utils::make_unique<StageSampler>(name_overrides);
+    }
+
+    decoder_thread_ = std::thread(&CompressedImageSequence::decode_frames, this);
+
+    // Fill the read-ahead window before anybody starts consuming
+    const size_t num_preheated = std::min(read_ahead_count_, num_frames());
+
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        frame_queued_.wait(lock, [&]() { 
+            return decoder_is_done_ || input_queue_->had_num_elements() >= num_preheated; 
+        });
+    }
+
+    if (decoder_error_) {
+        decoder_thread_.join();
+        std::rethrow_exception(decoder_error_);
+    }
+
+    FB_LOG_INFO << "Preheated fifo with " << input_queue_->had_num_elements() << " frames.";
+
+    state_ = State::READY_TO_READ;
+}
+
+fb::CompressedImageSequence::~CompressedImageSequence() {
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_requested_ = true;
+    }
+
+    frame_consumed_.notify_one();
+
+    if (decoder_thread_.joinable())
+        decoder_thread_.join();
+
+    FB_LOG_INFO 
+        << name_ << ": " << num_underruns_ << " underruns, waited for " 
+        << boost::chrono::duration_cast<boost::chrono::milliseconds>(underrun_time_) 
+        << " in total.";
+
+}
+
+size_t fb::CompressedImageSequence::decode_thread_count() const {
+    return decode_pool_->num_workers();
+}
+
+void fb::CompressedImageSequence::decode_frames() {
+
+    try {
+
+        std::vector<Frame> batch;
+        std::vector<clock::time_point> decode_begin(decode_pool_->num_workers());
+        std::vector<clock::time_point> decode_end(decode_pool_->num_workers());
+
+        size_t idx = 0;
+
+        while (idx < num_frames()) {
+
+            size_t batch_size = 0;
+
+            {
+                std::unique_lock<std::mutex> lock(lock_);
+                frame_consumed_.wait(lock, [&]() { 
+                    return stop_requested_ || input_queue_->had_num_elements() < read_ahead_count_; 
+                });
+
+                batch_size = std::min(
+                    std::min(read_ahead_count_ - input_queue_->had_num_elements(), decode_pool_->num_workers()),
+                    num_frames() - idx);
+            }
+
+            if (stop_requested_)
+                break;
+
+            // From the global pool, so the memory of consumed frames is 
+            // reused once they have been invalidated.
+            for (size_t i = 0; i < batch_size; ++i) {
+                batch.push_back(Frame(
+                    image_format_,
+                    frame_duration_ * static_cast<int64_t>(idx + i),
+                    idx + i + 1 == num_frames()));
+            }
+
+            decode_pool_->run(batch_size, [&](size_t task_index, size_t) {
+                decode_begin[task_index] = clock::now();
+                frame_codec::decompress(
+                    compressed_frames_[(idx + task_index) % compressed_frames_.size()],
+                    batch[task_index].image_data(),
+                    image_format_);
+                decode_end[task_index] = clock::now();
+            });
+
+            if (sampler_) {
+                for (size_t i = 0; i < batch_size; ++i) {
+                    sampler_->enter_sample(StageExecutionState::EXECUTE_BEGIN, decode_begin[i]);
+                    sampler_->enter_sample(StageExecutionState::EXECUTE_END, decode_end[i]);
+                }
+            }
+
+            // The decoder is the only producer of the queue
+            for (auto& f : batch) {
+                bool success = input_queue_->push(std::move(f));
+                FB_ASSERT(success);
+            }
+
+            batch.clear();
+            idx += batch_size;
+
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+            }
+
+            frame_queued_.notify_one();
+
+        }
+
+    } catch (...) {
+
+        FB_LOG_ERROR << "Decompressing frames failed for '" << name_ << "'.";
+        decoder_error_ = std::current_exception();
+
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        decoder_is_done_ = true;
+    }
+
+    frame_queued_.notify_one();
+
+}
+
+bool fb::CompressedImageSequence::wait_for_frame(Frame& out_frame) {
+
+    const clock::time_point underrun_begin = clock::now();
+
+    bool success = false;
+
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        frame_queued_.wait(lock, [&]() { 
+            success = input_queue_->pop(out_frame);
+            return success || decoder_is_done_;
+        });
+    }
+
+    if (decoder_error_)
+        std::rethrow_exception(decoder_error_);
+
+    const clock::time_point underrun_end = clock::now();
+
+    num_underruns_++;
+    underrun_time_ += underrun_end - underrun_begin;
+
+    if (sampler_) {
+        sampler_->enter_sample(StageExecutionState::TASK_BEGIN, underrun_begin);
+        sampler_->enter_sample(StageExecutionState::TASK_END, underrun_end);
+    }
+
+    FB_LOG_DEBUG 
+        << name_ << ": Underrun, waited " 
+        << boost::chrono::duration_cast<boost::chrono::microseconds>(underrun_end - underrun_begin)
+        << " for the decoder.";
+
+    return success;
+
+}
+
+void fb::CompressedImageSequence::frame_has_been_used(const Frame& frame) {
+
+    // Make room for the decoder
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+    }
+
+    frame_consumed_.notify_one();
+
+    if (frame.marks_end_of_sequence()) {
+        FB_ASSERT(state_ == State::READY_TO_READ);
+        state_ = State::END_OF_STREAM;
+    }
+
+}
+
+void fb::CompressedImageSequence::invalidate_frame(Frame&& f) {
+
+    Frame released(std::move(f));
+
+}
+
+fb::ContainerImageSequence::ContainerImageSequence(
+    const std::string& container_file,
+    const ImageFormat& image_format,
+    size_t loop_count,
+    size_t prefetch_count,
+    size_t first_frame) :
+        StreamSource("Container ('" + container_file + "')"),
+        loop_count_(loop_count),
+        prefetch_count_(prefetch_count),
+        first_frame_(first_frame),
+        next_frame_index_(0),
+        next_advised_frame_index_(0)
+{
+
+#ifdef _WIN32
+    FB_LOG_ERROR << "Memory-mapped image sequences are not supported on this platform.";
+    throw std::runtime_error("ContainerImageSequence is not supported on Windows.");
+#else
+
+    if (prefetch_count_ == 0 || prefetch_count_ > input_queue_->size()) {
+        FB_LOG_ERROR 
+            << "Invalid prefetch count " << prefetch_count_ 
+            << ", must be within [1, " << input_queue_->size() << "].";
+        throw std::invalid_argument("Invalid prefetch count.");
+    }
+
+    if (loop_count_ == 0)
+        throw std::invalid_argument("Loop count must not be zero.");
+
+    bf::path container_path = bf::path(ProgramOptions::global().input_sequences_folder());
+    container_path /= bf::path(container_file);
+
+    container_ = utils::make_unique<SequenceContainerReader>(container_path.string());
+
+    if (container_->num_frames() == 0)
+        throw std::runtime_error("Input sequence is empty.");
+
+    if (container_->image_format() != image_format) {
+        FB_LOG_ERROR 
+            << "Format of container '" << container_path << "' is [" 
+            << container_->image_format() << "], expected [" 
+            << image_format << "].";
+        throw std::runtime_error("Invalid image format. Check format.");
+    }
+
+    if (first_frame_ >= container_->num_frames()) {
+        FB_LOG_ERROR 
+            << "First frame " << first_frame_ << " is out of range, container '" 
+            << container_path << "' holds " << container_->num_frames() << " frames.";
+        throw std::invalid_argument("Invalid first frame.");
+    }
+
+    FB_LOG_INFO << 
+        "Mapping " << container_->num_frames() << " frames from container '" 
+        << container_path << "' on demand, starting at frame " << first_frame_ 
+        << ", prefetching " << prefetch_count_ << " frames.";
+
+    FB_LOG_INFO << "Frame duration is '" << container_->frame_duration() << "'.";
+
+    size_t cnt = 0;
+    while (cnt < prefetch_count_ && queue_next_frame())
+        cnt++;
+
+    FB_LOG_INFO << "Preheated fifo with " << cnt << " mapped frames.";
+
+    state_ = State::READY_TO_READ;
+
+#endif
+
+}
+
+fb::ContainerImageSequence::~ContainerImageSequence() {
+    // Mapped frames stay valid after the container has been closed
+}
+
+size_t fb::ContainerImageSequence::num_frames() const { 
+    return container_->num_frames() * loop_count_; 
+}
+
+bool fb::ContainerImageSequence::queue_next_frame() {
+
+    if (next_frame_index_ == num_frames())
+        return false;
+
+#ifdef _WIN32
+    return false;
+#else
+
+    Frame f(
+        container_->image_format(),
+        container_->frame_duration() * static_cast<int64_t>(next_frame_index_),
+        next_frame_index_ + 1 == num_frames(),
+        map_frame(
+            container_->file_descriptor(),
+            container_->frame_offset(container_index(next_frame_index_)),
+            container_->image_format().image_byte_size(),
+            container_->file_path()));
+
+    // We are the only thread working on the queue, see 
+    // PrefetchedImageSequence
+    bool success = input_queue_->push(std::move(f));
+    FB_ASSERT(success);
+
+    next_frame_index_++;
+
+    return true;
+
+#endif
+
+}
+
+void fb::ContainerImageSequence::frame_has_been_used(const Frame& frame) {
+
+    // Keeps the prefetch window filled
+    queue_next_frame();
+
+    if (frame.marks_end_of_sequence()) {
+        FB_ASSERT(state_ == State::READY_TO_READ);
+        state_ = State::END_OF_STREAM;
+    }
+
+}
+
+void fb::ContainerImageSequence::invalidate_frame(Frame&& f) {
+
+    Frame released(std::move(f));
+
+}
+bool fb::ContainerImageSequence::fill_next_frame(
+    uint8_t* data, 
+    const ImageFormat& format, 
+    Time& time) 
+{
+
+    if (format != container_->image_format()) {
+        FB_LOG_ERROR 
+            << "Can't fill [" << format << "] from container of format [" 
+            << container_->image_format() << "].";
+        throw std::invalid_argument("Invalid image format.");
+    }
+
+    bool end_of_sequence = false;
+
+    // Frames which have been mapped before we were asked to fill in place
+    // are drained first, no more frames are mapped from now on.
+    Frame mapped;
+    if (input_queue_->pop(mapped)) {
+
+        memcpy(data, mapped.image_data(), mapped.image_data_size());
+        time = mapped.time();
+        end_of_sequence = mapped.marks_end_of_sequence();
+
+    } else {
+
+        if (next_frame_index_ == num_frames())
+            return false;
+
+        container_->read_frame(container_index(next_frame_index_), data);
+
+        time = container_->frame_duration() * static_cast<int64_t>(next_frame_index_);
+        end_of_sequence = next_frame_index_ + 1 == num_frames();
+
+        next_frame_index_++;
+    }
+
+    advise_read_ahead();
+
+    if (end_of_sequence) {
+        FB_ASSERT(state_ == State::READY_TO_READ);
+        state_ = State::END_OF_STREAM;
+    }
+
+    return true;
+
+}
+
+size_t fb::ContainerImageSequence::container_index(size_t frame_index) const {
+
+    return (first_frame_ + frame_index) % container_->num_frames();
+
+}
+
+void fb::ContainerImageSequence::advise_read_ahead() {
+
+#ifndef _WIN32
+
+    // The mapped frames have been advised already
+    next_advised_frame_index_ = std::max(next_advised_frame_index_, next_frame_index_);
+
+    const size_t end_index = std::min(next_frame_index_ + prefetch_count_, num_frames());
+
+    for (; next_advised_frame_index_ < end_index; ++next_advised_frame_index_) {
+
+        int err = posix_fadvise(
+            container_->file_descriptor(),
+            static_cast<off_t>(container_->frame_offset(container_index(next_advised_frame_index_))),
+            static_cast<off_t>(container_->image_format().image_byte_size()),
+            POSIX_FADV_WILLNEED);
+
+        // Only a hint, reading works regardless
+        if (err != 0) {
+            FB_LOG_DEBUG << "posix_fadvise failed for '" << container_->file_path() << "': " << std::strerror(err) << ".";
+        }
+    }
+
+#endif
+
+}
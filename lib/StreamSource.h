@@ -25,16 +25,44 @@
 #include "Utils.h"
 #include "FrameTime.h"
 #include "Frame.h"
+#include "ChronoUtils.h"
 
 #include <memory>
 #include <string>
 #include <queue>
+#include <vector>
 #include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 #include <iosfwd>
 
 namespace toa {
     namespace frame_bender {
 
+        class StageSampler;
+        class SequenceContainerReader;
+        class WorkerPool;
+
+        // How the input sequence's frames are read from disk
+        enum class SequenceReader {
+            // All frames are read into memory up front, see PrefetchedImageSequence
+            PREFETCH,
+            // Frames are mapped on demand, see MmapImageSequence
+            MMAP,
+            // Frames are read by a background thread, see StreamingImageSequence
+            STREAM,
+            // The sequence is a single container file, see ContainerImageSequence
+            CONTAINER,
+            // Like PREFETCH, but frames are held compressed, see 
+            // CompressedImageSequence
+            COMPRESSED
+        };
+
+        std::ostream& operator<< (std::ostream& out, const SequenceReader& v);
+        std::istream& operator>>(std::istream& in, SequenceReader& v);
+
         /**
          * Base class for all stream sources.
          * Make note that is the the subclasses responsiblity to set the state to READY_TO_READ
@@ -71,7 +99,8 @@ namespace toa {
             bool pop_frame(Frame& out_frame);
             const std::string& name() const { return name_; }
             
-            // TODO: this should be replaced by proper pool handling in the future
+            // Hands a frame back to the source for reuse. Frames that the 
+            // source doesn't keep return their memory to the frame pool.
             virtual void invalidate_frame(Frame&& f);
 
             // Returns the current state. This call is thread-safe
@@ -79,10 +108,36 @@ namespace toa {
             // the last frame has been popped.
             State state() const;
 
+            // Sources that sample their own events (e.g. read underruns) 
+            // return them here, to be written into the trace file.
+            virtual const StageSampler* sampler() const { return nullptr; }
+
+            // Sources which can write a frame straight into memory that the
+            // caller provides (e.g. a mapped upload PBO) return true here.
+            virtual bool can_fill_in_place() const { return false; }
+
+            // In-place alternative to pop_frame(): writes the next frame's 
+            // image into data, which has to hold format.image_byte_size() 
+            // bytes, and returns the frame's time stamp. No Frame is created
+            // in between, so there is nothing to hand back either. Throws 
+            // if can_fill_in_place() is false, and for the same states as 
+            // pop_frame(). Don't mix with pop_frame() on the same source.
+            bool fill_frame(uint8_t* data, const ImageFormat& format, Time& time);
+
         protected:    
 
             // Implementor is responsible for transitioning the states correctly
             virtual void frame_has_been_used(const Frame& frame) = 0;
+
+            // Called by fill_frame(), only if can_fill_in_place() is true. 
+            // Implementor writes the next frame into data, and transitions 
+            // the states like in frame_has_been_used().
+            virtual bool fill_next_frame(uint8_t* data, const ImageFormat& format, Time& time);
+
+            // Called by pop_frame() if the queue is empty. Sources which 
+            // fill the queue asynchronously may wait for the next frame in 
+            // here. The default has nothing to wait for and returns false.
+            virtual bool wait_for_frame(Frame& out_frame);
             std::string name_;
             std::unique_ptr<CircularFifo<Frame>> input_queue_;
             std::atomic<State> state_;
@@ -122,7 +177,253 @@ namespace toa {
             Time end_time_stamp_;
         };
 
-        // TODO-DEF: create a container-framesource?
+        /**
+         * Streams the same kind of sequence as PrefetchedImageSequence, but
+         * without reading it into memory first. A frame's file is only 
+         * memory-mapped once the frame is queued, the kernel is asked to 
+         * read its pages ahead (madvise(MADV_WILLNEED)), and the frame 
+         * references the mapping instead of holding a copy. It is unmapped
+         * again as soon as the frame is handed back. Startup only costs a 
+         * directory listing, and at most prefetch_count frames (plus the 
+         * ones in flight) are mapped at any time. Not supported on Windows.
+         */
+        class MmapImageSequence final : public StreamSource {
+        public:
+
+            static const size_t kDefaultPrefetchCount = 8;
+
+            MmapImageSequence(
+                const std::string& frame_folder, // Note that this is relative to the global program.sequences_location
+                const std::string& regex_pattern,
+                const ImageFormat& image_format,
+                const Time& frame_duration,
+                size_t loop_count = 1,
+                size_t prefetch_count = kDefaultPrefetchCount);
+
+            size_t num_frames() const { return frame_files_.size() * loop_count_; }
+            uintmax_t total_data_size() const { return static_cast<uintmax_t>(image_format_.image_byte_size()) * num_frames(); }
+            size_t prefetch_count() const { return prefetch_count_; }
+
+            // Releases the frame's mapping right away
+            virtual void invalidate_frame(Frame&& f) override;
+
+        private:
+
+            virtual void frame_has_been_used(const Frame& frame) override;
+
+            // Maps the next frame of the sequence and queues it. Returns 
+            // false if all frames have been queued already.
+            bool queue_next_frame();
+
+            std::vector<std::string> frame_files_;
+            ImageFormat image_format_;
+            Time frame_duration_;
+            size_t loop_count_;
+            size_t prefetch_count_;
+            size_t next_frame_index_;
+        };
+
+        /**
+         * Streams a sequence from disk for sequences that don't fit into 
+         * memory. A dedicated reader thread reads the frame files into 
+         * pooled frames, and stays at most read_ahead_count frames ahead of
+         * the consumer. With direct I/O, the reads bypass the page cache 
+         * (O_DIRECT, Linux only), so that replaying a sequence measures the
+         * disk rather than the cache. If the consumer finds no frame ready,
+         * pop_frame() blocks until the reader catches up, and the underrun 
+         * is counted and sampled.
+         */
+        class StreamingImageSequence final : public StreamSource {
+        public:
+
+            static const size_t kDefaultReadAheadCount = 8;
+
+            StreamingImageSequence(
+                const std::string& frame_folder, // Note that this is relative to the global program.sequences_location
+                const std::string& regex_pattern,
+                const ImageFormat& image_format,
+                const Time& frame_duration,
+                size_t loop_count = 1,
+                size_t read_ahead_count = kDefaultReadAheadCount,
+                bool use_direct_io = true);
+
+            ~StreamingImageSequence();
+
+            size_t num_frames() const { return frame_files_.size() * loop_count_; }
+            uintmax_t total_data_size() const { return static_cast<uintmax_t>(image_format_.image_byte_size()) * num_frames(); }
+            size_t read_ahead_count() const { return read_ahead_count_; }
+
+            // Number of times pop_frame() had to wait for the reader
+            size_t num_underruns() const { return num_underruns_; }
+
+            // Hands the frame's memory back to the pool right away
+            virtual void invalidate_frame(Frame&& f) override;
+
+            // If stages are sampled: the read of every frame as EXECUTE_BEGIN
+            // and EXECUTE_END, every underrun as TASK_BEGIN and TASK_END.
+            virtual const StageSampler* sampler() const override { return sampler_.get(); }
+
+        private:
+
+            virtual void frame_has_been_used(const Frame& frame) override;
+            virtual bool wait_for_frame(Frame& out_frame) override;
+
+            void read_frames();
+            void read_frame_file(const std::string& file_path, Frame& frame);
+
+            std::vector<std::string> frame_files_;
+            ImageFormat image_format_;
+            Time frame_duration_;
+            size_t loop_count_;
+            size_t read_ahead_count_;
+            bool use_direct_io_;
+
+            std::unique_ptr<StageSampler> sampler_;
+
+            std::mutex lock_;
+            // Signaled by the consumer, when it took a frame
+            std::condition_variable frame_consumed_;
+            // Signaled by the reader, when it queued a frame or is done
+            std::condition_variable frame_queued_;
+
+            std::atomic<bool> stop_requested_;
+            std::atomic<bool> reader_is_done_;
+            std::exception_ptr reader_error_;
+            std::atomic<size_t> num_underruns_;
+            clock::duration underrun_time_;
+
+            std::thread reader_thread_;
+        };
+
+        /**
+         * Holds the whole sequence in memory like PrefetchedImageSequence, 
+         * but compressed losslessly (see FrameCodec.h), so that 3-5x longer
+         * sequences fit into the same amount of memory. A decoder thread 
+         * decompresses frames into pooled frames and stays at most 
+         * read_ahead_count frames ahead of the consumer. Each batch of 
+         * frames is decompressed in parallel, one frame per worker of a pool
+         * of decode_thread_count workers (the decoder thread being one of 
+         * them). Underruns are handled and counted like in 
+         * StreamingImageSequence.
+         */
+        class CompressedImageSequence final : public StreamSource {
+        public:
+
+            static const size_t kDefaultDecodeThreadCount = 2;
+
+            CompressedImageSequence(
+                const std::string& frame_folder, // Note that this is relative to the global program.sequences_location
+                const std::string& regex_pattern,
+                const ImageFormat& image_format,
+                const Time& frame_duration,
+                size_t loop_count = 1,
+                size_t read_ahead_count = StreamingImageSequence::kDefaultReadAheadCount,
+                // 0 uses one per hardware thread
+                size_t decode_thread_count = kDefaultDecodeThreadCount);
+
+            ~CompressedImageSequence();
+
+            size_t num_frames() const { return compressed_frames_.size() * loop_count_; }
+            uintmax_t total_data_size() const { return static_cast<uintmax_t>(image_format_.image_byte_size()) * num_frames(); }
+            // Memory held by the compressed frames of one loop
+            uintmax_t compressed_data_size() const { return compressed_data_size_; }
+            size_t read_ahead_count() const { return read_ahead_count_; }
+            size_t decode_thread_count() const;
+
+            // Number of times pop_frame() had to wait for the decoder
+            size_t num_underruns() const { return num_underruns_; }
+
+            // Hands the frame's memory back to the pool right away
+            virtual void invalidate_frame(Frame&& f) override;
+
+            // If stages are sampled: the decompression of every frame as 
+            // EXECUTE_BEGIN and EXECUTE_END, every underrun as TASK_BEGIN 
+            // and TASK_END.
+            virtual const StageSampler* sampler() const override { return sampler_.get(); }
+
+        private:
+
+            virtual void frame_has_been_used(const Frame& frame) override;
+            virtual bool wait_for_frame(Frame& out_frame) override;
+
+            void decode_frames();
+
+            std::vector<std::vector<uint8_t>> compressed_frames_;
+            uintmax_t compressed_data_size_;
+            ImageFormat image_format_;
+            Time frame_duration_;
+            size_t loop_count_;
+            size_t read_ahead_count_;
+
+            std::unique_ptr<WorkerPool> decode_pool_;
+            std::unique_ptr<StageSampler> sampler_;
+
+            std::mutex lock_;
+            // Signaled by the consumer, when it took a frame
+            std::condition_variable frame_consumed_;
+            // Signaled by the decoder, when it queued frames or is done
+            std::condition_variable frame_queued_;
+
+            std::atomic<bool> stop_requested_;
+            std::atomic<bool> decoder_is_done_;
+            std::exception_ptr decoder_error_;
+            std::atomic<size_t> num_underruns_;
+            clock::duration underrun_time_;
+
+            std::thread decoder_thread_;
+        };
+
+        /**
+         * Streams a sequence container (see SequenceContainer.h) like 
+         * MmapImageSequence streams a folder: frames are mapped on demand and
+         * prefetched with madvise(MADV_WILLNEED). All frames are mapped from 
+         * the one container file at their (page-aligned) offset, and the 
+         * stream may start at any frame. Can fill frames in place, in which 
+         * case the frames are read with pread() right into the caller's 
+         * memory, and read ahead with posix_fadvise(POSIX_FADV_WILLNEED). 
+         * Not supported on Windows.
+         */
+        class ContainerImageSequence final : public StreamSource {
+        public:
+
+            ContainerImageSequence(
+                const std::string& container_file, // Note that this is relative to the global program.sequences_location
+                const ImageFormat& image_format, // Throws if the container's format is different
+                size_t loop_count = 1,
+                size_t prefetch_count = MmapImageSequence::kDefaultPrefetchCount,
+                size_t first_frame = 0);
+
+            ~ContainerImageSequence();
+
+            size_t num_frames() const;
+            const SequenceContainerReader& container() const { return *container_; }
+
+            // Releases the frame's mapping right away
+            virtual void invalidate_frame(Frame&& f) override;
+
+            virtual bool can_fill_in_place() const override { return true; }
+
+        private:
+
+            virtual void frame_has_been_used(const Frame& frame) override;
+            virtual bool fill_next_frame(uint8_t* data, const ImageFormat& format, Time& time) override;
+
+            bool queue_next_frame();
+
+            // Index into the container of the stream's frame_index-th frame
+            size_t container_index(size_t frame_index) const;
+
+            // Keeps prefetch_count frames ahead of the next in-place read
+            // in the page cache
+            void advise_read_ahead();
+
+            std::unique_ptr<SequenceContainerReader> container_;
+            size_t loop_count_;
+            size_t prefetch_count_;
+            size_t first_frame_;
+            size_t next_frame_index_;
+            size_t next_advised_frame_index_;
+        };
 
     }
 }
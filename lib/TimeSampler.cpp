@@ -23,6 +23,7 @@
 #include "TimeSampler.h"
 #include "Init.h"
 #include "Logging.h"
+#include "SampleClock.h"
 #include <stdexcept>
 #include <type_traits>
 
@@ -154,7 +155,8 @@ void fb::gl::SyncPoint::initialize() {
 
     GLint64 gl_time = 0;
     glGetInteger64v(GL_TIMESTAMP, &gl_time);
-    auto host_time = clock::now();
+    // Same time domain as the stage samples, which GL times are mixed with
+    auto host_time = sample_clock::now();
 
     // Check if our clock really is in nanoseconds units
     static_assert(
@@ -45,6 +45,7 @@
 #include <boost/date_time.hpp>
 
 #include <stdexcept>
+#include <algorithm>
 
 namespace bf = boost::filesystem;
 namespace bt = boost::posix_time;
@@ -52,42 +53,96 @@ namespace bt = boost::posix_time;
 namespace fb = toa::frame_bender;
 namespace fbf = fbt_format;
 
+namespace {
+
+    std::unique_ptr<std::ofstream> open_trace_file(const std::string& file_path) {
+
+        bf::path out_path(file_path);
+
+        if (bf::is_directory(out_path)) {
+            FB_LOG_ERROR << "Path '" << out_path << "' is a directory, can't write to it.";
+            throw std::invalid_argument("Out file is a directory.");
+        }
+
+        if (bf::exists(out_path)) {
+            FB_LOG_WARNING << "File '" << out_path << "' will be overwritten.";
+        }
+
+        std::unique_ptr<std::ofstream> writer(new bf::ofstream(out_path, std::ios::binary | std::ios::out));
+
+        if (!writer->good()) {
+            FB_LOG_ERROR << "Can't open out stream to file '" << file_path << "'.";
+            throw std::invalid_argument("Invalid file argument for trace output.");
+        }
+
+        return writer;
+
+    }
+
+    void set_session_info(
+        fbf::TraceSession& session,
+        const std::string& session_name,
+        const std::string& vendor,
+        const std::string& renderer,
+        const std::string& version)
+    {
+
+        session.set_name(session_name);
+
+        session.set_local_time(bt::to_simple_string(bt::second_clock::local_time()));
+
+        session.mutable_opengl_info()->set_vendor(vendor);
+        session.mutable_opengl_info()->set_renderer(renderer);
+        session.mutable_opengl_info()->set_version(version);
+
+    }
+
+}
+
 fb::TraceFormatWriter::TraceFormatWriter(
     const std::string& file_path, 
     const std::string& session_name, 
     const gl::utils::GLInfo& gl_info) : 
-        was_flushed_(false)
+        was_flushed_(false),
+        stream_(nullptr)
 {
 
     GOOGLE_PROTOBUF_VERIFY_VERSION;
 
-    bf::path out_path(file_path);
+    writer_ = open_trace_file(file_path);
 
-    if (bf::is_directory(out_path)) {
-        FB_LOG_ERROR << "Path '" << out_path << "' is a directory, can't write to it.";
-        throw std::invalid_argument("Out file is a directory.");
-    }
+    container_ = utils::make_unique<fbf::TraceSession>();
 
-    if (bf::exists(out_path)) {
-        FB_LOG_WARNING << "File '" << out_path << "' will be overwritten.";
-    }
+    set_session_info(
+        *container_, 
+        session_name, 
+        gl_info.vendor, 
+        gl_info.renderer, 
+        gl_info.version_string);
 
-    writer_ = std::unique_ptr<std::ofstream>(new bf::ofstream(out_path, std::ios::binary | std::ios::out));
+}
+
+fb::TraceFormatWriter::TraceFormatWriter(
+    TraceStream& stream,
+    const std::string& session_name, 
+    const gl::utils::GLInfo& gl_info) : 
+        was_flushed_(false),
+        stream_(&stream)
+{
 
-    if (!writer_->good()) {
-        FB_LOG_ERROR << "Can't open out stream to file '" << file_path << "'.";
-        throw std::invalid_argument("Invalid file argument for trace output.");
+    if (stream.is_finished()) {
+        FB_LOG_ERROR << "Trace stream to '" << stream.file_path() << "' is already finished.";
+        throw std::invalid_argument("Trace stream is already finished.");
     }
 
     container_ = utils::make_unique<fbf::TraceSession>();
 
-    container_->set_name(session_name);
-
-    container_->set_local_time(bt::to_simple_string(bt::second_clock::local_time()));
-
-    container_->mutable_opengl_info()->set_vendor(gl_info.vendor);
-    container_->mutable_opengl_info()->set_renderer(gl_info.renderer);
-    container_->mutable_opengl_info()->set_version(gl_info.version_string);
+    set_session_info(
+        *container_, 
+        session_name, 
+        gl_info.vendor, 
+        gl_info.renderer, 
+        gl_info.version_string);
 
 }
 
@@ -148,15 +203,13 @@ fbf::StageTrace::EventType get_event_type(fb::StageExecutionState state) {
 
 void fb::TraceFormatWriter::add_sampler_statistic(
     fbt_format::StageTrace* trace_container,
-    const StageExecutionState& begin_event,
-    const StageExecutionState& end_event,
     const StageSampler::Statistic& statistic)
 {
 
     auto delta_statistic = trace_container->add_delta_statistics();
 
-    delta_statistic->set_begin_event(get_event_type(begin_event));
-    delta_statistic->set_end_event(get_event_type(end_event));
+    delta_statistic->set_begin_event(get_event_type(statistic.begin_state));
+    delta_statistic->set_end_event(get_event_type(statistic.end_state));
     
     static_assert(clock::period::num == 1, "Expecting a period numerator of 1.");
     static_assert(clock::period::den == 1000000000, "Expecting nanoseconds as the period of time.");
@@ -169,6 +222,26 @@ void fb::TraceFormatWriter::add_sampler_statistic(
     delta_statistic->set_median_ns(statistic.median.count());
     delta_statistic->set_num_samples(statistic.num_samples);
 
+    for (const auto& p : statistic.percentiles) {
+        delta_statistic->add_percentiles(p.percentile);
+        delta_statistic->add_percentile_values_ns(p.value.count());
+    }
+
+    // Only the non-empty buckets, so that histograms of several runs can be
+    // merged afterwards (see fbt_session.py)
+    const LatencyHistogram& histogram = statistic.histogram;
+
+    delta_statistic->set_histogram_significant_digits(histogram.significant_digits());
+    delta_statistic->set_histogram_highest_trackable_ns(histogram.highest_trackable_ns());
+
+    for (size_t i = 0; i < histogram.num_counts(); ++i) {
+        uint64_t count = histogram.count_at_index(i);
+        if (count != 0) {
+            delta_statistic->add_histogram_indices(static_cast<uint32_t>(i));
+            delta_statistic->add_histogram_counts(count);
+        }
+    }
+
 }
 
 void fb::TraceFormatWriter::add_stage_sampler(const std::string& name, const StageSampler& sampler)
@@ -188,8 +261,11 @@ void fb::TraceFormatWriter::add_stage_sampler(const std::string& name, const Sta
 
     }
 
-    // For each event type, we get all events and write to our format
-    for (size_t i = 0; i<static_cast<size_t>(StageExecutionState::NUMBER_OF_STATES); ++i)
+    // For each event type, we get all events and write to our format. 
+    // Streamed samplers already wrote all of their events.
+    bool events_were_streamed = (stream_ != nullptr) && (sampler.stream_.load() == stream_);
+
+    for (size_t i = 0; i<static_cast<size_t>(StageExecutionState::NUMBER_OF_STATES) && !events_were_streamed; ++i)
     {
 
         StageExecutionState state = StageExecutionState(i);
@@ -214,71 +290,58 @@ void fb::TraceFormatWriter::add_stage_sampler(const std::string& name, const Sta
 
             }
 
-        }
-
-    }
+            // The frames of the tasks, for relating stages by frame
+            if (state == StageExecutionState::TASK_BEGIN && sampler.has_trace_ids()) {
 
-    // Also add sample statistics that might be interesting
-    std::vector<fb::StageSampler::Statistic> answer;
+                for (size_t j = 0; j<number_of_trace_events; ++j)
+                    event_trace->add_trace_ids(sampler.get_trace_id(j));
 
-    StageExecutionState begin_event = StageExecutionState::TASK_BEGIN;
-    StageExecutionState end_event = StageExecutionState::TASK_END;
-    if (sampler.number_of_sampled_trace_events(begin_event) != 0) {
+            }
 
-        add_sampler_statistic(
-            stage_trace,
-            begin_event,
-            end_event,
-            StageSampler::build_delta_statistic(sampler, begin_event,sampler,end_event));
+        }
 
     }
 
-    begin_event = StageExecutionState::EXECUTE_BEGIN;
-    end_event = StageExecutionState::EXECUTE_END;
-    if (sampler.number_of_sampled_trace_events(begin_event) != 0) {
+    // Also add sample statistics that might be interesting, these cover all
+    // events (streamed or not)
+    for (const auto& statistic : sampler.collect_statistics())
+        add_sampler_statistic(stage_trace, statistic);
 
-        add_sampler_statistic(
-            stage_trace,
-            begin_event,
-            end_event,
-            StageSampler::build_delta_statistic(sampler, begin_event,sampler,end_event));
+}
 
-    }
+void fb::TraceFormatWriter::add_fifo_sampler(const FifoSampler& sampler)
+{
 
-    begin_event = StageExecutionState::EXECUTE_BEGIN;
-    end_event = StageExecutionState::INPUT_TOKEN_AVAILABLE;
-    if (sampler.number_of_sampled_trace_events(begin_event) != 0) {
+    static_assert(clock::period::num == 1, "Expecting a period numerator of 1.");
+    static_assert(clock::period::den == 1000000000, "Expecting nanoseconds as the period of time.");
 
-        add_sampler_statistic(
-            stage_trace,
-            begin_event,
-            end_event,
-            StageSampler::build_delta_statistic(sampler, begin_event,sampler,end_event));
+    auto queue_trace = container_->add_queue_traces();
 
-    }
+    queue_trace->set_name(sampler.name());
+    queue_trace->set_capacity(static_cast<google::protobuf::uint32>(sampler.capacity()));
 
-    begin_event = StageExecutionState::EXECUTE_BEGIN;
-    end_event = StageExecutionState::OUTPUT_TOKEN_AVAILABLE;
-    if (sampler.number_of_sampled_trace_events(begin_event) != 0) {
+    const int num_pushes = static_cast<int>(sampler.number_of_push_events());
 
-        add_sampler_statistic(
-            stage_trace,
-            begin_event,
-            end_event,
-            StageSampler::build_delta_statistic(sampler, begin_event,sampler,end_event));
+    queue_trace->mutable_push_times_ns()->Reserve(num_pushes);
+    queue_trace->mutable_push_occupancy()->Reserve(num_pushes);
 
+    for (size_t i = 0; i<sampler.number_of_push_events(); ++i) {
+        const auto& event = sampler.get_push_event(i);
+        queue_trace->add_push_times_ns(static_cast<google::protobuf::int64>(event.time.time_since_epoch().count()));
+        queue_trace->add_push_occupancy(event.occupancy);
     }
 
-    begin_event = StageExecutionState::GL_TASK_BEGIN;
-    end_event = StageExecutionState::GL_TASK_END;
-    if (sampler.number_of_sampled_trace_events(begin_event) != 0) {
+    const int num_pops = static_cast<int>(sampler.number_of_pop_events());
 
-        add_sampler_statistic(
-            stage_trace,
-            begin_event,
-            end_event,
-            StageSampler::build_delta_statistic(sampler, begin_event,sampler,end_event));
+    queue_trace->mutable_pop_times_ns()->Reserve(num_pops);
+    queue_trace->mutable_pop_occupancy()->Reserve(num_pops);
+    queue_trace->mutable_dwell_times_ns()->Reserve(num_pops);
 
+    for (size_t i = 0; i<sampler.number_of_pop_events(); ++i) {
+        const auto& event = sampler.get_pop_event(i);
+        queue_trace->add_pop_times_ns(static_cast<google::protobuf::int64>(event.time.time_since_epoch().count()));
+        queue_trace->add_pop_occupancy(event.occupancy);
+        queue_trace->add_dwell_times_ns(static_cast<google::protobuf::int64>(event.dwell_time.count()));
     }
 
 }
@@ -307,6 +370,14 @@ void fb::TraceFormatWriter::flush() {
     if (was_flushed())
         throw std::runtime_error("Writer has already been flushed.");
 
+    if (stream_ != nullptr) {
+
+        stream_->finish(*container_);
+        was_flushed_ = true;
+        return;
+
+    }
+
     using google::protobuf::io::OstreamOutputStream;
     using google::protobuf::io::GzipOutputStream;
 
@@ -324,3 +395,412 @@ void fb::TraceFormatWriter::flush() {
     was_flushed_ = true;
 
 }
+
+fb::TraceStream::TraceStream(
+    const std::string& file_path, 
+    size_t num_segments) :
+        file_path_(file_path),
+        segments_(num_segments),
+        num_segments_writing_(0),
+        stop_requested_(false),
+        is_finished_(false),
+        num_events_written_(0),
+        num_events_dropped_(0),
+        num_segment_waits_(0),
+        num_segments_added_(0)
+{
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    if (num_segments == 0) {
+        FB_LOG_ERROR << "Trace stream needs at least one segment.";
+        throw std::invalid_argument("Invalid number of trace segments.");
+    }
+
+    writer_ = open_trace_file(file_path);
+
+    free_segments_.reserve(num_segments);
+    full_segments_.reserve(num_segments);
+
+    for (auto& segment : segments_)
+        free_segments_.push_back(&segment);
+
+    // Provisional, overridden by finish(). But this way the file holds a
+    // valid session even if we never get there, e.g. a soak run that is 
+    // killed.
+    fbf::TraceSession header;
+
+    set_session_info(
+        header, 
+        bf::path(file_path).stem().string(), 
+        "unknown", 
+        "unknown", 
+        "unknown");
+
+    write_session(header);
+
+    flush_thread_ = std::thread(&TraceStream::flush_segments, this);
+
+    FB_LOG_INFO 
+        << "Streaming trace events to '" << file_path << "' with " 
+        << num_segments << " segments of " << TraceSegment::kNumMaxEvents 
+        << " events (" << num_segments * sizeof(TraceSegment) << " bytes).";
+
+}
+
+fb::TraceStream::~TraceStream()
+{
+
+    if (!is_finished()) {
+
+        try {
+
+            fbf::TraceSession empty_session;
+            finish(empty_session);
+
+        } catch (const std::exception& e) {
+
+            FB_LOG_ERROR << "Could not finish trace stream to '" << file_path_ << "': " << e.what();
+
+        }
+
+    }
+
+}
+
+void fb::TraceStream::attach(const std::string& name, const StageSampler& sampler)
+{
+
+    if (is_finished()) {
+        FB_LOG_ERROR << "Can't attach '" << name << "', trace stream is already finished.";
+        throw std::runtime_error("Trace stream is already finished.");
+    }
+
+    if (sampler.stream_.load() != nullptr) {
+        FB_LOG_ERROR << "Sampler '" << name << "' is already attached to a trace stream.";
+        throw std::invalid_argument("Sampler is already streamed.");
+    }
+
+    uint32_t stream_id = 0;
+
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+
+        stream_id = static_cast<uint32_t>(names_.size());
+        names_.push_back(name);
+        samplers_.push_back(&sampler);
+    }
+
+    // Events sampled before attaching go first
+    for (size_t i = 0; i<static_cast<size_t>(StageExecutionState::NUMBER_OF_STATES); ++i)
+    {
+
+        StageExecutionState state = StageExecutionState(i);
+
+        size_t num_events = sampler.number_of_sampled_trace_events(state);
+        size_t idx = 0;
+
+        while (idx < num_events) {
+
+            TraceSegment* segment = exchange_segment(nullptr, stream_id, state);
+
+            if (segment == nullptr) {
+                num_events_dropped_ += num_events - idx;
+                break;
+            }
+
+            while (idx < num_events && segment->num_events < TraceSegment::kNumMaxEvents) {
+
+                TraceId trace_id = (state == StageExecutionState::TASK_BEGIN) ? sampler.get_trace_id(idx) : kNoTraceId;
+
+                segment->trace_ids[segment->num_events] = trace_id;
+                segment->has_trace_ids = segment->has_trace_ids || (trace_id != kNoTraceId);
+                segment->events[segment->num_events++] = sampler.get_trace_event(state, idx++);
+
+            }
+
+            queue_segment(segment);
+
+        }
+
+    }
+
+    sampler.stream_id_ = stream_id;
+    sampler.stream_.store(this, std::memory_order_release);
+
+}
+
+void fb::TraceStream::detach(const StageSampler& sampler)
+{
+
+    if (sampler.stream_.load() != this)
+        return;
+
+    sampler.stream_.store(nullptr);
+
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+
+        samplers_.erase(
+            std::remove(std::begin(samplers_), std::end(samplers_), &sampler), 
+            std::end(samplers_));
+
+        for (auto& segment : sampler.stream_segments_) {
+
+            if (segment == nullptr)
+                continue;
+
+            if (segment->num_events != 0)
+                full_segments_.push_back(segment);
+            else
+                free_segments_.push_back(segment);
+
+            segment = nullptr;
+
+        }
+    }
+
+    segments_available_.notify_one();
+
+}
+
+fb::TraceSegment* fb::TraceStream::exchange_segment(
+    TraceSegment* full,
+    uint32_t stream_id,
+    StageExecutionState state)
+{
+
+    TraceSegment* segment = nullptr;
+
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+
+        if (full != nullptr)
+            full_segments_.push_back(full);
+
+        while (free_segments_.empty() && !stop_requested_) {
+
+            if (full_segments_.empty() && num_segments_writing_ == 0) {
+
+                // All segments are held by samplers, waiting would never end
+                segments_.emplace_back();
+                free_segments_.push_back(&segments_.back());
+                num_segments_added_++;
+
+            } else {
+
+                // Rather stall sampling than lose events
+                num_segment_waits_++;
+                segments_available_.notify_one();
+                segments_freed_.wait(lock);
+
+            }
+
+        }
+
+        if (!free_segments_.empty()) {
+            segment = free_segments_.back();
+            free_segments_.pop_back();
+        }
+    }
+
+    if (full != nullptr)
+        segments_available_.notify_one();
+
+    if (segment != nullptr) {
+        segment->stream_id = stream_id;
+        segment->state = state;
+        segment->num_events = 0;
+        segment->has_trace_ids = false;
+    }
+
+    return segment;
+
+}
+
+void fb::TraceStream::queue_segment(TraceSegment* segment)
+{
+
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        full_segments_.push_back(segment);
+    }
+
+    segments_available_.notify_one();
+
+}
+
+void fb::TraceStream::finish(const fbf::TraceSession& session)
+{
+
+    if (is_finished())
+        throw std::runtime_error("Trace stream has already been finished.");
+
+    // Samplers hand over what they have sampled so far
+    std::vector<const StageSampler*> samplers;
+
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        samplers = samplers_;
+    }
+
+    for (auto sampler : samplers)
+        detach(*sampler);
+
+    // The flush thread drains all full segments before it quits
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stop_requested_ = true;
+    }
+
+    segments_available_.notify_one();
+    segments_freed_.notify_all();
+
+    if (flush_thread_.joinable())
+        flush_thread_.join();
+
+    is_finished_ = true;
+
+    write_session(session);
+
+    writer_->close();
+
+    FB_LOG_INFO 
+        << "Streamed " << num_events_written() << " trace events to '" 
+        << file_path_ << "'.";
+
+    if (num_segment_waits() != 0 || num_segments_added_ != 0) {
+        FB_LOG_WARNING 
+            << "Sampling waited " << num_segment_waits() << " times for "
+            << "trace segments to be written, and " << num_segments_added_ 
+            << " segments were added. Increase "
+            << "profiling.trace_streaming.segment_count.";
+    }
+
+    if (num_events_dropped() != 0) {
+        FB_LOG_ERROR 
+            << "Dropped " << num_events_dropped() << " trace events, "
+            << "because they were sampled while finishing the trace stream.";
+    }
+
+}
+
+void fb::TraceStream::flush_segments()
+{
+
+    std::vector<TraceSegment*> segments;
+    segments.reserve(segments_.size());
+
+    std::unique_lock<std::mutex> lock(lock_);
+
+    while (true) {
+
+        segments_available_.wait(lock, [&]{ return stop_requested_ || !full_segments_.empty(); });
+
+        if (full_segments_.empty())
+            break;
+
+        segments.swap(full_segments_);
+        num_segments_writing_ = segments.size();
+
+        lock.unlock();
+
+        try {
+
+            write_segments(segments);
+
+        } catch (const std::exception& e) {
+
+            FB_LOG_ERROR << "Could not write trace segments to '" << file_path_ << "': " << e.what();
+
+        }
+
+        lock.lock();
+
+        free_segments_.insert(std::end(free_segments_), std::begin(segments), std::end(segments));
+        num_segments_writing_ = 0;
+        segments.clear();
+
+        segments_freed_.notify_all();
+
+    }
+
+}
+
+void fb::TraceStream::write_segments(const std::vector<TraceSegment*>& segments)
+{
+
+    // Every segment ends up as a StageTrace of its own, which are merged 
+    // with the others of the same name when reading the file
+    fbf::TraceSession chunk;
+
+    uint64_t num_events = 0;
+
+    for (auto segment : segments) {
+
+        auto stage_trace = chunk.add_stage_traces();
+
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            stage_trace->set_name(names_[segment->stream_id]);
+        }
+
+        auto event_trace = stage_trace->add_event_traces();
+        event_trace->set_type(get_event_type(segment->state));
+        event_trace->mutable_trace_times_ns()->Reserve(static_cast<int>(segment->num_events));
+
+        static_assert(clock::period::num == 1, "Expecting a period numerator of 1.");
+        static_assert(clock::period::den == 1000000000, "Expecting nanoseconds as the period of time.");
+
+        for (size_t i = 0; i<segment->num_events; ++i)
+            event_trace->add_trace_times_ns(static_cast<google::protobuf::int64>(segment->events[i].time_since_epoch().count()));
+
+        if (segment->has_trace_ids) {
+
+            event_trace->mutable_trace_ids()->Reserve(static_cast<int>(segment->num_events));
+
+            for (size_t i = 0; i<segment->num_events; ++i)
+                event_trace->add_trace_ids(segment->trace_ids[i]);
+
+        }
+
+        num_events += segment->num_events;
+
+    }
+
+    write_session(chunk);
+
+    num_events_written_ += num_events;
+
+}
+
+void fb::TraceStream::write_session(const fbf::TraceSession& session)
+{
+
+    using google::protobuf::io::OstreamOutputStream;
+    using google::protobuf::io::GzipOutputStream;
+
+    bool was_written = false;
+
+    {
+
+        OstreamOutputStream out_stream(writer_.get());
+
+        // Every session is a gzip member of its own (readers concatenate 
+        // them), so that everything written so far is complete on disk.
+        GzipOutputStream gzip_out_stream(&out_stream);
+
+        // Chunks are partial sessions, the required fields were written before
+        was_written = session.SerializePartialToZeroCopyStream(&gzip_out_stream);
+        was_written = gzip_out_stream.Close() && was_written;
+
+    }
+
+    writer_->flush();
+
+    if (!was_written || !writer_->good()) {
+        FB_LOG_ERROR << "Could not serialize trace session to '" << file_path_ << "'.";
+        throw std::runtime_error("Could not write trace stream.");
+    }
+
+}
@@ -25,8 +25,16 @@
 #include <memory>
 #include <string>
 #include <fstream>
+#include <vector>
+#include <array>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 #include "StageSampler.h"
+#include "FifoSampler.h"
 #include "Utils.h"
 #include "UtilsGL.h"
 
@@ -39,6 +47,123 @@ namespace fbt_format {
 namespace toa {
 
     namespace frame_bender {
+
+        // A fixed-size block of events of one state of one sampler. Filled by
+        // the thread sampling that state only, so no locking is required
+        // until the segment is full and handed over to the TraceStream.
+        struct TraceSegment {
+
+            static const size_t kNumMaxEvents = 1024;
+
+            uint32_t stream_id;
+            StageExecutionState state;
+            size_t num_events;
+            std::array<StageSampler::TraceEvent, kNumMaxEvents> events;
+
+            // Only for TASK_BEGIN, see StageSampler::enter_trace_id()
+            bool has_trace_ids;
+            std::array<TraceId, kNumMaxEvents> trace_ids;
+
+        };
+
+        // Writes all events of the attached samplers incrementally into a 
+        // trace file, instead of the first StageSampler::kNumMaxTraceEvents 
+        // only. Memory is bounded by the segments allocated up front; full 
+        // segments are serialized on a background thread. If the writer can't
+        // keep up and all segments are in flight, the sampling thread waits 
+        // for one to be written, so that no events are lost. Segments are 
+        // only added if all of them are held by samplers, as none would be 
+        // freed otherwise.
+        //
+        // The file consists of concatenated gzip members of TraceSession 
+        // messages (which protobuf merges on parsing), thus a stage's events 
+        // are spread over several StageTrace entries of the same name. See 
+        // scripts/fbt_session.py for merging them when reading.
+        class TraceStream : public utils::NoCopyingOrMoving {
+
+        public:
+
+            static const size_t kDefaultNumSegments = 256;
+
+            TraceStream(
+                const std::string& file_path, 
+                size_t num_segments = kDefaultNumSegments);
+
+            // Calls finish() with an empty session, if not finished yet
+            ~TraceStream();
+
+            // From now on, all events of sampler are streamed under name. 
+            // Events which the sampler already holds are written first, so 
+            // this should be called while the sampler is idle. Either the
+            // sampler must outlive finish(), or it detaches on destruction.
+            void attach(const std::string& name, const StageSampler& sampler);
+
+            // Hands over the sampler's partially filled segments, later 
+            // events of the sampler aren't streamed anymore.
+            void detach(const StageSampler& sampler);
+
+            // Writes all pending events, then session (the session's 
+            // attributes override the provisional ones written at the 
+            // beginning) and closes the file. Samplers are detached.
+            void finish(const fbt_format::TraceSession& session);
+
+            bool is_finished() const { return is_finished_; }
+
+            const std::string& file_path() const { return file_path_; }
+
+            uint64_t num_events_written() const { return num_events_written_; }
+
+            // Only events sampled while finishing, i.e. after the flush 
+            // thread was stopped, are dropped
+            uint64_t num_events_dropped() const { return num_events_dropped_; }
+
+            // How often a sampling thread had to wait for a free segment
+            uint64_t num_segment_waits() const { return num_segment_waits_; }
+
+            // Called by StageSampler only. Queues full (if not null) and 
+            // returns a fresh segment, waiting for one if necessary. Returns
+            // nullptr if the stream is finishing.
+            TraceSegment* exchange_segment(
+                TraceSegment* full,
+                uint32_t stream_id,
+                StageExecutionState state);
+
+            void count_dropped_event() { num_events_dropped_++; }
+
+        private:
+
+            void queue_segment(TraceSegment* segment);
+            void flush_segments();
+            void write_segments(const std::vector<TraceSegment*>& segments);
+            void write_session(const fbt_format::TraceSession& session);
+
+            std::string file_path_;
+
+            std::unique_ptr<std::ofstream> writer_;
+
+            // A deque, so that adding segments keeps the others in place
+            std::deque<TraceSegment> segments_;
+
+            // All guarded by lock_
+            std::mutex lock_;
+            std::condition_variable segments_available_;
+            std::condition_variable segments_freed_;
+            std::vector<TraceSegment*> free_segments_;
+            std::vector<TraceSegment*> full_segments_;
+            size_t num_segments_writing_;
+            std::vector<std::string> names_;
+            std::vector<const StageSampler*> samplers_;
+            bool stop_requested_;
+
+            bool is_finished_;
+            std::atomic<uint64_t> num_events_written_;
+            std::atomic<uint64_t> num_events_dropped_;
+            std::atomic<uint64_t> num_segment_waits_;
+            std::atomic<uint64_t> num_segments_added_;
+
+            std::thread flush_thread_;
+
+        };
                 
         class TraceFormatWriter : public utils::NoCopyingOrMoving {
 
@@ -49,10 +174,21 @@ namespace toa {
                 const std::string& session_name,
                 const gl::utils::GLInfo& gl_info);
 
+            // Finishes stream on flush() instead of writing a file of its 
+            // own. Events of streamed samplers are not added again.
+            TraceFormatWriter(
+                TraceStream& stream,
+                const std::string& session_name,
+                const gl::utils::GLInfo& gl_info);
+
             ~TraceFormatWriter();
 
             void add_stage_sampler(const std::string& name, const StageSampler& sampler);
 
+            // Also for streamed traces, but only the events that the sampler
+            // holds (see FifoSampler::kNumMaxTraceEvents)
+            void add_fifo_sampler(const FifoSampler& sampler);
+
             void set_session_statistics(
                 uint64_t number_of_frames_processed,
                 float avg_throughput_mb_per_sec,
@@ -66,12 +202,11 @@ namespace toa {
 
             void add_sampler_statistic(
                 fbt_format::StageTrace* trace_container,
-                const StageExecutionState& begin_event,
-                const StageExecutionState& end_event,
                 const StageSampler::Statistic& statistic);
 
             
             bool was_flushed_;
+            TraceStream* stream_;
             std::unique_ptr<std::ofstream> writer_;
             std::unique_ptr<fbt_format::TraceSession> container_;
 
@@ -0,0 +1,58 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_TRACE_ID_H
+#define TOA_FRAME_BENDER_TRACE_ID_H
+
+#include <cstdint>
+
+namespace toa {
+    namespace frame_bender {
+
+        // Identifies a frame on its way through the pipeline. Assigned by the
+        // head stage, passed on with TokenFrame and TokenGL, and recorded by 
+        // every stage's sampler along with the task that worked on it. This 
+        // way stages are related by frame, not by the order of their events, 
+        // which no longer line up once frames are dropped or a sampler 
+        // overflows.
+        typedef uint32_t TraceId;
+
+        // Tokens that don't carry a frame (yet)
+        const TraceId kNoTraceId = 0;
+
+        // Hands out the trace IDs for new frames, never kNoTraceId. At 60 
+        // frames per second, IDs wrap around after more than two years.
+        class TraceIdGenerator {
+        public:
+            TraceIdGenerator() : last_(kNoTraceId) {}
+            TraceId next() { 
+                if (++last_ == kNoTraceId) 
+                    ++last_; 
+                return last_; 
+            }
+        private:
+            TraceId last_;
+        };
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_TRACE_ID_H
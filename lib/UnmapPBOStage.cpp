@@ -67,6 +67,9 @@ fb::StageCommand fb::UnmapPBOStage::perform(
     token_out.format = token_in.format;
     token_out.gl_fence = 0;
     token_out.time_stamp = token_in.time_stamp;
+    token_out.trace_id = token_in.trace_id;
+
+    sampler_.enter_trace_id(token_in.trace_id);
 
     if (!pbo_memory_is_persistently_mapped_) {
 
@@ -132,6 +135,7 @@ fb::StageCommand fb::UnmapPBOStage::perform(
     token_in.format = upstream_token.format;
     token_in.id = upstream_token.id;
     token_in.time_stamp = Time(0, 1);
+    token_in.trace_id = kNoTraceId;
 
     return StageCommand::NO_CHANGE;
 
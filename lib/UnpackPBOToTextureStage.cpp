@@ -165,6 +165,11 @@ fb::StageCommand fb::UnpackPBOToTextureStage::perform(
     // Pass through time stamp
     tex_out_token.time_stamp = pbo_in_token.time_stamp;
 
+    // and the frame
+    tex_out_token.trace_id = pbo_in_token.trace_id;
+
+    sampler_.enter_trace_id(pbo_in_token.trace_id);
+
     return answer;
 
 }
@@ -22,6 +22,7 @@
 #ifndef TOA_FRAME_BENDER_UTILITIES_H
 #define TOA_FRAME_BENDER_UTILITIES_H
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <iterator>
@@ -31,6 +32,10 @@
 
 namespace toa {
     namespace frame_bender {
+
+        // Used for padding data that is written by different threads.
+        static const size_t kCacheLineSize = 64;
+
         namespace utils {
 
             static std::string strip_path(const std::string& file, const char sep) {
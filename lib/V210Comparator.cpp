@@ -0,0 +1,285 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "V210Comparator.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+namespace fb = toa::frame_bender;
+
+namespace {
+
+    const size_t kNumSlots = fb::v210::CompareAccumulator::kNumSlots;
+
+    // | Cb_0, Y'_0, Cr_0 | Y'_1, Cb_2, Y'_2 | Cr_2, Y'_3, Cb_4 | Y'_4, Cr_4, Y'_5 |
+    // with Y' = 0, Cb = 1, Cr = 2
+    const size_t kSlotChannel[kNumSlots] = { 1, 0, 2, 0, 1, 0, 2, 0, 1, 0, 2, 0 };
+
+    const char* const kSlotLabel[kNumSlots] = {
+        "Cb_0", "Y'_0", "Cr_0",
+        "Y'_1", "Cb_2", "Y'_2",
+        "Cr_2", "Y'_3", "Cb_4",
+        "Y'_4", "Cr_4", "Y'_5" };
+
+    const int32_t kMinValidCode = 4;
+    const int32_t kMaxValidCode = 1019;
+
+    void reset(fb::v210::CompareAccumulator& acc) {
+        for (size_t i = 0; i<kNumSlots; ++i) {
+            acc.min_error[i] = std::numeric_limits<int32_t>::max();
+            acc.max_error[i] = 0;
+            acc.sum_squared_error[i] = 0;
+            acc.reference_min[i] = std::numeric_limits<int32_t>::max();
+            acc.reference_max[i] = std::numeric_limits<int32_t>::min();
+            acc.candidate_min[i] = std::numeric_limits<int32_t>::max();
+            acc.candidate_max[i] = std::numeric_limits<int32_t>::min();
+        }
+    }
+
+    void merge(fb::v210::CompareAccumulator& acc, const fb::v210::CompareAccumulator& other) {
+        for (size_t i = 0; i<kNumSlots; ++i) {
+            acc.min_error[i] = std::min(acc.min_error[i], other.min_error[i]);
+            acc.max_error[i] = std::max(acc.max_error[i], other.max_error[i]);
+            acc.sum_squared_error[i] += other.sum_squared_error[i];
+            acc.reference_min[i] = std::min(acc.reference_min[i], other.reference_min[i]);
+            acc.reference_max[i] = std::max(acc.reference_max[i], other.reference_max[i]);
+            acc.candidate_min[i] = std::min(acc.candidate_min[i], other.candidate_min[i]);
+            acc.candidate_max[i] = std::max(acc.candidate_max[i], other.candidate_max[i]);
+        }
+    }
+
+    struct StripeResult {
+        fb::v210::CompareAccumulator accumulator;
+        // Equals the image height if no row exceeds the tolerance
+        size_t first_mismatch_row;
+    };
+
+}
+
+std::ostream& fb::operator<< (std::ostream& out, const ChannelComparisonStatistics& v) {
+
+    out << "Channel '" << v.channel_name << "': \n";
+    out << "    " << "max_error: " << v.max_error << ", \n";
+    out << "    " << "min_error: " << v.min_error << ", \n";
+    out << "    " << "mean_sq_error: " << v.mean_squared_error << ", \n";
+    out << "    " << "PSNR: " << v.psnr << ".\n";
+
+    return out;
+}
+
+fb::V210Comparator::V210Comparator(size_t num_threads, cpu::SimdLevel max_simd_level) :
+    simd_level_(cpu::clamp_simd_level(max_simd_level)),
+    compare_row_(nullptr)
+{
+
+    switch (simd_level_) {
+    case cpu::SimdLevel::avx2:
+        compare_row_ = &v210::compare_row_avx2;
+        break;
+    case cpu::SimdLevel::sse41:
+        compare_row_ = &v210::compare_row_sse41;
+        break;
+    case cpu::SimdLevel::scalar:
+    default:
+        compare_row_ = &v210::compare_row_scalar;
+        break;
+    }
+
+    if (num_threads != 1) {
+        worker_pool_ = utils::make_unique<WorkerPool>(num_threads);
+    }
+
+}
+
+const char* fb::V210Comparator::slot_label(size_t word, size_t component) {
+    FB_ASSERT(word < 4 && component < 3);
+    return kSlotLabel[word*3 + component];
+}
+
+fb::V210Comparator::Result fb::V210Comparator::compare(
+    const ImageFormat& format, 
+    const uint8_t* reference, 
+    const uint8_t* candidate,
+    uint16_t tolerance)
+{
+
+    if (format.pixel_format() != ImageFormat::PixelFormat::YUV_10BIT_V210) {
+        FB_LOG_ERROR << "Can't compare images of format '" << format.pixel_format() << "', V210 is required.";
+        throw std::invalid_argument("V210 format is required.");
+    }
+
+    const size_t height = format.height();
+    const size_t row_size = format.image_byte_size() / height;
+
+    // ImageFormat ensures that the width is a multiple of 48, i.e. there 
+    // are no partial groups and no row padding.
+    const size_t num_groups = format.width() / 6;
+
+    const size_t num_stripes = std::min<size_t>(num_threads(), height);
+
+    std::vector<StripeResult> stripes(num_stripes);
+
+    auto compare_stripe = [&](size_t stripe, size_t) {
+
+        StripeResult& result = stripes[stripe];
+        reset(result.accumulator);
+        result.first_mismatch_row = height;
+
+        const size_t first_row = stripe * height / num_stripes;
+        const size_t end_row = (stripe + 1) * height / num_stripes;
+
+        for (size_t row = first_row; row < end_row; ++row) {
+
+            const int32_t row_max_error = compare_row_(
+                reference + row * row_size,
+                candidate + row * row_size,
+                num_groups,
+                result.accumulator);
+
+            if (row_max_error > tolerance && result.first_mismatch_row == height)
+                result.first_mismatch_row = row;
+
+        }
+
+    };
+
+    if (num_stripes == 1) {
+        compare_stripe(0, 0);
+    } else {
+        worker_pool_->run(num_stripes, compare_stripe);
+    }
+
+    v210::CompareAccumulator acc;
+    reset(acc);
+
+    size_t first_mismatch_row = height;
+
+    for (const auto& stripe : stripes) {
+        merge(acc, stripe.accumulator);
+        first_mismatch_row = std::min(first_mismatch_row, stripe.first_mismatch_row);
+    }
+
+    Result result;
+
+    result.channels[0].channel_name = "Y'";
+    result.channels[1].channel_name = "Cb";
+    result.channels[2].channel_name = "Cr";
+
+    std::array<int32_t, 3> min_error;
+    std::array<int32_t, 3> max_error;
+    std::array<int64_t, 3> sum_squared_error;
+
+    min_error.fill(std::numeric_limits<int32_t>::max());
+    max_error.fill(0);
+    sum_squared_error.fill(0);
+
+    result.reference_in_range = true;
+    result.candidate_in_range = true;
+
+    for (size_t i = 0; i<kNumSlots; ++i) {
+
+        const size_t c = kSlotChannel[i];
+
+        min_error[c] = std::min(min_error[c], acc.min_error[i]);
+        max_error[c] = std::max(max_error[c], acc.max_error[i]);
+        sum_squared_error[c] += acc.sum_squared_error[i];
+
+        result.reference_in_range = result.reference_in_range && 
+            acc.reference_min[i] >= kMinValidCode && acc.reference_max[i] <= kMaxValidCode;
+
+        result.candidate_in_range = result.candidate_in_range && 
+            acc.candidate_min[i] >= kMinValidCode && acc.candidate_max[i] <= kMaxValidCode;
+
+    }
+
+    result.max_error = *std::max_element(max_error.begin(), max_error.end());
+
+    // Note that Cb and Cr have half the sampling rate in the horizontal 
+    // direction for V210 (!)
+    const double num_luma_samples = static_cast<double>(format.width()) * height;
+    const double num_samples[3] = { num_luma_samples, num_luma_samples / 2, num_luma_samples / 2 };
+
+    for (size_t c = 0; c<3; ++c) {
+
+        ChannelComparisonStatistics& stat = result.channels[c];
+
+        stat.min_error = min_error[c];
+        stat.max_error = max_error[c];
+        stat.mean_squared_error = static_cast<double>(sum_squared_error[c]) / num_samples[c];
+
+        // TODO: should we substract the forbidden code value?
+        if (stat.mean_squared_error == 0)
+            stat.psnr = std::numeric_limits<double>::infinity();
+        else
+            stat.psnr = 20*log10(1024) - 10*log10(stat.mean_squared_error);
+
+    }
+
+    std::memset(&result.first_mismatch, 0, sizeof(result.first_mismatch));
+
+    if (first_mismatch_row < height) {
+
+        // Only the row is known so far, look for the exact position
+        const uint8_t* ref_row = reference + first_mismatch_row * row_size;
+        const uint8_t* cand_row = candidate + first_mismatch_row * row_size;
+
+        bool found = false;
+
+        for (size_t w = 0; w < num_groups * 4 && !found; ++w) {
+
+            uint32_t ref_word;
+            uint32_t cand_word;
+            std::memcpy(&ref_word, ref_row + w*4, 4);
+            std::memcpy(&cand_word, cand_row + w*4, 4);
+
+            for (size_t k = 0; k<3 && !found; ++k) {
+
+                const int32_t r = static_cast<int32_t>((ref_word >> (10*k)) & 0x3FF);
+                const int32_t c = static_cast<int32_t>((cand_word >> (10*k)) & 0x3FF);
+
+                if (std::abs(r - c) > tolerance) {
+                    result.first_mismatch.row = first_mismatch_row;
+                    result.first_mismatch.word = w;
+                    result.first_mismatch.component = k;
+                    result.first_mismatch.reference_value = r;
+                    result.first_mismatch.candidate_value = c;
+                    found = true;
+                }
+
+            }
+
+        }
+
+        FB_ASSERT(found);
+
+    }
+
+    return result;
+
+}
@@ -0,0 +1,133 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_V210_COMPARATOR_H
+#define TOA_FRAME_BENDER_V210_COMPARATOR_H
+
+#include <array>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+#include "ImageFormat.h"
+#include "CpuFeatures.h"
+#include "V210CpuKernels.h"
+#include "WorkerPool.h"
+#include "Utils.h"
+
+namespace toa {
+    namespace frame_bender {
+
+        struct ChannelComparisonStatistics {
+            std::string channel_name;
+            double min_error;
+            double max_error;
+            double mean_squared_error;
+            double psnr;
+
+            ChannelComparisonStatistics(
+                std::string channel_name, 
+                double min_error, 
+                double max_error, 
+                double mean_squared_error, 
+                double psnr)
+                :   channel_name(std::move(channel_name)),
+                    min_error(min_error),
+                    max_error(max_error),
+                    mean_squared_error(mean_squared_error),
+                    psnr(psnr)
+            {}
+
+            ChannelComparisonStatistics()
+                :   channel_name("n/a"),
+                    min_error(.0),
+                    max_error(.0),
+                    mean_squared_error(.0),
+                    psnr(.0)
+            {}
+
+        };
+
+        std::ostream& operator<< (std::ostream& out, const ChannelComparisonStatistics& v);
+
+        // Compares V210 images component by component (without decoding to
+        // RGB), using the SIMD compare_row_* kernels on horizontal stripes
+        // of the image in parallel.
+        class V210Comparator : public utils::NoCopyingOrMoving {
+
+        public:
+
+            struct Result {
+
+                // Y', Cb, Cr
+                std::array<ChannelComparisonStatistics, 3> channels;
+
+                // Largest absolute error of any channel
+                int32_t max_error;
+
+                // False if any code value is outside of [4, 1019]
+                bool reference_in_range;
+                bool candidate_in_range;
+
+                // Valid if max_error exceeds the tolerance. Position of the
+                // first component (in memory order) that does.
+                struct Mismatch {
+                    size_t row;
+                    size_t word;
+                    size_t component;
+                    int32_t reference_value;
+                    int32_t candidate_value;
+                } first_mismatch;
+
+                bool is_within(uint16_t tolerance) const {
+                    return reference_in_range && candidate_in_range && max_error <= tolerance;
+                }
+
+            };
+
+            // A num_threads value of 0 uses one thread per hardware thread.
+            V210Comparator(size_t num_threads, cpu::SimdLevel max_simd_level);
+
+            // Both images must be of the given format. Not thread-safe.
+            Result compare(
+                const ImageFormat& format, 
+                const uint8_t* reference, 
+                const uint8_t* candidate,
+                uint16_t tolerance);
+
+            size_t num_threads() const { return worker_pool_ ? worker_pool_->num_workers() : 1; }
+            cpu::SimdLevel simd_level() const { return simd_level_; }
+
+            // Name of the V210 component at the given slot, e.g. "Cb_0"
+            static const char* slot_label(size_t word, size_t component);
+
+        private:
+
+            cpu::SimdLevel simd_level_;
+            v210::CompareRowFunction compare_row_;
+            std::unique_ptr<WorkerPool> worker_pool_;
+
+        };
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_V210_COMPARATOR_H
@@ -0,0 +1,202 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_V210_CPU_KERNELS_H
+#define TOA_FRAME_BENDER_V210_CPU_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Row kernels for converting V210 from/to RGBA on the host. These are the
+// CPU equivalents of the v210_decode_* and v210_encode_* GLSL converters and 
+// follow them closely, so that the output can be compared against the GPU
+// path (see FormatConverterStage's Mode::cpu_simd).
+//
+// Note that this header must stay free of any non-trivial includes, since it
+// is included by translation units that are compiled with ISA-specific
+// compiler flags (-msse4.1, -mavx2, ...). Inline functions from other headers
+// compiled with such flags might end up being picked by the linker for
+// the whole binary.
+
+namespace toa {
+    namespace frame_bender {
+        namespace v210 {
+
+            // Layout of the RGBA host memory, matches the GL data types in
+            // ImageFormat::gl_native_format()
+            enum class RgbaLayout : int32_t {
+                unorm16,
+                half_float,
+                float32
+            };
+
+            // Integer representation of the GLSL chroma filters. All GLSL 
+            // weights are of the form k/2^n, and all the sample values are 
+            // 10 bit integers, so the float accumulation in the shaders is 
+            // exact and can be reproduced bit-exactly with integer MADs 
+            // followed by a truncating division (= GLSL's int()). For 
+            // decoding, the taps are given in 4:2:2 chroma samples, for 
+            // encoding in 4:4:4 samples.
+            struct ChromaTaps {
+                static const int32_t kMaxCount = 13;
+                int32_t weights[kMaxCount];
+                int32_t count;
+                // Index of the first tap relative to the filtered position
+                int32_t first;
+                // Divisor of the weights as power of two
+                int32_t shift;
+            };
+
+            // Number of padding samples (on each side) of the chroma scratch 
+            // rows. Must be >= the largest filter support plus the widest
+            // vector width.
+            static const size_t kChromaPadding = 16;
+
+            struct ConversionSetup {
+                // Width in pixels, must be a multiple of 48 (see ImageFormat)
+                size_t width;
+                RgbaLayout rgba_layout;
+                ChromaTaps taps;
+                // Column-major 3x3 matrix (like GLSL's mat3x3), converts
+                // between R'G'B' and symmetric Y'CbCr (without binary offset),
+                // i.e. the inverse matrix for decoding.
+                float matrix[9];
+                // If true, R'G'B' is converted from/to linear RGB via the
+                // sRGB transfer function (FB_GLSL_LINEAR_RGB)
+                bool linear_rgb;
+                // Optional, only for encoding from 16 bit RGBA layouts with
+                // linear_rgb enabled. Maps each 16 bit input code to its 
+                // R'G'B' value, see build_encode_transfer_table().
+                const float* transfer_table;
+            };
+
+            // Number of entries of ConversionSetup::transfer_table
+            static const size_t kTransferTableSize = 1 << 16;
+
+            // Evaluating the transfer function is by far the most expensive 
+            // part of encoding, this replaces it by a lookup for the 16 bit 
+            // layouts. The entries are the same as computed by any of the 
+            // encode_row_* kernels.
+            void build_encode_transfer_table(RgbaLayout layout, float* table);
+
+            // Scratch memory required by the row kernels. All rows must hold
+            // at least width + 2*kChromaPadding elements. When encoding, 
+            // cb/cr hold the even and cb_full/cr_full the odd 4:4:4 chroma 
+            // samples of the row.
+            struct RowBuffers {
+                int32_t* luma;
+                int32_t* cb;
+                int32_t* cr;
+                int32_t* cb_full;
+                int32_t* cr_full;
+            };
+
+            // Converts a single row, from V210 to RGBA (decode_row_*) or
+            // from RGBA to V210 (encode_row_*).
+            typedef void (*RowFunction)(
+                const ConversionSetup& setup,
+                const uint8_t* src_row,
+                uint8_t* dst_row,
+                const RowBuffers& buffers);
+
+            void decode_row_scalar(
+                const ConversionSetup& setup,
+                const uint8_t* v210_row,
+                uint8_t* rgba_row,
+                const RowBuffers& buffers);
+
+            void decode_row_sse41(
+                const ConversionSetup& setup,
+                const uint8_t* v210_row,
+                uint8_t* rgba_row,
+                const RowBuffers& buffers);
+
+            void decode_row_avx2(
+                const ConversionSetup& setup,
+                const uint8_t* v210_row,
+                uint8_t* rgba_row,
+                const RowBuffers& buffers);
+
+            void encode_row_scalar(
+                const ConversionSetup& setup,
+                const uint8_t* rgba_row,
+                uint8_t* v210_row,
+                const RowBuffers& buffers);
+
+            void encode_row_sse41(
+                const ConversionSetup& setup,
+                const uint8_t* rgba_row,
+                uint8_t* v210_row,
+                const RowBuffers& buffers);
+
+            void encode_row_avx2(
+                const ConversionSetup& setup,
+                const uint8_t* rgba_row,
+                uint8_t* v210_row,
+                const RowBuffers& buffers);
+
+            // Running statistics of comparing two V210 images. All values
+            // are kept per position within a V210 group, i.e. per slot 
+            // word*3 + component (see V210Comparator for the mapping to 
+            // Y'CbCr channels). The errors are absolute differences.
+            struct CompareAccumulator {
+                static const size_t kNumSlots = 12;
+                int32_t min_error[kNumSlots];
+                int32_t max_error[kNumSlots];
+                int64_t sum_squared_error[kNumSlots];
+                int32_t reference_min[kNumSlots];
+                int32_t reference_max[kNumSlots];
+                int32_t candidate_min[kNumSlots];
+                int32_t candidate_max[kNumSlots];
+            };
+
+            // Compares num_groups V210 groups of two rows and adds the
+            // result to the accumulator. Returns the largest absolute error
+            // within the row.
+            typedef int32_t (*CompareRowFunction)(
+                const uint8_t* reference_row,
+                const uint8_t* candidate_row,
+                size_t num_groups,
+                CompareAccumulator& accumulator);
+
+            int32_t compare_row_scalar(
+                const uint8_t* reference_row,
+                const uint8_t* candidate_row,
+                size_t num_groups,
+                CompareAccumulator& accumulator);
+
+            int32_t compare_row_sse41(
+                const uint8_t* reference_row,
+                const uint8_t* candidate_row,
+                size_t num_groups,
+                CompareAccumulator& accumulator);
+
+            int32_t compare_row_avx2(
+                const uint8_t* reference_row,
+                const uint8_t* candidate_row,
+                size_t num_groups,
+                CompareAccumulator& accumulator);
+
+        }
+    }
+}
+
+#endif // TOA_FRAME_BENDER_V210_CPU_KERNELS_H
@@ -0,0 +1,904 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+// Generic implementation of the V210 row kernels declared in V210CpuKernels.h.
+// The code is written against a small "vector traits" interface V, which 
+// provides the arithmetic and load/store primitives for one instruction set:
+//
+//      V::F, V::I, V::M    float vector, int32 vector and comparison mask
+//      V::kWidth           number of lanes
+//      fset1, fadd, ...    arithmetic, see the scalar traits for reference
+//      unpack_v210_row     V210 row -> separate Y', Cb, Cr int32 rows
+//      pack_v210_groups    separate Y', Cb, Cr int32 rows -> V210 groups
+//      zip, unzip          interleaves/deinterleaves two int vectors
+//      store_rgba          stores kWidth pixels as RGBA with alpha = 1
+//      load_rgb            loads kWidth RGBA pixels, dropping alpha
+//      load_rgb_codes      same for 16 bit layouts, without conversion
+//      gather              table lookup
+//
+// This file may only be included by the kernel translation units, after the
+// traits type has been defined in an anonymous namespace (which gives all 
+// instantiations internal linkage).
+
+#ifndef TOA_FRAME_BENDER_V210_CPU_KERNELS_INL_H
+#define TOA_FRAME_BENDER_V210_CPU_KERNELS_INL_H
+
+#include "V210CpuKernels.h"
+
+namespace toa {
+    namespace frame_bender {
+        namespace v210 {
+            namespace detail {
+
+                template <typename V>
+                struct RowKernels {
+
+                    typedef typename V::F F;
+                    typedef typename V::I I;
+                    typedef typename V::M M;
+
+                    // See Cephes' logf, x must be > 0
+                    static F log_positive(F x) {
+
+                        const I bits = V::icast(x);
+
+                        // frexp, x is [0.5, 1) afterwards
+                        F e = V::i2f(V::isub(V::isrl(bits, 23), V::iset1(126)));
+                        x = V::fcast(V::ior(V::iand(bits, V::iset1(0x007fffff)), V::iset1(0x3f000000)));
+
+                        const F one = V::fset1(1.0f);
+                        const M is_small = V::cmplt(x, V::fset1(0.707106781186547524f));
+
+                        e = V::fselect(is_small, V::fsub(e, one), e);
+                        x = V::fselect(is_small, V::fsub(V::fadd(x, x), one), V::fsub(x, one));
+
+                        const F z = V::fmul(x, x);
+
+                        F y = V::fset1(7.0376836292e-2f);
+                        y = V::fadd(V::fmul(y, x), V::fset1(-1.1514610310e-1f));
+                        y = V::fadd(V::fmul(y, x), V::fset1(1.1676998740e-1f));
+                        y = V::fadd(V::fmul(y, x), V::fset1(-1.2420140846e-1f));
+                        y = V::fadd(V::fmul(y, x), V::fset1(1.4249322787e-1f));
+                        y = V::fadd(V::fmul(y, x), V::fset1(-1.6668057665e-1f));
+                        y = V::fadd(V::fmul(y, x), V::fset1(2.0000714765e-1f));
+                        y = V::fadd(V::fmul(y, x), V::fset1(-2.4999993993e-1f));
+                        y = V::fadd(V::fmul(y, x), V::fset1(3.3333331174e-1f));
+                        y = V::fmul(V::fmul(y, x), z);
+
+                        y = V::fadd(y, V::fmul(e, V::fset1(-2.12194440e-4f)));
+                        y = V::fsub(y, V::fmul(z, V::fset1(0.5f)));
+
+                        x = V::fadd(x, y);
+                        x = V::fadd(x, V::fmul(e, V::fset1(0.693359375f)));
+
+                        return x;
+                    }
+
+                    // See Cephes' expf
+                    static F exp(F x) {
+
+                        x = V::fmin(x, V::fset1(88.3762626647949f));
+                        x = V::fmax(x, V::fset1(-88.3762626647949f));
+
+                        F fx = V::ffloor(V::fadd(V::fmul(x, V::fset1(1.44269504088896341f)), V::fset1(0.5f)));
+
+                        x = V::fsub(x, V::fmul(fx, V::fset1(0.693359375f)));
+                        x = V::fsub(x, V::fmul(fx, V::fset1(-2.12194440e-4f)));
+
+                        const F z = V::fmul(x, x);
+
+                        F y = V::fset1(1.9875691500e-4f);
+                        y = V::fadd(V::fmul(y, x), V::fset1(1.3981999507e-3f));
+                        y = V::fadd(V::fmul(y, x), V::fset1(8.3334519073e-3f));
+                        y = V::fadd(V::fmul(y, x), V::fset1(4.1665795894e-2f));
+                        y = V::fadd(V::fmul(y, x), V::fset1(1.6666665459e-1f));
+                        y = V::fadd(V::fmul(y, x), V::fset1(5.0000001201e-1f));
+                        y = V::fadd(V::fadd(V::fmul(y, z), x), V::fset1(1.0f));
+
+                        // Build 2^fx
+                        const I pow2n = V::isll(V::iadd(V::f2i_trunc(fx), V::iset1(127)), 23);
+
+                        return V::fmul(y, V::fcast(pow2n));
+                    }
+
+                    // x must be > 0, otherwise result is undefined
+                    static F pow_positive(F x, float y) {
+                        return exp(V::fmul(log_positive(x), V::fset1(y)));
+                    }
+
+                    // Same as srgb_to_linear_component() in common.glsl, 
+                    // including the overlap of both segments at the edge.
+                    static F srgb_to_linear(F c) {
+
+                        const F zero = V::fset1(.0f);
+                        const F edge = V::fset1(0.04045f);
+
+                        const F linear_segment = V::fdiv(c, V::fset1(12.92f));
+
+                        // Clamp base to a small positive value, the result 
+                        // is discarded for those lanes anyway
+                        const F base = V::fmax(
+                            V::fdiv(V::fadd(c, V::fset1(0.055f)), V::fset1(1.055f)), 
+                            V::fset1(1e-6f));
+
+                        const F power_segment = pow_positive(base, 2.4f);
+
+                        return V::fadd(
+                            V::fselect(V::cmple(c, edge), linear_segment, zero),
+                            V::fselect(V::cmple(edge, c), power_segment, zero));
+                    }
+
+                    // Same as linear_to_srgb_component() in common.glsl
+                    static F linear_to_srgb(F c) {
+
+                        const F zero = V::fset1(.0f);
+                        const F edge = V::fset1(0.0031308f);
+
+                        const F linear_segment = V::fmul(c, V::fset1(12.92f));
+
+                        // pow(0, y) is 0 in GLSL, but we need a positive base
+                        // for log(). Lanes below the edge are discarded.
+                        const F base = V::fmax(c, V::fset1(1e-6f));
+
+                        const F power_segment = V::fsub(
+                            V::fmul(V::fset1(1.055f), pow_positive(base, 0.41666f)), 
+                            V::fset1(0.055f));
+
+                        return V::fadd(
+                            V::fselect(V::cmple(c, edge), linear_segment, zero),
+                            V::fselect(V::cmple(edge, c), power_segment, zero));
+                    }
+
+                    static void replicate_edges(int32_t* row, size_t count) {
+
+                        const int32_t first = row[0];
+                        const int32_t last = row[count-1];
+
+                        for (size_t i = 1; i<=kChromaPadding; ++i) {
+                            *(row - i) = first;
+                            row[count - 1 + i] = last;
+                        }
+
+                    }
+
+                    static I accumulate(I acc, const int32_t* src, const ChromaTaps& taps) {
+
+                        for (int32_t j = 0; j<taps.count; ++j) {
+                            acc = V::iadd(
+                                acc, 
+                                V::imul(
+                                    V::iloadu(src + taps.first + j), 
+                                    V::iset1(taps.weights[j])));
+                        }
+
+                        return acc;
+                    }
+
+                    // Divides by 2^shift, truncates like GLSL's int() (i.e.
+                    // towards zero).
+                    static I truncate(I acc, int32_t shift) {
+
+                        if (shift > 0) {
+                            const I bias = V::iand(
+                                V::isra(acc, 31), 
+                                V::iset1((1 << shift) - 1));
+                            acc = V::isra(V::iadd(acc, bias), shift);
+                        }
+
+                        return acc;
+                    }
+
+                    // Applies the filter taps around src
+                    static I filter(const int32_t* src, const ChromaTaps& taps) {
+                        return truncate(accumulate(V::iset1(0), src, taps), taps.shift);
+                    }
+
+                    // Splits 4:4:4 taps into the ones hitting even and odd
+                    // samples when filtering at an even position. Allows to
+                    // evaluate the filter on deinterleaved rows, i.e. only
+                    // at the positions which survive the subsampling.
+                    static void split_taps(
+                        const ChromaTaps& taps, 
+                        ChromaTaps& even, 
+                        ChromaTaps& odd)
+                    {
+
+                        even.count = 0;
+                        even.first = 0;
+                        even.shift = taps.shift;
+                        odd = even;
+
+                        for (int32_t j = 0; j<taps.count; ++j) {
+
+                            const int32_t offset = taps.first + j;
+                            const bool is_odd = (offset & 1) != 0;
+
+                            ChromaTaps& t = is_odd ? odd : even;
+
+                            if (t.count == 0)
+                                t.first = (offset - (is_odd ? 1 : 0)) / 2;
+
+                            t.weights[t.count++] = taps.weights[j];
+                        }
+
+                    }
+
+                    static size_t rgba_pixel_size(RgbaLayout layout) {
+                        return layout == RgbaLayout::float32 ? 16 : 8;
+                    }
+
+                    static void decode_row(
+                        const ConversionSetup& setup,
+                        const uint8_t* v210_row,
+                        uint8_t* rgba_row,
+                        const RowBuffers& buffers)
+                    {
+
+                        const size_t width = setup.width;
+                        const size_t chroma_width = width / 2;
+
+                        int32_t* const luma = buffers.luma;
+                        int32_t* const cb = buffers.cb + kChromaPadding;
+                        int32_t* const cr = buffers.cr + kChromaPadding;
+
+                        V::unpack_v210_row(v210_row, width, luma, cb, cr);
+
+                        // Same as clamp_left/clamp_right in 
+                        // v210_decode_ycbcr_lookup.glsl
+                        replicate_edges(cb, chroma_width);
+                        replicate_edges(cr, chroma_width);
+
+                        // Cosited samples are taken as they are, the ones in
+                        // between are interpolated.
+                        for (size_t k = 0; k<chroma_width; k += V::kWidth) {
+
+                            I lo;
+                            I hi;
+
+                            V::zip(V::iloadu(cb + k), filter(cb + k, setup.taps), lo, hi);
+                            V::istoreu(buffers.cb_full + 2*k, lo);
+                            V::istoreu(buffers.cb_full + 2*k + V::kWidth, hi);
+
+                            V::zip(V::iloadu(cr + k), filter(cr + k, setup.taps), lo, hi);
+                            V::istoreu(buffers.cr_full + 2*k, lo);
+                            V::istoreu(buffers.cr_full + 2*k + V::kWidth, hi);
+
+                        }
+
+                        const float* m = setup.matrix;
+                        const F m0 = V::fset1(m[0]); const F m1 = V::fset1(m[1]); const F m2 = V::fset1(m[2]);
+                        const F m3 = V::fset1(m[3]); const F m4 = V::fset1(m[4]); const F m5 = V::fset1(m[5]);
+                        const F m6 = V::fset1(m[6]); const F m7 = V::fset1(m[7]); const F m8 = V::fset1(m[8]);
+
+                        const I luma_offset = V::iset1(64);
+                        const I chroma_offset = V::iset1(512);
+
+                        const size_t pixel_size = rgba_pixel_size(setup.rgba_layout);
+
+                        for (size_t x = 0; x<width; x += V::kWidth) {
+
+                            const F y = V::i2f(V::isub(V::iloadu(luma + x), luma_offset));
+                            const F u = V::i2f(V::isub(V::iloadu(buffers.cb_full + x), chroma_offset));
+                            const F v = V::i2f(V::isub(V::iloadu(buffers.cr_full + x), chroma_offset));
+
+                            F r = V::fadd(V::fadd(V::fmul(m0, y), V::fmul(m3, u)), V::fmul(m6, v));
+                            F g = V::fadd(V::fadd(V::fmul(m1, y), V::fmul(m4, u)), V::fmul(m7, v));
+                            F b = V::fadd(V::fadd(V::fmul(m2, y), V::fmul(m5, u)), V::fmul(m8, v));
+
+                            if (setup.linear_rgb) {
+                                r = srgb_to_linear(r);
+                                g = srgb_to_linear(g);
+                                b = srgb_to_linear(b);
+                            }
+
+                            V::store_rgba(setup.rgba_layout, r, g, b, rgba_row + x*pixel_size);
+
+                        }
+
+                    }
+
+
+                    static void rgb_to_ycbcr(
+                        const ConversionSetup& setup,
+                        const F* m,
+                        const uint8_t* rgba,
+                        I& y,
+                        I& cb,
+                        I& cr)
+                    {
+
+                        F r;
+                        F g;
+                        F b;
+
+                        if (setup.transfer_table != nullptr) {
+
+                            I r_code;
+                            I g_code;
+                            I b_code;
+
+                            V::load_rgb_codes(rgba, r_code, g_code, b_code);
+
+                            r = V::gather(setup.transfer_table, r_code);
+                            g = V::gather(setup.transfer_table, g_code);
+                            b = V::gather(setup.transfer_table, b_code);
+
+                        } else {
+
+                            V::load_rgb(setup.rgba_layout, rgba, r, g, b);
+
+                            if (setup.linear_rgb) {
+                                r = linear_to_srgb(r);
+                                g = linear_to_srgb(g);
+                                b = linear_to_srgb(b);
+                            }
+
+                        }
+
+                        const I min_value = V::iset1(4);
+                        const I max_value = V::iset1(1019);
+
+                        // roundEven() + binary offset, clamped to the 
+                        // allowed range, like v210_encode_lookup_and_rgba_to_ycbcr.glsl
+                        y = V::f2i_round(V::fadd(V::fadd(V::fmul(m[0], r), V::fmul(m[3], g)), V::fmul(m[6], b)));
+                        cb = V::f2i_round(V::fadd(V::fadd(V::fmul(m[1], r), V::fmul(m[4], g)), V::fmul(m[7], b)));
+                        cr = V::f2i_round(V::fadd(V::fadd(V::fmul(m[2], r), V::fmul(m[5], g)), V::fmul(m[8], b)));
+
+                        y = V::imin(V::imax(V::iadd(y, V::iset1(64)), min_value), max_value);
+                        cb = V::imin(V::imax(V::iadd(cb, V::iset1(512)), min_value), max_value);
+                        cr = V::imin(V::imax(V::iadd(cr, V::iset1(512)), min_value), max_value);
+
+                    }
+
+                    // Replicates the first/last sample of a deinterleaved
+                    // row, same as the clamping of the pixel coordinate in 
+                    // v210_encode_glsl_*.
+                    static void replicate_edges(int32_t* even, int32_t* odd, size_t count) {
+
+                        const int32_t first = even[0];
+                        const int32_t last = odd[count-1];
+
+                        for (size_t i = 1; i<=kChromaPadding; ++i) {
+                            *(even - i) = first;
+                            *(odd - i) = first;
+                            even[count - 1 + i] = last;
+                            odd[count - 1 + i] = last;
+                        }
+
+                    }
+
+                    static void encode_row(
+                        const ConversionSetup& setup,
+                        const uint8_t* rgba_row,
+                        uint8_t* v210_row,
+                        const RowBuffers& buffers)
+                    {
+
+                        // Pixels per iteration of the packing loop, must be
+                        // a multiple of 6 (V210 group) and 2*kWidth.
+                        static const size_t kPixelsPerChunk = 48;
+
+                        const size_t width = setup.width;
+                        const size_t chroma_width = width / 2;
+
+                        int32_t* const luma = buffers.luma;
+                        int32_t* const cb_even = buffers.cb + kChromaPadding;
+                        int32_t* const cr_even = buffers.cr + kChromaPadding;
+                        int32_t* const cb_odd = buffers.cb_full + kChromaPadding;
+                        int32_t* const cr_odd = buffers.cr_full + kChromaPadding;
+
+                        F m[9];
+                        for (size_t i = 0; i<9; ++i)
+                            m[i] = V::fset1(setup.matrix[i]);
+
+                        const size_t pixel_size = rgba_pixel_size(setup.rgba_layout);
+
+                        for (size_t x = 0; x<width; x += 2*V::kWidth) {
+
+                            I y0, cb0, cr0;
+                            I y1, cb1, cr1;
+
+                            rgb_to_ycbcr(setup, m, rgba_row + x*pixel_size, y0, cb0, cr0);
+                            rgb_to_ycbcr(setup, m, rgba_row + (x + V::kWidth)*pixel_size, y1, cb1, cr1);
+
+                            V::istoreu(luma + x, y0);
+                            V::istoreu(luma + x + V::kWidth, y1);
+
+                            I even;
+                            I odd;
+
+                            V::unzip(cb0, cb1, even, odd);
+                            V::istoreu(cb_even + x/2, even);
+                            V::istoreu(cb_odd + x/2, odd);
+
+                            V::unzip(cr0, cr1, even, odd);
+                            V::istoreu(cr_even + x/2, even);
+                            V::istoreu(cr_odd + x/2, odd);
+
+                        }
+
+                        replicate_edges(cb_even, cb_odd, chroma_width);
+                        replicate_edges(cr_even, cr_odd, chroma_width);
+
+                        ChromaTaps even_taps;
+                        ChromaTaps odd_taps;
+                        split_taps(setup.taps, even_taps, odd_taps);
+
+                        const I min_value = V::iset1(4);
+                        const I max_value = V::iset1(1019);
+
+                        // One extra element, the packing reads 4 chroma 
+                        // samples per group
+                        int32_t cb_sub[kPixelsPerChunk/2 + 1];
+                        int32_t cr_sub[kPixelsPerChunk/2 + 1];
+                        cb_sub[kPixelsPerChunk/2] = 0;
+                        cr_sub[kPixelsPerChunk/2] = 0;
+
+                        for (size_t x = 0; x<width; x += kPixelsPerChunk) {
+
+                            for (size_t j = 0; j<kPixelsPerChunk/2; j += V::kWidth) {
+
+                                const size_t k = x/2 + j;
+
+                                // Note that the GLSL version doesn't clamp
+                                // the filtered values, which only makes a
+                                // difference for overshooting filters. We
+                                // don't want to write reserved values.
+                                I acc = accumulate(V::iset1(0), cb_even + k, even_taps);
+                                acc = truncate(accumulate(acc, cb_odd + k, odd_taps), setup.taps.shift);
+                                V::istoreu(cb_sub + j, V::imin(V::imax(acc, min_value), max_value));
+
+                                acc = accumulate(V::iset1(0), cr_even + k, even_taps);
+                                acc = truncate(accumulate(acc, cr_odd + k, odd_taps), setup.taps.shift);
+                                V::istoreu(cr_sub + j, V::imin(V::imax(acc, min_value), max_value));
+
+                            }
+
+                            V::pack_v210_groups(
+                                luma + x, 
+                                cb_sub, 
+                                cr_sub, 
+                                kPixelsPerChunk/6, 
+                                v210_row + (x/6)*16);
+
+                        }
+
+                    }
+
+                    // Not using std::min/max here, see V210CpuKernels.h
+                    static int32_t min_of(int32_t a, int32_t b) { return a < b ? a : b; }
+                    static int32_t max_of(int32_t a, int32_t b) { return a > b ? a : b; }
+
+                    static void update_slot(
+                        CompareAccumulator& acc, 
+                        size_t slot, 
+                        int32_t min_error,
+                        int32_t max_error,
+                        int32_t reference_min,
+                        int32_t reference_max,
+                        int32_t candidate_min,
+                        int32_t candidate_max)
+                    {
+                        acc.min_error[slot] = min_of(acc.min_error[slot], min_error);
+                        acc.max_error[slot] = max_of(acc.max_error[slot], max_error);
+                        acc.reference_min[slot] = min_of(acc.reference_min[slot], reference_min);
+                        acc.reference_max[slot] = max_of(acc.reference_max[slot], reference_max);
+                        acc.candidate_min[slot] = min_of(acc.candidate_min[slot], candidate_min);
+                        acc.candidate_max[slot] = max_of(acc.candidate_max[slot], candidate_max);
+                    }
+
+                    static int32_t compare_row(
+                        const uint8_t* reference_row,
+                        const uint8_t* candidate_row,
+                        size_t num_groups,
+                        CompareAccumulator& acc)
+                    {
+
+                        // Stepping by a multiple of 4 words keeps every lane
+                        // on the same slot of the V210 group, so the slots 
+                        // only have to be told apart after the loop.
+                        static const size_t kNumVectors = V::kWidth < 4 ? 4 / V::kWidth : 1;
+                        static const size_t kStep = kNumVectors * V::kWidth;
+
+                        // Squared errors are summed up in 32 bit lanes, 
+                        // which holds at least 2047 * 1023^2.
+                        static const size_t kFlushInterval = 1024;
+
+                        const int32_t* ref_words = reinterpret_cast<const int32_t*>(reference_row);
+                        const int32_t* cand_words = reinterpret_cast<const int32_t*>(candidate_row);
+
+                        const size_t num_words = num_groups * 4;
+                        const size_t num_vector_words = num_words - num_words % kStep;
+
+                        const I zero = V::iset1(0);
+                        const I mask = V::iset1(0x3FF);
+
+                        I min_error[kNumVectors][3];
+                        I max_error[kNumVectors][3];
+                        I sum_squared_error[kNumVectors][3];
+                        I ref_min[kNumVectors][3];
+                        I ref_max[kNumVectors][3];
+                        I cand_min[kNumVectors][3];
+                        I cand_max[kNumVectors][3];
+
+                        for (size_t v = 0; v<kNumVectors; ++v) {
+                            for (size_t k = 0; k<3; ++k) {
+                                min_error[v][k] = V::iset1(0x3FF);
+                                max_error[v][k] = zero;
+                                sum_squared_error[v][k] = zero;
+                                ref_min[v][k] = V::iset1(0x3FF);
+                                ref_max[v][k] = zero;
+                                cand_min[v][k] = V::iset1(0x3FF);
+                                cand_max[v][k] = zero;
+                            }
+                        }
+
+                        int32_t lanes[V::kWidth];
+
+                        auto flush_sums = [&]() {
+                            for (size_t v = 0; v<kNumVectors; ++v) {
+                                for (size_t k = 0; k<3; ++k) {
+                                    V::istoreu(lanes, sum_squared_error[v][k]);
+                                    for (size_t l = 0; l<V::kWidth; ++l) {
+                                        acc.sum_squared_error[((v*V::kWidth + l) % 4)*3 + k] += lanes[l];
+                                    }
+                                    sum_squared_error[v][k] = zero;
+                                }
+                            }
+                        };
+
+                        size_t steps_since_flush = 0;
+
+                        for (size_t w = 0; w<num_vector_words; w += kStep) {
+
+                            for (size_t v = 0; v<kNumVectors; ++v) {
+
+                                const I ref = V::iloadu(ref_words + w + v*V::kWidth);
+                                const I cand = V::iloadu(cand_words + w + v*V::kWidth);
+
+                                for (size_t k = 0; k<3; ++k) {
+
+                                    const I r = V::iand(V::isrl(ref, static_cast<int32_t>(10*k)), mask);
+                                    const I c = V::iand(V::isrl(cand, static_cast<int32_t>(10*k)), mask);
+
+                                    const I d = V::isub(r, c);
+                                    const I e = V::imax(d, V::isub(zero, d));
+
+                                    min_error[v][k] = V::imin(min_error[v][k], e);
+                                    max_error[v][k] = V::imax(max_error[v][k], e);
+                                    sum_squared_error[v][k] = V::iadd(sum_squared_error[v][k], V::imul(e, e));
+
+                                    ref_min[v][k] = V::imin(ref_min[v][k], r);
+                                    ref_max[v][k] = V::imax(ref_max[v][k], r);
+                                    cand_min[v][k] = V::imin(cand_min[v][k], c);
+                                    cand_max[v][k] = V::imax(cand_max[v][k], c);
+
+                                }
+
+                            }
+
+                            if (++steps_since_flush == kFlushInterval) {
+                                flush_sums();
+                                steps_since_flush = 0;
+                            }
+
+                        }
+
+                        flush_sums();
+
+                        int32_t row_max_error = 0;
+
+                        int32_t min_e[V::kWidth];
+                        int32_t max_e[V::kWidth];
+                        int32_t r_min[V::kWidth];
+                        int32_t r_max[V::kWidth];
+                        int32_t c_min[V::kWidth];
+                        int32_t c_max[V::kWidth];
+
+                        if (num_vector_words > 0) {
+
+                            for (size_t v = 0; v<kNumVectors; ++v) {
+                                for (size_t k = 0; k<3; ++k) {
+
+                                    V::istoreu(min_e, min_error[v][k]);
+                                    V::istoreu(max_e, max_error[v][k]);
+                                    V::istoreu(r_min, ref_min[v][k]);
+                                    V::istoreu(r_max, ref_max[v][k]);
+                                    V::istoreu(c_min, cand_min[v][k]);
+                                    V::istoreu(c_max, cand_max[v][k]);
+
+                                    for (size_t l = 0; l<V::kWidth; ++l) {
+                                        update_slot(
+                                            acc, 
+                                            ((v*V::kWidth + l) % 4)*3 + k,
+                                            min_e[l], max_e[l], 
+                                            r_min[l], r_max[l], 
+                                            c_min[l], c_max[l]);
+                                        row_max_error = max_of(row_max_error, max_e[l]);
+                                    }
+
+                                }
+                            }
+
+                        }
+
+                        // Remaining words if the vectors span several groups
+                        for (size_t w = num_vector_words; w<num_words; ++w) {
+                            for (size_t k = 0; k<3; ++k) {
+
+                                const int32_t r = (ref_words[w] >> (10*k)) & 0x3FF;
+                                const int32_t c = (cand_words[w] >> (10*k)) & 0x3FF;
+                                const int32_t e = r > c ? r - c : c - r;
+
+                                const size_t slot = (w % 4)*3 + k;
+                                update_slot(acc, slot, e, e, r, r, c, c);
+                                acc.sum_squared_error[slot] += e*e;
+                                row_max_error = max_of(row_max_error, e);
+
+                            }
+                        }
+
+                        return row_max_error;
+
+                    }
+
+                };
+
+            }
+        }
+    }
+}
+
+#if defined(FB_V210_CPU_KERNELS_SSE41)
+
+#include <smmintrin.h>
+
+namespace toa {
+    namespace frame_bender {
+        namespace v210 {
+            namespace detail {
+
+                // 128 bit helpers shared by the SSE4.1 and AVX2 kernels. Note
+                // that these are static to keep them local to the ISA-specific
+                // translation unit.
+                namespace sse {
+
+                    // Unpacks one V210 group (4 words, 6 pixels). Writes 4 
+                    // values to cb/cr and 6 to luma, of which the last Cb/Cr
+                    // value is garbage (and overwritten by the next group).
+                    static inline void unpack_v210_group(
+                        const uint8_t* src, 
+                        int32_t* luma, 
+                        int32_t* cb, 
+                        int32_t* cr)
+                    {
+
+                        const __m128i mask = _mm_set1_epi32(0x3FF);
+                        const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+                        // c0 = | Cb_0, Y'_1, Cr_2, Y'_4 |
+                        // c1 = | Y'_0, Cb_2, Y'_3, Cr_4 |
+                        // c2 = | Cr_0, Y'_2, Cb_4, Y'_5 |
+                        const __m128i c0 = _mm_and_si128(words, mask);
+                        const __m128i c1 = _mm_and_si128(_mm_srli_epi32(words, 10), mask);
+                        const __m128i c2 = _mm_and_si128(_mm_srli_epi32(words, 20), mask);
+
+                        __m128i cb_vec = _mm_blend_epi16(c0, c1, 0x0C);
+                        cb_vec = _mm_blend_epi16(cb_vec, c2, 0x30);
+
+                        __m128i cr_vec = _mm_blend_epi16(c2, c0, 0x30);
+                        cr_vec = _mm_blend_epi16(cr_vec, c1, 0xC0);
+                        cr_vec = _mm_shuffle_epi32(cr_vec, _MM_SHUFFLE(3, 3, 2, 0));
+
+                        __m128i luma_0_3 = _mm_shuffle_epi32(c1, _MM_SHUFFLE(2, 2, 1, 0));
+                        luma_0_3 = _mm_blend_epi16(luma_0_3, c0, 0x0C);
+                        luma_0_3 = _mm_blend_epi16(luma_0_3, _mm_shuffle_epi32(c2, _MM_SHUFFLE(1, 1, 1, 1)), 0x30);
+
+                        const __m128i c0_c2_hi = _mm_unpackhi_epi32(c0, c2);
+                        const __m128i luma_4_5 = _mm_unpackhi_epi64(c0_c2_hi, c0_c2_hi);
+
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(luma), luma_0_3);
+                        _mm_storel_epi64(reinterpret_cast<__m128i*>(luma + 4), luma_4_5);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(cb), cb_vec);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(cr), cr_vec);
+
+                    }
+
+                    // Vectorized version of the scalar RTNE conversion (see 
+                    // V210CpuKernelsScalar.cpp). The half values are returned
+                    // sign-extended in the 32 bit lanes, ready for 
+                    // _mm_packs_epi32.
+                    static inline __m128i float_to_half(__m128 f) {
+
+                        const __m128i mask_sign = _mm_set1_epi32(static_cast<int>(0x80000000u));
+                        const __m128i f16max = _mm_set1_epi32((127 + 16) << 23);
+                        const __m128i nan_bit = _mm_set1_epi32(0x200);
+                        const __m128i infty_as_fp16 = _mm_set1_epi32(0x7c00);
+                        const __m128i min_normal = _mm_set1_epi32((127 - 14) << 23);
+                        const __m128i subnorm_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+                        const __m128i normal_bias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+                        const __m128 just_sign = _mm_and_ps(_mm_castsi128_ps(mask_sign), f);
+                        const __m128 abs_f = _mm_xor_ps(f, just_sign);
+                        const __m128i abs_f_int = _mm_castps_si128(abs_f);
+
+                        const __m128 is_nan = _mm_cmpunord_ps(abs_f, abs_f);
+                        const __m128i is_regular = _mm_cmpgt_epi32(f16max, abs_f_int);
+                        const __m128i inf_or_nan = _mm_or_si128(
+                            _mm_and_si128(_mm_castps_si128(is_nan), nan_bit), 
+                            infty_as_fp16);
+
+                        const __m128i is_subnormal = _mm_cmpgt_epi32(min_normal, abs_f_int);
+
+                        // Result is subnormal
+                        const __m128 subnormal_1 = _mm_add_ps(abs_f, _mm_castsi128_ps(subnorm_magic));
+                        const __m128i subnormal_2 = _mm_sub_epi32(_mm_castps_si128(subnormal_1), subnorm_magic);
+
+                        // Result is normal
+                        const __m128i mant_odd = _mm_srai_epi32(_mm_slli_epi32(abs_f_int, 31 - 13), 31);
+                        const __m128i rounded = _mm_sub_epi32(_mm_add_epi32(abs_f_int, normal_bias), mant_odd);
+                        const __m128i normal = _mm_srli_epi32(rounded, 13);
+
+                        const __m128i non_special = _mm_blendv_epi8(normal, subnormal_2, is_subnormal);
+                        const __m128i joined = _mm_blendv_epi8(inf_or_nan, non_special, is_regular);
+
+                        const __m128i sign_shift = _mm_srai_epi32(_mm_castps_si128(just_sign), 16);
+
+                        return _mm_or_si128(joined, sign_shift);
+                    }
+
+                    // Exact half to float conversion of zero-extended 16 bit
+                    // lanes, based on Fabian Giesen's half_to_float_SSE2.
+                    static inline __m128 half_to_float(__m128i h) {
+
+                        const __m128i mask_nosign = _mm_set1_epi32(0x7fff);
+                        const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+                        const __m128i was_infnan = _mm_set1_epi32(0x7bff);
+                        const __m128i exp_infnan = _mm_set1_epi32(255 << 23);
+
+                        const __m128i expmant = _mm_and_si128(mask_nosign, h);
+                        const __m128i justsign = _mm_xor_si128(h, expmant);
+                        const __m128i shifted = _mm_slli_epi32(expmant, 13);
+                        const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(shifted), magic);
+                        const __m128i b_wasinfnan = _mm_cmpgt_epi32(expmant, was_infnan);
+                        const __m128i sign = _mm_slli_epi32(justsign, 16);
+                        const __m128i infnanexp = _mm_and_si128(b_wasinfnan, exp_infnan);
+
+                        return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infnanexp)));
+                    }
+
+                    // Loads 4 RGBA pixels and returns one color channel per
+                    // register. Unorm values are converted like GL does, 
+                    // i.e. c / (2^16 - 1).
+                    static inline void load_rgb(
+                        RgbaLayout layout, 
+                        const uint8_t* src, 
+                        __m128& r, 
+                        __m128& g, 
+                        __m128& b)
+                    {
+
+                        __m128 p0;
+                        __m128 p1;
+                        __m128 p2;
+                        __m128 p3;
+
+                        const __m128i* const src_vec = reinterpret_cast<const __m128i*>(src);
+
+                        switch (layout) {
+
+                        case RgbaLayout::float32:
+                            p0 = _mm_loadu_ps(reinterpret_cast<const float*>(src));
+                            p1 = _mm_loadu_ps(reinterpret_cast<const float*>(src + 16));
+                            p2 = _mm_loadu_ps(reinterpret_cast<const float*>(src + 32));
+                            p3 = _mm_loadu_ps(reinterpret_cast<const float*>(src + 48));
+                            break;
+
+                        case RgbaLayout::half_float: {
+                            const __m128i h01 = _mm_loadu_si128(src_vec);
+                            const __m128i h23 = _mm_loadu_si128(src_vec + 1);
+                            p0 = half_to_float(_mm_cvtepu16_epi32(h01));
+                            p1 = half_to_float(_mm_cvtepu16_epi32(_mm_srli_si128(h01, 8)));
+                            p2 = half_to_float(_mm_cvtepu16_epi32(h23));
+                            p3 = half_to_float(_mm_cvtepu16_epi32(_mm_srli_si128(h23, 8)));
+                            }
+                            break;
+
+                        case RgbaLayout::unorm16:
+                        default: {
+                            const __m128i u01 = _mm_loadu_si128(src_vec);
+                            const __m128i u23 = _mm_loadu_si128(src_vec + 1);
+                            p0 = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(u01));
+                            p1 = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(u01, 8)));
+                            p2 = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(u23));
+                            p3 = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(u23, 8)));
+                            }
+                            break;
+
+                        }
+
+                        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+                        if (layout == RgbaLayout::unorm16) {
+                            const __m128 max_value = _mm_set1_ps(65535.0f);
+                            p0 = _mm_div_ps(p0, max_value);
+                            p1 = _mm_div_ps(p1, max_value);
+                            p2 = _mm_div_ps(p2, max_value);
+                        }
+
+                        r = p0;
+                        g = p1;
+                        b = p2;
+
+                    }
+
+                    // Packs 6 Y' and 3 Cb/Cr samples into one V210 group. 
+                    // Reads 4 values from cb/cr, the last one is ignored.
+                    // All values must be 10 bit already.
+                    static inline void pack_v210_group(
+                        const int32_t* luma, 
+                        const int32_t* cb, 
+                        const int32_t* cr, 
+                        uint8_t* dst)
+                    {
+
+                        const __m128i y_0_3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(luma));
+                        const __m128i y_2_5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(luma + 2));
+                        const __m128i cb_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cb));
+                        const __m128i cr_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cr));
+
+                        // c0 = | Cb_0, Y'_1, Cr_2, Y'_4 |
+                        __m128i c0 = _mm_blend_epi16(cb_vec, y_0_3, 0x0C);
+                        c0 = _mm_blend_epi16(c0, _mm_shuffle_epi32(cr_vec, _MM_SHUFFLE(2, 1, 1, 0)), 0x30);
+                        c0 = _mm_blend_epi16(c0, _mm_shuffle_epi32(y_2_5, _MM_SHUFFLE(2, 2, 1, 0)), 0xC0);
+
+                        // c1 = | Y'_0, Cb_2, Y'_3, Cr_4 |
+                        __m128i c1 = _mm_blend_epi16(_mm_shuffle_epi32(y_0_3, _MM_SHUFFLE(3, 3, 1, 0)), cb_vec, 0x0C);
+                        c1 = _mm_blend_epi16(c1, _mm_shuffle_epi32(cr_vec, _MM_SHUFFLE(2, 2, 1, 0)), 0xC0);
+
+                        // c2 = | Cr_0, Y'_2, Cb_4, Y'_5 |
+                        __m128i c2 = _mm_blend_epi16(cr_vec, _mm_shuffle_epi32(y_0_3, _MM_SHUFFLE(3, 2, 2, 0)), 0x0C);
+                        c2 = _mm_blend_epi16(c2, cb_vec, 0x30);
+                        c2 = _mm_blend_epi16(c2, y_2_5, 0xC0);
+
+                        const __m128i words = _mm_or_si128(
+                            _mm_or_si128(c0, _mm_slli_epi32(c1, 10)), 
+                            _mm_slli_epi32(c2, 20));
+
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), words);
+
+                    }
+
+                    static inline __m128i float_to_unorm16(__m128 f) {
+                        const __m128 clamped = _mm_min_ps(_mm_max_ps(f, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                        return _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(65535.0f)));
+                    }
+
+                }
+
+            }
+        }
+    }
+}
+
+#endif // FB_V210_CPU_KERNELS_SSE41
+
+#endif // TOA_FRAME_BENDER_V210_CPU_KERNELS_INL_H
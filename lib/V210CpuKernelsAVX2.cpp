@@ -0,0 +1,338 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+// Note: this translation unit is compiled with AVX2 and F16C code generation
+// enabled and therefore must not include Precompile.h or any other header 
+// with inline functions that are used in other translation units as well. 
+// See V210CpuKernels.h for details.
+
+#define FB_V210_CPU_KERNELS_SSE41 1
+
+#include "V210CpuKernels.h"
+
+#include <immintrin.h>
+
+namespace {
+
+    typedef toa::frame_bender::v210::RgbaLayout RgbaLayout;
+
+    struct Avx2Traits {
+
+        typedef __m256 F;
+        typedef __m256i I;
+        typedef __m256 M;
+
+        static const size_t kWidth = 8;
+
+        static F fset1(float v) { return _mm256_set1_ps(v); }
+        static F fadd(F a, F b) { return _mm256_add_ps(a, b); }
+        static F fsub(F a, F b) { return _mm256_sub_ps(a, b); }
+        static F fmul(F a, F b) { return _mm256_mul_ps(a, b); }
+        static F fdiv(F a, F b) { return _mm256_div_ps(a, b); }
+        static F fmin(F a, F b) { return _mm256_min_ps(a, b); }
+        static F fmax(F a, F b) { return _mm256_max_ps(a, b); }
+        static F ffloor(F a) { return _mm256_floor_ps(a); }
+
+        static M cmplt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static M cmple(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+        static F fselect(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+
+        static F i2f(I a) { return _mm256_cvtepi32_ps(a); }
+        static I f2i_trunc(F a) { return _mm256_cvttps_epi32(a); }
+        static I f2i_round(F a) { return _mm256_cvtps_epi32(a); }
+
+        static I icast(F a) { return _mm256_castps_si256(a); }
+        static F fcast(I a) { return _mm256_castsi256_ps(a); }
+
+        static I iset1(int32_t v) { return _mm256_set1_epi32(v); }
+        static I iadd(I a, I b) { return _mm256_add_epi32(a, b); }
+        static I isub(I a, I b) { return _mm256_sub_epi32(a, b); }
+        static I imul(I a, I b) { return _mm256_mullo_epi32(a, b); }
+        static I iand(I a, I b) { return _mm256_and_si256(a, b); }
+        static I ior(I a, I b) { return _mm256_or_si256(a, b); }
+        static I imin(I a, I b) { return _mm256_min_epi32(a, b); }
+        static I imax(I a, I b) { return _mm256_max_epi32(a, b); }
+        static I isra(I a, int32_t n) { return _mm256_sra_epi32(a, _mm_cvtsi32_si128(n)); }
+        static I isrl(I a, int32_t n) { return _mm256_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+        static I isll(I a, int32_t n) { return _mm256_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+
+        static I iloadu(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static void istoreu(int32_t* p, I v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+
+        static void zip(I even, I odd, I& lo, I& hi) {
+            // unpack works per 128 bit lane, fix up the order afterwards
+            const __m256i a = _mm256_unpacklo_epi32(even, odd);
+            const __m256i b = _mm256_unpackhi_epi32(even, odd);
+            lo = _mm256_permute2x128_si256(a, b, 0x20);
+            hi = _mm256_permute2x128_si256(a, b, 0x31);
+        }
+
+        static void unzip(I lo, I hi, I& even, I& odd) {
+            // shuffle works per 128 bit lane, fix up the order afterwards
+            const __m256 a = _mm256_castsi256_ps(lo);
+            const __m256 b = _mm256_castsi256_ps(hi);
+            even = _mm256_permute4x64_epi64(
+                _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), 
+                _MM_SHUFFLE(3, 1, 2, 0));
+            odd = _mm256_permute4x64_epi64(
+                _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), 
+                _MM_SHUFFLE(3, 1, 2, 0));
+        }
+
+        static void unpack_v210_row(
+            const uint8_t* src, 
+            size_t width, 
+            int32_t* luma, 
+            int32_t* cb, 
+            int32_t* cr);
+
+        static void pack_v210_groups(
+            const int32_t* luma, 
+            const int32_t* cb, 
+            const int32_t* cr, 
+            size_t num_groups,
+            uint8_t* dst);
+
+        static void store_rgba(RgbaLayout layout, F r, F g, F b, uint8_t* dst);
+
+        static void load_rgb(RgbaLayout layout, const uint8_t* src, F& r, F& g, F& b);
+
+        static void load_rgb_codes(const uint8_t* src, I& r, I& g, I& b);
+
+        static F gather(const float* table, I index) { return _mm256_i32gather_ps(table, index, 4); }
+
+    };
+
+}
+
+#include "V210CpuKernels.inl.h"
+
+namespace fb = toa::frame_bender;
+
+void Avx2Traits::unpack_v210_row(
+    const uint8_t* src, 
+    size_t width, 
+    int32_t* luma, 
+    int32_t* cb, 
+    int32_t* cr)
+{
+
+    // TODO: a 256 bit variant could process two groups at once, but the
+    // unpacking is not the bottleneck (the color conversion is).
+    for (size_t x = 0; x<width; x += 6, src += 16, luma += 6, cb += 3, cr += 3)
+        fb::v210::detail::sse::unpack_v210_group(src, luma, cb, cr);
+
+}
+
+void Avx2Traits::pack_v210_groups(
+    const int32_t* luma, 
+    const int32_t* cb, 
+    const int32_t* cr, 
+    size_t num_groups,
+    uint8_t* dst)
+{
+
+    for (size_t i = 0; i<num_groups; ++i, dst += 16, luma += 6, cb += 3, cr += 3)
+        fb::v210::detail::sse::pack_v210_group(luma, cb, cr, dst);
+
+}
+
+void Avx2Traits::load_rgb(RgbaLayout layout, const uint8_t* src, F& r, F& g, F& b) {
+
+    // Each register holds px i | px i+4 afterwards
+    __m256 q0;
+    __m256 q1;
+    __m256 q2;
+    __m256 q3;
+
+    const __m128i* const src_vec = reinterpret_cast<const __m128i*>(src);
+
+    switch (layout) {
+
+    case RgbaLayout::float32: {
+        const float* const p = reinterpret_cast<const float*>(src);
+        q0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p + 16), 1);
+        q1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 4)), _mm_loadu_ps(p + 20), 1);
+        q2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 8)), _mm_loadu_ps(p + 24), 1);
+        q3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 12)), _mm_loadu_ps(p + 28), 1);
+        }
+        break;
+
+    case RgbaLayout::half_float: {
+        // Two consecutive pixels per register
+        const __m256 o0 = _mm256_cvtph_ps(_mm_loadu_si128(src_vec));
+        const __m256 o1 = _mm256_cvtph_ps(_mm_loadu_si128(src_vec + 1));
+        const __m256 o2 = _mm256_cvtph_ps(_mm_loadu_si128(src_vec + 2));
+        const __m256 o3 = _mm256_cvtph_ps(_mm_loadu_si128(src_vec + 3));
+        q0 = _mm256_permute2f128_ps(o0, o2, 0x20);
+        q1 = _mm256_permute2f128_ps(o0, o2, 0x31);
+        q2 = _mm256_permute2f128_ps(o1, o3, 0x20);
+        q3 = _mm256_permute2f128_ps(o1, o3, 0x31);
+        }
+        break;
+
+    case RgbaLayout::unorm16:
+    default: {
+        const __m256 o0 = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(src_vec)));
+        const __m256 o1 = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(src_vec + 1)));
+        const __m256 o2 = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(src_vec + 2)));
+        const __m256 o3 = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(src_vec + 3)));
+        q0 = _mm256_permute2f128_ps(o0, o2, 0x20);
+        q1 = _mm256_permute2f128_ps(o0, o2, 0x31);
+        q2 = _mm256_permute2f128_ps(o1, o3, 0x20);
+        q3 = _mm256_permute2f128_ps(o1, o3, 0x31);
+        }
+        break;
+
+    }
+
+    // 4x4 transpose within each 128 bit lane
+    const __m256 t0 = _mm256_unpacklo_ps(q0, q1);
+    const __m256 t1 = _mm256_unpacklo_ps(q2, q3);
+    const __m256 t2 = _mm256_unpackhi_ps(q0, q1);
+    const __m256 t3 = _mm256_unpackhi_ps(q2, q3);
+
+    r = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+    g = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+    b = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+
+    if (layout == RgbaLayout::unorm16) {
+        const __m256 max_value = _mm256_set1_ps(65535.0f);
+        r = _mm256_div_ps(r, max_value);
+        g = _mm256_div_ps(g, max_value);
+        b = _mm256_div_ps(b, max_value);
+    }
+
+}
+
+void Avx2Traits::load_rgb_codes(const uint8_t* src, I& r, I& g, I& b) {
+
+    const __m128i* const src_vec = reinterpret_cast<const __m128i*>(src);
+
+    // Same as in load_rgb(), just on the integer codes
+    const __m256i o0 = _mm256_cvtepu16_epi32(_mm_loadu_si128(src_vec));
+    const __m256i o1 = _mm256_cvtepu16_epi32(_mm_loadu_si128(src_vec + 1));
+    const __m256i o2 = _mm256_cvtepu16_epi32(_mm_loadu_si128(src_vec + 2));
+    const __m256i o3 = _mm256_cvtepu16_epi32(_mm_loadu_si128(src_vec + 3));
+
+    const __m256i q0 = _mm256_permute2x128_si256(o0, o2, 0x20);
+    const __m256i q1 = _mm256_permute2x128_si256(o0, o2, 0x31);
+    const __m256i q2 = _mm256_permute2x128_si256(o1, o3, 0x20);
+    const __m256i q3 = _mm256_permute2x128_si256(o1, o3, 0x31);
+
+    const __m256i t0 = _mm256_unpacklo_epi32(q0, q1);
+    const __m256i t1 = _mm256_unpacklo_epi32(q2, q3);
+    const __m256i t2 = _mm256_unpackhi_epi32(q0, q1);
+    const __m256i t3 = _mm256_unpackhi_epi32(q2, q3);
+
+    r = _mm256_unpacklo_epi64(t0, t1);
+    g = _mm256_unpackhi_epi64(t0, t1);
+    b = _mm256_unpacklo_epi64(t2, t3);
+
+}
+
+void Avx2Traits::store_rgba(RgbaLayout layout, F r, F g, F b, uint8_t* dst) {
+
+    const __m256 a = _mm256_set1_ps(1.0f);
+
+    // 4x4 transpose within each 128 bit lane
+    const __m256 t0 = _mm256_unpacklo_ps(r, g);
+    const __m256 t1 = _mm256_unpackhi_ps(r, g);
+    const __m256 t2 = _mm256_unpacklo_ps(b, a);
+    const __m256 t3 = _mm256_unpackhi_ps(b, a);
+
+    const __m256 q0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)); // px 0 | px 4
+    const __m256 q1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)); // px 1 | px 5
+    const __m256 q2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)); // px 2 | px 6
+    const __m256 q3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)); // px 3 | px 7
+
+    // Two consecutive pixels per register
+    const __m256 o0 = _mm256_permute2f128_ps(q0, q1, 0x20);
+    const __m256 o1 = _mm256_permute2f128_ps(q2, q3, 0x20);
+    const __m256 o2 = _mm256_permute2f128_ps(q0, q1, 0x31);
+    const __m256 o3 = _mm256_permute2f128_ps(q2, q3, 0x31);
+
+    switch (layout) {
+
+    case RgbaLayout::float32:
+        _mm256_storeu_ps(reinterpret_cast<float*>(dst), o0);
+        _mm256_storeu_ps(reinterpret_cast<float*>(dst + 32), o1);
+        _mm256_storeu_ps(reinterpret_cast<float*>(dst + 64), o2);
+        _mm256_storeu_ps(reinterpret_cast<float*>(dst + 96), o3);
+        break;
+
+    case RgbaLayout::half_float: {
+        __m128i* const dst_vec = reinterpret_cast<__m128i*>(dst);
+        _mm_storeu_si128(dst_vec, _mm256_cvtps_ph(o0, _MM_FROUND_TO_NEAREST_INT));
+        _mm_storeu_si128(dst_vec + 1, _mm256_cvtps_ph(o1, _MM_FROUND_TO_NEAREST_INT));
+        _mm_storeu_si128(dst_vec + 2, _mm256_cvtps_ph(o2, _MM_FROUND_TO_NEAREST_INT));
+        _mm_storeu_si128(dst_vec + 3, _mm256_cvtps_ph(o3, _MM_FROUND_TO_NEAREST_INT));
+        }
+        break;
+
+    case RgbaLayout::unorm16: {
+
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 scale = _mm256_set1_ps(65535.0f);
+
+        const __m256i u0 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(o0, zero), one), scale));
+        const __m256i u1 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(o1, zero), one), scale));
+        const __m256i u2 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(o2, zero), one), scale));
+        const __m256i u3 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(o3, zero), one), scale));
+
+        // packus works per lane: | px 0, px 2 | px 1, px 3 | -> reorder
+        __m256i* const dst_vec = reinterpret_cast<__m256i*>(dst);
+        _mm256_storeu_si256(dst_vec, _mm256_permute4x64_epi64(_mm256_packus_epi32(u0, u1), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_si256(dst_vec + 1, _mm256_permute4x64_epi64(_mm256_packus_epi32(u2, u3), _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+        break;
+
+    }
+
+}
+
+void fb::v210::decode_row_avx2(
+    const ConversionSetup& setup,
+    const uint8_t* v210_row,
+    uint8_t* rgba_row,
+    const RowBuffers& buffers)
+{
+    detail::RowKernels<Avx2Traits>::decode_row(setup, v210_row, rgba_row, buffers);
+}
+
+void fb::v210::encode_row_avx2(
+    const ConversionSetup& setup,
+    const uint8_t* rgba_row,
+    uint8_t* v210_row,
+    const RowBuffers& buffers)
+{
+    detail::RowKernels<Avx2Traits>::encode_row(setup, rgba_row, v210_row, buffers);
+}
+
+int32_t fb::v210::compare_row_avx2(
+    const uint8_t* reference_row,
+    const uint8_t* candidate_row,
+    size_t num_groups,
+    CompareAccumulator& accumulator)
+{
+    return detail::RowKernels<Avx2Traits>::compare_row(reference_row, candidate_row, num_groups, accumulator);
+}
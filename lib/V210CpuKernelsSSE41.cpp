@@ -0,0 +1,247 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+// Note: this translation unit is compiled with SSE4.1 code generation enabled
+// and therefore must not include Precompile.h or any other header with 
+// inline functions that are used in other translation units as well. See
+// V210CpuKernels.h for details.
+
+#define FB_V210_CPU_KERNELS_SSE41 1
+
+#include "V210CpuKernels.h"
+
+#include <smmintrin.h>
+
+namespace {
+
+    typedef toa::frame_bender::v210::RgbaLayout RgbaLayout;
+
+    struct Sse41Traits {
+
+        typedef __m128 F;
+        typedef __m128i I;
+        typedef __m128 M;
+
+        static const size_t kWidth = 4;
+
+        static F fset1(float v) { return _mm_set1_ps(v); }
+        static F fadd(F a, F b) { return _mm_add_ps(a, b); }
+        static F fsub(F a, F b) { return _mm_sub_ps(a, b); }
+        static F fmul(F a, F b) { return _mm_mul_ps(a, b); }
+        static F fdiv(F a, F b) { return _mm_div_ps(a, b); }
+        static F fmin(F a, F b) { return _mm_min_ps(a, b); }
+        static F fmax(F a, F b) { return _mm_max_ps(a, b); }
+        static F ffloor(F a) { return _mm_floor_ps(a); }
+
+        static M cmplt(F a, F b) { return _mm_cmplt_ps(a, b); }
+        static M cmple(F a, F b) { return _mm_cmple_ps(a, b); }
+        static F fselect(M m, F a, F b) { return _mm_blendv_ps(b, a, m); }
+
+        static F i2f(I a) { return _mm_cvtepi32_ps(a); }
+        static I f2i_trunc(F a) { return _mm_cvttps_epi32(a); }
+        static I f2i_round(F a) { return _mm_cvtps_epi32(a); }
+
+        static I icast(F a) { return _mm_castps_si128(a); }
+        static F fcast(I a) { return _mm_castsi128_ps(a); }
+
+        static I iset1(int32_t v) { return _mm_set1_epi32(v); }
+        static I iadd(I a, I b) { return _mm_add_epi32(a, b); }
+        static I isub(I a, I b) { return _mm_sub_epi32(a, b); }
+        static I imul(I a, I b) { return _mm_mullo_epi32(a, b); }
+        static I iand(I a, I b) { return _mm_and_si128(a, b); }
+        static I ior(I a, I b) { return _mm_or_si128(a, b); }
+        static I imin(I a, I b) { return _mm_min_epi32(a, b); }
+        static I imax(I a, I b) { return _mm_max_epi32(a, b); }
+        static I isra(I a, int32_t n) { return _mm_sra_epi32(a, _mm_cvtsi32_si128(n)); }
+        static I isrl(I a, int32_t n) { return _mm_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+        static I isll(I a, int32_t n) { return _mm_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+
+        static I iloadu(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        static void istoreu(int32_t* p, I v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+
+        static void zip(I even, I odd, I& lo, I& hi) {
+            lo = _mm_unpacklo_epi32(even, odd);
+            hi = _mm_unpackhi_epi32(even, odd);
+        }
+
+        static void unzip(I lo, I hi, I& even, I& odd) {
+            const __m128 a = _mm_castsi128_ps(lo);
+            const __m128 b = _mm_castsi128_ps(hi);
+            even = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            odd = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+
+        static void unpack_v210_row(
+            const uint8_t* src, 
+            size_t width, 
+            int32_t* luma, 
+            int32_t* cb, 
+            int32_t* cr);
+
+        static void pack_v210_groups(
+            const int32_t* luma, 
+            const int32_t* cb, 
+            const int32_t* cr, 
+            size_t num_groups,
+            uint8_t* dst);
+
+        static void store_rgba(RgbaLayout layout, F r, F g, F b, uint8_t* dst);
+
+        static void load_rgb(RgbaLayout layout, const uint8_t* src, F& r, F& g, F& b);
+
+        static void load_rgb_codes(const uint8_t* src, I& r, I& g, I& b);
+
+        static F gather(const float* table, I index) {
+            // No gather instructions before AVX2
+            return _mm_setr_ps(
+                table[_mm_cvtsi128_si32(index)],
+                table[_mm_extract_epi32(index, 1)],
+                table[_mm_extract_epi32(index, 2)],
+                table[_mm_extract_epi32(index, 3)]);
+        }
+
+    };
+
+}
+
+#include "V210CpuKernels.inl.h"
+
+namespace fb = toa::frame_bender;
+
+void Sse41Traits::unpack_v210_row(
+    const uint8_t* src, 
+    size_t width, 
+    int32_t* luma, 
+    int32_t* cb, 
+    int32_t* cr)
+{
+
+    for (size_t x = 0; x<width; x += 6, src += 16, luma += 6, cb += 3, cr += 3)
+        fb::v210::detail::sse::unpack_v210_group(src, luma, cb, cr);
+
+}
+
+void Sse41Traits::pack_v210_groups(
+    const int32_t* luma, 
+    const int32_t* cb, 
+    const int32_t* cr, 
+    size_t num_groups,
+    uint8_t* dst)
+{
+
+    for (size_t i = 0; i<num_groups; ++i, dst += 16, luma += 6, cb += 3, cr += 3)
+        fb::v210::detail::sse::pack_v210_group(luma, cb, cr, dst);
+
+}
+
+void Sse41Traits::load_rgb(RgbaLayout layout, const uint8_t* src, F& r, F& g, F& b) {
+    fb::v210::detail::sse::load_rgb(layout, src, r, g, b);
+}
+
+void Sse41Traits::load_rgb_codes(const uint8_t* src, I& r, I& g, I& b) {
+
+    const __m128i* const src_vec = reinterpret_cast<const __m128i*>(src);
+
+    const __m128i u01 = _mm_loadu_si128(src_vec);
+    const __m128i u23 = _mm_loadu_si128(src_vec + 1);
+
+    __m128 p0 = _mm_castsi128_ps(_mm_cvtepu16_epi32(u01));
+    __m128 p1 = _mm_castsi128_ps(_mm_cvtepu16_epi32(_mm_srli_si128(u01, 8)));
+    __m128 p2 = _mm_castsi128_ps(_mm_cvtepu16_epi32(u23));
+    __m128 p3 = _mm_castsi128_ps(_mm_cvtepu16_epi32(_mm_srli_si128(u23, 8)));
+
+    _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+    r = _mm_castps_si128(p0);
+    g = _mm_castps_si128(p1);
+    b = _mm_castps_si128(p2);
+
+}
+
+void Sse41Traits::store_rgba(RgbaLayout layout, F r, F g, F b, uint8_t* dst) {
+
+    __m128 p0 = r;
+    __m128 p1 = g;
+    __m128 p2 = b;
+    __m128 p3 = _mm_set1_ps(1.0f);
+
+    // One RGBA pixel per register afterwards
+    _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+    __m128i* const dst_vec = reinterpret_cast<__m128i*>(dst);
+
+    switch (layout) {
+
+    case RgbaLayout::float32:
+        _mm_storeu_ps(reinterpret_cast<float*>(dst), p0);
+        _mm_storeu_ps(reinterpret_cast<float*>(dst + 16), p1);
+        _mm_storeu_ps(reinterpret_cast<float*>(dst + 32), p2);
+        _mm_storeu_ps(reinterpret_cast<float*>(dst + 48), p3);
+        break;
+
+    case RgbaLayout::half_float:
+        _mm_storeu_si128(dst_vec, _mm_packs_epi32(
+            fb::v210::detail::sse::float_to_half(p0), 
+            fb::v210::detail::sse::float_to_half(p1)));
+        _mm_storeu_si128(dst_vec + 1, _mm_packs_epi32(
+            fb::v210::detail::sse::float_to_half(p2), 
+            fb::v210::detail::sse::float_to_half(p3)));
+        break;
+
+    case RgbaLayout::unorm16:
+        _mm_storeu_si128(dst_vec, _mm_packus_epi32(
+            fb::v210::detail::sse::float_to_unorm16(p0), 
+            fb::v210::detail::sse::float_to_unorm16(p1)));
+        _mm_storeu_si128(dst_vec + 1, _mm_packus_epi32(
+            fb::v210::detail::sse::float_to_unorm16(p2), 
+            fb::v210::detail::sse::float_to_unorm16(p3)));
+        break;
+
+    }
+
+}
+
+void fb::v210::decode_row_sse41(
+    const ConversionSetup& setup,
+    const uint8_t* v210_row,
+    uint8_t* rgba_row,
+    const RowBuffers& buffers)
+{
+    detail::RowKernels<Sse41Traits>::decode_row(setup, v210_row, rgba_row, buffers);
+}
+
+void fb::v210::encode_row_sse41(
+    const ConversionSetup& setup,
+    const uint8_t* rgba_row,
+    uint8_t* v210_row,
+    const RowBuffers& buffers)
+{
+    detail::RowKernels<Sse41Traits>::encode_row(setup, rgba_row, v210_row, buffers);
+}
+
+int32_t fb::v210::compare_row_sse41(
+    const uint8_t* reference_row,
+    const uint8_t* candidate_row,
+    size_t num_groups,
+    CompareAccumulator& accumulator)
+{
+    return detail::RowKernels<Sse41Traits>::compare_row(reference_row, candidate_row, num_groups, accumulator);
+}
@@ -0,0 +1,337 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "V210CpuKernels.h"
+#include "Logging.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+    typedef toa::frame_bender::v210::RgbaLayout RgbaLayout;
+
+    // Reference traits with a single lane, used when no SIMD support is
+    // available and to cross-check the vectorized kernels in the tests.
+    struct ScalarTraits {
+
+        typedef float F;
+        typedef int32_t I;
+        typedef bool M;
+
+        static const size_t kWidth = 1;
+
+        static F fset1(float v) { return v; }
+        static F fadd(F a, F b) { return a + b; }
+        static F fsub(F a, F b) { return a - b; }
+        static F fmul(F a, F b) { return a * b; }
+        static F fdiv(F a, F b) { return a / b; }
+        static F fmin(F a, F b) { return a < b ? a : b; }
+        static F fmax(F a, F b) { return a > b ? a : b; }
+        static F ffloor(F a) { return std::floor(a); }
+
+        static M cmplt(F a, F b) { return a < b; }
+        static M cmple(F a, F b) { return a <= b; }
+        static F fselect(M m, F a, F b) { return m ? a : b; }
+
+        static F i2f(I a) { return static_cast<float>(a); }
+        static I f2i_trunc(F a) { return static_cast<int32_t>(a); }
+        static I f2i_round(F a) { return static_cast<int32_t>(std::nearbyint(a)); }
+
+        static I icast(F a) { I i; std::memcpy(&i, &a, sizeof(i)); return i; }
+        static F fcast(I a) { F f; std::memcpy(&f, &a, sizeof(f)); return f; }
+
+        static I iset1(int32_t v) { return v; }
+        static I iadd(I a, I b) { return a + b; }
+        static I isub(I a, I b) { return a - b; }
+        static I imul(I a, I b) { return a * b; }
+        static I iand(I a, I b) { return a & b; }
+        static I ior(I a, I b) { return a | b; }
+        static I imin(I a, I b) { return a < b ? a : b; }
+        static I imax(I a, I b) { return a > b ? a : b; }
+        static I isra(I a, int32_t n) { return a >> n; }
+        static I isrl(I a, int32_t n) { return static_cast<I>(static_cast<uint32_t>(a) >> n); }
+        static I isll(I a, int32_t n) { return static_cast<I>(static_cast<uint32_t>(a) << n); }
+
+        static I iloadu(const int32_t* p) { return *p; }
+        static void istoreu(int32_t* p, I v) { *p = v; }
+
+        static void zip(I even, I odd, I& lo, I& hi) { lo = even; hi = odd; }
+        static void unzip(I lo, I hi, I& even, I& odd) { even = lo; odd = hi; }
+
+        static uint32_t read_word(const uint8_t* p) {
+            // V210 is little-endian, as is the host
+            uint32_t w;
+            std::memcpy(&w, p, sizeof(w));
+            return w;
+        }
+
+        static void unpack_v210_row(
+            const uint8_t* src, 
+            size_t width, 
+            int32_t* luma, 
+            int32_t* cb, 
+            int32_t* cr)
+        {
+
+            // | Cb_0, Y'_0, Cr_0 | Y'_1, Cb_2, Y'_2 | Cr_2, Y'_3, Cb_4 | Y'_4, Cr_4, Y'_5 |
+
+            for (size_t x = 0; x<width; x += 6, src += 16, luma += 6, cb += 3, cr += 3) {
+
+                const uint32_t w0 = read_word(src);
+                const uint32_t w1 = read_word(src + 4);
+                const uint32_t w2 = read_word(src + 8);
+                const uint32_t w3 = read_word(src + 12);
+
+                cb[0]   = w0 & 0x3FF;
+                luma[0] = (w0 >> 10) & 0x3FF;
+                cr[0]   = (w0 >> 20) & 0x3FF;
+
+                luma[1] = w1 & 0x3FF;
+                cb[1]   = (w1 >> 10) & 0x3FF;
+                luma[2] = (w1 >> 20) & 0x3FF;
+
+                cr[1]   = w2 & 0x3FF;
+                luma[3] = (w2 >> 10) & 0x3FF;
+                cb[2]   = (w2 >> 20) & 0x3FF;
+
+                luma[4] = w3 & 0x3FF;
+                cr[2]   = (w3 >> 10) & 0x3FF;
+                luma[5] = (w3 >> 20) & 0x3FF;
+
+            }
+
+        }
+
+        static void pack_v210_groups(
+            const int32_t* luma, 
+            const int32_t* cb, 
+            const int32_t* cr, 
+            size_t num_groups,
+            uint8_t* dst)
+        {
+
+            for (size_t i = 0; i<num_groups; ++i, dst += 16, luma += 6, cb += 3, cr += 3) {
+
+                const uint32_t words[4] = {
+                    static_cast<uint32_t>(cb[0] | (luma[0] << 10) | (cr[0] << 20)),
+                    static_cast<uint32_t>(luma[1] | (cb[1] << 10) | (luma[2] << 20)),
+                    static_cast<uint32_t>(cr[1] | (luma[3] << 10) | (cb[2] << 20)),
+                    static_cast<uint32_t>(luma[4] | (cr[2] << 10) | (luma[5] << 20))
+                };
+
+                std::memcpy(dst, words, sizeof(words));
+
+            }
+
+        }
+
+        // Same as the SSE version, see Fabian Giesen's half_to_float_SSE2
+        static float half_to_float(uint16_t h) {
+
+            const uint32_t expmant = h & 0x7fffu;
+            const uint32_t sign = static_cast<uint32_t>(h ^ expmant) << 16;
+            const uint32_t infnan = expmant > 0x7bffu ? (255u << 23) : 0u;
+
+            const float magic = fcast(static_cast<int32_t>((254u - 15u) << 23));
+            const float scaled = fcast(static_cast<int32_t>(expmant << 13)) * magic;
+
+            return fcast(static_cast<int32_t>(static_cast<uint32_t>(icast(scaled)) | sign | infnan));
+        }
+
+        // Round-to-nearest-even float to half conversion, based on 
+        // Fabian Giesen's float_to_half_fast3_rtne.
+        static uint16_t float_to_half(float f) {
+
+            const uint32_t f32infty = 255u << 23;
+            const uint32_t f16max = (127u + 16u) << 23;
+            const uint32_t denorm_magic_bits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+            uint32_t bits = static_cast<uint32_t>(icast(f));
+            const uint32_t sign = bits & 0x80000000u;
+            bits ^= sign;
+
+            uint16_t o = 0;
+
+            if (bits >= f16max) {
+                // Inf or NaN
+                o = (bits > f32infty) ? 0x7e00 : 0x7c00;
+            } else if (bits < (113u << 23)) {
+                // Resulting half is a denormal or zero
+                const float denorm_magic = fcast(static_cast<int32_t>(denorm_magic_bits));
+                const float tmp = fcast(static_cast<int32_t>(bits)) + denorm_magic;
+                o = static_cast<uint16_t>(static_cast<uint32_t>(icast(tmp)) - denorm_magic_bits);
+            } else {
+                const uint32_t mant_odd = (bits >> 13) & 1;
+                bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xfff;
+                bits += mant_odd;
+                o = static_cast<uint16_t>(bits >> 13);
+            }
+
+            return static_cast<uint16_t>(o | (sign >> 16));
+        }
+
+        static uint16_t float_to_unorm16(float f) {
+            const float clamped = fmin(fmax(f, .0f), 1.0f);
+            return static_cast<uint16_t>(f2i_round(clamped * 65535.0f));
+        }
+
+        static void store_rgba(RgbaLayout layout, F r, F g, F b, uint8_t* dst) {
+
+            switch (layout) {
+
+            case RgbaLayout::float32: {
+                const float rgba[4] = {r, g, b, 1.0f};
+                std::memcpy(dst, rgba, sizeof(rgba));
+                }
+                break;
+
+            case RgbaLayout::half_float: {
+                const uint16_t rgba[4] = {
+                    float_to_half(r), 
+                    float_to_half(g), 
+                    float_to_half(b), 
+                    float_to_half(1.0f)};
+                std::memcpy(dst, rgba, sizeof(rgba));
+                }
+                break;
+
+            case RgbaLayout::unorm16: {
+                const uint16_t rgba[4] = {
+                    float_to_unorm16(r), 
+                    float_to_unorm16(g), 
+                    float_to_unorm16(b), 
+                    0xFFFF};
+                std::memcpy(dst, rgba, sizeof(rgba));
+                }
+                break;
+
+            }
+
+        }
+
+        static void load_rgb(RgbaLayout layout, const uint8_t* src, F& r, F& g, F& b) {
+
+            switch (layout) {
+
+            case RgbaLayout::float32: {
+                float rgba[4];
+                std::memcpy(rgba, src, sizeof(rgba));
+                r = rgba[0];
+                g = rgba[1];
+                b = rgba[2];
+                }
+                break;
+
+            case RgbaLayout::half_float: {
+                uint16_t rgba[4];
+                std::memcpy(rgba, src, sizeof(rgba));
+                r = half_to_float(rgba[0]);
+                g = half_to_float(rgba[1]);
+                b = half_to_float(rgba[2]);
+                }
+                break;
+
+            case RgbaLayout::unorm16:
+            default: {
+                uint16_t rgba[4];
+                std::memcpy(rgba, src, sizeof(rgba));
+                r = static_cast<float>(rgba[0]) / 65535.0f;
+                g = static_cast<float>(rgba[1]) / 65535.0f;
+                b = static_cast<float>(rgba[2]) / 65535.0f;
+                }
+                break;
+
+            }
+
+        }
+
+        static void load_rgb_codes(const uint8_t* src, I& r, I& g, I& b) {
+            uint16_t rgba[4];
+            std::memcpy(rgba, src, sizeof(rgba));
+            r = rgba[0];
+            g = rgba[1];
+            b = rgba[2];
+        }
+
+        static F gather(const float* table, I index) { return table[index]; }
+
+    };
+
+}
+
+// Kernels must be included after the traits definition, see the notes in
+// V210CpuKernels.inl.h
+#include "V210CpuKernels.inl.h"
+
+namespace fb = toa::frame_bender;
+
+void fb::v210::decode_row_scalar(
+    const ConversionSetup& setup,
+    const uint8_t* v210_row,
+    uint8_t* rgba_row,
+    const RowBuffers& buffers)
+{
+    detail::RowKernels<ScalarTraits>::decode_row(setup, v210_row, rgba_row, buffers);
+}
+
+void fb::v210::encode_row_scalar(
+    const ConversionSetup& setup,
+    const uint8_t* rgba_row,
+    uint8_t* v210_row,
+    const RowBuffers& buffers)
+{
+    detail::RowKernels<ScalarTraits>::encode_row(setup, rgba_row, v210_row, buffers);
+}
+
+void fb::v210::build_encode_transfer_table(RgbaLayout layout, float* table) {
+
+    FB_ASSERT(layout == RgbaLayout::unorm16 || layout == RgbaLayout::half_float);
+
+    for (size_t code = 0; code<kTransferTableSize; ++code) {
+
+        const uint16_t rgba[4] = {
+            static_cast<uint16_t>(code), 
+            static_cast<uint16_t>(code), 
+            static_cast<uint16_t>(code), 
+            0};
+
+        float r;
+        float g;
+        float b;
+
+        ScalarTraits::load_rgb(layout, reinterpret_cast<const uint8_t*>(rgba), r, g, b);
+
+        table[code] = detail::RowKernels<ScalarTraits>::linear_to_srgb(r);
+
+    }
+
+}
+
+int32_t fb::v210::compare_row_scalar(
+    const uint8_t* reference_row,
+    const uint8_t* candidate_row,
+    size_t num_groups,
+    CompareAccumulator& accumulator)
+{
+    return detail::RowKernels<ScalarTraits>::compare_row(reference_row, candidate_row, num_groups, accumulator);
+}
@@ -0,0 +1,156 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "Precompile.h"
+#include "WorkerPool.h"
+#include "Logging.h"
+
+namespace fb = toa::frame_bender;
+
+fb::WorkerPool::WorkerPool(size_t num_workers) :
+    stop_(false),
+    generation_(0),
+    num_busy_threads_(0),
+    task_(nullptr),
+    num_tasks_(0),
+    next_task_(0)
+{
+
+    if (num_workers == 0) {
+        num_workers = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 1; i < num_workers; ++i) {
+        threads_.push_back(std::thread(&WorkerPool::thread_main, this, i));
+    }
+
+    FB_LOG_DEBUG << "Created worker pool with " << num_workers << " worker(s).";
+
+}
+
+fb::WorkerPool::~WorkerPool() {
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    wake_condition_.notify_all();
+
+    for (auto& thread : threads_) {
+        if (thread.joinable())
+            thread.join();
+    }
+
+}
+
+void fb::WorkerPool::run(size_t num_tasks, const Task& task) {
+
+    if (num_tasks == 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        num_tasks_ = num_tasks;
+        next_task_ = 0;
+        num_busy_threads_ = threads_.size();
+        exception_ = nullptr;
+        ++generation_;
+    }
+
+    wake_condition_.notify_all();
+
+    std::exception_ptr own_exception;
+
+    try {
+        work(0);
+    } catch (...) {
+        own_exception = std::current_exception();
+        // Don't let the others start on any remaining tasks
+        next_task_ = num_tasks_;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_condition_.wait(lock, [this]{ return num_busy_threads_ == 0; });
+
+    task_ = nullptr;
+
+    if (own_exception)
+        std::rethrow_exception(own_exception);
+
+    if (exception_)
+        std::rethrow_exception(exception_);
+
+}
+
+void fb::WorkerPool::work(size_t worker_index) {
+
+    for (;;) {
+
+        const size_t task_index = next_task_.fetch_add(1);
+
+        if (task_index >= num_tasks_)
+            break;
+
+        (*task_)(task_index, worker_index);
+
+    }
+
+}
+
+void fb::WorkerPool::thread_main(size_t worker_index) {
+
+    uint64_t seen_generation = 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for (;;) {
+
+        wake_condition_.wait(lock, [&]{ return stop_ || generation_ != seen_generation; });
+
+        if (stop_)
+            break;
+
+        seen_generation = generation_;
+
+        lock.unlock();
+
+        std::exception_ptr exception;
+
+        try {
+            work(worker_index);
+        } catch (...) {
+            exception = std::current_exception();
+            next_task_ = num_tasks_;
+        }
+
+        lock.lock();
+
+        if (exception && !exception_)
+            exception_ = exception;
+
+        if (--num_busy_threads_ == 0)
+            done_condition_.notify_one();
+
+    }
+
+}
@@ -0,0 +1,87 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TOA_FRAME_BENDER_WORKER_POOL_H
+#define TOA_FRAME_BENDER_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Utils.h"
+
+namespace toa {
+    namespace frame_bender {
+
+        // A fixed set of threads that stay alive for the lifetime of the 
+        // pool, so that per-frame work can be fanned out without paying for 
+        // thread creation each time. The thread calling run() takes part in 
+        // the work as worker 0, i.e. a pool of N workers spawns N-1 threads.
+        class WorkerPool : public utils::NoCopyingOrMoving {
+
+        public:
+
+            // Invoked as task(task_index, worker_index)
+            typedef std::function<void(size_t, size_t)> Task;
+
+            // A value of 0 uses one worker per hardware thread.
+            explicit WorkerPool(size_t num_workers);
+            ~WorkerPool();
+
+            size_t num_workers() const { return threads_.size() + 1; }
+
+            // Executes task for all indices in [0, num_tasks) and blocks 
+            // until all of them are finished. Exceptions thrown by a task 
+            // are rethrown here. Must not be called concurrently.
+            void run(size_t num_tasks, const Task& task);
+
+        private:
+
+            void thread_main(size_t worker_index);
+            void work(size_t worker_index);
+
+            std::vector<std::thread> threads_;
+
+            std::mutex mutex_;
+            std::condition_variable wake_condition_;
+            std::condition_variable done_condition_;
+
+            // Guarded by mutex_
+            bool stop_;
+            uint64_t generation_;
+            size_t num_busy_threads_;
+            std::exception_ptr exception_;
+
+            // Only valid during run()
+            const Task* task_;
+            size_t num_tasks_;
+            std::atomic<size_t> next_task_;
+
+        };
+
+    }
+}
+
+#endif // TOA_FRAME_BENDER_WORKER_POOL_H
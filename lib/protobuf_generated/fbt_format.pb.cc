@@ -43,6 +43,9 @@ const ::google::protobuf::EnumDescriptor* StageTrace_EventType_descriptor_ = NUL
 const ::google::protobuf::Descriptor* OpenGLInfo_descriptor_ = NULL;
 const ::google::protobuf::internal::GeneratedMessageReflection*
   OpenGLInfo_reflection_ = NULL;
+const ::google::protobuf::Descriptor* QueueTrace_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  QueueTrace_reflection_ = NULL;
 const ::google::protobuf::Descriptor* TraceSession_descriptor_ = NULL;
 const ::google::protobuf::internal::GeneratedMessageReflection*
   TraceSession_reflection_ = NULL;
@@ -94,7 +97,7 @@ void protobuf_AssignDesc_fbt_5fformat_2eproto() {
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(StageTrace_EventNameMapping));
   StageTrace_DeltaStatistic_descriptor_ = StageTrace_descriptor_->nested_type(1);
-  static const int StageTrace_DeltaStatistic_offsets_[9] = {
+  static const int StageTrace_DeltaStatistic_offsets_[15] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_DeltaStatistic, name_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_DeltaStatistic, begin_event_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_DeltaStatistic, end_event_),
@@ -104,6 +107,12 @@ void protobuf_AssignDesc_fbt_5fformat_2eproto() {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_DeltaStatistic, std_deviation_ns_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_DeltaStatistic, median_ns_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_DeltaStatistic, num_samples_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_DeltaStatistic, percentiles_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_DeltaStatistic, percentile_values_ns_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_DeltaStatistic, histogram_significant_digits_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_DeltaStatistic, histogram_highest_trackable_ns_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_DeltaStatistic, histogram_indices_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_DeltaStatistic, histogram_counts_),
   };
   StageTrace_DeltaStatistic_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -117,9 +126,10 @@ void protobuf_AssignDesc_fbt_5fformat_2eproto() {
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(StageTrace_DeltaStatistic));
   StageTrace_EventTrace_descriptor_ = StageTrace_descriptor_->nested_type(2);
-  static const int StageTrace_EventTrace_offsets_[2] = {
+  static const int StageTrace_EventTrace_offsets_[3] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_EventTrace, type_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_EventTrace, trace_times_ns_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StageTrace_EventTrace, trace_ids_),
   };
   StageTrace_EventTrace_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -150,13 +160,35 @@ void protobuf_AssignDesc_fbt_5fformat_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(OpenGLInfo));
-  TraceSession_descriptor_ = file->message_type(2);
-  static const int TraceSession_offsets_[5] = {
+  QueueTrace_descriptor_ = file->message_type(2);
+  static const int QueueTrace_offsets_[7] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(QueueTrace, name_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(QueueTrace, capacity_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(QueueTrace, push_times_ns_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(QueueTrace, push_occupancy_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(QueueTrace, pop_times_ns_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(QueueTrace, pop_occupancy_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(QueueTrace, dwell_times_ns_),
+  };
+  QueueTrace_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      QueueTrace_descriptor_,
+      QueueTrace::default_instance_,
+      QueueTrace_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(QueueTrace, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(QueueTrace, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(QueueTrace));
+  TraceSession_descriptor_ = file->message_type(3);
+  static const int TraceSession_offsets_[6] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TraceSession, name_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TraceSession, opengl_info_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TraceSession, local_time_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TraceSession, stage_traces_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TraceSession, session_statistic_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TraceSession, queue_traces_),
   };
   TraceSession_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -209,6 +241,8 @@ void protobuf_RegisterTypes(const ::std::string&) {
     StageTrace_EventTrace_descriptor_, &StageTrace_EventTrace::default_instance());
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
     OpenGLInfo_descriptor_, &OpenGLInfo::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    QueueTrace_descriptor_, &QueueTrace::default_instance());
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
     TraceSession_descriptor_, &TraceSession::default_instance());
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
@@ -228,6 +262,8 @@ void protobuf_ShutdownFile_fbt_5fformat_2eproto() {
   delete StageTrace_EventTrace_reflection_;
   delete OpenGLInfo::default_instance_;
   delete OpenGLInfo_reflection_;
+  delete QueueTrace::default_instance_;
+  delete QueueTrace_reflection_;
   delete TraceSession::default_instance_;
   delete TraceSession_reflection_;
   delete TraceSession_SessionStatistic::default_instance_;
@@ -241,7 +277,7 @@ void protobuf_AddDesc_fbt_5fformat_2eproto() {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
   ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
-    "\n\020fbt_format.proto\022\nfbt_format\"\267\006\n\nStage"
+    "\n\020fbt_format.proto\022\nfbt_format\"\224\010\n\nStage"
     "Trace\022\014\n\004name\030\001 \002(\t\0227\n\014event_traces\030\002 \003("
     "\0132!.fbt_format.StageTrace.EventTrace\022\?\n\016"
     "name_overrides\030\003 \003(\0132\'.fbt_format.StageT"
@@ -249,31 +285,42 @@ void protobuf_AddDesc_fbt_5fformat_2eproto() {
     "s\030\004 \003(\0132%.fbt_format.StageTrace.DeltaSta"
     "tistic\032P\n\020EventNameMapping\022.\n\004type\030\001 \002(\016"
     "2 .fbt_format.StageTrace.EventType\022\014\n\004na"
-    "me\030\002 \002(\t\032\210\002\n\016DeltaStatistic\022\014\n\004name\030\001 \002("
+    "me\030\002 \002(\t\032\316\003\n\016DeltaStatistic\022\014\n\004name\030\001 \002("
     "\t\0225\n\013begin_event\030\002 \002(\0162 .fbt_format.Stag"
     "eTrace.EventType\0223\n\tend_event\030\003 \002(\0162 .fb"
     "t_format.StageTrace.EventType\022\022\n\naverage"
     "_ns\030\004 \002(\022\022\022\n\nminimum_ns\030\005 \002(\022\022\022\n\nmaximum"
     "_ns\030\006 \002(\022\022\030\n\020std_deviation_ns\030\007 \002(\022\022\021\n\tm"
-    "edian_ns\030\010 \002(\022\022\023\n\013num_samples\030\t \002(\004\032X\n\nE"
-    "ventTrace\022.\n\004type\030\001 \002(\0162 .fbt_format.Sta"
-    "geTrace.EventType\022\032\n\016trace_times_ns\030\002 \003("
-    "\022B\002\020\001\"\250\001\n\tEventType\022\021\n\rEXECUTE_BEGIN\020\001\022\031"
-    "\n\025INPUT_TOKEN_AVAILABLE\020\002\022\032\n\026OUTPUT_TOKE"
-    "N_AVAILABLE\020\003\022\016\n\nTASK_BEGIN\020\004\022\014\n\010TASK_EN"
-    "D\020\005\022\017\n\013EXECUTE_END\020\006\022\021\n\rGL_TASK_BEGIN\020\007\022"
-    "\017\n\013GL_TASK_END\020\010\"\?\n\nOpenGLInfo\022\016\n\006vendor"
-    "\030\001 \002(\t\022\020\n\010renderer\030\002 \002(\t\022\017\n\007version\030\003 \002("
-    "\t\"\376\002\n\014TraceSession\022\014\n\004name\030\001 \002(\t\022+\n\013open"
-    "gl_info\030\002 \002(\0132\026.fbt_format.OpenGLInfo\022\022\n"
-    "\nlocal_time\030\003 \002(\t\022,\n\014stage_traces\030\004 \003(\0132"
-    "\026.fbt_format.StageTrace\022D\n\021session_stati"
-    "stic\030\005 \001(\0132).fbt_format.TraceSession.Ses"
-    "sionStatistic\032\252\001\n\020SessionStatistic\022\"\n\032nu"
-    "mber_of_frames_processed\030\001 \002(\004\022!\n\031avg_th"
-    "roughput_mb_per_sec\030\002 \002(\002\022.\n&med_frame_p"
-    "rocessing_time_per_frame_ns\030\003 \002(\022\022\037\n\027avg"
-    "_millisecs_per_frame\030\004 \001(\002", 1306);
+    "edian_ns\030\010 \002(\022\022\023\n\013num_samples\030\t \002(\004\022\027\n\013p"
+    "ercentiles\030\n \003(\001B\002\020\001\022 \n\024percentile_value"
+    "s_ns\030\013 \003(\022B\002\020\001\022$\n\034histogram_significant_"
+    "digits\030\014 \001(\r\022&\n\036histogram_highest_tracka"
+    "ble_ns\030\r \001(\022\022\035\n\021histogram_indices\030\016 \003(\rB"
+    "\002\020\001\022\034\n\020histogram_counts\030\017 \003(\004B\002\020\001\032o\n\nEve"
+    "ntTrace\022.\n\004type\030\001 \002(\0162 .fbt_format.Stage"
+    "Trace.EventType\022\032\n\016trace_times_ns\030\002 \003(\022B"
+    "\002\020\001\022\025\n\ttrace_ids\030\003 \003(\rB\002\020\001\"\250\001\n\tEventType"
+    "\022\021\n\rEXECUTE_BEGIN\020\001\022\031\n\025INPUT_TOKEN_AVAIL"
+    "ABLE\020\002\022\032\n\026OUTPUT_TOKEN_AVAILABLE\020\003\022\016\n\nTA"
+    "SK_BEGIN\020\004\022\014\n\010TASK_END\020\005\022\017\n\013EXECUTE_END\020"
+    "\006\022\021\n\rGL_TASK_BEGIN\020\007\022\017\n\013GL_TASK_END\020\010\"\?\n"
+    "\nOpenGLInfo\022\016\n\006vendor\030\001 \002(\t\022\020\n\010renderer\030"
+    "\002 \002(\t\022\017\n\007version\030\003 \002(\t\"\264\001\n\nQueueTrace\022\014\n"
+    "\004name\030\001 \002(\t\022\020\n\010capacity\030\002 \002(\r\022\031\n\rpush_ti"
+    "mes_ns\030\003 \003(\022B\002\020\001\022\032\n\016push_occupancy\030\004 \003(\r"
+    "B\002\020\001\022\030\n\014pop_times_ns\030\005 \003(\022B\002\020\001\022\031\n\rpop_oc"
+    "cupancy\030\006 \003(\rB\002\020\001\022\032\n\016dwell_times_ns\030\007 \003("
+    "\022B\002\020\001\"\254\003\n\014TraceSession\022\014\n\004name\030\001 \002(\t\022+\n\013"
+    "opengl_info\030\002 \002(\0132\026.fbt_format.OpenGLInf"
+    "o\022\022\n\nlocal_time\030\003 \002(\t\022,\n\014stage_traces\030\004 "
+    "\003(\0132\026.fbt_format.StageTrace\022D\n\021session_s"
+    "tatistic\030\005 \001(\0132).fbt_format.TraceSession"
+    ".SessionStatistic\022,\n\014queue_traces\030\006 \003(\0132"
+    "\026.fbt_format.QueueTrace\032\252\001\n\020SessionStati"
+    "stic\022\"\n\032number_of_frames_processed\030\001 \002(\004"
+    "\022!\n\031avg_throughput_mb_per_sec\030\002 \002(\002\022.\n&m"
+    "ed_frame_processing_time_per_frame_ns\030\003 "
+    "\002(\022\022\037\n\027avg_millisecs_per_frame\030\004 \001(\002", 1756);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "fbt_format.proto", &protobuf_RegisterTypes);
   StageTrace::default_instance_ = new StageTrace();
@@ -281,6 +328,7 @@ void protobuf_AddDesc_fbt_5fformat_2eproto() {
   StageTrace_DeltaStatistic::default_instance_ = new StageTrace_DeltaStatistic();
   StageTrace_EventTrace::default_instance_ = new StageTrace_EventTrace();
   OpenGLInfo::default_instance_ = new OpenGLInfo();
+  QueueTrace::default_instance_ = new QueueTrace();
   TraceSession::default_instance_ = new TraceSession();
   TraceSession_SessionStatistic::default_instance_ = new TraceSession_SessionStatistic();
   StageTrace::default_instance_->InitAsDefaultInstance();
@@ -288,6 +336,7 @@ void protobuf_AddDesc_fbt_5fformat_2eproto() {
   StageTrace_DeltaStatistic::default_instance_->InitAsDefaultInstance();
   StageTrace_EventTrace::default_instance_->InitAsDefaultInstance();
   OpenGLInfo::default_instance_->InitAsDefaultInstance();
+  QueueTrace::default_instance_->InitAsDefaultInstance();
   TraceSession::default_instance_->InitAsDefaultInstance();
   TraceSession_SessionStatistic::default_instance_->InitAsDefaultInstance();
   ::google::protobuf::internal::OnShutdown(&protobuf_ShutdownFile_fbt_5fformat_2eproto);
@@ -636,6 +685,12 @@ const int StageTrace_DeltaStatistic::kMaximumNsFieldNumber;
 const int StageTrace_DeltaStatistic::kStdDeviationNsFieldNumber;
 const int StageTrace_DeltaStatistic::kMedianNsFieldNumber;
 const int StageTrace_DeltaStatistic::kNumSamplesFieldNumber;
+const int StageTrace_DeltaStatistic::kPercentilesFieldNumber;
+const int StageTrace_DeltaStatistic::kPercentileValuesNsFieldNumber;
+const int StageTrace_DeltaStatistic::kHistogramSignificantDigitsFieldNumber;
+const int StageTrace_DeltaStatistic::kHistogramHighestTrackableNsFieldNumber;
+const int StageTrace_DeltaStatistic::kHistogramIndicesFieldNumber;
+const int StageTrace_DeltaStatistic::kHistogramCountsFieldNumber;
 #endif  // !_MSC_VER
 
 StageTrace_DeltaStatistic::StageTrace_DeltaStatistic()
@@ -666,6 +721,8 @@ void StageTrace_DeltaStatistic::SharedCtor() {
   std_deviation_ns_ = GOOGLE_LONGLONG(0);
   median_ns_ = GOOGLE_LONGLONG(0);
   num_samples_ = GOOGLE_ULONGLONG(0);
+  histogram_significant_digits_ = 0u;
+  histogram_highest_trackable_ns_ = GOOGLE_LONGLONG(0);
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -724,7 +781,15 @@ void StageTrace_DeltaStatistic::Clear() {
     begin_event_ = 1;
     end_event_ = 1;
   }
-  num_samples_ = GOOGLE_ULONGLONG(0);
+  if (_has_bits_[8 / 32] & 6400) {
+    num_samples_ = GOOGLE_ULONGLONG(0);
+    histogram_significant_digits_ = 0u;
+    histogram_highest_trackable_ns_ = GOOGLE_LONGLONG(0);
+  }
+  percentiles_.Clear();
+  percentile_values_ns_.Clear();
+  histogram_indices_.Clear();
+  histogram_counts_.Clear();
 
 #undef OFFSET_OF_FIELD_
 #undef ZR_
@@ -885,6 +950,108 @@ bool StageTrace_DeltaStatistic::MergePartialFromCodedStream(
         } else {
           goto handle_unusual;
         }
+        if (input->ExpectTag(82)) goto parse_percentiles;
+        break;
+      }
+
+      // repeated double percentiles = 10 [packed = true];
+      case 10: {
+        if (tag == 82) {
+         parse_percentiles:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
+                   double, ::google::protobuf::internal::WireFormatLite::TYPE_DOUBLE>(
+                 input, this->mutable_percentiles())));
+        } else if (tag == 81) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitive<
+                   double, ::google::protobuf::internal::WireFormatLite::TYPE_DOUBLE>(
+                 1, 82, input, this->mutable_percentiles())));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(90)) goto parse_percentile_values_ns;
+        break;
+      }
+
+      // repeated sint64 percentile_values_ns = 11 [packed = true];
+      case 11: {
+        if (tag == 90) {
+         parse_percentile_values_ns:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_SINT64>(
+                 input, this->mutable_percentile_values_ns())));
+        } else if (tag == 88) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_SINT64>(
+                 1, 90, input, this->mutable_percentile_values_ns())));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(96)) goto parse_histogram_significant_digits;
+        break;
+      }
+
+      // optional uint32 histogram_significant_digits = 12;
+      case 12: {
+        if (tag == 96) {
+         parse_histogram_significant_digits:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &histogram_significant_digits_)));
+          set_has_histogram_significant_digits();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(104)) goto parse_histogram_highest_trackable_ns;
+        break;
+      }
+
+      // optional sint64 histogram_highest_trackable_ns = 13;
+      case 13: {
+        if (tag == 104) {
+         parse_histogram_highest_trackable_ns:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_SINT64>(
+                 input, &histogram_highest_trackable_ns_)));
+          set_has_histogram_highest_trackable_ns();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(114)) goto parse_histogram_indices;
+        break;
+      }
+
+      // repeated uint32 histogram_indices = 14 [packed = true];
+      case 14: {
+        if (tag == 114) {
+         parse_histogram_indices:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, this->mutable_histogram_indices())));
+        } else if (tag == 112) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 1, 114, input, this->mutable_histogram_indices())));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(122)) goto parse_histogram_counts;
+        break;
+      }
+
+      // repeated uint64 histogram_counts = 15 [packed = true];
+      case 15: {
+        if (tag == 122) {
+         parse_histogram_counts:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, this->mutable_histogram_counts())));
+        } else if (tag == 120) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 1, 122, input, this->mutable_histogram_counts())));
+        } else {
+          goto handle_unusual;
+        }
         if (input->ExpectAtEnd()) goto success;
         break;
       }
@@ -966,6 +1133,56 @@ void StageTrace_DeltaStatistic::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteUInt64(9, this->num_samples(), output);
   }
 
+  // repeated double percentiles = 10 [packed = true];
+  if (this->percentiles_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(10, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_percentiles_cached_byte_size_);
+  }
+  for (int i = 0; i < this->percentiles_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteDoubleNoTag(
+      this->percentiles(i), output);
+  }
+
+  // repeated sint64 percentile_values_ns = 11 [packed = true];
+  if (this->percentile_values_ns_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(11, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_percentile_values_ns_cached_byte_size_);
+  }
+  for (int i = 0; i < this->percentile_values_ns_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteSInt64NoTag(
+      this->percentile_values_ns(i), output);
+  }
+
+  // optional uint32 histogram_significant_digits = 12;
+  if (has_histogram_significant_digits()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(12, this->histogram_significant_digits(), output);
+  }
+
+  // optional sint64 histogram_highest_trackable_ns = 13;
+  if (has_histogram_highest_trackable_ns()) {
+    ::google::protobuf::internal::WireFormatLite::WriteSInt64(13, this->histogram_highest_trackable_ns(), output);
+  }
+
+  // repeated uint32 histogram_indices = 14 [packed = true];
+  if (this->histogram_indices_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(14, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_histogram_indices_cached_byte_size_);
+  }
+  for (int i = 0; i < this->histogram_indices_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32NoTag(
+      this->histogram_indices(i), output);
+  }
+
+  // repeated uint64 histogram_counts = 15 [packed = true];
+  if (this->histogram_counts_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(15, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_histogram_counts_cached_byte_size_);
+  }
+  for (int i = 0; i < this->histogram_counts_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64NoTag(
+      this->histogram_counts(i), output);
+  }
+
   if (!unknown_fields().empty()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -1029,6 +1246,72 @@ void StageTrace_DeltaStatistic::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(9, this->num_samples(), target);
   }
 
+  // repeated double percentiles = 10 [packed = true];
+  if (this->percentiles_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      10,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _percentiles_cached_byte_size_, target);
+  }
+  for (int i = 0; i < this->percentiles_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteDoubleNoTagToArray(this->percentiles(i), target);
+  }
+
+  // repeated sint64 percentile_values_ns = 11 [packed = true];
+  if (this->percentile_values_ns_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      11,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _percentile_values_ns_cached_byte_size_, target);
+  }
+  for (int i = 0; i < this->percentile_values_ns_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteSInt64NoTagToArray(this->percentile_values_ns(i), target);
+  }
+
+  // optional uint32 histogram_significant_digits = 12;
+  if (has_histogram_significant_digits()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(12, this->histogram_significant_digits(), target);
+  }
+
+  // optional sint64 histogram_highest_trackable_ns = 13;
+  if (has_histogram_highest_trackable_ns()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteSInt64ToArray(13, this->histogram_highest_trackable_ns(), target);
+  }
+
+  // repeated uint32 histogram_indices = 14 [packed = true];
+  if (this->histogram_indices_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      14,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _histogram_indices_cached_byte_size_, target);
+  }
+  for (int i = 0; i < this->histogram_indices_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteUInt32NoTagToArray(this->histogram_indices(i), target);
+  }
+
+  // repeated uint64 histogram_counts = 15 [packed = true];
+  if (this->histogram_counts_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      15,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _histogram_counts_cached_byte_size_, target);
+  }
+  for (int i = 0; i < this->histogram_counts_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteUInt64NoTagToArray(this->histogram_counts(i), target);
+  }
+
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -1104,7 +1387,86 @@ int StageTrace_DeltaStatistic::ByteSize() const {
           this->num_samples());
     }
 
+    // optional uint32 histogram_significant_digits = 12;
+    if (has_histogram_significant_digits()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->histogram_significant_digits());
+    }
+
+    // optional sint64 histogram_highest_trackable_ns = 13;
+    if (has_histogram_highest_trackable_ns()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::SInt64Size(
+          this->histogram_highest_trackable_ns());
+    }
+
+  }
+  // repeated double percentiles = 10 [packed = true];
+  {
+    int data_size = 0;
+    data_size = 8 * this->percentiles_size();
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _percentiles_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
+  }
+
+  // repeated sint64 percentile_values_ns = 11 [packed = true];
+  {
+    int data_size = 0;
+    for (int i = 0; i < this->percentile_values_ns_size(); i++) {
+      data_size += ::google::protobuf::internal::WireFormatLite::
+        SInt64Size(this->percentile_values_ns(i));
+    }
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _percentile_values_ns_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
+  }
+
+  // repeated uint32 histogram_indices = 14 [packed = true];
+  {
+    int data_size = 0;
+    for (int i = 0; i < this->histogram_indices_size(); i++) {
+      data_size += ::google::protobuf::internal::WireFormatLite::
+        UInt32Size(this->histogram_indices(i));
+    }
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _histogram_indices_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
+  }
+
+  // repeated uint64 histogram_counts = 15 [packed = true];
+  {
+    int data_size = 0;
+    for (int i = 0; i < this->histogram_counts_size(); i++) {
+      data_size += ::google::protobuf::internal::WireFormatLite::
+        UInt64Size(this->histogram_counts(i));
+    }
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _histogram_counts_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
   }
+
   if (!unknown_fields().empty()) {
     total_size +=
       ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
@@ -1130,6 +1492,10 @@ void StageTrace_DeltaStatistic::MergeFrom(const ::google::protobuf::Message& fro
 
 void StageTrace_DeltaStatistic::MergeFrom(const StageTrace_DeltaStatistic& from) {
   GOOGLE_CHECK_NE(&from, this);
+  percentiles_.MergeFrom(from.percentiles_);
+  percentile_values_ns_.MergeFrom(from.percentile_values_ns_);
+  histogram_indices_.MergeFrom(from.histogram_indices_);
+  histogram_counts_.MergeFrom(from.histogram_counts_);
   if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
     if (from.has_name()) {
       set_name(from.name());
@@ -1160,6 +1526,12 @@ void StageTrace_DeltaStatistic::MergeFrom(const StageTrace_DeltaStatistic& from)
     if (from.has_num_samples()) {
       set_num_samples(from.num_samples());
     }
+    if (from.has_histogram_significant_digits()) {
+      set_histogram_significant_digits(from.histogram_significant_digits());
+    }
+    if (from.has_histogram_highest_trackable_ns()) {
+      set_histogram_highest_trackable_ns(from.histogram_highest_trackable_ns());
+    }
   }
   mutable_unknown_fields()->MergeFrom(from.unknown_fields());
 }
@@ -1193,6 +1565,12 @@ void StageTrace_DeltaStatistic::Swap(StageTrace_DeltaStatistic* other) {
     std::swap(std_deviation_ns_, other->std_deviation_ns_);
     std::swap(median_ns_, other->median_ns_);
     std::swap(num_samples_, other->num_samples_);
+    percentiles_.Swap(&other->percentiles_);
+    percentile_values_ns_.Swap(&other->percentile_values_ns_);
+    std::swap(histogram_significant_digits_, other->histogram_significant_digits_);
+    std::swap(histogram_highest_trackable_ns_, other->histogram_highest_trackable_ns_);
+    histogram_indices_.Swap(&other->histogram_indices_);
+    histogram_counts_.Swap(&other->histogram_counts_);
     std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
@@ -1213,6 +1591,7 @@ void StageTrace_DeltaStatistic::Swap(StageTrace_DeltaStatistic* other) {
 #ifndef _MSC_VER
 const int StageTrace_EventTrace::kTypeFieldNumber;
 const int StageTrace_EventTrace::kTraceTimesNsFieldNumber;
+const int StageTrace_EventTrace::kTraceIdsFieldNumber;
 #endif  // !_MSC_VER
 
 StageTrace_EventTrace::StageTrace_EventTrace()
@@ -1271,6 +1650,7 @@ StageTrace_EventTrace* StageTrace_EventTrace::New() const {
 void StageTrace_EventTrace::Clear() {
   type_ = 1;
   trace_times_ns_.Clear();
+  trace_ids_.Clear();
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   mutable_unknown_fields()->Clear();
 }
@@ -1318,6 +1698,24 @@ bool StageTrace_EventTrace::MergePartialFromCodedStream(
         } else {
           goto handle_unusual;
         }
+        if (input->ExpectTag(26)) goto parse_trace_ids;
+        break;
+      }
+
+      // repeated uint32 trace_ids = 3 [packed = true];
+      case 3: {
+        if (tag == 26) {
+         parse_trace_ids:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, this->mutable_trace_ids())));
+        } else if (tag == 24) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 1, 26, input, this->mutable_trace_ids())));
+        } else {
+          goto handle_unusual;
+        }
         if (input->ExpectAtEnd()) goto success;
         break;
       }
@@ -1363,6 +1761,16 @@ void StageTrace_EventTrace::SerializeWithCachedSizes(
       this->trace_times_ns(i), output);
   }
 
+  // repeated uint32 trace_ids = 3 [packed = true];
+  if (this->trace_ids_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(3, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_trace_ids_cached_byte_size_);
+  }
+  for (int i = 0; i < this->trace_ids_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32NoTag(
+      this->trace_ids(i), output);
+  }
+
   if (!unknown_fields().empty()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -1393,6 +1801,20 @@ void StageTrace_EventTrace::SerializeWithCachedSizes(
       WriteSInt64NoTagToArray(this->trace_times_ns(i), target);
   }
 
+  // repeated uint32 trace_ids = 3 [packed = true];
+  if (this->trace_ids_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      3,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _trace_ids_cached_byte_size_, target);
+  }
+  for (int i = 0; i < this->trace_ids_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteUInt32NoTagToArray(this->trace_ids(i), target);
+  }
+
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -1429,6 +1851,23 @@ int StageTrace_EventTrace::ByteSize() const {
     total_size += data_size;
   }
 
+  // repeated uint32 trace_ids = 3 [packed = true];
+  {
+    int data_size = 0;
+    for (int i = 0; i < this->trace_ids_size(); i++) {
+      data_size += ::google::protobuf::internal::WireFormatLite::
+        UInt32Size(this->trace_ids(i));
+    }
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _trace_ids_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
+  }
+
   if (!unknown_fields().empty()) {
     total_size +=
       ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
@@ -1455,6 +1894,7 @@ void StageTrace_EventTrace::MergeFrom(const ::google::protobuf::Message& from) {
 void StageTrace_EventTrace::MergeFrom(const StageTrace_EventTrace& from) {
   GOOGLE_CHECK_NE(&from, this);
   trace_times_ns_.MergeFrom(from.trace_times_ns_);
+  trace_ids_.MergeFrom(from.trace_ids_);
   if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
     if (from.has_type()) {
       set_type(from.type());
@@ -1485,6 +1925,7 @@ void StageTrace_EventTrace::Swap(StageTrace_EventTrace* other) {
   if (other != this) {
     std::swap(type_, other->type_);
     trace_times_ns_.Swap(&other->trace_times_ns_);
+    trace_ids_.Swap(&other->trace_ids_);
     std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
@@ -2231,80 +2672,680 @@ void OpenGLInfo::Swap(OpenGLInfo* other) {
 // ===================================================================
 
 #ifndef _MSC_VER
-const int TraceSession_SessionStatistic::kNumberOfFramesProcessedFieldNumber;
-const int TraceSession_SessionStatistic::kAvgThroughputMbPerSecFieldNumber;
-const int TraceSession_SessionStatistic::kMedFrameProcessingTimePerFrameNsFieldNumber;
-const int TraceSession_SessionStatistic::kAvgMillisecsPerFrameFieldNumber;
+const int QueueTrace::kNameFieldNumber;
+const int QueueTrace::kCapacityFieldNumber;
+const int QueueTrace::kPushTimesNsFieldNumber;
+const int QueueTrace::kPushOccupancyFieldNumber;
+const int QueueTrace::kPopTimesNsFieldNumber;
+const int QueueTrace::kPopOccupancyFieldNumber;
+const int QueueTrace::kDwellTimesNsFieldNumber;
 #endif  // !_MSC_VER
 
-TraceSession_SessionStatistic::TraceSession_SessionStatistic()
+QueueTrace::QueueTrace()
   : ::google::protobuf::Message() {
   SharedCtor();
-  // @@protoc_insertion_point(constructor:fbt_format.TraceSession.SessionStatistic)
+  // @@protoc_insertion_point(constructor:fbt_format.QueueTrace)
 }
 
-void TraceSession_SessionStatistic::InitAsDefaultInstance() {
+void QueueTrace::InitAsDefaultInstance() {
 }
 
-TraceSession_SessionStatistic::TraceSession_SessionStatistic(const TraceSession_SessionStatistic& from)
+QueueTrace::QueueTrace(const QueueTrace& from)
   : ::google::protobuf::Message() {
   SharedCtor();
   MergeFrom(from);
-  // @@protoc_insertion_point(copy_constructor:fbt_format.TraceSession.SessionStatistic)
+  // @@protoc_insertion_point(copy_constructor:fbt_format.QueueTrace)
 }
 
-void TraceSession_SessionStatistic::SharedCtor() {
+void QueueTrace::SharedCtor() {
+  ::google::protobuf::internal::GetEmptyString();
   _cached_size_ = 0;
-  number_of_frames_processed_ = GOOGLE_ULONGLONG(0);
-  avg_throughput_mb_per_sec_ = 0;
-  med_frame_processing_time_per_frame_ns_ = GOOGLE_LONGLONG(0);
-  avg_millisecs_per_frame_ = 0;
+  name_ = const_cast< ::std::string*>(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  capacity_ = 0u;
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
-TraceSession_SessionStatistic::~TraceSession_SessionStatistic() {
-  // @@protoc_insertion_point(destructor:fbt_format.TraceSession.SessionStatistic)
+QueueTrace::~QueueTrace() {
+  // @@protoc_insertion_point(destructor:fbt_format.QueueTrace)
   SharedDtor();
 }
 
-void TraceSession_SessionStatistic::SharedDtor() {
+void QueueTrace::SharedDtor() {
+  if (name_ != &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    delete name_;
+  }
   if (this != default_instance_) {
   }
 }
 
-void TraceSession_SessionStatistic::SetCachedSize(int size) const {
+void QueueTrace::SetCachedSize(int size) const {
   GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
   _cached_size_ = size;
   GOOGLE_SAFE_CONCURRENT_WRITES_END();
 }
-const ::google::protobuf::Descriptor* TraceSession_SessionStatistic::descriptor() {
+const ::google::protobuf::Descriptor* QueueTrace::descriptor() {
   protobuf_AssignDescriptorsOnce();
-  return TraceSession_SessionStatistic_descriptor_;
+  return QueueTrace_descriptor_;
 }
 
-const TraceSession_SessionStatistic& TraceSession_SessionStatistic::default_instance() {
+const QueueTrace& QueueTrace::default_instance() {
   if (default_instance_ == NULL) protobuf_AddDesc_fbt_5fformat_2eproto();
   return *default_instance_;
 }
 
-TraceSession_SessionStatistic* TraceSession_SessionStatistic::default_instance_ = NULL;
+QueueTrace* QueueTrace::default_instance_ = NULL;
 
-TraceSession_SessionStatistic* TraceSession_SessionStatistic::New() const {
-  return new TraceSession_SessionStatistic;
+QueueTrace* QueueTrace::New() const {
+  return new QueueTrace;
 }
 
-void TraceSession_SessionStatistic::Clear() {
-#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
-  &reinterpret_cast<TraceSession_SessionStatistic*>(16)->f) - \
-   reinterpret_cast<char*>(16))
-
-#define ZR_(first, last) do {                              \
-    size_t f = OFFSET_OF_FIELD_(first);                    \
-    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
-    ::memset(&first, 0, n);                                \
-  } while (0)
-
-  ZR_(number_of_frames_processed_, avg_millisecs_per_frame_);
+void QueueTrace::Clear() {
+  if (_has_bits_[0 / 32] & 3) {
+    if (has_name()) {
+      if (name_ != &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+        name_->clear();
+      }
+    }
+    capacity_ = 0u;
+  }
+  push_times_ns_.Clear();
+  push_occupancy_.Clear();
+  pop_times_ns_.Clear();
+  pop_occupancy_.Clear();
+  dwell_times_ns_.Clear();
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool QueueTrace::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
+  ::google::protobuf::uint32 tag;
+  // @@protoc_insertion_point(parse_start:fbt_format.QueueTrace)
+  for (;;) {
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // required string name = 1;
+      case 1: {
+        if (tag == 10) {
+          DO_(::google::protobuf::internal::WireFormatLite::ReadString(
+                input, this->mutable_name()));
+          ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(
+            this->name().data(), this->name().length(),
+            ::google::protobuf::internal::WireFormat::PARSE,
+            "name");
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(16)) goto parse_capacity;
+        break;
+      }
+
+      // required uint32 capacity = 2;
+      case 2: {
+        if (tag == 16) {
+         parse_capacity:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &capacity_)));
+          set_has_capacity();
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(26)) goto parse_push_times_ns;
+        break;
+      }
+
+      // repeated sint64 push_times_ns = 3 [packed = true];
+      case 3: {
+        if (tag == 26) {
+         parse_push_times_ns:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_SINT64>(
+                 input, this->mutable_push_times_ns())));
+        } else if (tag == 24) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_SINT64>(
+                 1, 26, input, this->mutable_push_times_ns())));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(34)) goto parse_push_occupancy;
+        break;
+      }
+
+      // repeated uint32 push_occupancy = 4 [packed = true];
+      case 4: {
+        if (tag == 34) {
+         parse_push_occupancy:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, this->mutable_push_occupancy())));
+        } else if (tag == 32) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 1, 34, input, this->mutable_push_occupancy())));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(42)) goto parse_pop_times_ns;
+        break;
+      }
+
+      // repeated sint64 pop_times_ns = 5 [packed = true];
+      case 5: {
+        if (tag == 42) {
+         parse_pop_times_ns:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_SINT64>(
+                 input, this->mutable_pop_times_ns())));
+        } else if (tag == 40) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_SINT64>(
+                 1, 42, input, this->mutable_pop_times_ns())));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(50)) goto parse_pop_occupancy;
+        break;
+      }
+
+      // repeated uint32 pop_occupancy = 6 [packed = true];
+      case 6: {
+        if (tag == 50) {
+         parse_pop_occupancy:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, this->mutable_pop_occupancy())));
+        } else if (tag == 48) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 1, 50, input, this->mutable_pop_occupancy())));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(58)) goto parse_dwell_times_ns;
+        break;
+      }
+
+      // repeated sint64 dwell_times_ns = 7 [packed = true];
+      case 7: {
+        if (tag == 58) {
+         parse_dwell_times_ns:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_SINT64>(
+                 input, this->mutable_dwell_times_ns())));
+        } else if (tag == 56) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_SINT64>(
+                 1, 58, input, this->mutable_dwell_times_ns())));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectAtEnd()) goto success;
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0 ||
+            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          goto success;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+success:
+  // @@protoc_insertion_point(parse_success:fbt_format.QueueTrace)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:fbt_format.QueueTrace)
+  return false;
+#undef DO_
+}
+
+void QueueTrace::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:fbt_format.QueueTrace)
+  // required string name = 1;
+  if (has_name()) {
+    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->name().data(), this->name().length(),
+      ::google::protobuf::internal::WireFormat::SERIALIZE,
+      "name");
+    ::google::protobuf::internal::WireFormatLite::WriteStringMaybeAliased(
+      1, this->name(), output);
+  }
+
+  // required uint32 capacity = 2;
+  if (has_capacity()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(2, this->capacity(), output);
+  }
+
+  // repeated sint64 push_times_ns = 3 [packed = true];
+  if (this->push_times_ns_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(3, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_push_times_ns_cached_byte_size_);
+  }
+  for (int i = 0; i < this->push_times_ns_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteSInt64NoTag(
+      this->push_times_ns(i), output);
+  }
+
+  // repeated uint32 push_occupancy = 4 [packed = true];
+  if (this->push_occupancy_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(4, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_push_occupancy_cached_byte_size_);
+  }
+  for (int i = 0; i < this->push_occupancy_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32NoTag(
+      this->push_occupancy(i), output);
+  }
+
+  // repeated sint64 pop_times_ns = 5 [packed = true];
+  if (this->pop_times_ns_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(5, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_pop_times_ns_cached_byte_size_);
+  }
+  for (int i = 0; i < this->pop_times_ns_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteSInt64NoTag(
+      this->pop_times_ns(i), output);
+  }
+
+  // repeated uint32 pop_occupancy = 6 [packed = true];
+  if (this->pop_occupancy_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(6, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_pop_occupancy_cached_byte_size_);
+  }
+  for (int i = 0; i < this->pop_occupancy_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32NoTag(
+      this->pop_occupancy(i), output);
+  }
+
+  // repeated sint64 dwell_times_ns = 7 [packed = true];
+  if (this->dwell_times_ns_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(7, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_dwell_times_ns_cached_byte_size_);
+  }
+  for (int i = 0; i < this->dwell_times_ns_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteSInt64NoTag(
+      this->dwell_times_ns(i), output);
+  }
+
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:fbt_format.QueueTrace)
+}
+
+::google::protobuf::uint8* QueueTrace::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:fbt_format.QueueTrace)
+  // required string name = 1;
+  if (has_name()) {
+    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->name().data(), this->name().length(),
+      ::google::protobuf::internal::WireFormat::SERIALIZE,
+      "name");
+    target =
+      ::google::protobuf::internal::WireFormatLite::WriteStringToArray(
+        1, this->name(), target);
+  }
+
+  // required uint32 capacity = 2;
+  if (has_capacity()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(2, this->capacity(), target);
+  }
+
+  // repeated sint64 push_times_ns = 3 [packed = true];
+  if (this->push_times_ns_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      3,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _push_times_ns_cached_byte_size_, target);
+  }
+  for (int i = 0; i < this->push_times_ns_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteSInt64NoTagToArray(this->push_times_ns(i), target);
+  }
+
+  // repeated uint32 push_occupancy = 4 [packed = true];
+  if (this->push_occupancy_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      4,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _push_occupancy_cached_byte_size_, target);
+  }
+  for (int i = 0; i < this->push_occupancy_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteUInt32NoTagToArray(this->push_occupancy(i), target);
+  }
+
+  // repeated sint64 pop_times_ns = 5 [packed = true];
+  if (this->pop_times_ns_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      5,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _pop_times_ns_cached_byte_size_, target);
+  }
+  for (int i = 0; i < this->pop_times_ns_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteSInt64NoTagToArray(this->pop_times_ns(i), target);
+  }
+
+  // repeated uint32 pop_occupancy = 6 [packed = true];
+  if (this->pop_occupancy_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      6,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _pop_occupancy_cached_byte_size_, target);
+  }
+  for (int i = 0; i < this->pop_occupancy_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteUInt32NoTagToArray(this->pop_occupancy(i), target);
+  }
+
+  // repeated sint64 dwell_times_ns = 7 [packed = true];
+  if (this->dwell_times_ns_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      7,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _dwell_times_ns_cached_byte_size_, target);
+  }
+  for (int i = 0; i < this->dwell_times_ns_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteSInt64NoTagToArray(this->dwell_times_ns(i), target);
+  }
+
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:fbt_format.QueueTrace)
+  return target;
+}
+
+int QueueTrace::ByteSize() const {
+  int total_size = 0;
+
+  if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    // required string name = 1;
+    if (has_name()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::StringSize(
+          this->name());
+    }
+
+    // required uint32 capacity = 2;
+    if (has_capacity()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->capacity());
+    }
+
+  }
+  // repeated sint64 push_times_ns = 3 [packed = true];
+  {
+    int data_size = 0;
+    for (int i = 0; i < this->push_times_ns_size(); i++) {
+      data_size += ::google::protobuf::internal::WireFormatLite::
+        SInt64Size(this->push_times_ns(i));
+    }
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _push_times_ns_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
+  }
+
+  // repeated uint32 push_occupancy = 4 [packed = true];
+  {
+    int data_size = 0;
+    for (int i = 0; i < this->push_occupancy_size(); i++) {
+      data_size += ::google::protobuf::internal::WireFormatLite::
+        UInt32Size(this->push_occupancy(i));
+    }
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _push_occupancy_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
+  }
+
+  // repeated sint64 pop_times_ns = 5 [packed = true];
+  {
+    int data_size = 0;
+    for (int i = 0; i < this->pop_times_ns_size(); i++) {
+      data_size += ::google::protobuf::internal::WireFormatLite::
+        SInt64Size(this->pop_times_ns(i));
+    }
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _pop_times_ns_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
+  }
+
+  // repeated uint32 pop_occupancy = 6 [packed = true];
+  {
+    int data_size = 0;
+    for (int i = 0; i < this->pop_occupancy_size(); i++) {
+      data_size += ::google::protobuf::internal::WireFormatLite::
+        UInt32Size(this->pop_occupancy(i));
+    }
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _pop_occupancy_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
+  }
+
+  // repeated sint64 dwell_times_ns = 7 [packed = true];
+  {
+    int data_size = 0;
+    for (int i = 0; i < this->dwell_times_ns_size(); i++) {
+      data_size += ::google::protobuf::internal::WireFormatLite::
+        SInt64Size(this->dwell_times_ns(i));
+    }
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _dwell_times_ns_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
+  }
+
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void QueueTrace::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const QueueTrace* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const QueueTrace*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void QueueTrace::MergeFrom(const QueueTrace& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  push_times_ns_.MergeFrom(from.push_times_ns_);
+  push_occupancy_.MergeFrom(from.push_occupancy_);
+  pop_times_ns_.MergeFrom(from.pop_times_ns_);
+  pop_occupancy_.MergeFrom(from.pop_occupancy_);
+  dwell_times_ns_.MergeFrom(from.dwell_times_ns_);
+  if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    if (from.has_name()) {
+      set_name(from.name());
+    }
+    if (from.has_capacity()) {
+      set_capacity(from.capacity());
+    }
+  }
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void QueueTrace::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void QueueTrace::CopyFrom(const QueueTrace& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool QueueTrace::IsInitialized() const {
+  if ((_has_bits_[0] & 0x00000003) != 0x00000003) return false;
+
+  return true;
+}
+
+void QueueTrace::Swap(QueueTrace* other) {
+  if (other != this) {
+    std::swap(name_, other->name_);
+    std::swap(capacity_, other->capacity_);
+    push_times_ns_.Swap(&other->push_times_ns_);
+    push_occupancy_.Swap(&other->push_occupancy_);
+    pop_times_ns_.Swap(&other->pop_times_ns_);
+    pop_occupancy_.Swap(&other->pop_occupancy_);
+    dwell_times_ns_.Swap(&other->dwell_times_ns_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata QueueTrace::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = QueueTrace_descriptor_;
+  metadata.reflection = QueueTrace_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+#ifndef _MSC_VER
+const int TraceSession_SessionStatistic::kNumberOfFramesProcessedFieldNumber;
+const int TraceSession_SessionStatistic::kAvgThroughputMbPerSecFieldNumber;
+const int TraceSession_SessionStatistic::kMedFrameProcessingTimePerFrameNsFieldNumber;
+const int TraceSession_SessionStatistic::kAvgMillisecsPerFrameFieldNumber;
+#endif  // !_MSC_VER
+
+TraceSession_SessionStatistic::TraceSession_SessionStatistic()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:fbt_format.TraceSession.SessionStatistic)
+}
+
+void TraceSession_SessionStatistic::InitAsDefaultInstance() {
+}
+
+TraceSession_SessionStatistic::TraceSession_SessionStatistic(const TraceSession_SessionStatistic& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+  // @@protoc_insertion_point(copy_constructor:fbt_format.TraceSession.SessionStatistic)
+}
+
+void TraceSession_SessionStatistic::SharedCtor() {
+  _cached_size_ = 0;
+  number_of_frames_processed_ = GOOGLE_ULONGLONG(0);
+  avg_throughput_mb_per_sec_ = 0;
+  med_frame_processing_time_per_frame_ns_ = GOOGLE_LONGLONG(0);
+  avg_millisecs_per_frame_ = 0;
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+TraceSession_SessionStatistic::~TraceSession_SessionStatistic() {
+  // @@protoc_insertion_point(destructor:fbt_format.TraceSession.SessionStatistic)
+  SharedDtor();
+}
+
+void TraceSession_SessionStatistic::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void TraceSession_SessionStatistic::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* TraceSession_SessionStatistic::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return TraceSession_SessionStatistic_descriptor_;
+}
+
+const TraceSession_SessionStatistic& TraceSession_SessionStatistic::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_fbt_5fformat_2eproto();
+  return *default_instance_;
+}
+
+TraceSession_SessionStatistic* TraceSession_SessionStatistic::default_instance_ = NULL;
+
+TraceSession_SessionStatistic* TraceSession_SessionStatistic::New() const {
+  return new TraceSession_SessionStatistic;
+}
+
+void TraceSession_SessionStatistic::Clear() {
+#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
+  &reinterpret_cast<TraceSession_SessionStatistic*>(16)->f) - \
+   reinterpret_cast<char*>(16))
+
+#define ZR_(first, last) do {                              \
+    size_t f = OFFSET_OF_FIELD_(first);                    \
+    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
+    ::memset(&first, 0, n);                                \
+  } while (0)
+
+  ZR_(number_of_frames_processed_, avg_millisecs_per_frame_);
 
 #undef OFFSET_OF_FIELD_
 #undef ZR_
@@ -2583,6 +3624,7 @@ const int TraceSession::kOpenglInfoFieldNumber;
 const int TraceSession::kLocalTimeFieldNumber;
 const int TraceSession::kStageTracesFieldNumber;
 const int TraceSession::kSessionStatisticFieldNumber;
+const int TraceSession::kQueueTracesFieldNumber;
 #endif  // !_MSC_VER
 
 TraceSession::TraceSession()
@@ -2672,6 +3714,7 @@ void TraceSession::Clear() {
     }
   }
   stage_traces_.Clear();
+  queue_traces_.Clear();
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   mutable_unknown_fields()->Clear();
 }
@@ -2755,6 +3798,20 @@ bool TraceSession::MergePartialFromCodedStream(
         } else {
           goto handle_unusual;
         }
+        if (input->ExpectTag(50)) goto parse_queue_traces;
+        break;
+      }
+
+      // repeated .fbt_format.QueueTrace queue_traces = 6;
+      case 6: {
+        if (tag == 50) {
+         parse_queue_traces:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+                input, add_queue_traces()));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(50)) goto parse_queue_traces;
         if (input->ExpectAtEnd()) goto success;
         break;
       }
@@ -2822,6 +3879,12 @@ void TraceSession::SerializeWithCachedSizes(
       5, this->session_statistic(), output);
   }
 
+  // repeated .fbt_format.QueueTrace queue_traces = 6;
+  for (int i = 0; i < this->queue_traces_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      6, this->queue_traces(i), output);
+  }
+
   if (!unknown_fields().empty()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -2875,6 +3938,13 @@ void TraceSession::SerializeWithCachedSizes(
         5, this->session_statistic(), target);
   }
 
+  // repeated .fbt_format.QueueTrace queue_traces = 6;
+  for (int i = 0; i < this->queue_traces_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        6, this->queue_traces(i), target);
+  }
+
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -2924,6 +3994,14 @@ int TraceSession::ByteSize() const {
         this->stage_traces(i));
   }
 
+  // repeated .fbt_format.QueueTrace queue_traces = 6;
+  total_size += 1 * this->queue_traces_size();
+  for (int i = 0; i < this->queue_traces_size(); i++) {
+    total_size +=
+      ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+        this->queue_traces(i));
+  }
+
   if (!unknown_fields().empty()) {
     total_size +=
       ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
@@ -2950,6 +4028,7 @@ void TraceSession::MergeFrom(const ::google::protobuf::Message& from) {
 void TraceSession::MergeFrom(const TraceSession& from) {
   GOOGLE_CHECK_NE(&from, this);
   stage_traces_.MergeFrom(from.stage_traces_);
+  queue_traces_.MergeFrom(from.queue_traces_);
   if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
     if (from.has_name()) {
       set_name(from.name());
@@ -2989,6 +4068,7 @@ bool TraceSession::IsInitialized() const {
   if (has_session_statistic()) {
     if (!this->session_statistic().IsInitialized()) return false;
   }
+  if (!::google::protobuf::internal::AllAreInitialized(this->queue_traces())) return false;
   return true;
 }
 
@@ -2999,6 +4079,7 @@ void TraceSession::Swap(TraceSession* other) {
     std::swap(local_time_, other->local_time_);
     stage_traces_.Swap(&other->stage_traces_);
     std::swap(session_statistic_, other->session_statistic_);
+    queue_traces_.Swap(&other->queue_traces_);
     std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
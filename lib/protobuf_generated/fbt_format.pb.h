@@ -39,6 +39,7 @@ class StageTrace_EventNameMapping;
 class StageTrace_DeltaStatistic;
 class StageTrace_EventTrace;
 class OpenGLInfo;
+class QueueTrace;
 class TraceSession;
 class TraceSession_SessionStatistic;
 
@@ -284,6 +285,68 @@ class StageTrace_DeltaStatistic : public ::google::protobuf::Message {
   inline ::google::protobuf::uint64 num_samples() const;
   inline void set_num_samples(::google::protobuf::uint64 value);
 
+  // repeated double percentiles = 10 [packed = true];
+  inline int percentiles_size() const;
+  inline void clear_percentiles();
+  static const int kPercentilesFieldNumber = 10;
+  inline double percentiles(int index) const;
+  inline void set_percentiles(int index, double value);
+  inline void add_percentiles(double value);
+  inline const ::google::protobuf::RepeatedField< double >&
+      percentiles() const;
+  inline ::google::protobuf::RepeatedField< double >*
+      mutable_percentiles();
+
+  // repeated sint64 percentile_values_ns = 11 [packed = true];
+  inline int percentile_values_ns_size() const;
+  inline void clear_percentile_values_ns();
+  static const int kPercentileValuesNsFieldNumber = 11;
+  inline ::google::protobuf::int64 percentile_values_ns(int index) const;
+  inline void set_percentile_values_ns(int index, ::google::protobuf::int64 value);
+  inline void add_percentile_values_ns(::google::protobuf::int64 value);
+  inline const ::google::protobuf::RepeatedField< ::google::protobuf::int64 >&
+      percentile_values_ns() const;
+  inline ::google::protobuf::RepeatedField< ::google::protobuf::int64 >*
+      mutable_percentile_values_ns();
+
+  // optional uint32 histogram_significant_digits = 12;
+  inline bool has_histogram_significant_digits() const;
+  inline void clear_histogram_significant_digits();
+  static const int kHistogramSignificantDigitsFieldNumber = 12;
+  inline ::google::protobuf::uint32 histogram_significant_digits() const;
+  inline void set_histogram_significant_digits(::google::protobuf::uint32 value);
+
+  // optional sint64 histogram_highest_trackable_ns = 13;
+  inline bool has_histogram_highest_trackable_ns() const;
+  inline void clear_histogram_highest_trackable_ns();
+  static const int kHistogramHighestTrackableNsFieldNumber = 13;
+  inline ::google::protobuf::int64 histogram_highest_trackable_ns() const;
+  inline void set_histogram_highest_trackable_ns(::google::protobuf::int64 value);
+
+  // repeated uint32 histogram_indices = 14 [packed = true];
+  inline int histogram_indices_size() const;
+  inline void clear_histogram_indices();
+  static const int kHistogramIndicesFieldNumber = 14;
+  inline ::google::protobuf::uint32 histogram_indices(int index) const;
+  inline void set_histogram_indices(int index, ::google::protobuf::uint32 value);
+  inline void add_histogram_indices(::google::protobuf::uint32 value);
+  inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >&
+      histogram_indices() const;
+  inline ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >*
+      mutable_histogram_indices();
+
+  // repeated uint64 histogram_counts = 15 [packed = true];
+  inline int histogram_counts_size() const;
+  inline void clear_histogram_counts();
+  static const int kHistogramCountsFieldNumber = 15;
+  inline ::google::protobuf::uint64 histogram_counts(int index) const;
+  inline void set_histogram_counts(int index, ::google::protobuf::uint64 value);
+  inline void add_histogram_counts(::google::protobuf::uint64 value);
+  inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint64 >&
+      histogram_counts() const;
+  inline ::google::protobuf::RepeatedField< ::google::protobuf::uint64 >*
+      mutable_histogram_counts();
+
   // @@protoc_insertion_point(class_scope:fbt_format.StageTrace.DeltaStatistic)
  private:
   inline void set_has_name();
@@ -304,6 +367,10 @@ class StageTrace_DeltaStatistic : public ::google::protobuf::Message {
   inline void clear_has_median_ns();
   inline void set_has_num_samples();
   inline void clear_has_num_samples();
+  inline void set_has_histogram_significant_digits();
+  inline void clear_has_histogram_significant_digits();
+  inline void set_has_histogram_highest_trackable_ns();
+  inline void clear_has_histogram_highest_trackable_ns();
 
   ::google::protobuf::UnknownFieldSet _unknown_fields_;
 
@@ -318,6 +385,16 @@ class StageTrace_DeltaStatistic : public ::google::protobuf::Message {
   ::google::protobuf::int64 std_deviation_ns_;
   ::google::protobuf::int64 median_ns_;
   ::google::protobuf::uint64 num_samples_;
+  ::google::protobuf::RepeatedField< double > percentiles_;
+  mutable int _percentiles_cached_byte_size_;
+  ::google::protobuf::RepeatedField< ::google::protobuf::int64 > percentile_values_ns_;
+  mutable int _percentile_values_ns_cached_byte_size_;
+  ::google::protobuf::uint32 histogram_significant_digits_;
+  ::google::protobuf::int64 histogram_highest_trackable_ns_;
+  ::google::protobuf::RepeatedField< ::google::protobuf::uint32 > histogram_indices_;
+  mutable int _histogram_indices_cached_byte_size_;
+  ::google::protobuf::RepeatedField< ::google::protobuf::uint64 > histogram_counts_;
+  mutable int _histogram_counts_cached_byte_size_;
   friend void  protobuf_AddDesc_fbt_5fformat_2eproto();
   friend void protobuf_AssignDesc_fbt_5fformat_2eproto();
   friend void protobuf_ShutdownFile_fbt_5fformat_2eproto();
@@ -399,6 +476,18 @@ class StageTrace_EventTrace : public ::google::protobuf::Message {
   inline ::google::protobuf::RepeatedField< ::google::protobuf::int64 >*
       mutable_trace_times_ns();
 
+  // repeated uint32 trace_ids = 3 [packed = true];
+  inline int trace_ids_size() const;
+  inline void clear_trace_ids();
+  static const int kTraceIdsFieldNumber = 3;
+  inline ::google::protobuf::uint32 trace_ids(int index) const;
+  inline void set_trace_ids(int index, ::google::protobuf::uint32 value);
+  inline void add_trace_ids(::google::protobuf::uint32 value);
+  inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >&
+      trace_ids() const;
+  inline ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >*
+      mutable_trace_ids();
+
   // @@protoc_insertion_point(class_scope:fbt_format.StageTrace.EventTrace)
  private:
   inline void set_has_type();
@@ -411,6 +500,8 @@ class StageTrace_EventTrace : public ::google::protobuf::Message {
   ::google::protobuf::RepeatedField< ::google::protobuf::int64 > trace_times_ns_;
   mutable int _trace_times_ns_cached_byte_size_;
   int type_;
+  ::google::protobuf::RepeatedField< ::google::protobuf::uint32 > trace_ids_;
+  mutable int _trace_ids_cached_byte_size_;
   friend void  protobuf_AddDesc_fbt_5fformat_2eproto();
   friend void protobuf_AssignDesc_fbt_5fformat_2eproto();
   friend void protobuf_ShutdownFile_fbt_5fformat_2eproto();
@@ -691,6 +782,170 @@ class OpenGLInfo : public ::google::protobuf::Message {
 };
 // -------------------------------------------------------------------
 
+class QueueTrace : public ::google::protobuf::Message {
+ public:
+  QueueTrace();
+  virtual ~QueueTrace();
+
+  QueueTrace(const QueueTrace& from);
+
+  inline QueueTrace& operator=(const QueueTrace& from) {
+    CopyFrom(from);
+    return *this;
+  }
+
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const QueueTrace& default_instance();
+
+  void Swap(QueueTrace* other);
+
+  // implements Message ----------------------------------------------
+
+  QueueTrace* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const QueueTrace& from);
+  void MergeFrom(const QueueTrace& from);
+  void Clear();
+  bool IsInitialized() const;
+
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  ::google::protobuf::Metadata GetMetadata() const;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  // required string name = 1;
+  inline bool has_name() const;
+  inline void clear_name();
+  static const int kNameFieldNumber = 1;
+  inline const ::std::string& name() const;
+  inline void set_name(const ::std::string& value);
+  inline void set_name(const char* value);
+  inline void set_name(const char* value, size_t size);
+  inline ::std::string* mutable_name();
+  inline ::std::string* release_name();
+  inline void set_allocated_name(::std::string* name);
+
+  // required uint32 capacity = 2;
+  inline bool has_capacity() const;
+  inline void clear_capacity();
+  static const int kCapacityFieldNumber = 2;
+  inline ::google::protobuf::uint32 capacity() const;
+  inline void set_capacity(::google::protobuf::uint32 value);
+
+  // repeated sint64 push_times_ns = 3 [packed = true];
+  inline int push_times_ns_size() const;
+  inline void clear_push_times_ns();
+  static const int kPushTimesNsFieldNumber = 3;
+  inline ::google::protobuf::int64 push_times_ns(int index) const;
+  inline void set_push_times_ns(int index, ::google::protobuf::int64 value);
+  inline void add_push_times_ns(::google::protobuf::int64 value);
+  inline const ::google::protobuf::RepeatedField< ::google::protobuf::int64 >&
+      push_times_ns() const;
+  inline ::google::protobuf::RepeatedField< ::google::protobuf::int64 >*
+      mutable_push_times_ns();
+
+  // repeated uint32 push_occupancy = 4 [packed = true];
+  inline int push_occupancy_size() const;
+  inline void clear_push_occupancy();
+  static const int kPushOccupancyFieldNumber = 4;
+  inline ::google::protobuf::uint32 push_occupancy(int index) const;
+  inline void set_push_occupancy(int index, ::google::protobuf::uint32 value);
+  inline void add_push_occupancy(::google::protobuf::uint32 value);
+  inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >&
+      push_occupancy() const;
+  inline ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >*
+      mutable_push_occupancy();
+
+  // repeated sint64 pop_times_ns = 5 [packed = true];
+  inline int pop_times_ns_size() const;
+  inline void clear_pop_times_ns();
+  static const int kPopTimesNsFieldNumber = 5;
+  inline ::google::protobuf::int64 pop_times_ns(int index) const;
+  inline void set_pop_times_ns(int index, ::google::protobuf::int64 value);
+  inline void add_pop_times_ns(::google::protobuf::int64 value);
+  inline const ::google::protobuf::RepeatedField< ::google::protobuf::int64 >&
+      pop_times_ns() const;
+  inline ::google::protobuf::RepeatedField< ::google::protobuf::int64 >*
+      mutable_pop_times_ns();
+
+  // repeated uint32 pop_occupancy = 6 [packed = true];
+  inline int pop_occupancy_size() const;
+  inline void clear_pop_occupancy();
+  static const int kPopOccupancyFieldNumber = 6;
+  inline ::google::protobuf::uint32 pop_occupancy(int index) const;
+  inline void set_pop_occupancy(int index, ::google::protobuf::uint32 value);
+  inline void add_pop_occupancy(::google::protobuf::uint32 value);
+  inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >&
+      pop_occupancy() const;
+  inline ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >*
+      mutable_pop_occupancy();
+
+  // repeated sint64 dwell_times_ns = 7 [packed = true];
+  inline int dwell_times_ns_size() const;
+  inline void clear_dwell_times_ns();
+  static const int kDwellTimesNsFieldNumber = 7;
+  inline ::google::protobuf::int64 dwell_times_ns(int index) const;
+  inline void set_dwell_times_ns(int index, ::google::protobuf::int64 value);
+  inline void add_dwell_times_ns(::google::protobuf::int64 value);
+  inline const ::google::protobuf::RepeatedField< ::google::protobuf::int64 >&
+      dwell_times_ns() const;
+  inline ::google::protobuf::RepeatedField< ::google::protobuf::int64 >*
+      mutable_dwell_times_ns();
+
+  // @@protoc_insertion_point(class_scope:fbt_format.QueueTrace)
+ private:
+  inline void set_has_name();
+  inline void clear_has_name();
+  inline void set_has_capacity();
+  inline void clear_has_capacity();
+
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+
+  ::google::protobuf::uint32 _has_bits_[1];
+  mutable int _cached_size_;
+  ::std::string* name_;
+  ::google::protobuf::uint32 capacity_;
+  ::google::protobuf::RepeatedField< ::google::protobuf::int64 > push_times_ns_;
+  mutable int _push_times_ns_cached_byte_size_;
+  ::google::protobuf::RepeatedField< ::google::protobuf::uint32 > push_occupancy_;
+  mutable int _push_occupancy_cached_byte_size_;
+  ::google::protobuf::RepeatedField< ::google::protobuf::int64 > pop_times_ns_;
+  mutable int _pop_times_ns_cached_byte_size_;
+  ::google::protobuf::RepeatedField< ::google::protobuf::uint32 > pop_occupancy_;
+  mutable int _pop_occupancy_cached_byte_size_;
+  ::google::protobuf::RepeatedField< ::google::protobuf::int64 > dwell_times_ns_;
+  mutable int _dwell_times_ns_cached_byte_size_;
+  friend void  protobuf_AddDesc_fbt_5fformat_2eproto();
+  friend void protobuf_AssignDesc_fbt_5fformat_2eproto();
+  friend void protobuf_ShutdownFile_fbt_5fformat_2eproto();
+
+  void InitAsDefaultInstance();
+  static QueueTrace* default_instance_;
+};
+// -------------------------------------------------------------------
+
 class TraceSession_SessionStatistic : public ::google::protobuf::Message {
  public:
   TraceSession_SessionStatistic();
@@ -909,6 +1164,18 @@ class TraceSession : public ::google::protobuf::Message {
   inline ::fbt_format::TraceSession_SessionStatistic* release_session_statistic();
   inline void set_allocated_session_statistic(::fbt_format::TraceSession_SessionStatistic* session_statistic);
 
+  // repeated .fbt_format.QueueTrace queue_traces = 6;
+  inline int queue_traces_size() const;
+  inline void clear_queue_traces();
+  static const int kQueueTracesFieldNumber = 6;
+  inline const ::fbt_format::QueueTrace& queue_traces(int index) const;
+  inline ::fbt_format::QueueTrace* mutable_queue_traces(int index);
+  inline ::fbt_format::QueueTrace* add_queue_traces();
+  inline const ::google::protobuf::RepeatedPtrField< ::fbt_format::QueueTrace >&
+      queue_traces() const;
+  inline ::google::protobuf::RepeatedPtrField< ::fbt_format::QueueTrace >*
+      mutable_queue_traces();
+
   // @@protoc_insertion_point(class_scope:fbt_format.TraceSession)
  private:
   inline void set_has_name();
@@ -929,6 +1196,7 @@ class TraceSession : public ::google::protobuf::Message {
   ::std::string* local_time_;
   ::google::protobuf::RepeatedPtrField< ::fbt_format::StageTrace > stage_traces_;
   ::fbt_format::TraceSession_SessionStatistic* session_statistic_;
+  ::google::protobuf::RepeatedPtrField< ::fbt_format::QueueTrace > queue_traces_;
   friend void  protobuf_AddDesc_fbt_5fformat_2eproto();
   friend void protobuf_AssignDesc_fbt_5fformat_2eproto();
   friend void protobuf_ShutdownFile_fbt_5fformat_2eproto();
@@ -1318,6 +1586,174 @@ inline void StageTrace_DeltaStatistic::set_num_samples(::google::protobuf::uint6
   // @@protoc_insertion_point(field_set:fbt_format.StageTrace.DeltaStatistic.num_samples)
 }
 
+// repeated double percentiles = 10 [packed = true];
+inline int StageTrace_DeltaStatistic::percentiles_size() const {
+  return percentiles_.size();
+}
+inline void StageTrace_DeltaStatistic::clear_percentiles() {
+  percentiles_.Clear();
+}
+inline double StageTrace_DeltaStatistic::percentiles(int index) const {
+  // @@protoc_insertion_point(field_get:fbt_format.StageTrace.DeltaStatistic.percentiles)
+  return percentiles_.Get(index);
+}
+inline void StageTrace_DeltaStatistic::set_percentiles(int index, double value) {
+  percentiles_.Set(index, value);
+  // @@protoc_insertion_point(field_set:fbt_format.StageTrace.DeltaStatistic.percentiles)
+}
+inline void StageTrace_DeltaStatistic::add_percentiles(double value) {
+  percentiles_.Add(value);
+  // @@protoc_insertion_point(field_add:fbt_format.StageTrace.DeltaStatistic.percentiles)
+}
+inline const ::google::protobuf::RepeatedField< double >&
+StageTrace_DeltaStatistic::percentiles() const {
+  // @@protoc_insertion_point(field_list:fbt_format.StageTrace.DeltaStatistic.percentiles)
+  return percentiles_;
+}
+inline ::google::protobuf::RepeatedField< double >*
+StageTrace_DeltaStatistic::mutable_percentiles() {
+  // @@protoc_insertion_point(field_mutable_list:fbt_format.StageTrace.DeltaStatistic.percentiles)
+  return &percentiles_;
+}
+
+// repeated sint64 percentile_values_ns = 11 [packed = true];
+inline int StageTrace_DeltaStatistic::percentile_values_ns_size() const {
+  return percentile_values_ns_.size();
+}
+inline void StageTrace_DeltaStatistic::clear_percentile_values_ns() {
+  percentile_values_ns_.Clear();
+}
+inline ::google::protobuf::int64 StageTrace_DeltaStatistic::percentile_values_ns(int index) const {
+  // @@protoc_insertion_point(field_get:fbt_format.StageTrace.DeltaStatistic.percentile_values_ns)
+  return percentile_values_ns_.Get(index);
+}
+inline void StageTrace_DeltaStatistic::set_percentile_values_ns(int index, ::google::protobuf::int64 value) {
+  percentile_values_ns_.Set(index, value);
+  // @@protoc_insertion_point(field_set:fbt_format.StageTrace.DeltaStatistic.percentile_values_ns)
+}
+inline void StageTrace_DeltaStatistic::add_percentile_values_ns(::google::protobuf::int64 value) {
+  percentile_values_ns_.Add(value);
+  // @@protoc_insertion_point(field_add:fbt_format.StageTrace.DeltaStatistic.percentile_values_ns)
+}
+inline const ::google::protobuf::RepeatedField< ::google::protobuf::int64 >&
+StageTrace_DeltaStatistic::percentile_values_ns() const {
+  // @@protoc_insertion_point(field_list:fbt_format.StageTrace.DeltaStatistic.percentile_values_ns)
+  return percentile_values_ns_;
+}
+inline ::google::protobuf::RepeatedField< ::google::protobuf::int64 >*
+StageTrace_DeltaStatistic::mutable_percentile_values_ns() {
+  // @@protoc_insertion_point(field_mutable_list:fbt_format.StageTrace.DeltaStatistic.percentile_values_ns)
+  return &percentile_values_ns_;
+}
+
+// optional uint32 histogram_significant_digits = 12;
+inline bool StageTrace_DeltaStatistic::has_histogram_significant_digits() const {
+  return (_has_bits_[0] & 0x00000800u) != 0;
+}
+inline void StageTrace_DeltaStatistic::set_has_histogram_significant_digits() {
+  _has_bits_[0] |= 0x00000800u;
+}
+inline void StageTrace_DeltaStatistic::clear_has_histogram_significant_digits() {
+  _has_bits_[0] &= ~0x00000800u;
+}
+inline void StageTrace_DeltaStatistic::clear_histogram_significant_digits() {
+  histogram_significant_digits_ = 0u;
+  clear_has_histogram_significant_digits();
+}
+inline ::google::protobuf::uint32 StageTrace_DeltaStatistic::histogram_significant_digits() const {
+  // @@protoc_insertion_point(field_get:fbt_format.StageTrace.DeltaStatistic.histogram_significant_digits)
+  return histogram_significant_digits_;
+}
+inline void StageTrace_DeltaStatistic::set_histogram_significant_digits(::google::protobuf::uint32 value) {
+  set_has_histogram_significant_digits();
+  histogram_significant_digits_ = value;
+  // @@protoc_insertion_point(field_set:fbt_format.StageTrace.DeltaStatistic.histogram_significant_digits)
+}
+
+// optional sint64 histogram_highest_trackable_ns = 13;
+inline bool StageTrace_DeltaStatistic::has_histogram_highest_trackable_ns() const {
+  return (_has_bits_[0] & 0x00001000u) != 0;
+}
+inline void StageTrace_DeltaStatistic::set_has_histogram_highest_trackable_ns() {
+  _has_bits_[0] |= 0x00001000u;
+}
+inline void StageTrace_DeltaStatistic::clear_has_histogram_highest_trackable_ns() {
+  _has_bits_[0] &= ~0x00001000u;
+}
+inline void StageTrace_DeltaStatistic::clear_histogram_highest_trackable_ns() {
+  histogram_highest_trackable_ns_ = GOOGLE_LONGLONG(0);
+  clear_has_histogram_highest_trackable_ns();
+}
+inline ::google::protobuf::int64 StageTrace_DeltaStatistic::histogram_highest_trackable_ns() const {
+  // @@protoc_insertion_point(field_get:fbt_format.StageTrace.DeltaStatistic.histogram_highest_trackable_ns)
+  return histogram_highest_trackable_ns_;
+}
+inline void StageTrace_DeltaStatistic::set_histogram_highest_trackable_ns(::google::protobuf::int64 value) {
+  set_has_histogram_highest_trackable_ns();
+  histogram_highest_trackable_ns_ = value;
+  // @@protoc_insertion_point(field_set:fbt_format.StageTrace.DeltaStatistic.histogram_highest_trackable_ns)
+}
+
+// repeated uint32 histogram_indices = 14 [packed = true];
+inline int StageTrace_DeltaStatistic::histogram_indices_size() const {
+  return histogram_indices_.size();
+}
+inline void StageTrace_DeltaStatistic::clear_histogram_indices() {
+  histogram_indices_.Clear();
+}
+inline ::google::protobuf::uint32 StageTrace_DeltaStatistic::histogram_indices(int index) const {
+  // @@protoc_insertion_point(field_get:fbt_format.StageTrace.DeltaStatistic.histogram_indices)
+  return histogram_indices_.Get(index);
+}
+inline void StageTrace_DeltaStatistic::set_histogram_indices(int index, ::google::protobuf::uint32 value) {
+  histogram_indices_.Set(index, value);
+  // @@protoc_insertion_point(field_set:fbt_format.StageTrace.DeltaStatistic.histogram_indices)
+}
+inline void StageTrace_DeltaStatistic::add_histogram_indices(::google::protobuf::uint32 value) {
+  histogram_indices_.Add(value);
+  // @@protoc_insertion_point(field_add:fbt_format.StageTrace.DeltaStatistic.histogram_indices)
+}
+inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >&
+StageTrace_DeltaStatistic::histogram_indices() const {
+  // @@protoc_insertion_point(field_list:fbt_format.StageTrace.DeltaStatistic.histogram_indices)
+  return histogram_indices_;
+}
+inline ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >*
+StageTrace_DeltaStatistic::mutable_histogram_indices() {
+  // @@protoc_insertion_point(field_mutable_list:fbt_format.StageTrace.DeltaStatistic.histogram_indices)
+  return &histogram_indices_;
+}
+
+// repeated uint64 histogram_counts = 15 [packed = true];
+inline int StageTrace_DeltaStatistic::histogram_counts_size() const {
+  return histogram_counts_.size();
+}
+inline void StageTrace_DeltaStatistic::clear_histogram_counts() {
+  histogram_counts_.Clear();
+}
+inline ::google::protobuf::uint64 StageTrace_DeltaStatistic::histogram_counts(int index) const {
+  // @@protoc_insertion_point(field_get:fbt_format.StageTrace.DeltaStatistic.histogram_counts)
+  return histogram_counts_.Get(index);
+}
+inline void StageTrace_DeltaStatistic::set_histogram_counts(int index, ::google::protobuf::uint64 value) {
+  histogram_counts_.Set(index, value);
+  // @@protoc_insertion_point(field_set:fbt_format.StageTrace.DeltaStatistic.histogram_counts)
+}
+inline void StageTrace_DeltaStatistic::add_histogram_counts(::google::protobuf::uint64 value) {
+  histogram_counts_.Add(value);
+  // @@protoc_insertion_point(field_add:fbt_format.StageTrace.DeltaStatistic.histogram_counts)
+}
+inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint64 >&
+StageTrace_DeltaStatistic::histogram_counts() const {
+  // @@protoc_insertion_point(field_list:fbt_format.StageTrace.DeltaStatistic.histogram_counts)
+  return histogram_counts_;
+}
+inline ::google::protobuf::RepeatedField< ::google::protobuf::uint64 >*
+StageTrace_DeltaStatistic::mutable_histogram_counts() {
+  // @@protoc_insertion_point(field_mutable_list:fbt_format.StageTrace.DeltaStatistic.histogram_counts)
+  return &histogram_counts_;
+}
+
 // -------------------------------------------------------------------
 
 // StageTrace_EventTrace
@@ -1376,6 +1812,36 @@ StageTrace_EventTrace::mutable_trace_times_ns() {
   // @@protoc_insertion_point(field_mutable_list:fbt_format.StageTrace.EventTrace.trace_times_ns)
   return &trace_times_ns_;
 }
+// repeated uint32 trace_ids = 3 [packed = true];
+inline int StageTrace_EventTrace::trace_ids_size() const {
+  return trace_ids_.size();
+}
+inline void StageTrace_EventTrace::clear_trace_ids() {
+  trace_ids_.Clear();
+}
+inline ::google::protobuf::uint32 StageTrace_EventTrace::trace_ids(int index) const {
+  // @@protoc_insertion_point(field_get:fbt_format.StageTrace.EventTrace.trace_ids)
+  return trace_ids_.Get(index);
+}
+inline void StageTrace_EventTrace::set_trace_ids(int index, ::google::protobuf::uint32 value) {
+  trace_ids_.Set(index, value);
+  // @@protoc_insertion_point(field_set:fbt_format.StageTrace.EventTrace.trace_ids)
+}
+inline void StageTrace_EventTrace::add_trace_ids(::google::protobuf::uint32 value) {
+  trace_ids_.Add(value);
+  // @@protoc_insertion_point(field_add:fbt_format.StageTrace.EventTrace.trace_ids)
+}
+inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >&
+StageTrace_EventTrace::trace_ids() const {
+  // @@protoc_insertion_point(field_list:fbt_format.StageTrace.EventTrace.trace_ids)
+  return trace_ids_;
+}
+inline ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >*
+StageTrace_EventTrace::mutable_trace_ids() {
+  // @@protoc_insertion_point(field_mutable_list:fbt_format.StageTrace.EventTrace.trace_ids)
+  return &trace_ids_;
+}
+
 
 // -------------------------------------------------------------------
 
@@ -1781,6 +2247,260 @@ inline void OpenGLInfo::set_allocated_version(::std::string* version) {
 
 // -------------------------------------------------------------------
 
+// QueueTrace
+
+// required string name = 1;
+inline bool QueueTrace::has_name() const {
+  return (_has_bits_[0] & 0x00000001u) != 0;
+}
+inline void QueueTrace::set_has_name() {
+  _has_bits_[0] |= 0x00000001u;
+}
+inline void QueueTrace::clear_has_name() {
+  _has_bits_[0] &= ~0x00000001u;
+}
+inline void QueueTrace::clear_name() {
+  if (name_ != &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    name_->clear();
+  }
+  clear_has_name();
+}
+inline const ::std::string& QueueTrace::name() const {
+  // @@protoc_insertion_point(field_get:fbt_format.QueueTrace.name)
+  return *name_;
+}
+inline void QueueTrace::set_name(const ::std::string& value) {
+  set_has_name();
+  if (name_ == &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    name_ = new ::std::string;
+  }
+  name_->assign(value);
+  // @@protoc_insertion_point(field_set:fbt_format.QueueTrace.name)
+}
+inline void QueueTrace::set_name(const char* value) {
+  set_has_name();
+  if (name_ == &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    name_ = new ::std::string;
+  }
+  name_->assign(value);
+  // @@protoc_insertion_point(field_set_char:fbt_format.QueueTrace.name)
+}
+inline void QueueTrace::set_name(const char* value, size_t size) {
+  set_has_name();
+  if (name_ == &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    name_ = new ::std::string;
+  }
+  name_->assign(reinterpret_cast<const char*>(value), size);
+  // @@protoc_insertion_point(field_set_pointer:fbt_format.QueueTrace.name)
+}
+inline ::std::string* QueueTrace::mutable_name() {
+  set_has_name();
+  if (name_ == &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    name_ = new ::std::string;
+  }
+  // @@protoc_insertion_point(field_mutable:fbt_format.QueueTrace.name)
+  return name_;
+}
+inline ::std::string* QueueTrace::release_name() {
+  clear_has_name();
+  if (name_ == &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    return NULL;
+  } else {
+    ::std::string* temp = name_;
+    name_ = const_cast< ::std::string*>(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+    return temp;
+  }
+}
+inline void QueueTrace::set_allocated_name(::std::string* name) {
+  if (name_ != &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+    delete name_;
+  }
+  if (name) {
+    set_has_name();
+    name_ = name;
+  } else {
+    clear_has_name();
+    name_ = const_cast< ::std::string*>(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  }
+  // @@protoc_insertion_point(field_set_allocated:fbt_format.QueueTrace.name)
+}
+
+// required uint32 capacity = 2;
+inline bool QueueTrace::has_capacity() const {
+  return (_has_bits_[0] & 0x00000002u) != 0;
+}
+inline void QueueTrace::set_has_capacity() {
+  _has_bits_[0] |= 0x00000002u;
+}
+inline void QueueTrace::clear_has_capacity() {
+  _has_bits_[0] &= ~0x00000002u;
+}
+inline void QueueTrace::clear_capacity() {
+  capacity_ = 0u;
+  clear_has_capacity();
+}
+inline ::google::protobuf::uint32 QueueTrace::capacity() const {
+  // @@protoc_insertion_point(field_get:fbt_format.QueueTrace.capacity)
+  return capacity_;
+}
+inline void QueueTrace::set_capacity(::google::protobuf::uint32 value) {
+  set_has_capacity();
+  capacity_ = value;
+  // @@protoc_insertion_point(field_set:fbt_format.QueueTrace.capacity)
+}
+
+// repeated sint64 push_times_ns = 3 [packed = true];
+inline int QueueTrace::push_times_ns_size() const {
+  return push_times_ns_.size();
+}
+inline void QueueTrace::clear_push_times_ns() {
+  push_times_ns_.Clear();
+}
+inline ::google::protobuf::int64 QueueTrace::push_times_ns(int index) const {
+  // @@protoc_insertion_point(field_get:fbt_format.QueueTrace.push_times_ns)
+  return push_times_ns_.Get(index);
+}
+inline void QueueTrace::set_push_times_ns(int index, ::google::protobuf::int64 value) {
+  push_times_ns_.Set(index, value);
+  // @@protoc_insertion_point(field_set:fbt_format.QueueTrace.push_times_ns)
+}
+inline void QueueTrace::add_push_times_ns(::google::protobuf::int64 value) {
+  push_times_ns_.Add(value);
+  // @@protoc_insertion_point(field_add:fbt_format.QueueTrace.push_times_ns)
+}
+inline const ::google::protobuf::RepeatedField< ::google::protobuf::int64 >&
+QueueTrace::push_times_ns() const {
+  // @@protoc_insertion_point(field_list:fbt_format.QueueTrace.push_times_ns)
+  return push_times_ns_;
+}
+inline ::google::protobuf::RepeatedField< ::google::protobuf::int64 >*
+QueueTrace::mutable_push_times_ns() {
+  // @@protoc_insertion_point(field_mutable_list:fbt_format.QueueTrace.push_times_ns)
+  return &push_times_ns_;
+}
+
+// repeated uint32 push_occupancy = 4 [packed = true];
+inline int QueueTrace::push_occupancy_size() const {
+  return push_occupancy_.size();
+}
+inline void QueueTrace::clear_push_occupancy() {
+  push_occupancy_.Clear();
+}
+inline ::google::protobuf::uint32 QueueTrace::push_occupancy(int index) const {
+  // @@protoc_insertion_point(field_get:fbt_format.QueueTrace.push_occupancy)
+  return push_occupancy_.Get(index);
+}
+inline void QueueTrace::set_push_occupancy(int index, ::google::protobuf::uint32 value) {
+  push_occupancy_.Set(index, value);
+  // @@protoc_insertion_point(field_set:fbt_format.QueueTrace.push_occupancy)
+}
+inline void QueueTrace::add_push_occupancy(::google::protobuf::uint32 value) {
+  push_occupancy_.Add(value);
+  // @@protoc_insertion_point(field_add:fbt_format.QueueTrace.push_occupancy)
+}
+inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >&
+QueueTrace::push_occupancy() const {
+  // @@protoc_insertion_point(field_list:fbt_format.QueueTrace.push_occupancy)
+  return push_occupancy_;
+}
+inline ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >*
+QueueTrace::mutable_push_occupancy() {
+  // @@protoc_insertion_point(field_mutable_list:fbt_format.QueueTrace.push_occupancy)
+  return &push_occupancy_;
+}
+
+// repeated sint64 pop_times_ns = 5 [packed = true];
+inline int QueueTrace::pop_times_ns_size() const {
+  return pop_times_ns_.size();
+}
+inline void QueueTrace::clear_pop_times_ns() {
+  pop_times_ns_.Clear();
+}
+inline ::google::protobuf::int64 QueueTrace::pop_times_ns(int index) const {
+  // @@protoc_insertion_point(field_get:fbt_format.QueueTrace.pop_times_ns)
+  return pop_times_ns_.Get(index);
+}
+inline void QueueTrace::set_pop_times_ns(int index, ::google::protobuf::int64 value) {
+  pop_times_ns_.Set(index, value);
+  // @@protoc_insertion_point(field_set:fbt_format.QueueTrace.pop_times_ns)
+}
+inline void QueueTrace::add_pop_times_ns(::google::protobuf::int64 value) {
+  pop_times_ns_.Add(value);
+  // @@protoc_insertion_point(field_add:fbt_format.QueueTrace.pop_times_ns)
+}
+inline const ::google::protobuf::RepeatedField< ::google::protobuf::int64 >&
+QueueTrace::pop_times_ns() const {
+  // @@protoc_insertion_point(field_list:fbt_format.QueueTrace.pop_times_ns)
+  return pop_times_ns_;
+}
+inline ::google::protobuf::RepeatedField< ::google::protobuf::int64 >*
+QueueTrace::mutable_pop_times_ns() {
+  // @@protoc_insertion_point(field_mutable_list:fbt_format.QueueTrace.pop_times_ns)
+  return &pop_times_ns_;
+}
+
+// repeated uint32 pop_occupancy = 6 [packed = true];
+inline int QueueTrace::pop_occupancy_size() const {
+  return pop_occupancy_.size();
+}
+inline void QueueTrace::clear_pop_occupancy() {
+  pop_occupancy_.Clear();
+}
+inline ::google::protobuf::uint32 QueueTrace::pop_occupancy(int index) const {
+  // @@protoc_insertion_point(field_get:fbt_format.QueueTrace.pop_occupancy)
+  return pop_occupancy_.Get(index);
+}
+inline void QueueTrace::set_pop_occupancy(int index, ::google::protobuf::uint32 value) {
+  pop_occupancy_.Set(index, value);
+  // @@protoc_insertion_point(field_set:fbt_format.QueueTrace.pop_occupancy)
+}
+inline void QueueTrace::add_pop_occupancy(::google::protobuf::uint32 value) {
+  pop_occupancy_.Add(value);
+  // @@protoc_insertion_point(field_add:fbt_format.QueueTrace.pop_occupancy)
+}
+inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >&
+QueueTrace::pop_occupancy() const {
+  // @@protoc_insertion_point(field_list:fbt_format.QueueTrace.pop_occupancy)
+  return pop_occupancy_;
+}
+inline ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >*
+QueueTrace::mutable_pop_occupancy() {
+  // @@protoc_insertion_point(field_mutable_list:fbt_format.QueueTrace.pop_occupancy)
+  return &pop_occupancy_;
+}
+
+// repeated sint64 dwell_times_ns = 7 [packed = true];
+inline int QueueTrace::dwell_times_ns_size() const {
+  return dwell_times_ns_.size();
+}
+inline void QueueTrace::clear_dwell_times_ns() {
+  dwell_times_ns_.Clear();
+}
+inline ::google::protobuf::int64 QueueTrace::dwell_times_ns(int index) const {
+  // @@protoc_insertion_point(field_get:fbt_format.QueueTrace.dwell_times_ns)
+  return dwell_times_ns_.Get(index);
+}
+inline void QueueTrace::set_dwell_times_ns(int index, ::google::protobuf::int64 value) {
+  dwell_times_ns_.Set(index, value);
+  // @@protoc_insertion_point(field_set:fbt_format.QueueTrace.dwell_times_ns)
+}
+inline void QueueTrace::add_dwell_times_ns(::google::protobuf::int64 value) {
+  dwell_times_ns_.Add(value);
+  // @@protoc_insertion_point(field_add:fbt_format.QueueTrace.dwell_times_ns)
+}
+inline const ::google::protobuf::RepeatedField< ::google::protobuf::int64 >&
+QueueTrace::dwell_times_ns() const {
+  // @@protoc_insertion_point(field_list:fbt_format.QueueTrace.dwell_times_ns)
+  return dwell_times_ns_;
+}
+inline ::google::protobuf::RepeatedField< ::google::protobuf::int64 >*
+QueueTrace::mutable_dwell_times_ns() {
+  // @@protoc_insertion_point(field_mutable_list:fbt_format.QueueTrace.dwell_times_ns)
+  return &dwell_times_ns_;
+}
+
+// -------------------------------------------------------------------
+
 // TraceSession_SessionStatistic
 
 // required uint64 number_of_frames_processed = 1;
@@ -2147,6 +2867,36 @@ inline void TraceSession::set_allocated_session_statistic(::fbt_format::TraceSes
   // @@protoc_insertion_point(field_set_allocated:fbt_format.TraceSession.session_statistic)
 }
 
+// repeated .fbt_format.QueueTrace queue_traces = 6;
+inline int TraceSession::queue_traces_size() const {
+  return queue_traces_.size();
+}
+inline void TraceSession::clear_queue_traces() {
+  queue_traces_.Clear();
+}
+inline const ::fbt_format::QueueTrace& TraceSession::queue_traces(int index) const {
+  // @@protoc_insertion_point(field_get:fbt_format.TraceSession.queue_traces)
+  return queue_traces_.Get(index);
+}
+inline ::fbt_format::QueueTrace* TraceSession::mutable_queue_traces(int index) {
+  // @@protoc_insertion_point(field_mutable:fbt_format.TraceSession.queue_traces)
+  return queue_traces_.Mutable(index);
+}
+inline ::fbt_format::QueueTrace* TraceSession::add_queue_traces() {
+  // @@protoc_insertion_point(field_add:fbt_format.TraceSession.queue_traces)
+  return queue_traces_.Add();
+}
+inline const ::google::protobuf::RepeatedPtrField< ::fbt_format::QueueTrace >&
+TraceSession::queue_traces() const {
+  // @@protoc_insertion_point(field_list:fbt_format.TraceSession.queue_traces)
+  return queue_traces_;
+}
+inline ::google::protobuf::RepeatedPtrField< ::fbt_format::QueueTrace >*
+TraceSession::mutable_queue_traces() {
+  // @@protoc_insertion_point(field_mutable_list:fbt_format.TraceSession.queue_traces)
+  return &queue_traces_;
+}
+
 
 // @@protoc_insertion_point(namespace_scope)
 
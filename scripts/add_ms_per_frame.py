@@ -2,6 +2,7 @@ import os
 import sys
 import gzip
 import fbt_format_pb2
+import fbt_session
 import math
 import shutil
 
@@ -16,11 +17,7 @@ def add_ms_per_frame(folder):
 
     if os.path.exists(trace_file):
 
-        trace_session = fbt_format_pb2.TraceSession()
-
-        input_file = gzip.GzipFile(trace_file, 'rb')
-        trace_session.ParseFromString(input_file.read())
-        input_file.close()
+        trace_session = fbt_session.read_session(trace_file)
 
         if trace_session.HasField('session_statistic'):
 
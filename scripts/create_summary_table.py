@@ -7,6 +7,7 @@ import time
 import csv
 import gzip
 import fbt_format_pb2
+import fbt_session
 
 from optparse import OptionParser
 
@@ -25,11 +26,7 @@ def collect_traces(folder):
 
     if os.path.exists(trace_file):
 
-        trace_session = fbt_format_pb2.TraceSession()
-
-        input_file = gzip.GzipFile(trace_file, 'rb')
-        trace_session.ParseFromString(input_file.read())
-        input_file.close()
+        trace_session = fbt_session.read_session(trace_file)
 
         if not trace_session.HasField('session_statistic'):
             raise RuntimeError("File did not have a session_statistics.")
@@ -18,7 +18,7 @@ _sym_db = _symbol_database.Default()
 DESCRIPTOR = _descriptor.FileDescriptor(
   name='fbt_format.proto',
   package='fbt_format',
-  serialized_pb=_b('\n\x10\x66\x62t_format.proto\x12\nfbt_format\"\xb7\x06\n\nStageTrace\x12\x0c\n\x04name\x18\x01 \x02(\t\x12\x37\n\x0c\x65vent_traces\x18\x02 \x03(\x0b\x32!.fbt_format.StageTrace.EventTrace\x12?\n\x0ename_overrides\x18\x03 \x03(\x0b\x32\'.fbt_format.StageTrace.EventNameMapping\x12?\n\x10\x64\x65lta_statistics\x18\x04 \x03(\x0b\x32%.fbt_format.StageTrace.DeltaStatistic\x1aP\n\x10\x45ventNameMapping\x12.\n\x04type\x18\x01 \x02(\x0e\x32 .fbt_format.StageTrace.EventType\x12\x0c\n\x04name\x18\x02 \x02(\t\x1a\x88\x02\n\x0e\x44\x65ltaStatistic\x12\x0c\n\x04name\x18\x01 \x02(\t\x12\x35\n\x0b\x62\x65gin_event\x18\x02 \x02(\x0e\x32 .fbt_format.StageTrace.EventType\x12\x33\n\tend_event\x18\x03 \x02(\x0e\x32 .fbt_format.StageTrace.EventType\x12\x12\n\naverage_ns\x18\x04 \x02(\x12\x12\x12\n\nminimum_ns\x18\x05 \x02(\x12\x12\x12\n\nmaximum_ns\x18\x06 \x02(\x12\x12\x18\n\x10std_deviation_ns\x18\x07 \x02(\x12\x12\x11\n\tmedian_ns\x18\x08 \x02(\x12\x12\x13\n\x0bnum_samples\x18\t \x02(\x04\x1aX\n\nEventTrace\x12.\n\x04type\x18\x01 \x02(\x0e\x32 .fbt_format.StageTrace.EventType\x12\x1a\n\x0etrace_times_ns\x18\x02 \x03(\x12\x42\x02\x10\x01\"\xa8\x01\n\tEventType\x12\x11\n\rEXECUTE_BEGIN\x10\x01\x12\x19\n\x15INPUT_TOKEN_AVAILABLE\x10\x02\x12\x1a\n\x16OUTPUT_TOKEN_AVAILABLE\x10\x03\x12\x0e\n\nTASK_BEGIN\x10\x04\x12\x0c\n\x08TASK_END\x10\x05\x12\x0f\n\x0b\x45XECUTE_END\x10\x06\x12\x11\n\rGL_TASK_BEGIN\x10\x07\x12\x0f\n\x0bGL_TASK_END\x10\x08\"?\n\nOpenGLInfo\x12\x0e\n\x06vendor\x18\x01 \x02(\t\x12\x10\n\x08renderer\x18\x02 \x02(\t\x12\x0f\n\x07version\x18\x03 \x02(\t\"\xfe\x02\n\x0cTraceSession\x12\x0c\n\x04name\x18\x01 \x02(\t\x12+\n\x0bopengl_info\x18\x02 \x02(\x0b\x32\x16.fbt_format.OpenGLInfo\x12\x12\n\nlocal_time\x18\x03 \x02(\t\x12,\n\x0cstage_traces\x18\x04 \x03(\x0b\x32\x16.fbt_format.StageTrace\x12\x44\n\x11session_statistic\x18\x05 \x01(\x0b\x32).fbt_format.TraceSession.SessionStatistic\x1a\xaa\x01\n\x10SessionStatistic\x12\"\n\x1anumber_of_frames_processed\x18\x01 \x02(\x04\x12!\n\x19\x61vg_throughput_mb_per_sec\x18\x02 \x02(\x02\x12.\n&med_frame_processing_time_per_frame_ns\x18\x03 \x02(\x12\x12\x1f\n\x17\x61vg_millisecs_per_frame\x18\x04 \x01(\x02')
+  serialized_pb=_b('\n\x10\x66\x62t_format.proto\x12\nfbt_format\"\x94\x08\n\nStageTrace\x12\x0c\n\x04name\x18\x01 \x02(\t\x12\x37\n\x0c\x65vent_traces\x18\x02 \x03(\x0b\x32!.fbt_format.StageTrace.EventTrace\x12?\n\x0ename_overrides\x18\x03 \x03(\x0b\x32\'.fbt_format.StageTrace.EventNameMapping\x12?\n\x10\x64\x65lta_statistics\x18\x04 \x03(\x0b\x32%.fbt_format.StageTrace.DeltaStatistic\x1aP\n\x10\x45ventNameMapping\x12.\n\x04type\x18\x01 \x02(\x0e\x32 .fbt_format.StageTrace.EventType\x12\x0c\n\x04name\x18\x02 \x02(\t\x1a\xce\x03\n\x0e\x44\x65ltaStatistic\x12\x0c\n\x04name\x18\x01 \x02(\t\x12\x35\n\x0b\x62\x65gin_event\x18\x02 \x02(\x0e\x32 .fbt_format.StageTrace.EventType\x12\x33\n\tend_event\x18\x03 \x02(\x0e\x32 .fbt_format.StageTrace.EventType\x12\x12\n\naverage_ns\x18\x04 \x02(\x12\x12\x12\n\nminimum_ns\x18\x05 \x02(\x12\x12\x12\n\nmaximum_ns\x18\x06 \x02(\x12\x12\x18\n\x10std_deviation_ns\x18\x07 \x02(\x12\x12\x11\n\tmedian_ns\x18\x08 \x02(\x12\x12\x13\n\x0bnum_samples\x18\t \x02(\x04\x12\x17\n\x0bpercentiles\x18\n \x03(\x01\x42\x02\x10\x01\x12 \n\x14percentile_values_ns\x18\x0b \x03(\x12\x42\x02\x10\x01\x12$\n\x1chistogram_significant_digits\x18\x0c \x01(\r\x12&\n\x1ehistogram_highest_trackable_ns\x18\r \x01(\x12\x12\x1d\n\x11histogram_indices\x18\x0e \x03(\rB\x02\x10\x01\x12\x1c\n\x10histogram_counts\x18\x0f \x03(\x04\x42\x02\x10\x01\x1ao\n\nEventTrace\x12.\n\x04type\x18\x01 \x02(\x0e\x32 .fbt_format.StageTrace.EventType\x12\x1a\n\x0etrace_times_ns\x18\x02 \x03(\x12\x42\x02\x10\x01\x12\x15\n\ttrace_ids\x18\x03 \x03(\rB\x02\x10\x01\"\xa8\x01\n\tEventType\x12\x11\n\rEXECUTE_BEGIN\x10\x01\x12\x19\n\x15INPUT_TOKEN_AVAILABLE\x10\x02\x12\x1a\n\x16OUTPUT_TOKEN_AVAILABLE\x10\x03\x12\x0e\n\nTASK_BEGIN\x10\x04\x12\x0c\n\x08TASK_END\x10\x05\x12\x0f\n\x0b\x45XECUTE_END\x10\x06\x12\x11\n\rGL_TASK_BEGIN\x10\x07\x12\x0f\n\x0bGL_TASK_END\x10\x08\"?\n\nOpenGLInfo\x12\x0e\n\x06vendor\x18\x01 \x02(\t\x12\x10\n\x08renderer\x18\x02 \x02(\t\x12\x0f\n\x07version\x18\x03 \x02(\t\"\xb4\x01\n\nQueueTrace\x12\x0c\n\x04name\x18\x01 \x02(\t\x12\x10\n\x08\x63\x61pacity\x18\x02 \x02(\r\x12\x19\n\rpush_times_ns\x18\x03 \x03(\x12\x42\x02\x10\x01\x12\x1a\n\x0epush_occupancy\x18\x04 \x03(\rB\x02\x10\x01\x12\x18\n\x0cpop_times_ns\x18\x05 \x03(\x12\x42\x02\x10\x01\x12\x19\n\rpop_occupancy\x18\x06 \x03(\rB\x02\x10\x01\x12\x1a\n\x0e\x64well_times_ns\x18\x07 \x03(\x12\x42\x02\x10\x01\"\xac\x03\n\x0cTraceSession\x12\x0c\n\x04name\x18\x01 \x02(\t\x12+\n\x0bopengl_info\x18\x02 \x02(\x0b\x32\x16.fbt_format.OpenGLInfo\x12\x12\n\nlocal_time\x18\x03 \x02(\t\x12,\n\x0cstage_traces\x18\x04 \x03(\x0b\x32\x16.fbt_format.StageTrace\x12\x44\n\x11session_statistic\x18\x05 \x01(\x0b\x32).fbt_format.TraceSession.SessionStatistic\x12,\n\x0cqueue_traces\x18\x06 \x03(\x0b\x32\x16.fbt_format.QueueTrace\x1a\xaa\x01\n\x10SessionStatistic\x12\"\n\x1anumber_of_frames_processed\x18\x01 \x02(\x04\x12!\n\x19\x61vg_throughput_mb_per_sec\x18\x02 \x02(\x02\x12.\n&med_frame_processing_time_per_frame_ns\x18\x03 \x02(\x12\x12\x1f\n\x17\x61vg_millisecs_per_frame\x18\x04 \x01(\x02')
 )
 _sym_db.RegisterFileDescriptor(DESCRIPTOR)
 
@@ -65,8 +65,8 @@ _STAGETRACE_EVENTTYPE = _descriptor.EnumDescriptor(
   ],
   containing_type=None,
   options=None,
-  serialized_start=688,
-  serialized_end=856,
+  serialized_start=909,
+  serialized_end=1077,
 )
 _sym_db.RegisterEnumDescriptor(_STAGETRACE_EVENTTYPE)
 
@@ -177,6 +177,48 @@ _STAGETRACE_DELTASTATISTIC = _descriptor.Descriptor(
       message_type=None, enum_type=None, containing_type=None,
       is_extension=False, extension_scope=None,
       options=None),
+    _descriptor.FieldDescriptor(
+      name='percentiles', full_name='fbt_format.StageTrace.DeltaStatistic.percentiles', index=9,
+      number=10, type=1, cpp_type=5, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=_descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))),
+    _descriptor.FieldDescriptor(
+      name='percentile_values_ns', full_name='fbt_format.StageTrace.DeltaStatistic.percentile_values_ns', index=10,
+      number=11, type=18, cpp_type=2, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=_descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))),
+    _descriptor.FieldDescriptor(
+      name='histogram_significant_digits', full_name='fbt_format.StageTrace.DeltaStatistic.histogram_significant_digits', index=11,
+      number=12, type=13, cpp_type=3, label=1,
+      has_default_value=False, default_value=0,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=None),
+    _descriptor.FieldDescriptor(
+      name='histogram_highest_trackable_ns', full_name='fbt_format.StageTrace.DeltaStatistic.histogram_highest_trackable_ns', index=12,
+      number=13, type=18, cpp_type=2, label=1,
+      has_default_value=False, default_value=0,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=None),
+    _descriptor.FieldDescriptor(
+      name='histogram_indices', full_name='fbt_format.StageTrace.DeltaStatistic.histogram_indices', index=13,
+      number=14, type=13, cpp_type=3, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=_descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))),
+    _descriptor.FieldDescriptor(
+      name='histogram_counts', full_name='fbt_format.StageTrace.DeltaStatistic.histogram_counts', index=14,
+      number=15, type=4, cpp_type=4, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=_descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))),
   ],
   extensions=[
   ],
@@ -189,7 +231,7 @@ _STAGETRACE_DELTASTATISTIC = _descriptor.Descriptor(
   oneofs=[
   ],
   serialized_start=331,
-  serialized_end=595,
+  serialized_end=793,
 )
 
 _STAGETRACE_EVENTTRACE = _descriptor.Descriptor(
@@ -213,6 +255,13 @@ _STAGETRACE_EVENTTRACE = _descriptor.Descriptor(
       message_type=None, enum_type=None, containing_type=None,
       is_extension=False, extension_scope=None,
       options=_descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))),
+    _descriptor.FieldDescriptor(
+      name='trace_ids', full_name='fbt_format.StageTrace.EventTrace.trace_ids', index=2,
+      number=3, type=13, cpp_type=3, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=_descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))),
   ],
   extensions=[
   ],
@@ -224,8 +273,8 @@ _STAGETRACE_EVENTTRACE = _descriptor.Descriptor(
   extension_ranges=[],
   oneofs=[
   ],
-  serialized_start=597,
-  serialized_end=685,
+  serialized_start=795,
+  serialized_end=906,
 )
 
 _STAGETRACE = _descriptor.Descriptor(
@@ -276,7 +325,7 @@ _STAGETRACE = _descriptor.Descriptor(
   oneofs=[
   ],
   serialized_start=33,
-  serialized_end=856,
+  serialized_end=1077,
 )
 
 
@@ -319,8 +368,80 @@ _OPENGLINFO = _descriptor.Descriptor(
   extension_ranges=[],
   oneofs=[
   ],
-  serialized_start=858,
-  serialized_end=921,
+  serialized_start=1079,
+  serialized_end=1142,
+)
+
+
+_QUEUETRACE = _descriptor.Descriptor(
+  name='QueueTrace',
+  full_name='fbt_format.QueueTrace',
+  filename=None,
+  file=DESCRIPTOR,
+  containing_type=None,
+  fields=[
+    _descriptor.FieldDescriptor(
+      name='name', full_name='fbt_format.QueueTrace.name', index=0,
+      number=1, type=9, cpp_type=9, label=2,
+      has_default_value=False, default_value=_b("").decode('utf-8'),
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=None),
+    _descriptor.FieldDescriptor(
+      name='capacity', full_name='fbt_format.QueueTrace.capacity', index=1,
+      number=2, type=13, cpp_type=3, label=2,
+      has_default_value=False, default_value=0,
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=None),
+    _descriptor.FieldDescriptor(
+      name='push_times_ns', full_name='fbt_format.QueueTrace.push_times_ns', index=2,
+      number=3, type=18, cpp_type=2, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=_descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))),
+    _descriptor.FieldDescriptor(
+      name='push_occupancy', full_name='fbt_format.QueueTrace.push_occupancy', index=3,
+      number=4, type=13, cpp_type=3, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=_descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))),
+    _descriptor.FieldDescriptor(
+      name='pop_times_ns', full_name='fbt_format.QueueTrace.pop_times_ns', index=4,
+      number=5, type=18, cpp_type=2, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=_descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))),
+    _descriptor.FieldDescriptor(
+      name='pop_occupancy', full_name='fbt_format.QueueTrace.pop_occupancy', index=5,
+      number=6, type=13, cpp_type=3, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=_descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))),
+    _descriptor.FieldDescriptor(
+      name='dwell_times_ns', full_name='fbt_format.QueueTrace.dwell_times_ns', index=6,
+      number=7, type=18, cpp_type=2, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=_descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))),
+  ],
+  extensions=[
+  ],
+  nested_types=[],
+  enum_types=[
+  ],
+  options=None,
+  is_extendable=False,
+  extension_ranges=[],
+  oneofs=[
+  ],
+  serialized_start=1145,
+  serialized_end=1325,
 )
 
 
@@ -370,8 +491,8 @@ _TRACESESSION_SESSIONSTATISTIC = _descriptor.Descriptor(
   extension_ranges=[],
   oneofs=[
   ],
-  serialized_start=1136,
-  serialized_end=1306,
+  serialized_start=1586,
+  serialized_end=1756,
 )
 
 _TRACESESSION = _descriptor.Descriptor(
@@ -416,6 +537,13 @@ _TRACESESSION = _descriptor.Descriptor(
       message_type=None, enum_type=None, containing_type=None,
       is_extension=False, extension_scope=None,
       options=None),
+    _descriptor.FieldDescriptor(
+      name='queue_traces', full_name='fbt_format.TraceSession.queue_traces', index=5,
+      number=6, type=11, cpp_type=10, label=3,
+      has_default_value=False, default_value=[],
+      message_type=None, enum_type=None, containing_type=None,
+      is_extension=False, extension_scope=None,
+      options=None),
   ],
   extensions=[
   ],
@@ -427,8 +555,8 @@ _TRACESESSION = _descriptor.Descriptor(
   extension_ranges=[],
   oneofs=[
   ],
-  serialized_start=924,
-  serialized_end=1306,
+  serialized_start=1328,
+  serialized_end=1756,
 )
 
 _STAGETRACE_EVENTNAMEMAPPING.fields_by_name['type'].enum_type = _STAGETRACE_EVENTTYPE
@@ -446,8 +574,10 @@ _TRACESESSION_SESSIONSTATISTIC.containing_type = _TRACESESSION
 _TRACESESSION.fields_by_name['opengl_info'].message_type = _OPENGLINFO
 _TRACESESSION.fields_by_name['stage_traces'].message_type = _STAGETRACE
 _TRACESESSION.fields_by_name['session_statistic'].message_type = _TRACESESSION_SESSIONSTATISTIC
+_TRACESESSION.fields_by_name['queue_traces'].message_type = _QUEUETRACE
 DESCRIPTOR.message_types_by_name['StageTrace'] = _STAGETRACE
 DESCRIPTOR.message_types_by_name['OpenGLInfo'] = _OPENGLINFO
+DESCRIPTOR.message_types_by_name['QueueTrace'] = _QUEUETRACE
 DESCRIPTOR.message_types_by_name['TraceSession'] = _TRACESESSION
 
 StageTrace = _reflection.GeneratedProtocolMessageType('StageTrace', (_message.Message,), dict(
@@ -488,6 +618,13 @@ OpenGLInfo = _reflection.GeneratedProtocolMessageType('OpenGLInfo', (_message.Me
   ))
 _sym_db.RegisterMessage(OpenGLInfo)
 
+QueueTrace = _reflection.GeneratedProtocolMessageType('QueueTrace', (_message.Message,), dict(
+  DESCRIPTOR = _QUEUETRACE,
+  __module__ = 'fbt_format_pb2'
+  # @@protoc_insertion_point(class_scope:fbt_format.QueueTrace)
+  ))
+_sym_db.RegisterMessage(QueueTrace)
+
 TraceSession = _reflection.GeneratedProtocolMessageType('TraceSession', (_message.Message,), dict(
 
   SessionStatistic = _reflection.GeneratedProtocolMessageType('SessionStatistic', (_message.Message,), dict(
@@ -504,6 +641,26 @@ _sym_db.RegisterMessage(TraceSession)
 _sym_db.RegisterMessage(TraceSession.SessionStatistic)
 
 
+_STAGETRACE_DELTASTATISTIC.fields_by_name['percentiles'].has_options = True
+_STAGETRACE_DELTASTATISTIC.fields_by_name['percentiles']._options = _descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))
+_STAGETRACE_DELTASTATISTIC.fields_by_name['percentile_values_ns'].has_options = True
+_STAGETRACE_DELTASTATISTIC.fields_by_name['percentile_values_ns']._options = _descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))
+_STAGETRACE_DELTASTATISTIC.fields_by_name['histogram_indices'].has_options = True
+_STAGETRACE_DELTASTATISTIC.fields_by_name['histogram_indices']._options = _descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))
+_STAGETRACE_DELTASTATISTIC.fields_by_name['histogram_counts'].has_options = True
+_STAGETRACE_DELTASTATISTIC.fields_by_name['histogram_counts']._options = _descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))
 _STAGETRACE_EVENTTRACE.fields_by_name['trace_times_ns'].has_options = True
 _STAGETRACE_EVENTTRACE.fields_by_name['trace_times_ns']._options = _descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))
+_STAGETRACE_EVENTTRACE.fields_by_name['trace_ids'].has_options = True
+_STAGETRACE_EVENTTRACE.fields_by_name['trace_ids']._options = _descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))
+_QUEUETRACE.fields_by_name['push_times_ns'].has_options = True
+_QUEUETRACE.fields_by_name['push_times_ns']._options = _descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))
+_QUEUETRACE.fields_by_name['push_occupancy'].has_options = True
+_QUEUETRACE.fields_by_name['push_occupancy']._options = _descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))
+_QUEUETRACE.fields_by_name['pop_times_ns'].has_options = True
+_QUEUETRACE.fields_by_name['pop_times_ns']._options = _descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))
+_QUEUETRACE.fields_by_name['pop_occupancy'].has_options = True
+_QUEUETRACE.fields_by_name['pop_occupancy']._options = _descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))
+_QUEUETRACE.fields_by_name['dwell_times_ns'].has_options = True
+_QUEUETRACE.fields_by_name['dwell_times_ns']._options = _descriptor._ParseOptions(descriptor_pb2.FieldOptions(), _b('\020\001'))
 # @@protoc_insertion_point(module_scope)
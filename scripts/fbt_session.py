@@ -0,0 +1,178 @@
+import gzip
+import fbt_format_pb2
+
+# A streamed trace (profiling.trace_streaming.is_enabled) holds the events of
+# a stage in many stage traces of the same name, in the order they were
+# written. This merges them into one stage trace per name, ordered like their
+# last occurrence, which is the one FrameBender writes when finishing.
+def merge_streamed_stage_traces(trace_session):
+
+    names = []
+    merged = {}
+
+    for stage in trace_session.stage_traces:
+
+        if stage.name in merged:
+            names.remove(stage.name)
+        else:
+            merged[stage.name] = fbt_format_pb2.StageTrace()
+            merged[stage.name].name = stage.name
+
+        names.append(stage.name)
+
+        target = merged[stage.name]
+
+        for event_trace in stage.event_traces:
+            existing = [x for x in target.event_traces if (x.type == event_trace.type)]
+            if existing:
+                # Trace IDs stay parallel to the times, unknown ones are 0
+                if existing[0].trace_ids or event_trace.trace_ids:
+                    existing[0].trace_ids.extend([0] * (len(existing[0].trace_times_ns) - len(existing[0].trace_ids)))
+                    existing[0].trace_ids.extend(event_trace.trace_ids)
+                    existing[0].trace_ids.extend([0] * (len(event_trace.trace_times_ns) - len(event_trace.trace_ids)))
+                existing[0].trace_times_ns.extend(event_trace.trace_times_ns)
+            else:
+                target.event_traces.add().CopyFrom(event_trace)
+
+        target.name_overrides.extend(stage.name_overrides)
+        target.delta_statistics.extend(stage.delta_statistics)
+
+    del trace_session.stage_traces[:]
+
+    for name in names:
+        trace_session.stage_traces.add().CopyFrom(merged[name])
+
+# The times of the given event type of a stage trace by trace ID (of the 
+# frame that the task worked on). Events of other types are related to the 
+# tasks by their order within the stage.
+def event_times_by_trace_id(stage_trace, event_type):
+
+    begin = [x for x in stage_trace.event_traces if x.type == fbt_format_pb2.StageTrace.TASK_BEGIN]
+    events = [x for x in stage_trace.event_traces if x.type == event_type]
+
+    if not begin or not events:
+        return {}
+
+    times = {}
+
+    for trace_id, time in zip(begin[0].trace_ids, events[0].trace_times_ns):
+        if trace_id != 0 and trace_id not in times:
+            times[trace_id] = time
+
+    return times
+
+# The latency of each frame from begin_event of begin_stage to end_event of 
+# end_stage (both stage traces), as a dict of trace ID to nanoseconds. Only 
+# frames that passed both stages are included.
+def frame_latencies_ns(begin_stage, begin_event, end_stage, end_event):
+
+    begin_times = event_times_by_trace_id(begin_stage, begin_event)
+    end_times = event_times_by_trace_id(end_stage, end_event)
+
+    return dict((trace_id, end_times[trace_id] - begin_times[trace_id]) for trace_id in end_times if trace_id in begin_times)
+
+# The layout of LatencyHistogram (lib/LatencyHistogram.cpp) for the given
+# precision, returns the magnitude of half the sub-bucket count.
+def histogram_sub_bucket_half_count_magnitude(significant_digits):
+
+    largest_value_with_single_unit_resolution = 2 * (10 ** significant_digits)
+
+    magnitude = 0
+    while (1 << magnitude) < largest_value_with_single_unit_resolution:
+        magnitude += 1
+
+    return max(magnitude, 1) - 1
+
+# The smallest and largest value counted at a histogram index
+def histogram_value_range_at_index(index, significant_digits):
+
+    half_magnitude = histogram_sub_bucket_half_count_magnitude(significant_digits)
+    half_count = 1 << half_magnitude
+
+    bucket_index = (index >> half_magnitude) - 1
+    sub_bucket_index = (index & (half_count - 1)) + half_count
+
+    if bucket_index < 0:
+        sub_bucket_index -= half_count
+        bucket_index = 0
+
+    lowest = sub_bucket_index << bucket_index
+    return (lowest, lowest + (1 << bucket_index) - 1)
+
+# Merges the histograms of delta statistics (e.g. the same statistic of 
+# several runs) into a dict of index to count. All of them must have the 
+# same histogram layout.
+def merge_delta_histograms(delta_statistics):
+
+    counts = {}
+    layout = None
+
+    for statistic in delta_statistics:
+
+        statistic_layout = (statistic.histogram_significant_digits, statistic.histogram_highest_trackable_ns)
+
+        if layout is None:
+            layout = statistic_layout
+        elif layout != statistic_layout:
+            raise ValueError("Can't merge histograms of different layouts: " + str(layout) + " vs. " + str(statistic_layout))
+
+        for index, count in zip(statistic.histogram_indices, statistic.histogram_counts):
+            counts[index] = counts.get(index, 0) + count
+
+    return counts
+
+# Like LatencyHistogram::value_at_percentile(), for merged histogram counts
+# (see merge_delta_histograms). percentile is in [0, 100].
+def histogram_value_at_percentile(counts, significant_digits, percentile):
+
+    total_count = sum(counts.values())
+
+    if total_count == 0:
+        return 0
+
+    percentile = min(max(percentile, 0.0), 100.0)
+    count_at_percentile = max(int(percentile / 100.0 * total_count + 0.5), 1)
+
+    count_so_far = 0
+
+    for index in sorted(counts.keys()):
+        count_so_far += counts[index]
+        if count_so_far >= count_at_percentile:
+            return histogram_value_range_at_index(index, significant_digits)[1]
+
+    return histogram_value_range_at_index(max(counts.keys()), significant_digits)[1]
+
+# Summarizes a queue trace (one pipeline edge, see FifoSampler) as a dict,
+# like FifoSampler's report. Dwell times of the initial tokens (negative)
+# are left out.
+def queue_trace_summary(queue_trace):
+
+    occupancies = list(queue_trace.push_occupancy) + list(queue_trace.pop_occupancy)
+    dwell_times_ns = [x for x in queue_trace.dwell_times_ns if x >= 0]
+
+    def average(values):
+        return float(sum(values)) / len(values) if values else 0.0
+
+    return {
+        'name' : queue_trace.name,
+        'capacity' : queue_trace.capacity,
+        'average_occupancy' : average(occupancies),
+        'full_after_push' : sum(1 for x in queue_trace.push_occupancy if x >= queue_trace.capacity),
+        'num_pushes' : len(queue_trace.push_occupancy),
+        'empty_after_pop' : sum(1 for x in queue_trace.pop_occupancy if x == 0),
+        'num_pops' : len(queue_trace.pop_occupancy),
+        'average_dwell_time_ns' : average(dwell_times_ns),
+        'maximum_dwell_time_ns' : max(dwell_times_ns) if dwell_times_ns else 0
+    }
+
+def read_session(trace_file):
+
+    trace_session = fbt_format_pb2.TraceSession()
+
+    input_file = gzip.GzipFile(trace_file, 'rb')
+    trace_session.ParseFromString(input_file.read())
+    input_file.close()
+
+    merge_streamed_stage_traces(trace_session)
+
+    return trace_session
@@ -2,6 +2,7 @@ import os
 import sys
 import gzip
 import fbt_format_pb2
+import fbt_session
 import math
 import shutil
 
@@ -54,11 +55,7 @@ if not os.path.exists(opts.input_file):
 
 trace_file = opts.input_file
 
-trace_session = fbt_format_pb2.TraceSession()
-
-input_file = gzip.GzipFile(trace_file, 'rb')
-trace_session.ParseFromString(input_file.read())
-input_file.close()
+trace_session = fbt_session.read_session(trace_file)
 
 stage_traces = trace_session.stage_traces[:]
 
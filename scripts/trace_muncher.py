@@ -2,6 +2,7 @@ import os
 import sys
 import gzip
 import fbt_format_pb2
+import fbt_session
 import cairo
 import math
 
@@ -25,13 +26,7 @@ def open_session(filepath):
     if not os.path.exists(filepath):
         raise RuntimeError("Input file " + filepath + " does not exist.")
 
-    trace_session = fbt_format_pb2.TraceSession()
-
-    input_file = gzip.GzipFile(opts.input_file, 'rb')
-    trace_session.ParseFromString(input_file.read())
-    input_file.close()
-
-    return trace_session
+    return fbt_session.read_session(filepath)
 
 def inch_to_mm(inch):
     return inch*25.4
@@ -21,27 +21,229 @@
  */
 #include <iostream>
 #include <regex>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/program_options.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/align/aligned_alloc.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FB_CONVERT_YUV10_USE_SSE2 1
+#include <emmintrin.h>
+#endif
 
 namespace bf = boost::filesystem;
+namespace po = boost::program_options;
+namespace bi = boost::interprocess;
+
+namespace {
+
+    // Size of the buffer used for writing, also the amount of input 
+    // converted at once.
+    const size_t kChunkSize = 4 * 1024 * 1024;
+    const size_t kChunkAlignment = 4096;
+
+    // Need to convert from YUV10 -> V210
+    // The following shows the layout in increasing
+    // memory addresses
+    // Sources: 
+    // https://developer.apple.com/quicktime/icefloe/dispatch019.html#v210
+    // and
+    // http://www.dvs.de/fileadmin/downloads/products/videosystems/clipster/extraweb/support/documentation/archive/software/clipster_edit_ug_v2_4.pdf
+    // and
+    // http://www.tribler.org/trac/wiki/FfmpegYuv
+
+    // |               YUV10               |
+    // | BYTE_0 | BYTE_1 | BYTE_2 | BYTE_3 |
+    // |98765432|10987654|32109876|543210XX|
+    // |    Cb    |    Y'    |    Cr    |XX|
+    //
+    // |               V210                |
+    // | BYTE_0 | BYTE_1 | BYTE_2 | BYTE_3 |
+    // |76543210|54321098|32109876|XX987654|
+    // |   Cb   | Y'  |Cb| Cr|  Y'|XX| Cr  |
+    //
+    // I.e. YUV10 is a big-endian word with the components from the top, V210 
+    // a little-endian word with the components from the bottom.
+
+    inline uint32_t repack_word(const uint8_t* src) {
+
+        const uint32_t w = 
+            (static_cast<uint32_t>(src[0]) << 24) |
+            (static_cast<uint32_t>(src[1]) << 16) |
+            (static_cast<uint32_t>(src[2]) << 8) |
+            static_cast<uint32_t>(src[3]);
+
+        return (w >> 22) | (((w >> 12) & 0x3FF) << 10) | (((w >> 2) & 0x3FF) << 20);
+
+    }
+
+    void repack_words(const uint8_t* src, uint8_t* dst, size_t num_words) {
+
+        size_t i = 0;
+
+#if defined(FB_CONVERT_YUV10_USE_SSE2)
+
+        const __m128i byte_mask = _mm_set1_epi32(0x00FF00FF);
+        const __m128i mask = _mm_set1_epi32(0x3FF);
+
+        for (; i + 4 <= num_words; i += 4) {
+
+            __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i*4));
+
+            // Byte swap, SSE2 has no byte shuffle
+            w = _mm_or_si128(
+                _mm_and_si128(_mm_srli_epi16(w, 8), byte_mask), 
+                _mm_andnot_si128(byte_mask, _mm_slli_epi16(w, 8)));
+            w = _mm_or_si128(_mm_srli_epi32(w, 16), _mm_slli_epi32(w, 16));
+
+            const __m128i c0 = _mm_srli_epi32(w, 22);
+            const __m128i c1 = _mm_and_si128(_mm_srli_epi32(w, 12), mask);
+            const __m128i c2 = _mm_and_si128(_mm_srli_epi32(w, 2), mask);
+
+            const __m128i v210 = _mm_or_si128(
+                c0, 
+                _mm_or_si128(_mm_slli_epi32(c1, 10), _mm_slli_epi32(c2, 20)));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i*4), v210);
+
+        }
+
+#endif
+
+        for (; i < num_words; ++i) {
+            const uint32_t v210 = repack_word(src + i*4);
+            // V210 is little-endian, as is the host
+            std::memcpy(dst + i*4, &v210, 4);
+        }
+
+    }
+
+    typedef std::unique_ptr<uint8_t, decltype(&boost::alignment::aligned_free)> AlignedBuffer;
+
+    AlignedBuffer make_buffer() {
+
+        AlignedBuffer buffer(
+            static_cast<uint8_t*>(boost::alignment::aligned_alloc(kChunkAlignment, kChunkSize)),
+            &boost::alignment::aligned_free);
+
+        if (!buffer)
+            throw std::bad_alloc();
+
+        return buffer;
+    }
+
+    // Returns the number of bytes written
+    uintmax_t convert_file(
+        const bf::path& in_path, 
+        const bf::path& out_path, 
+        uint8_t* buffer) 
+    {
+
+        const uintmax_t file_size = bf::file_size(in_path);
+
+        if (file_size % 4 != 0) {
+            throw std::runtime_error(
+                "Size of '" + in_path.string() + "' is not a multiple of 4 bytes.");
+        }
+
+        bf::ofstream frame_writer;
+
+        // No need for the stream's own buffering, we always write large 
+        // chunks.
+        frame_writer.rdbuf()->pubsetbuf(nullptr, 0);
+        frame_writer.open(out_path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if (!frame_writer.good())
+            throw std::runtime_error("Can't open '" + out_path.string() + "' for writing.");
+
+        if (file_size == 0)
+            return 0;
+
+        bi::file_mapping mapping(in_path.string().c_str(), bi::read_only);
+        bi::mapped_region region(mapping, bi::read_only);
+
+#if !defined(_WIN32)
+        region.advise(bi::mapped_region::advice_sequential);
+#endif
+
+        const uint8_t* src = static_cast<const uint8_t*>(region.get_address());
+
+        for (uintmax_t offset = 0; offset < file_size; offset += kChunkSize) {
+
+            const size_t chunk_size = static_cast<size_t>(
+                std::min<uintmax_t>(kChunkSize, file_size - offset));
+
+            repack_words(src + offset, buffer, chunk_size / 4);
+
+            frame_writer.write(reinterpret_cast<const char*>(buffer), chunk_size);
+
+            if (!frame_writer.good())
+                throw std::runtime_error("Writing '" + out_path.string() + "' failed.");
+
+        }
+
+        return file_size;
+
+    }
+
+}
 
 int main(int argc, const char* argv[]) {
 
     try {
-        if (argc < 2) {
+
+        std::string input_dir_str;
+        std::string output_dir_str;
+        std::string regex_pattern_str;
+        size_t num_threads = 0;
+
+        po::options_description options("Options");
+        options.add_options()
+            ("help", "Print out help message")
+            ("pattern", po::value<std::string>(&regex_pattern_str), "Regex pattern for all YUV10 files of the input folder.")
+            ("input", po::value<std::string>(&input_dir_str)->default_value("."), "Folder to read the YUV10 files from.")
+            ("output", po::value<std::string>(&output_dir_str)->default_value(""), "Folder to write the V210 files to, defaults to the input folder.")
+            ("threads", po::value<size_t>(&num_threads)->default_value(0), "Number of files converted concurrently, 0 uses one per hardware thread.");
+
+        po::positional_options_description positional;
+        positional.add("pattern", 1);
+
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+        po::notify(vm);
+
+        if (vm.count("help") || regex_pattern_str.empty()) {
             std::cout << "Argument required: regex pattern for all YUV10 files of \n";
-            std::cout << "current folder.";
+            std::cout << "the input folder. Files will be overwritten by default.\n";
+            std::cout << options << "\n";
             return EXIT_SUCCESS;
         }
 
-        // First argument is pattern to use for YUV10 files.
-        // Everything happens in CWD (input and output as well)
-        // Files will be overwritten by default
+        bf::path input_dir(input_dir_str);
+        bf::path output_dir(output_dir_str.empty() ? input_dir_str : output_dir_str);
+
+        if (!bf::is_directory(input_dir)) {
+            throw std::invalid_argument("Invalid input folder: '" + input_dir_str + "'.");
+        }
+
+        if (!bf::exists(output_dir)) {
+            bf::create_directories(output_dir);
+        }
 
         // iterator of the file system
-        auto dir_start = bf::directory_iterator(".");
+        auto dir_start = bf::directory_iterator(input_dir);
 
         if (dir_start == bf::directory_iterator()) {
             std::cout << "Directory is empty, nothing to process.\n";
@@ -50,7 +252,6 @@ int main(int argc, const char* argv[]) {
 
         std::vector<bf::directory_entry> filtered_files;
 
-        std::string regex_pattern_str(argv[1]);
         std::regex frame_pattern_regex(regex_pattern_str);
 
         std::cout << "Using regex pattern '" << regex_pattern_str << "'.\n";
@@ -61,7 +262,7 @@ int main(int argc, const char* argv[]) {
             std::back_inserter(filtered_files),
             [&](const bf::directory_entry& entry) {
                 
-                bool does_match = std::regex_match(
+                bool does_match = bf::is_regular_file(entry.path()) && std::regex_match(
                     entry.path().filename().string(), 
                     frame_pattern_regex);
 
@@ -80,80 +281,79 @@ int main(int argc, const char* argv[]) {
         std::cout << "First frame of selection : '" << filtered_files.front() << "'.\n";
         std::cout << "Last frame of selection: '" << filtered_files.back() << "'.\n";
 
-        for (const auto& frame_dir_entry : filtered_files) {
+        if (num_threads == 0)
+            num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
 
-            bf::ifstream frame_reader(
-                frame_dir_entry.path(),
-                std::ios::in | std::ios::binary);
+        num_threads = std::min(num_threads, filtered_files.size());
 
-            bf::path out_path = frame_dir_entry.path();
-            out_path.replace_extension(".v210");
+        std::cout << "Converting on " << num_threads << " thread(s).\n";
 
-            std::cout << "Writing '" << out_path << "'...";
+        std::atomic<size_t> next_file(0);
+        std::atomic<uintmax_t> bytes_written(0);
+        std::atomic<bool> failed(false);
+        std::mutex output_mutex;
 
-            bf::ofstream frame_writer(
-                out_path,
-                std::ios::out | std::ios::binary);
-            frame_writer.imbue(std::locale::classic());
+        auto worker = [&]() {
 
-            if (!frame_reader.good())
-                throw std::runtime_error("Reading failed.");
+            try {
 
-            if (!frame_writer.good())
-                throw std::runtime_error("Writing failed.");
-
-            frame_reader.seekg(0, std::ios::beg);
-
-            // Get four bytes, representing three components
-            while (frame_reader.peek() != bf::ifstream::traits_type::eof()) {
-
-                // Need to convert from YUV10 -> V210
-                // The following shows the layout in increasing
-                // memory addresses
-                // Sources: 
-                // https://developer.apple.com/quicktime/icefloe/dispatch019.html#v210
-                // and
-                // http://www.dvs.de/fileadmin/downloads/products/videosystems/clipster/extraweb/support/documentation/archive/software/clipster_edit_ug_v2_4.pdf
-                // and
-                // http://www.tribler.org/trac/wiki/FfmpegYuv
-
-                // |               YUV10               |
-                // | BYTE_0 | BYTE_1 | BYTE_2 | BYTE_3 |
-                // |98765432|10987654|32109876|543210XX|
-                // |    Cb    |    Y'    |    Cr    |XX|
-                //
-                // |               V210                |
-                // | BYTE_0 | BYTE_1 | BYTE_2 | BYTE_3 |
-                // |76543210|54321098|32109876|XX987654|
-                // |   Cb   | Y'  |Cb| Cr|  Y'|XX| Cr  |
-
-                int32_t a = frame_reader.get();
-                int32_t b = frame_reader.get();
-                int32_t c = frame_reader.get();
-                int32_t d = frame_reader.get();
-
-                int32_t C_0 = (a << 2) | (b >> 6);
-                int32_t C_1 = ((b & 0x3F) << 4) | (c >> 4);
-                int32_t C_2 = ((c & 0x0F) << 6) | (d >> 2);
-
-                char k = C_0;
-                char l = C_0 >> 8 | C_1 << 2;
-                char m = C_1 >> 6 | C_2 << 4;
-                char n = C_2 >> 4;
-
-                frame_writer.put(k);
-                frame_writer.put(l);
-                frame_writer.put(m);
-                frame_writer.put(n);
+                AlignedBuffer buffer = make_buffer();
+
+                for (size_t i = next_file++; i < filtered_files.size() && !failed; i = next_file++) {
+
+                    const bf::path& in_path = filtered_files[i].path();
+
+                    bf::path out_path = output_dir / in_path.filename();
+                    out_path.replace_extension(".v210");
 
+                    if (bf::exists(out_path) && bf::equivalent(in_path, out_path)) {
+                        throw std::runtime_error("Refusing to overwrite input file '" + in_path.string() + "'.");
+                    }
+
+                    bytes_written += convert_file(in_path, out_path, buffer.get());
+
+                    std::lock_guard<std::mutex> lock(output_mutex);
+                    std::cout << "Written '" << out_path.string() << "'.\n";
+
+                }
+
+            } catch (const std::exception& e) {
+                failed = true;
+                std::lock_guard<std::mutex> lock(output_mutex);
+                std::cout << "Caught exception: '" << e.what() << "'.\n";
             }
 
-            std::cout << "done!\n";
+        };
+
+        const auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < num_threads; ++i) {
+            threads.push_back(std::thread(worker));
         }
 
+        worker();
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (failed) {
+            std::cout << "Conversion failed.\n";
+            return EXIT_FAILURE;
+        }
+
+        std::cout 
+            << "Converted " << filtered_files.size() << " files (" 
+            << bytes_written / (1024 * 1024) << " MiB) in " << seconds << " s.\n";
+
         std::cout << "Done. Good bye!\n";
+
     } catch (const std::exception& e) {
         std::cout << "Caugth exception: '" << e.what() << "'.\n";
+        return EXIT_FAILURE;
     }
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,148 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <string>
+
+#include "FrameBender.h"
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+namespace fb = toa::frame_bender;
+
+// Measures the host copy throughput of every copy kernel the CPU supports,
+// for a few common frame sizes and thread counts. Copies are from one 
+// frame-pool buffer to another, i.e. host to host, which does not capture
+// the write-combined PBO memory the copy stages write to (or read from).
+
+namespace {
+
+    struct FrameSize {
+        std::string name;
+        size_t byte_size;
+    };
+
+    fb::ImageFormat make_format(size_t width, size_t height, fb::ImageFormat::PixelFormat pixel_format) {
+
+        return fb::ImageFormat(
+            static_cast<uint32_t>(width), 
+            static_cast<uint32_t>(height),
+            fb::ImageFormat::Transfer::BT_709,
+            fb::ImageFormat::Chromaticity::BT_709,
+            pixel_format,
+            fb::ImageFormat::Origin::UPPER_LEFT);
+
+    }
+
+}
+
+int main(int argc, const char* argv[]) {
+
+    try {
+
+        size_t num_iterations = 0;
+        std::vector<size_t> thread_counts;
+
+        po::options_description options("Options");
+        options.add_options()
+            ("help", "Print out help message")
+            ("iterations", po::value<size_t>(&num_iterations)->default_value(200), "Number of copies per measurement.")
+            ("threads", po::value<std::vector<size_t>>(&thread_counts)->multitoken(), "Thread counts to measure, defaults to 1 2 4.");
+
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv).options(options).run(), vm);
+        po::notify(vm);
+
+        if (vm.count("help")) {
+            std::cout << options << "\n";
+            return EXIT_SUCCESS;
+        }
+
+        if (thread_counts.empty()) {
+            thread_counts.push_back(1);
+            thread_counts.push_back(2);
+            thread_counts.push_back(4);
+        }
+
+        if (num_iterations == 0)
+            throw std::invalid_argument("Number of iterations must not be zero.");
+
+        std::vector<FrameSize> frame_sizes;
+        frame_sizes.push_back(FrameSize{ "720p RGBA 8", make_format(1280, 720, fb::ImageFormat::PixelFormat::RGBA_8BIT).image_byte_size() });
+        frame_sizes.push_back(FrameSize{ "1080p V210", make_format(1920, 1080, fb::ImageFormat::PixelFormat::YUV_10BIT_V210).image_byte_size() });
+        frame_sizes.push_back(FrameSize{ "1080p RGBA 16F", make_format(1920, 1080, fb::ImageFormat::PixelFormat::RGBA_FLOAT_16BIT).image_byte_size() });
+        frame_sizes.push_back(FrameSize{ "2160p V210", make_format(3840, 2160, fb::ImageFormat::PixelFormat::YUV_10BIT_V210).image_byte_size() });
+
+        std::cout << "Best kernel of this CPU: " << fb::host_copy::max_kernel() << "\n\n";
+
+        std::cout 
+            << std::left << std::setw(16) << "frame" 
+            << std::setw(14) << "kernel" 
+            << std::right << std::setw(8) << "threads" 
+            << std::setw(12) << "GB/s" << "\n";
+
+        for (const auto& frame_size : frame_sizes) {
+
+            fb::FrameMemoryPtr src = fb::FramePool::global().acquire(frame_size.byte_size);
+            fb::FrameMemoryPtr dst = fb::FramePool::global().acquire(frame_size.byte_size);
+
+            memset(src.get(), 0x5A, frame_size.byte_size);
+
+            for (int32_t k = 0; k <= static_cast<int32_t>(fb::host_copy::max_kernel()); ++k) {
+
+                for (auto num_threads : thread_counts) {
+
+                    fb::HostCopyEngine engine(fb::HostCopyKernel(k), num_threads);
+
+                    // Warm up, also faults in the destination pages
+                    engine.copy(dst.get(), src.get(), frame_size.byte_size);
+
+                    auto begin = std::chrono::steady_clock::now();
+
+                    for (size_t i = 0; i<num_iterations; ++i)
+                        engine.copy(dst.get(), src.get(), frame_size.byte_size);
+
+                    auto end = std::chrono::steady_clock::now();
+
+                    const double seconds = std::chrono::duration<double>(end - begin).count();
+                    const double gb_per_second = static_cast<double>(frame_size.byte_size) * num_iterations / seconds / 1e9;
+
+                    std::cout 
+                        << std::left << std::setw(16) << frame_size.name 
+                        << std::setw(14) << engine.kernel() 
+                        << std::right << std::setw(8) << engine.num_threads() 
+                        << std::setw(12) << std::fixed << std::setprecision(2) << gb_per_second << "\n";
+                }
+            }
+        }
+
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+
+}
@@ -0,0 +1,176 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <iostream>
+#include <regex>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#include "FrameBender.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/program_options.hpp>
+#include <boost/align/aligned_alloc.hpp>
+
+namespace bf = boost::filesystem;
+namespace po = boost::program_options;
+namespace fb = toa::frame_bender;
+
+// Packs a folder of raw frame files into a single sequence container, see
+// SequenceContainer.h.
+
+int main(int argc, const char* argv[]) {
+
+    try {
+
+        std::string input_dir_str;
+        std::string output_str;
+        std::string pattern;
+        size_t width = 0;
+        size_t height = 0;
+        fb::ImageFormat::PixelFormat pixel_format = fb::ImageFormat::PixelFormat::YUV_10BIT_V210;
+        fb::ImageFormat::Origin origin = fb::ImageFormat::Origin::UPPER_LEFT;
+        fb::ImageFormat::Transfer transfer = fb::ImageFormat::Transfer::BT_709;
+        fb::Time frame_duration(1, 25);
+
+        po::options_description options("Options");
+        options.add_options()
+            ("help", "Print out help message")
+            ("input", po::value<std::string>(&input_dir_str), "Folder to read the frame files from.")
+            ("output", po::value<std::string>(&output_str), "Container file to write, defaults to the input folder's name + '.fbseq' next to it.")
+            ("pattern", po::value<std::string>(&pattern)->default_value(".*\\.v210"), "Regex of the frame file names, frames are ordered by name.")
+            ("width", po::value<size_t>(&width)->default_value(1920), "Image width of the frames.")
+            ("height", po::value<size_t>(&height)->default_value(1080), "Image height of the frames.")
+            ("pixel_format", po::value<fb::ImageFormat::PixelFormat>(&pixel_format)->default_value(fb::ImageFormat::PixelFormat::YUV_10BIT_V210), "Pixel format of the frames.")
+            ("image_origin", po::value<fb::ImageFormat::Origin>(&origin)->default_value(fb::ImageFormat::Origin::UPPER_LEFT), "Image origin of the frames.")
+            ("image_transfer", po::value<fb::ImageFormat::Transfer>(&transfer)->default_value(fb::ImageFormat::Transfer::BT_709), "Image transfer of the frames.")
+            ("frame_duration", po::value<fb::Time>(&frame_duration)->default_value(fb::Time(1, 25)), "Duration of one frame, e.g. 1/25 for 25fps.");
+
+        po::positional_options_description positional;
+        positional.add("input", 1);
+        positional.add("output", 1);
+
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+        po::notify(vm);
+
+        if (vm.count("help") || input_dir_str.empty()) {
+            std::cout << "Arguments required: [input folder] ([output file]).\n";
+            std::cout << options << "\n";
+            return EXIT_SUCCESS;
+        }
+
+        bf::path input_dir(input_dir_str);
+
+        if (!bf::is_directory(input_dir)) {
+            throw std::invalid_argument("Invalid input folder: '" + input_dir_str + "'.");
+        }
+
+        // Strip a trailing separator, so that the folder has a name
+        if (!input_dir.has_filename() || input_dir.filename() == ".")
+            input_dir = input_dir.parent_path();
+
+        bf::path output_path = output_str.empty() ? 
+            bf::path(input_dir.string() + fb::sequence_container::kFileExtension) : 
+            bf::path(output_str);
+
+        fb::ImageFormat format(
+            static_cast<uint32_t>(width),
+            static_cast<uint32_t>(height),
+            transfer,
+            fb::ImageFormat::Chromaticity::BT_709,
+            pixel_format,
+            origin);
+
+        std::regex frame_pattern_regex(pattern);
+
+        std::vector<bf::path> frames;
+
+        for (auto it = bf::directory_iterator(input_dir); it != bf::directory_iterator(); ++it) {
+            if (bf::is_regular_file(it->path()) && 
+                std::regex_match(it->path().filename().string(), frame_pattern_regex))
+            {
+                frames.push_back(it->path());
+            }
+        }
+
+        if (frames.empty()) {
+            std::cout << "No files matched the pattern '" << pattern << "'. Nothing to process.\n";
+            return EXIT_SUCCESS;
+        }
+
+        std::sort(std::begin(frames), std::end(frames));
+
+        std::cout << "First frame of selection : '" << frames.front() << "'.\n";
+        std::cout << "Last frame of selection: '" << frames.back() << "'.\n";
+        std::cout << "Format: [" << format << "].\n";
+
+        std::unique_ptr<uint8_t, decltype(&boost::alignment::aligned_free)> buffer(
+            static_cast<uint8_t*>(boost::alignment::aligned_alloc(fb::sequence_container::kPayloadAlignment, format.image_byte_size())),
+            &boost::alignment::aligned_free);
+
+        if (!buffer)
+            throw std::bad_alloc();
+
+        const auto start = std::chrono::steady_clock::now();
+
+        fb::SequenceContainerWriter writer(output_path.string(), format, frame_duration);
+
+        for (const auto& frame_path : frames) {
+
+            if (bf::file_size(frame_path) != format.image_byte_size()) {
+                throw std::invalid_argument(
+                    "Unexpected byte size of '" + frame_path.string() + "': Got '" + 
+                    std::to_string(bf::file_size(frame_path)) + "', but need '" + 
+                    std::to_string(format.image_byte_size()) + "'.");
+            }
+
+            bf::ifstream frame_reader(frame_path, std::ios::in | std::ios::binary);
+
+            frame_reader.read(reinterpret_cast<char*>(buffer.get()), format.image_byte_size());
+
+            if (!frame_reader.good())
+                throw std::runtime_error("Failed to read '" + frame_path.string() + "'.");
+
+            writer.add_frame(buffer.get());
+
+        }
+
+        writer.finish();
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout 
+            << "Packed " << writer.num_frames() << " frames into '" 
+            << output_path.string() << "' (" 
+            << bf::file_size(output_path) / (1024 * 1024) << " MiB) in " << seconds << " s.\n";
+
+        std::cout << "Done. Good bye!\n";
+
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+/* Copyright (c) 2015 Heinrich Fink <hfink@toolsonair.com>
+ * Copyright (c) 2014 ToolsOnAir Broadcast Engineering GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+#include "FrameBender.h"
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+namespace fb = toa::frame_bender;
+
+// Compares the cost of taking a time stamp with clock::now() and with the 
+// sample clock (steady and TSC), both bare and through StageSampler::sample().
+// Afterwards, checks how far the TSC drifts off clock over a while, i.e. how 
+// well the periodic calibration keeps it in line.
+
+namespace {
+
+    volatile int64_t sink = 0;
+
+    template <typename Function>
+    double ns_per_call(size_t num_calls, Function f) {
+
+        auto begin = fb::clock::now();
+
+        for (size_t i = 0; i<num_calls; ++i)
+            f();
+
+        auto end = fb::clock::now();
+
+        return static_cast<double>((end - begin).count()) / static_cast<double>(num_calls);
+
+    }
+
+    double ns_per_sample(size_t num_calls) {
+
+        // Stay within the sampler's capacity, so that every call stores
+        const size_t batch_size = fb::StageSampler::kNumMaxTraceEvents;
+
+        double total_ns = 0.0;
+        size_t num_sampled = 0;
+
+        while (num_sampled < num_calls) {
+
+            std::unique_ptr<fb::StageSampler> sampler = fb::utils::make_unique<fb::StageSampler>();
+
+            total_ns += ns_per_call(batch_size, [&]{ 
+                sampler->sample(fb::StageExecutionState::TASK_BEGIN); 
+            }) * batch_size;
+
+            num_sampled += batch_size;
+        }
+
+        return total_ns / static_cast<double>(num_sampled);
+
+    }
+
+    void print_row(const std::string& name, double ns) {
+
+        std::cout 
+            << std::left << std::setw(36) << name 
+            << std::right << std::setw(12) << std::fixed << std::setprecision(2) << ns << "\n";
+
+    }
+
+}
+
+int main(int argc, const char* argv[]) {
+
+    try {
+
+        size_t num_calls = 0;
+        size_t drift_seconds = 0;
+
+        po::options_description options("Options");
+        options.add_options()
+            ("help", "Print out help message")
+            ("calls", po::value<size_t>(&num_calls)->default_value(10000000), "Number of time stamps per measurement.")
+            ("drift_seconds", po::value<size_t>(&drift_seconds)->default_value(5), "How long to watch the TSC against clock, 0 to skip.");
+
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv).options(options).run(), vm);
+        po::notify(vm);
+
+        if (vm.count("help")) {
+            std::cout << options << "\n";
+            return EXIT_SUCCESS;
+        }
+
+        if (num_calls == 0)
+            throw std::invalid_argument("Number of calls must not be zero.");
+
+        std::cout 
+            << std::left << std::setw(36) << "time stamp" 
+            << std::right << std::setw(12) << "ns/call" << "\n";
+
+        print_row("clock::now()", ns_per_call(num_calls, []{ 
+            sink = fb::clock::now().time_since_epoch().count(); 
+        }));
+
+        fb::sample_clock::select(fb::SampleClockSource::steady);
+
+        print_row("sample_clock::now() (steady)", ns_per_call(num_calls, []{ 
+            sink = fb::sample_clock::now().time_since_epoch().count(); 
+        }));
+
+        print_row("StageSampler::sample() (steady)", ns_per_sample(num_calls));
+
+        if (fb::sample_clock::select(fb::SampleClockSource::tsc) != fb::SampleClockSource::tsc) {
+            std::cout << "\nCPU has no invariant TSC, skipping the TSC.\n";
+            return EXIT_SUCCESS;
+        }
+
+        print_row("sample_clock::read_tsc()", ns_per_call(num_calls, []{ 
+            sink = static_cast<int64_t>(fb::sample_clock::read_tsc()); 
+        }));
+
+        print_row("sample_clock::now() (tsc)", ns_per_call(num_calls, []{ 
+            sink = fb::sample_clock::now().time_since_epoch().count(); 
+        }));
+
+        print_row("StageSampler::sample() (tsc)", ns_per_sample(num_calls));
+
+        std::cout 
+            << "\nTSC runs at " << std::setprecision(3) 
+            << fb::sample_clock::tsc_ticks_per_second() / 1e6 << " MHz.\n";
+
+        if (drift_seconds == 0)
+            return EXIT_SUCCESS;
+
+        // Sample clock minus clock, bracketing the TSC reading by two clock
+        // readings to account for the time in between
+        int64_t max_offset_ns = 0;
+        const size_t num_checks = drift_seconds * 10;
+
+        for (size_t i = 0; i<num_checks; ++i) {
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            int64_t before = fb::clock::now().time_since_epoch().count();
+            int64_t tsc_time = fb::sample_clock::now().time_since_epoch().count();
+            int64_t after = fb::clock::now().time_since_epoch().count();
+
+            int64_t offset = tsc_time - (before + (after - before)/2);
+
+            if (std::abs(offset) > std::abs(max_offset_ns))
+                max_offset_ns = offset;
+        }
+
+        std::cout 
+            << "Largest offset of the TSC to clock over " << drift_seconds 
+            << " s: " << max_offset_ns << " ns.\n";
+
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+
+}
@@ -20,96 +20,315 @@
  * THE SOFTWARE.
  */
 #include <iostream>
+#include <regex>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 
 #include "FrameBender.h"
-#include "TestUtils.h"
+#include "V210Comparator.h"
+#include "WorkerPool.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/program_options.hpp>
 
 namespace bf = boost::filesystem;
+namespace po = boost::program_options;
 namespace fb = toa::frame_bender;
 
-fb::Frame read_from_file(const bf::path& path) {
-
-    fb::ImageFormat input_sequence_format(
-		1920,
-		1080,
-        fb::ImageFormat::Transfer::BT_709, 
-        fb::ImageFormat::Chromaticity::BT_709,
-		fb::ImageFormat::PixelFormat::YUV_10BIT_V210,
-		fb::ImageFormat::Origin::UPPER_LEFT);
-
-    fb::Frame f(
-        input_sequence_format,
-        fb::Time(0, 1),
-        false
-        );
-
-    auto size = bf::file_size(path);
-    if (f.image_data_size() != size) {
-        throw std::invalid_argument("Unexpected byte size: Got '" + std::to_string(size) + "', but need '" + std::to_string(f.image_data_size()) + "'.");
+namespace {
+
+    void read_from_file(
+        const bf::path& path, 
+        const fb::ImageFormat& format, 
+        std::vector<uint8_t>& data) 
+    {
+
+        auto size = bf::file_size(path);
+        if (format.image_byte_size() != size) {
+            throw std::invalid_argument(
+                "Unexpected byte size of '" + path.string() + "': Got '" + 
+                std::to_string(size) + "', but need '" + 
+                std::to_string(format.image_byte_size()) + "'.");
+        }
+
+        data.resize(format.image_byte_size());
+
+        bf::ifstream frame_reader(
+            path,
+            std::ios::in | std::ios::binary);
+
+        if (!frame_reader.good())
+            throw std::runtime_error("Can't read '" + path.string() + "'.");
+
+        frame_reader.read(
+            reinterpret_cast<char*>(data.data()), 
+            data.size());
+
+        if (!frame_reader.good())
+            throw std::runtime_error("Failed to read '" + path.string() + "'.");
+
+    }
+
+    std::vector<bf::path> list_frames(const bf::path& folder, const std::regex& pattern) {
+
+        std::vector<bf::path> frames;
+
+        for (auto it = bf::directory_iterator(folder); it != bf::directory_iterator(); ++it) {
+            if (bf::is_regular_file(it->path()) && 
+                std::regex_match(it->path().filename().string(), pattern))
+            {
+                frames.push_back(it->path());
+            }
+        }
+
+        std::sort(std::begin(frames), std::end(frames));
+
+        return frames;
+
     }
 
-    bf::ifstream frame_reader(
-        path,
-        std::ios::in | std::ios::binary);
+    int compare_single(
+        const bf::path& reference_path,
+        const bf::path& candidate_path,
+        const fb::ImageFormat& format,
+        size_t num_threads,
+        fb::cpu::SimdLevel simd_level,
+        uint16_t tolerance)
+    {
+
+        std::vector<uint8_t> reference;
+        std::vector<uint8_t> candidate;
+
+        read_from_file(reference_path, format, reference);
+        read_from_file(candidate_path, format, candidate);
+
+        fb::V210Comparator comparator(num_threads, simd_level);
+
+        auto result = comparator.compare(format, reference.data(), candidate.data(), tolerance);
+
+        std::cout << "Comparison statistics: \n";
+        for (auto& el : result.channels) {
+            std::cout << el << "\n";
+        }
+
+        if (!result.reference_in_range)
+            std::cout << "Reference contains values outside of [4, 1019].\n";
+
+        if (!result.candidate_in_range)
+            std::cout << "Candidate contains values outside of [4, 1019].\n";
+
+        return result.is_within(tolerance) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    }
+
+    // Compares the frames of both folders pairwise (in order of their file 
+    // names), one frame per worker.
+    int compare_batch(
+        const bf::path& reference_folder,
+        const bf::path& candidate_folder,
+        const std::regex& pattern,
+        const fb::ImageFormat& format,
+        size_t num_threads,
+        fb::cpu::SimdLevel simd_level,
+        uint16_t tolerance)
+    {
+
+        auto reference_frames = list_frames(reference_folder, pattern);
+        auto candidate_frames = list_frames(candidate_folder, pattern);
+
+        if (reference_frames.size() != candidate_frames.size()) {
+            throw std::invalid_argument(
+                "Number of frames doesn't match: reference='" + 
+                std::to_string(reference_frames.size()) + "', candidate='" + 
+                std::to_string(candidate_frames.size()) + "'.");
+        }
+
+        if (reference_frames.empty()) {
+            std::cout << "No frames to compare.\n";
+            return EXIT_SUCCESS;
+        }
+
+        fb::WorkerPool pool(num_threads);
+
+        struct WorkerState {
+            std::unique_ptr<fb::V210Comparator> comparator;
+            std::vector<uint8_t> reference;
+            std::vector<uint8_t> candidate;
+        };
+
+        std::vector<WorkerState> workers(pool.num_workers());
+        for (auto& worker : workers) {
+            worker.comparator = fb::utils::make_unique<fb::V210Comparator>(1, simd_level);
+        }
+
+        std::vector<fb::V210Comparator::Result> results(reference_frames.size());
+
+        pool.run(
+            reference_frames.size(), 
+            [&](size_t frame, size_t worker_index) {
 
-    if (!frame_reader.good())
-        throw std::runtime_error("Can't read.");
+                WorkerState& worker = workers[worker_index];
 
-    frame_reader.seekg(0, std::ios::beg);
+                read_from_file(reference_frames[frame], format, worker.reference);
+                read_from_file(candidate_frames[frame], format, worker.candidate);
 
-    frame_reader.read(
-        reinterpret_cast<char*>(f.image_data()), 
-        f.image_data_size());
+                results[frame] = worker.comparator->compare(
+                    format, 
+                    worker.reference.data(), 
+                    worker.candidate.data(), 
+                    tolerance);
+
+            });
+
+        size_t num_failed = 0;
+
+        std::array<fb::ChannelComparisonStatistics, 3> total;
+        for (size_t c = 0; c<3; ++c) {
+            total[c] = results.front().channels[c];
+            total[c].mean_squared_error = .0;
+        }
+
+        for (size_t i = 0; i<results.size(); ++i) {
+
+            const auto& result = results[i];
+
+            std::cout 
+                << reference_frames[i].filename().string() << " vs " 
+                << candidate_frames[i].filename().string() << ": PSNR ";
+
+            for (size_t c = 0; c<3; ++c) {
+
+                const auto& channel = result.channels[c];
+
+                std::cout << channel.channel_name << "=" << channel.psnr << (c < 2 ? ", " : "");
+
+                total[c].min_error = std::min(total[c].min_error, channel.min_error);
+                total[c].max_error = std::max(total[c].max_error, channel.max_error);
+                total[c].mean_squared_error += channel.mean_squared_error;
+
+            }
+
+            std::cout << ", max error " << result.max_error;
+
+            if (!result.is_within(tolerance)) {
+                std::cout << " (FAILED)";
+                ++num_failed;
+            }
+
+            std::cout << "\n";
+
+        }
+
+        // All frames have the same number of samples
+        for (auto& el : total) {
+            el.mean_squared_error /= static_cast<double>(results.size());
+            if (el.mean_squared_error == 0)
+                el.psnr = std::numeric_limits<double>::infinity();
+            else
+                el.psnr = 20*log10(1024) - 10*log10(el.mean_squared_error);
+        }
+
+        std::cout << "\nComparison statistics over " << results.size() << " frames: \n";
+        for (auto& el : total) {
+            std::cout << el << "\n";
+        }
+
+        std::cout << num_failed << " of " << results.size() << " frames exceeded the tolerance.\n";
+
+        return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    }
 
-    return f;
 }
 
 int main(int argc, const char* argv[]) {
 
     try {
 
-        if (argc < 3) {
-            std::cout << "Arguments required: [reference] [candidate].\n";
+        std::string arg_reference_str;
+        std::string arg_candidate_str;
+        size_t width = 0;
+        size_t height = 0;
+        size_t num_threads = 0;
+        size_t tolerance = 0;
+        std::string pattern;
+        fb::cpu::SimdLevel simd_level = fb::cpu::SimdLevel::avx2;
+
+        po::options_description options("Options");
+        options.add_options()
+            ("help", "Print out help message")
+            ("reference", po::value<std::string>(&arg_reference_str), "Reference frame or folder.")
+            ("candidate", po::value<std::string>(&arg_candidate_str), "Candidate frame or folder.")
+            ("width", po::value<size_t>(&width)->default_value(1920), "Image width of the frames.")
+            ("height", po::value<size_t>(&height)->default_value(1080), "Image height of the frames.")
+            ("threads", po::value<size_t>(&num_threads)->default_value(0), "Number of threads to use, 0 uses one per hardware thread.")
+            ("simd_level", po::value<fb::cpu::SimdLevel>(&simd_level)->default_value(fb::cpu::SimdLevel::avx2), "Highest instruction set to use (scalar, sse41 or avx2).")
+            ("tolerance", po::value<size_t>(&tolerance)->default_value(1023), "Largest absolute error per component for a frame to pass.")
+            ("pattern", po::value<std::string>(&pattern)->default_value(".*\\.v210"), "Regex of the frame file names when comparing folders.");
+
+        po::positional_options_description positional;
+        positional.add("reference", 1);
+        positional.add("candidate", 1);
+
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+        po::notify(vm);
+
+        if (vm.count("help") || arg_reference_str.empty() || arg_candidate_str.empty()) {
+            std::cout << "Arguments required: [reference] [candidate], either two V210 files or two folders.\n";
+            std::cout << options << "\n";
             return EXIT_SUCCESS;
         }
 
-        fb::ProgramOptions::initialize_global(argc, argv);
-
-        std::cout << "Assuming a resolution of 1080p.\n";
+        fb::ImageFormat format(
+            static_cast<uint32_t>(width),
+            static_cast<uint32_t>(height),
+            fb::ImageFormat::Transfer::BT_709, 
+            fb::ImageFormat::Chromaticity::BT_709,
+            fb::ImageFormat::PixelFormat::YUV_10BIT_V210,
+            fb::ImageFormat::Origin::UPPER_LEFT);
 
-        std::string arg_reference_str = std::string(argv[1]);
-        std::string arg_candidate_str = std::string(argv[2]);
+        std::cout << "Assuming a resolution of " << width << "x" << height << ".\n";
 
         bf::path reference_path(arg_reference_str);
         bf::path candidate_path(arg_candidate_str);
 
-        if (!bf::is_regular_file(reference_path) || !bf::exists(reference_path)) {
-            throw std::invalid_argument("Invalid path: '" + arg_reference_str + "'.");
-        }
+        const uint16_t tolerance_value = static_cast<uint16_t>(std::min<size_t>(tolerance, 1023));
 
-        if (!bf::is_regular_file(candidate_path) || !bf::exists(candidate_path)) {
-            throw std::invalid_argument("Invalid path: '" + arg_candidate_str + "'.");
-        }
+        if (bf::is_directory(reference_path) && bf::is_directory(candidate_path)) {
 
-        fb::Frame reference = read_from_file(reference_path);
-        fb::Frame candidate = read_from_file(candidate_path);
+            return compare_batch(
+                reference_path, 
+                candidate_path, 
+                std::regex(pattern),
+                format, 
+                num_threads, 
+                simd_level, 
+                tolerance_value);
 
-        std::array<fb::test::ChannelComparisonStatistics, 3> stats;
+        }
 
-        // Don't care whether frames are within tolerance, just need the stats
-        fb::test::compare_v210_frames(reference, candidate, 1000, &stats);
+        if (!bf::is_regular_file(reference_path)) {
+            throw std::invalid_argument("Invalid path: '" + arg_reference_str + "'.");
+        }
 
-        std::cout << "Comparison statistics: \n";
-        for (auto& el : stats) {
-            std::cout << el << "\n";
+        if (!bf::is_regular_file(candidate_path)) {
+            throw std::invalid_argument("Invalid path: '" + arg_candidate_str + "'.");
         }
 
+        return compare_single(
+            reference_path, 
+            candidate_path, 
+            format, 
+            num_threads, 
+            simd_level, 
+            tolerance_value);
+
     } catch (const std::exception& e) {
         std::cout << "Exception: " << e.what() << std::endl;
     }
 
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    return EXIT_FAILURE;
+}